@@ -0,0 +1,10 @@
+#define VERSION          "1.3.0"
+#define VERSION_REVISION "85496b8a0522"
+#define VERSION_FULL     "1.3.0 (85496b8a0522)"
+
+#define CORE_SCALAR_TYPE_DOUBLE
+#define CORE_SCALAR_TYPE double
+typedef CORE_SCALAR_TYPE scalar;
+
+
+
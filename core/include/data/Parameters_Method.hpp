@@ -35,6 +35,12 @@ namespace Data
 		long int n_iterations;
 		// Number of iterations after which the Method should save data
 		long int n_iterations_log;
+
+		// File to which a checkpoint of the running simulation is written (none if empty).
+		//		If it exists when a simulation is started, the simulation is continued from it.
+		std::string checkpoint_file = "";
+		// Number of iterations after which a checkpoint is written (0 = only when the simulation is stopped)
+		long int n_iterations_checkpoint = 0;
 	};
 }
 #endif
\ No newline at end of file
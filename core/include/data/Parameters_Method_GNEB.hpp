@@ -15,13 +15,20 @@ namespace Data
 	{
 	public:
 		// Constructor
-		Parameters_Method_GNEB(std::string output_folder, std::array<bool,4> save_output, scalar force_convergence, long int n_iterations, long int n_iterations_log, scalar spring_constant, int n_E_interpolations);
+		Parameters_Method_GNEB(std::string output_folder, std::array<bool,4> save_output, scalar force_convergence, long int n_iterations, long int n_iterations_log, scalar spring_constant, int n_E_interpolations, int n_threads_images = 0);
 
 		// Strength of springs between images
 		scalar spring_constant;
 
 		// Number of Energy interpolations between Images
 		int n_E_interpolations;
+
+		// Maximum number of threads evaluating the images concurrently (0 means all threads, if there are
+		//		at least as many images as threads, and otherwise one image after the other with all threads)
+		int n_threads_images;
+
+		// Whether to save the image chain as a binary trajectory (one frame per image) instead of text
+		bool save_output_binary = false;
 	};
 }
 #endif
\ No newline at end of file
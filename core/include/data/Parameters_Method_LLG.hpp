@@ -4,6 +4,7 @@
 
 #include <random>
 #include <vector>
+#include <cstdint>
 
 #include "Core_Defines.h"
 #include <engine/Vectormath_Defines.hpp>
@@ -16,12 +17,15 @@ namespace Data
 	{
 	public:
 		// Constructor
-		Parameters_Method_LLG(std::string output_folder, std::array<bool,6> save_output, scalar force_convergence, long int n_iterations, long int n_iterations_log,
+		Parameters_Method_LLG(std::string output_folder, std::array<bool,7> save_output, scalar force_convergence, long int n_iterations, long int n_iterations_log,
 			int seed_i, scalar temperature_i, scalar damping_i, scalar time_step_i, bool renorm_sd_i,
 			scalar stt_magnitude_i, Vector3 stt_polarisation_normal_i);
 
 		//PRNG Seed
 		const int seed;
+		// Iteration of the thermal noise, i.e. the number of noise fields drawn so far.
+		//		The noise is determined by seed and noise_iteration, so setting it restarts the noise of a trajectory.
+		uint64_t noise_iteration = 0;
 		// --------------- Different distributions ------------
 		std::mt19937 prng;
 		std::uniform_real_distribution<scalar> distribution_real;
@@ -34,12 +38,37 @@ namespace Data
 		scalar damping;
 		// Time step per iteration
 		scalar dt;
+		// Adaptive time step of the deterministic integration (temperature 0): each step is accepted or rejected
+		//		by an embedded estimate of its error and dt is adapted by a PI controller within [dt_min, dt_max]
+		bool adaptive_dt = false;
+		// Tolerance of the error estimate, i.e. of the largest difference of a spin between the embedded solutions
+		scalar dt_tolerance = 1e-4;
+		// Bounds of the adaptive time step, 0 < dt_min <= dt_max (by default 1e-5 ps and 1 ps)
+		scalar dt_min, dt_max;
+		// Time integrated so far, in the units of dt
+		scalar time = 0;
+		// Accepted time steps since the last output (written by Method_LLG::Save_Current)
+		std::vector<scalar> dt_history;
 		// whether to renormalize spins after every SD iteration
 		bool renorm_sd = 1;
 		// Whether to save an archive of spin configurations
 		bool save_output_archive;
 		// Whether to save a single spin configurations
 		bool save_output_single;
+		// Whether to save the spin configurations as binary trajectories instead of text
+		bool save_output_binary;
+
+		// Number of iterations between the parallel tempering swaps when the images of a chain
+		//		are iterated as replicas at different temperatures (0 = no swaps)
+		long int n_iterations_swap = 0;
+
+		// Monte Carlo (Method_MC): whether the trial moves are in a cone around the spins, otherwise uniform on the sphere
+		bool mc_metropolis_cone = true;
+		// Opening angle of the cone [degrees]
+		scalar mc_cone_angle = 30;
+		// Whether the cone angle is adapted such that the acceptance ratio stays near mc_acceptance_target
+		bool mc_adaptive_cone = true;
+		scalar mc_acceptance_target = 0.5;
 
 		// spin-transfer-torque parameter (prop to injected current density)
 		scalar stt_magnitude;
@@ -4,6 +4,7 @@
 
 #include <random>
 #include <memory>
+#include <cstdint>
 
 #include "Core_Defines.h"
 #include <engine/Vectormath_Defines.hpp>
@@ -31,17 +32,27 @@ namespace Data
 		// Assignment operator
 		Spin_System& operator=(Spin_System const & other);
 
-		// Update
+		// Update the observables E, E_array and effective_field.
+		//		They are only recalculated if the spins have changed since their last update.
 		void UpdateEnergy();
 		void UpdateEffectiveField();
+		// Update both in one evaluation of the Hamiltonian
+		void UpdateEnergyAndEffectiveField();
+		// Mark the spins (or the Hamiltonian) as changed, so that the observables are recalculated on their next update.
+		//		This has to be called whenever the spins are modified.
+		void Invalidate();
+		// Give this system its own copy of the Hamiltonian, if it is shared with other systems.
+		//		Copies of a system share the Hamiltonian and geometry, which are not modified by the
+		//		methods, so this has to be called before modifying the Hamiltonian of one system.
+		void Unshare_Hamiltonian();
 
 		// Number of spins
 		int nos;
 		// Orientations of the Spins: spins[dim][nos]
 		std::shared_ptr<vectorfield> spins;
-		// Spin Hamiltonian
+		// Spin Hamiltonian (may be shared with copies of this system)
 		std::shared_ptr<Engine::Hamiltonian> hamiltonian;
-		// Geometric Information
+		// Geometric Information (shared with copies of this system)
 		std::shared_ptr<Geometry> geometry;
 		// Parameters for LLG Iterations (MC, SIB, ...)
 		std::shared_ptr<Parameters_Method_LLG> llg_parameters;
@@ -54,6 +65,9 @@ namespace Data
 		// Total effective field of the spins [3][nos]
 		vectorfield effective_field;
 
+		// Version of the spins, and the versions for which the observables were last calculated
+		std::uint64_t spins_version, energy_version, effective_field_version;
+
 
 	//private:
 
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef DIPOLE_FFT_H
+#define DIPOLE_FFT_H
+
+#include <vector>
+#include <complex>
+#include <memory>
+
+#include "Core_Defines.h"
+#include <engine/Vectormath_Defines.hpp>
+#include <engine/Dipole_Solver.hpp>
+#include <data/Geometry.hpp>
+
+namespace Engine
+{
+	/*
+		The Dipole-Dipole interaction of a regular lattice, calculated as a convolution via FFT.
+		The dipole kernel (3 n_ij n_ij^T - 1)/r_ij^3 between all pairs of basis atoms is transformed
+		once for a geometry, so that the field of all spins costs O(N log N) instead of O(N^2).
+		Open directions are zero-padded, so the cyclic convolution does not wrap around the lattice.
+		In periodic directions the kernel contains the images of the pairs within one lattice length,
+		i.e. the same pairs as created by Neighbours::Create_Dipole_Pairs.
+	*/
+	class Dipole_FFT : public Dipole_Solver
+	{
+	public:
+		// Only pairs with a distance up to cutoff_radius are taken into account, if cutoff_radius > 0
+		Dipole_FFT(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions, scalar cutoff_radius);
+
+		void Field(const vectorfield & spins, vectorfield & field) const override;
+		std::string Method() const override { return "fft"; }
+
+		// Cutoff radius of the kernel (<= 0 means no cutoff)
+		const scalar cutoff_radius;
+
+	private:
+		typedef std::complex<scalar> complex;
+		// A one-dimensional transform of fixed length
+		struct Plan;
+
+		// Number of basis atoms and of cells
+		int n_basis;
+		int n_cells[3];
+		// Size of the (padded) FFT grid
+		int n_grid[3];
+		int n_grid_total;
+		std::vector<std::shared_ptr<Plan>> plans;
+		// Fourier transformed kernel: the components xx, xy, xz, yy, yz, zz for each pair of basis atoms
+		//		kernel[6*(ibasis*n_basis + jbasis) + component][grid point]
+		std::vector<std::vector<complex>> kernel;
+
+		// In-place three-dimensional transform on the grid (not normalised)
+		void Transform(std::vector<complex> & data, bool inverse) const;
+	};
+}
+#endif
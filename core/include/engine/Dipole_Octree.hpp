@@ -0,0 +1,63 @@
+#pragma once
+#ifndef DIPOLE_OCTREE_H
+#define DIPOLE_OCTREE_H
+
+#include <vector>
+
+#include "Core_Defines.h"
+#include <engine/Vectormath_Defines.hpp>
+#include <engine/Dipole_Solver.hpp>
+#include <data/Geometry.hpp>
+
+namespace Engine
+{
+	/*
+		The Dipole-Dipole interaction of arbitrary spin positions, calculated hierarchically (Barnes-Hut).
+		The spins are sorted into an octree, and the spins of a cell which is small compared to its distance
+		to a spin are replaced by the multipole expansion of the cell, consisting of its total dipole moment
+		and the first moments of the dipoles around the centre of the cell.
+		This costs O(N log N) instead of O(N^2) and does not require a regular lattice.
+		All pairs of spins are taken into account, i.e. there is neither a cutoff nor periodic images.
+	*/
+	class Dipole_Octree : public Dipole_Solver
+	{
+	public:
+		// A cell of size s at a distance d from a spin is approximated if s < theta*d,
+		//		theta = 0 gives the direct sum and the error decreases at least as theta^2.
+		//		Cells with at most leaf_size spins are not subdivided further.
+		Dipole_Octree(const Data::Geometry & geometry, scalar theta, int leaf_size = 8);
+
+		void Field(const vectorfield & spins, vectorfield & field) const override;
+		std::string Method() const override { return "octree"; }
+
+		// Calculates the field of the spins with the given indices by direct summation over all spins
+		void Field_Direct(const vectorfield & spins, const intfield & indices, vectorfield & field) const;
+		// Relative RMS error of Field compared to the direct sum, measured on n_samples evenly spaced spins
+		scalar Measure_Error(const vectorfield & spins, int n_samples) const;
+
+		// Accuracy parameter
+		const scalar theta;
+		// Number of cells of the octree
+		int Get_N_Nodes() const { return nodes.size(); }
+
+	private:
+		struct Node
+		{
+			// Mean position of the spins and the diagonal of their bounding box
+			Vector3 centre = Vector3::Zero();
+			Vector3 box_min = Vector3::Zero(), box_max = Vector3::Zero();
+			scalar size = 0;
+			// Range of the cell in order
+			int begin = 0, end = 0;
+			// Children are stored contiguously after their parent
+			int first_child = 0, n_children = 0;
+		};
+
+		vectorfield positions;
+		// Spin indices, sorted such that each cell is a contiguous range
+		intfield order;
+		// Cells in breadth-first order, i.e. children have larger indices than their parents
+		std::vector<Node> nodes;
+	};
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef DIPOLE_SOLVER_H
+#define DIPOLE_SOLVER_H
+
+#include <string>
+
+#include "Core_Defines.h"
+#include <engine/Vectormath_Defines.hpp>
+
+namespace Engine
+{
+	/*
+		Interface of the solvers for the long-range Dipole-Dipole interaction, which calculate the dipolar
+		field of all spins at once instead of summing over explicit pairs.
+	*/
+	class Dipole_Solver
+	{
+	public:
+		virtual ~Dipole_Solver() {};
+
+		// Calculates field[i] = sum_j (3 n_ij n_ij^T - 1)/r_ij^3 * spins[j]
+		virtual void Field(const vectorfield & spins, vectorfield & field) const = 0;
+
+		// Name of the method, as used for the dd_method keyword of the config file
+		virtual std::string Method() const = 0;
+	};
+}
+#endif
@@ -4,9 +4,11 @@
 
 #include <random>
 #include <vector>
+#include <memory>
 
 #include "Core_Defines.h"
 #include <engine/Vectormath_Defines.hpp>
+#include <engine/Vectormath_SoA.hpp>
 #include <utility/Logging.hpp>
 #include <utility/Exception.hpp>
 
@@ -36,6 +38,15 @@ namespace Engine
 		*/
 		virtual void Hessian(const vectorfield & spins, MatrixX & hessian);
 
+		/*
+			Calculate the Hessian matrix of a spin configuration in sparse storage.
+			The layout is the same as for the dense Hessian, i.e. the entry (3*i+alpha, 3*j+beta)
+			couples component alpha of spin i with component beta of spin j.
+			This function converts the dense Hessian and is thus only the fallback for derived
+			classes where it has not been overridden.
+		*/
+		virtual void Sparse_Hessian(const vectorfield & spins, SpMatrixX & hessian);
+
 		/*
 			Calculate the energy gradient of a spin configuration.
 			This function uses finite differences and may thus be quite inefficient. You should
@@ -44,6 +55,21 @@ namespace Engine
 		*/
 		virtual void Gradient(const vectorfield & spins, vectorfield & gradient);
 
+		/*
+			Calculate the energy gradient of a spin configuration in structure-of-arrays layout.
+			This function converts to and from the vectorfield layout and is thus only the fallback
+			for derived classes which do not implement their interactions on vectorfield_soa.
+		*/
+		virtual void Gradient_SoA(const vectorfield_soa & spins, vectorfield_soa & gradient);
+
+		/*
+			Calculate the energy gradients of several spin configurations of this system at once,
+			e.g. of the replicas of a parallel tempering simulation.
+			This function calls Gradient for each configuration and is thus only the fallback for derived
+			classes which do not evaluate their interactions for all configurations in one sweep.
+		*/
+		virtual void Gradient_Batch(const std::vector<std::shared_ptr<vectorfield>> & spins, std::vector<vectorfield> & gradients);
+
 		// Calculate the Energy contributions for the spins of a configuration
 		virtual void Energy_Contributions_per_Spin(const vectorfield & spins, std::vector<std::pair<std::string, scalarfield>> & contributions);
 
@@ -53,6 +79,28 @@ namespace Engine
 		// Calculate the Energy of a spin configuration
 		virtual scalar Energy(const vectorfield & spins);
 
+		/*
+			Calculate the change of the Energy of a spin configuration when spin ispin is set to spin_new.
+			This function calculates the Energy of both configurations and is thus only the fallback for
+			derived classes which do not calculate the difference from the interactions of spin ispin.
+		*/
+		virtual scalar Energy_Difference(const vectorfield & spins, int ispin, const Vector3 & spin_new);
+
+		/*
+			The spins interacting with each spin, i.e. whose Energy_Difference depends on each other, in compressed layout:
+			the spins interacting with spin ispin are interacting[k] for offset[ispin] <= k < offset[ispin+1].
+			Returns false if this is not known or the interactions are long-ranged, i.e. if all spins may interact.
+		*/
+		virtual bool Interacting_Spins(int nos, intfield & offset, intfield & interacting);
+
+		/*
+			Calculate the energy gradient and the Energy contributions of a spin configuration.
+			Derived classes should override this to evaluate both in one sweep over their interactions,
+			which is cheaper than calling Gradient and Energy_Contributions separately.
+			This function is the fallback for derived classes where it has not been overridden.
+		*/
+		virtual void Energy_and_Gradient(const vectorfield & spins, vectorfield & gradient, std::vector<std::pair<std::string, scalar>> & energy_contributions);
+
 		// Hamiltonian name as string
 		virtual const std::string& Name();
 
@@ -60,8 +108,14 @@ namespace Engine
 		std::vector<bool> boundary_conditions; // [3] (a, b, c)
 	
 	protected:
-		// Energy contributions per spin
+		// Names of the energy contributions of this Hamiltonian (set by the derived classes).
+		//		The values per spin are calculated into fields owned by the caller, so that
+		//		one Hamiltonian can be evaluated for several images concurrently.
 		std::vector<std::pair<std::string, scalarfield>> energy_contributions_per_spin;
+		// Resize the contributions to nos spins with the names above and set them to zero
+		void Prepare_Energy_Contributions(int nos, std::vector<std::pair<std::string, scalarfield>> & contributions) const;
+		// Sum the energy contributions per spin into the total Energy contributions
+		void Sum_Energy_Contributions(const std::vector<std::pair<std::string, scalarfield>> & contributions, std::vector<std::pair<std::string, scalar>> & energy_contributions) const;
 
 		std::mt19937 prng;
 		std::uniform_int_distribution<int> distribution_int;
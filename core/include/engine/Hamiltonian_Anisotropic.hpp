@@ -3,10 +3,12 @@
 #define HAMILTONIAN_ANISOTROPIC_NEW_H
 
 #include <vector>
+#include <memory>
 
 #include "Core_Defines.h"
 #include <engine/Vectormath_Defines.hpp>
 #include <engine/Hamiltonian.hpp>
+#include <engine/Dipole_Solver.hpp>
 #include <data/Geometry.hpp>
 
 namespace Engine
@@ -27,14 +29,17 @@ namespace Engine
 			std::vector<indexPairs> DMI_indices, std::vector<scalarfield> DMI_magnitude, std::vector<vectorfield> DMI_normal,
 			std::vector<indexPairs> DD_indices, std::vector<scalarfield> DD_magnitude, std::vector<vectorfield> DD_normal,
 			std::vector<indexQuadruplets> quadruplet_indices, std::vector<scalarfield> quadruplet_magnitude,
-			std::vector<bool> boundary_conditions
+			std::vector<bool> boundary_conditions,
+			std::shared_ptr<Dipole_Solver> dipole_solver = nullptr
 		);
 
 		void Update_Energy_Contributions() override;
 
 		void Hessian(const vectorfield & spins, MatrixX & hessian) override;
+		void Sparse_Hessian(const vectorfield & spins, SpMatrixX & hessian) override;
 		void Gradient(const vectorfield & spins, vectorfield & gradient) override;
 		void Energy_Contributions_per_Spin(const vectorfield & spins, std::vector<std::pair<std::string, scalarfield>> & contributions) override;
+		void Energy_and_Gradient(const vectorfield & spins, vectorfield & gradient, std::vector<std::pair<std::string, scalar>> & energy_contributions) override;
 
 		// Hamiltonian name as string
 		const std::string& Name() override;
@@ -66,12 +71,37 @@ namespace Engine
 		std::vector<indexPairs> DD_indices;			// [periodicity][nop][2] (i,j)
 		std::vector<scalarfield> DD_magnitude;			// [periodicity][nop]    r_ij (distance)
 		std::vector<vectorfield> DD_normal;			// [periodicity][nop][4] (nx,ny,nz)
+		// Dipole Dipole interaction of the whole system via FFT or octree (used in addition to the DD pairs)
+		std::shared_ptr<Dipole_Solver> dipole_solver;
 
 		// ------------ Quadruplet Interactions ------------
 		std::vector<indexQuadruplets> Quadruplet_indices;
 		std::vector<scalarfield> Quadruplet_magnitude;
 
 	private:
+		// ------------ Interactions per Spin ------------
+		// The interactions a spin takes part in, in the same order as in the loops over the
+		// interaction lists. This allows to calculate gradient and energy spin by spin, so that
+		// disjoint ranges of spins can be calculated in parallel with the same result.
+		enum class Interaction_Type : char { Zeeman, Anisotropy, Exchange, DMI, DD, Quadruplet };
+		struct Spin_Interaction
+		{
+			Interaction_Type type;
+			char periodicity;
+			// The position of the spin within the pair or quadruplet
+			char role;
+			// The index within the interaction list
+			int index;
+		};
+		intfield spin_interactions_offset;				// [nos+1]
+		std::vector<Spin_Interaction> spin_interactions;
+		// Build the lists of interactions per spin from the interaction lists
+		void Update_Spin_Interactions();
+		// Check if the boundary conditions contain a periodicity
+		bool Periodicity_Active(int i_periodicity);
+		// Calculate the gradient and/or the energy contributions (the ones which are not nullptr) for the spins in [begin, end)
+		void Spin_Range(const vectorfield & spins, vectorfield * gradient, std::vector<std::pair<std::string, scalarfield>> * contributions, int begin, int end);
+
 		// ------------ Effective Field Functions ------------
 		// Calculate the Zeeman effective field of a single Spin
 		void Gradient_Zeeman(const vectorfield & spins, vectorfield & gradient);
@@ -83,6 +113,8 @@ namespace Engine
 		void Gradient_DMI(const vectorfield & spins, indexPairs & indices, scalarfield & DMI_magnitude, vectorfield & DMI_normal, vectorfield & gradient);
 		// Calculates the Dipole-Dipole contribution to the effective field of spin ispin within system s
 		void Gradient_DD(const vectorfield& spins, indexPairs & indices, scalarfield & DD_magnitude, vectorfield & DD_normal, vectorfield & gradient);
+		// Calculates the Dipole-Dipole contribution of dipole_solver
+		void Gradient_DD_Solver(const vectorfield & spins, vectorfield & gradient);
 		// Quadruplet
 		void Gradient_Quadruplet(const vectorfield & spins, indexQuadruplets & indices, scalarfield & magnitude, vectorfield & gradient);
 
@@ -99,6 +131,8 @@ namespace Engine
 		void E_DMI(const vectorfield & spins, indexPairs & indices, scalarfield & DMI_magnitude, vectorfield & DMI_normal, scalarfield & Energy);
 		// calculates the Dipole-Dipole Energy
 		void E_DD(const vectorfield& spins, indexPairs & indices, scalarfield & DD_magnitude, vectorfield & DD_normal, scalarfield & Energy);
+		// calculates the Dipole-Dipole Energy of dipole_solver
+		void E_DD_Solver(const vectorfield & spins, scalarfield & Energy);
 		// Quadruplet
 		void E_Quadruplet(const vectorfield & spins, indexQuadruplets & indices, scalarfield & magnitude, scalarfield & Energy);
 
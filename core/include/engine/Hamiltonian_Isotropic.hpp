@@ -3,10 +3,13 @@
 #define HAMILTONIAN_ISOTROPIC_NEW_H
 
 #include <vector>
+#include <array>
+#include <memory>
 
 #include "Core_Defines.h"
 #include <engine/Vectormath_Defines.hpp>
 #include <engine/Hamiltonian.hpp>
+#include <engine/Dipole_Solver.hpp>
 #include <data/Geometry.hpp>
 
 namespace Engine
@@ -15,16 +18,47 @@ namespace Engine
 	class Hamiltonian_Isotropic : public Hamiltonian
 	{
 	public:
+		// The neighbour lists in compressed layout, see the members of the same names below
+		struct Neighbour_Lists
+		{
+			intfield neigh_offset, neigh;
+			vectorfield dm_normal;
+			intfield dd_offset, dd_neigh;
+			vectorfield dd_normal;
+			scalarfield dd_distance;
+			int max_n_4spin;
+			intfield n_4spin_offset;
+			std::vector<std::array<int, 3>> neigh_4spin;
+		};
+		// Calculate the neighbour lists of a geometry, the Dipole-Dipole neighbours only if with_dd is set
+		static Neighbour_Lists Create_Neighbour_Lists(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions,
+			int n_neigh_shells, scalar dd_radius, bool with_dd);
+
 		// Constructor
+		//		If dipole_solver is given, it replaces the Dipole-Dipole neighbours within dd_radius
+		Hamiltonian_Isotropic(std::vector<bool> boundary_conditions, scalar external_field_magnitude, Vector3 external_field_normal, scalar mu_s,
+			scalar anisotropy_magnitude, Vector3 anisotropy_normal,
+			int n_neigh_shells, std::vector<scalar> jij, scalar dij, scalar bij, scalar kijkl, scalar dd_radius, Data::Geometry geometry,
+			std::shared_ptr<Dipole_Solver> dipole_solver = nullptr);
+		// Constructor from neighbour lists which have already been calculated (e.g. read from a compiled Hamiltonian)
 		Hamiltonian_Isotropic(std::vector<bool> boundary_conditions, scalar external_field_magnitude, Vector3 external_field_normal, scalar mu_s,
 			scalar anisotropy_magnitude, Vector3 anisotropy_normal,
-			int n_neigh_shells, std::vector<scalar> jij, scalar dij, scalar bij, scalar kijkl, scalar dd_radius, Data::Geometry geometry);
+			int n_neigh_shells, std::vector<scalar> jij, scalar dij, scalar bij, scalar kijkl, scalar dd_radius, Neighbour_Lists neighbours,
+			std::shared_ptr<Dipole_Solver> dipole_solver = nullptr);
 		
 		void Update_Energy_Contributions() override;
 		
 		void Hessian(const vectorfield & spins, MatrixX & hessian) override;
 		void Gradient(const vectorfield & spins, vectorfield & gradient) override;
+		// Evaluates the fields of several configurations in one sweep over the neighbour lists
+		//		(falls back to Gradient per configuration with 4-spin or Dipole-Dipole neighbours)
+		void Gradient_Batch(const std::vector<std::shared_ptr<vectorfield>> & spins, std::vector<vectorfield> & gradients) override;
 		void Energy_Contributions_per_Spin(const vectorfield & spins, std::vector<std::pair<std::string, scalarfield>> & contributions) override;
+		void Energy_and_Gradient(const vectorfield & spins, vectorfield & gradient, std::vector<std::pair<std::string, scalar>> & energy_contributions) override;
+		// Calculated from the neighbours of spin ispin (from the whole system with a dipole_solver)
+		scalar Energy_Difference(const vectorfield & spins, int ispin, const Vector3 & spin_new) override;
+		// The pair, Dipole-Dipole and 4-spin neighbours (false with a dipole_solver)
+		bool Interacting_Spins(int nos, intfield & offset, intfield & interacting) override;
 
 		// Hamiltonian name as string
 		const std::string& Name() override;
@@ -41,44 +75,49 @@ namespace Engine
 		// -------------------- Two Spin Interactions ------------------
 		// number of pairwise interaction shells
 		int n_neigh_shells;
-		// number of spins in shell ns_in_shell[
-		std::vector<std::vector<int>> n_spins_in_shell;
-		// Neighbours of each spin neigh[nos][n_shell][max_n_in_shell[n_shell]]
-		std::vector<std::vector<std::vector<int>>> neigh;
+		// Neighbours of each spin in compressed (CSR) layout: the neighbours of spin ispin in shell
+		// ishell are neigh[k] for neigh_offset[ispin*n_neigh_shells + ishell] <= k < neigh_offset[ispin*n_neigh_shells + ishell + 1]
+		intfield neigh_offset;		// [nos*n_neigh_shells + 1]
+		intfield neigh;				// [n_pairs]
 
 		// Exchange Interaction
 		std::vector<scalar> jij;
+		// Exchange constant of each neighbour pair, i.e. jij of its shell [n_pairs]
+		scalarfield neigh_jij;
 		// DMI
 		scalar dij;
-		// DM normal vectors [nos][max_n_in_shell[n_shell]]
-		std::vector<vectorfield> dm_normal;
+		// DM normal vectors, with the same layout as neigh (only set in the first shell) [n_pairs]
+		vectorfield dm_normal;
 		// Biquadratic Exchange
 		scalar bij;
 		// Dipole Dipole radius
 		scalar dd_radius;
-		// Dipole Dipole neighbours of each spin neigh_dd[nos][max_n]
-		std::vector<std::vector<int>> dd_neigh;
-		// Dipole Dipole neighbour positions of each spin neigh_dd[nos][max_n]
-		std::vector<std::vector<Vector3>> dd_neigh_pos;
-		// Dipole Dipole normal vectors [nos][max_n]
-		std::vector<vectorfield> dd_normal;
-		// Dipole Dipole distance [nos][max_n]
-		std::vector<std::vector<scalar>> dd_distance;
+		// Dipole Dipole neighbours of each spin in CSR layout: dd_neigh[k] for dd_offset[ispin] <= k < dd_offset[ispin+1]
+		intfield dd_offset;			// [nos+1]
+		intfield dd_neigh;			// [n_dd_pairs]
+		// Dipole Dipole normal vectors [n_dd_pairs]
+		vectorfield dd_normal;
+		// Dipole Dipole distance [n_dd_pairs]
+		scalarfield dd_distance;
+		// Dipole Dipole interaction of the whole system via FFT or octree
+		std::shared_ptr<Dipole_Solver> dipole_solver;
 
 		// -------------------- Four Spin Interactions ------------------
 		// Four Spin
 		scalar kijkl;
 		// Maximum number of 4-Spin interactions per spin
 		int max_n_4spin;
-		// actual number of 4-Spin interactions for each spin number_t4_spin[nos]
-		std::vector<int> n_4spin;
-		// 4 spin interaction neighbours: neigh_4spin[dim][nos][number_t4_spin[nos]]
-		std::vector<std::vector<std::vector<int>>> neigh_4spin;
+		// 4 spin interaction neighbours in CSR layout: (j, k, l) = neigh_4spin[t] for n_4spin_offset[ispin] <= t < n_4spin_offset[ispin+1]
+		intfield n_4spin_offset;	// [nos+1]
+		std::vector<std::array<int, 3>> neigh_4spin;
+		// The 4 spin interactions in which each spin takes part (as any of the four spins), in CSR layout:
+		//		(i, t) = quadruplets_of_spin[q] for quadruplets_of_spin_offset[ispin] <= q < quadruplets_of_spin_offset[ispin+1],
+		//		where i is the spin owning the interaction t in neigh_4spin. Calculated in Update_Energy_Contributions.
+		intfield quadruplets_of_spin_offset;	// [nos+1]
+		std::vector<std::array<int, 2>> quadruplets_of_spin;
 
-		// segments[nos][4]
-		std::vector<std::vector<int>> segments;
-		// Position of the Segments: segments_pos[nos][4]
-		std::vector<std::vector<Vector3>> segments_pos;
+		// Memory used by the neighbour lists in bytes
+		std::size_t Neighbours_Memory_Footprint();
 
 	private:
 		// -------------------- Effective Field Functions ------------------
@@ -7,9 +7,12 @@
 #include <data/Spin_System_Chain.hpp>
 #include <data/Parameters_Method.hpp>
 #include <utility/Timing.hpp>
+#include <utility/IO_Binary_File.hpp>
 
 #include <deque>
 #include <fstream>
+#include <functional>
+#include <cstdint>
 
 namespace Engine
 {
@@ -42,6 +45,11 @@ namespace Engine
 		// Finalize the optimization of the systems
 		virtual void Finalize();
 
+		// Save and restore the internal state needed to continue the iterations exactly (see Optimizer::Save_Checkpoint).
+		//		Derived classes which override these should call them first.
+		virtual void Save_State(Utility::IO::Binary_Writer & writer);
+		virtual void Load_State(Utility::IO::Binary_Reader & reader);
+
 		// Method name as string
 		virtual std::string Name();
 		// Method name as enum
@@ -61,6 +69,18 @@ namespace Engine
 		virtual scalar Force_on_Image_MaxAbsComponent(const vectorfield & image, vectorfield force) final;
 		// Check if iterations_allowed
 		virtual bool Iterations_Allowed();
+
+		// Snapshot of a system for the asynchronous output (see Utility::IO::Queue_Output).
+		//		The spins and energies are copied into one of two buffers, which share the Hamiltonian and geometry
+		//		of the system, so that the next snapshot can be taken while the last one is being written.
+		std::shared_ptr<Data::Spin_System> Output_Snapshot(std::shared_ptr<Data::Spin_System> system);
+		// Queue the task writing the last snapshot
+		void Queue_Output(std::function<void()> task);
+
+	private:
+		std::shared_ptr<Data::Spin_System> output_buffers[2];
+		std::uint64_t output_tickets[2];
+		int output_buffer;
 	};
 }
 
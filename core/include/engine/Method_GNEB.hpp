@@ -37,6 +37,10 @@ namespace Engine
 
 		// Sets iteration_allowed to false for the chain
 		void Finalize() override;
+
+		// The types (climbing, falling, ...) of the images
+		void Save_State(Utility::IO::Binary_Writer & writer) override;
+		void Load_State(Utility::IO::Binary_Reader & reader) override;
 		
 		bool Iterations_Allowed() override;
 
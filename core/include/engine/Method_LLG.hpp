@@ -16,12 +16,18 @@ namespace Engine
 {
 	/*
 		The Landau-Lifshitz-Gilbert (LLG) method
+			Either a single image is iterated, or all images of a chain are iterated at once as replicas
+			of the same system, each with its own LLG parameters (e.g. temperature and seed).
+			The replicas can exchange their configurations in parallel tempering swaps.
 	*/
 	class Method_LLG : public Method
 	{
 	public:
         // Constructor
 		Method_LLG(std::shared_ptr<Data::Spin_System> system, int idx_img, int idx_chain);
+		// Constructor for the images of a chain as replicas
+		//		The method parameters (number of iterations, output, swaps) are taken from the first image.
+		Method_LLG(std::shared_ptr<Data::Spin_System_Chain> chain, int idx_chain);
     
 		// Calculate Forces onto Systems
 		void Calculate_Force(std::vector<std::shared_ptr<vectorfield>> configurations, std::vector<vectorfield> & forces) override;
@@ -42,11 +48,32 @@ namespace Engine
 		// Sets iteration_allowed to false for the corresponding method
 		void Finalize() override;
 
+		// The convergence state of the images
+		void Save_State(Utility::IO::Binary_Writer & writer) override;
+		void Load_State(Utility::IO::Binary_Reader & reader) override;
+
+		// Maximum absolute force component of each image
+		std::vector<scalar> force_maxAbsComponent_image;
+		// Numbers of attempted and accepted parallel tempering swaps of the images r and r+1 [noi-1]
+		std::vector<long int> n_swaps_attempted;
+		std::vector<long int> n_swaps_accepted;
+
+	protected:
+		// Iterations are allowed as long as they are allowed for all images
+		bool Iterations_Allowed() override;
+
 	private:
 		// Last calculated forces
 		std::vector<vectorfield> F_total;
 		// Convergence parameters
 		std::vector<bool> force_converged;
+		// Number of iterations done by this method and number of swap steps
+		std::int64_t n_iterations_done;
+		std::int64_t n_swap_steps;
+
+		// Parallel tempering: alternately the even or odd pairs of neighbouring images exchange
+		//		their configurations with the Metropolis probability min(1, exp((1/kT_r - 1/kT_r+1)(E_r - E_r+1)))
+		void Swap_Replicas();
     };
 }
 
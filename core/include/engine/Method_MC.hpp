@@ -0,0 +1,78 @@
+#pragma once
+#ifndef METHOD_MC_H
+#define METHOD_MC_H
+
+#include "Core_Defines.h"
+#include <engine/Method.hpp>
+#include <data/Spin_System.hpp>
+#include <data/Parameters_Method_LLG.hpp>
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace Engine
+{
+	/*
+		The Metropolis Monte Carlo (MC) method
+			Each iteration is a sweep over all spins, in which a trial move of each spin (in a cone around it or
+			uniformly on the sphere) is accepted with the probability min(1, exp(-dE/kT)).
+			The energy differences are calculated locally (see Hamiltonian::Energy_Difference). The spins are coloured
+			such that spins of the same colour do not interact, so that the spins of one colour are updated in parallel.
+			The temperature, seed, number of iterations and output are taken from the LLG parameters of the system.
+	*/
+	class Method_MC : public Method
+	{
+	public:
+		// Constructor
+		Method_MC(std::shared_ptr<Data::Spin_System> system, int idx_img, int idx_chain);
+
+		// One Metropolis sweep over all spins
+		void Sweep();
+
+		// Monte Carlo does not use the forces
+		void Calculate_Force(std::vector<std::shared_ptr<vectorfield>> configurations, std::vector<vectorfield> & forces) override;
+		// The sampling is never converged
+		bool Force_Converged() override;
+
+		// Method name as string
+		std::string Name() override;
+
+		// Save the current Step's Data: spins and energy
+		void Save_Current(std::string starttime, int iteration, bool initial=false, bool final=false) override;
+		// A hook into the Optimizer before an Iteration
+		void Hook_Pre_Iteration() override;
+		// A hook into the Optimizer after an Iteration: logs the acceptance ratio and sweeps per second
+		void Hook_Post_Iteration() override;
+
+		// Sets iteration_allowed to false
+		void Finalize() override;
+
+		// The sweep counter, cone angle and acceptance statistics
+		void Save_State(Utility::IO::Binary_Writer & writer) override;
+		void Load_State(Utility::IO::Binary_Reader & reader) override;
+
+		// Acceptance ratio of the last sweep
+		scalar acceptance_ratio;
+		// Current opening angle of the cone [rad]
+		scalar cone_angle;
+		// Number of colours of the spins, i.e. of sequential parts of a sweep
+		int Number_of_Colours();
+		// Spins of each colour, i.e. spins which do not interact with each other
+		std::vector<intfield> colours;
+
+	private:
+		// Whether the spins of one colour can be updated in parallel (not if the interactions are not local)
+		bool parallel;
+		// Number of sweeps done, which determines the random numbers
+		std::int64_t n_sweeps;
+		// Accepted and attempted moves since the last log
+		std::int64_t n_accepted_log, n_attempted_log;
+		std::chrono::time_point<std::chrono::system_clock> t_last_log;
+
+		// Greedy colouring of the interaction graph
+		void Colour_Spins();
+	};
+}
+
+#endif
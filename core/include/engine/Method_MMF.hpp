@@ -44,7 +44,7 @@ namespace Engine
 		bool switched1, switched2;
 		std::shared_ptr<Data::Spin_System_Chain_Collection> collection;
 
-		std::vector<MatrixX> hessian;
+		std::vector<SpMatrixX> hessian;
 		// Last calculated forces
 		std::vector<vectorfield> F_gradient;
 		// Last calculated minimum mode
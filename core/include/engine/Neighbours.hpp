@@ -7,12 +7,27 @@
 #include <engine/Vectormath_Defines.hpp>
 
 #include <vector>
+#include <array>
 #include <memory>
 
 namespace Engine
 {
 	namespace Neighbours
 	{
+		// A neighbour of a basis atom: the basis atom jatom in the cell translated by translation[0..2]
+		struct Neighbour_Offset
+		{
+			int iatom, jatom;
+			int translation[3];
+			// Vector from iatom to the translated jatom and its length
+			Vector3 vector_ij;
+			scalar distance;
+		};
+
+		// Calculates the offsets to all basis atoms (in translated cells) within radius of each basis atom.
+		//		The translations are bounded by radius and by max_translations, so this does not depend on the number of cells.
+		std::vector<Neighbour_Offset> Get_Neighbour_Offsets(const Data::Geometry & geometry, const scalar radius, const std::vector<int> & max_translations);
+
 		// creates Neighbours
 		void Create_Neighbours(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions,
 			const int n_shells, std::vector<std::vector<int>> &n_spins_in_shell,
@@ -21,6 +36,14 @@ namespace Engine
 			std::vector<vectorfield> &dm_normal,
 			std::vector<std::vector<int>> &segments, std::vector<std::vector<Vector3>> &segments_pos);
 
+		// creates the same Neighbours, DM normal vectors and 4-spin Neighbours as Create_Neighbours directly in compressed layout,
+		//		without the lists padded to the maximum number of neighbours: the neighbours of spin ispin in shell are
+		//		neigh[k] with DM normal vector dm_normal[k] (zero beyond the first shell) for neigh_offset[ispin*n_shells + shell] <= k
+		//		< neigh_offset[ispin*n_shells + shell + 1] and its 4-spin neighbours are neigh_4spin[n_4spin_offset[ispin] .. n_4spin_offset[ispin+1])
+		void Create_Neighbours_Compressed(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions,
+			const int n_shells, intfield & neigh_offset, intfield & neigh, vectorfield & dm_normal,
+			int & max_n_4spin, intfield & n_4spin_offset, std::vector<std::array<int, 3>> & neigh_4spin);
+
 		// calculates shell radii for every shell
 		std::vector<scalar> Get_Shell_Radius(const Data::Geometry & geometry, const int n_shells);
 
@@ -33,6 +56,16 @@ namespace Engine
 			const std::vector<Vector3> &boundary_vectors, std::vector<std::vector<int>> &n_spins_in_shell,
 			std::vector<std::vector<std::vector<int>>> & neigh, std::vector<std::vector<std::vector<Vector3>>> & neigh_pos, const bool borderOnly);
 
+		// calculates the same neighbours as Get_Neighbours_in_Shells in compressed layout: the neighbours of atom iatom in shell
+		//		are neigh[k] at neigh_pos[k] for offset[iatom*n_shells + shell] <= k < offset[iatom*n_shells + shell + 1]
+		void Get_Neighbours_in_Shells_Compressed(const Data::Geometry & geometry, const int n_shells, const std::vector<scalar> & shell_radius,
+			const std::vector<Vector3> & boundary_vectors, intfield & offset, intfield & neigh, vectorfield & neigh_pos, const bool borderOnly);
+
+		// calculates the neighbours within all the shells by testing all pairs of atoms - O(N^2), kept as a reference for Get_Neighbours_in_Shells
+		void Get_Neighbours_in_Shells_Reference(const Data::Geometry & geometry, const int n_shells, const std::vector<scalar> & shell_radius,
+			const std::vector<Vector3> &boundary_vectors, std::vector<std::vector<int>> &n_spins_in_shell,
+			std::vector<std::vector<std::vector<int>>> & neigh, std::vector<std::vector<std::vector<Vector3>>> & neigh_pos, const bool borderOnly);
+
 		// calculates the 4Spin Neighbours
 		void Create_Neighbours_4Spin(const int nos, const int n_shells, const std::vector<std::vector<std::vector<int>>> & neigh, const std::vector<std::vector<int>> &n_spins_in_shell,
 			const int &max_n_4spin, std::vector<int> &n_4spin, std::vector<std::vector<std::vector<int>>> &neigh_4spin);
@@ -66,6 +99,11 @@ namespace Engine
 			const scalar dd_radius, std::vector<std::vector<int>> & dd_neigh, std::vector<std::vector<Vector3>>& dd_neigh_pos,
 			std::vector<vectorfield> & dd_normal, std::vector<std::vector<scalar>> & dd_distance);
 
+		// calculates the Dipole-Dipole neighbours in compressed layout: the neighbours of spin ispin are dd_neigh[k]
+		//		with dd_normal[k] and dd_distance[k] for dd_offset[ispin] <= k < dd_offset[ispin+1]
+		void Create_Dipole_Neighbours_Compressed(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions,
+			const scalar dd_radius, intfield & dd_offset, intfield & dd_neigh, vectorfield & dd_normal, scalarfield & dd_distance);
+
 		// Creates the boundary vectors for given boundary_conditions and geometry
 		std::vector<Vector3> Get_Boundary_Vectors(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions);
 
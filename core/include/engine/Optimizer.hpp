@@ -40,6 +40,12 @@ namespace Engine
 		virtual std::string Name();
 		virtual std::string FullName();
 
+		// Write a checkpoint of the simulation after the given number of iterations
+		void Save_Checkpoint(const std::string & file, int iteration);
+		// Continue the simulation from a checkpoint, i.e. restore the systems, the method and the optimizer.
+		//		Returns false, leaving everything unchanged, if the file does not exist or belongs to a different simulation.
+		bool Load_Checkpoint(const std::string & file, int & iteration);
+
 	protected:
 		// The Method instance with which to calculate the forces on configurations
 		std::shared_ptr<Engine::Method> method;
@@ -69,6 +75,11 @@ namespace Engine
 		// Check if a stop file is present -> Stop the iterations
 		virtual bool StopFilePresent() final;
 
+		// Save and restore the internal state needed to continue the iterations exactly, see Save_Checkpoint.
+		//		Derived classes which keep state between iterations should override these and call them first.
+		virtual void Save_State(Utility::IO::Binary_Writer & writer);
+		virtual void Load_State(Utility::IO::Binary_Reader & reader);
+
 		// Precision for the conversion of scalar to string
 		int print_precision;
 	};
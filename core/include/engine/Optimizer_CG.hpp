@@ -2,12 +2,23 @@
 #ifndef OPTIMIZER_CG_H
 #define OPTIMIZER_CG_H
 
+#include "Core_Defines.h"
 #include <engine/Optimizer.hpp>
 
 namespace Engine
 {
 	/*
-		Conjugate Gradient Optimizer
+		Conjugate Gradient Optimizer:
+			Nonlinear CG on the product of the spheres of the spins (Riemannian CG).
+			The spins are moved along great circles in the conjugate direction d, and d and the previous gradient
+			are parallel transported along these great circles into the tangent space of the new configuration.
+			The conjugation factor is the hybrid max(0, min(Polak-Ribiere, Fletcher-Reeves)), with a restart to
+			steepest descent whenever d is not a descent direction.
+			The line search is a secant step on the directional derivative: a trial step is accepted if the
+			directional derivative dropped sufficiently, otherwise the spins are moved to the secant minimum.
+			The gradient of the final configuration is reused in the next iteration, so an iteration
+			costs one or two force calculations.
+			The force of the method, projected onto the tangent spaces of the spins, is used as the negative gradient.
 	*/
 	class Optimizer_CG : public Optimizer
 	{
@@ -20,7 +31,39 @@ namespace Engine
 		// Optimizer name as string
 		std::string Name() override;
 		std::string FullName() override;
-    };
+
+	protected:
+		// The directions, gradients and steps
+		void Save_State(Utility::IO::Binary_Writer & writer) override;
+		void Load_State(Utility::IO::Binary_Reader & reader) override;
+
+	private:
+		// Maximum rotation of a spin in one step [rad]
+		scalar max_rotation = 0.5;
+		// A trial step is accepted if the directional derivative dropped below this fraction (in magnitude)
+		scalar curvature_condition = 0.5;
+
+		// Conjugate directions [noi][nos]
+		std::vector<vectorfield> direction;
+		// Gradients on the spheres at the configurations [noi][nos]
+		std::vector<vectorfield> gradient;
+		// Previous gradients, transported to the configurations [noi][nos]
+		std::vector<vectorfield> gradient_previous;
+		// Configurations at the start of the line search [noi][nos]
+		std::vector<vectorfield> spins_start;
+		// Configurations to which the gradients belong, to detect changes between the iterations [noi][nos]
+		std::vector<vectorfield> spins_gradient;
+		// Last step lengths along the directions and directional derivatives at the start of the steps [noi]
+		std::vector<scalar> step, slope;
+		// Whether the directions and previous gradients can be used
+		bool conjugate;
+
+		// The gradient on the spheres, i.e. minus the force projected onto the tangent spaces of the spins
+		void Tangent_Gradient(const vectorfield & spins, const vectorfield & force, vectorfield & out);
+		// Move spins along the great circles of direction*alpha, starting from start, and parallel transport
+		//		the tangent vectors in transport (which belong to start) along with them
+		void Rotate(const vectorfield & start, const vectorfield & direction, scalar alpha, vectorfield & spins, std::vector<vectorfield*> transport);
+	};
 }
 
-#endif
\ No newline at end of file
+#endif
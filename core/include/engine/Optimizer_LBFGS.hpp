@@ -0,0 +1,64 @@
+#pragma once
+#ifndef OPTIMIZER_LBFGS_H
+#define OPTIMIZER_LBFGS_H
+
+#include "Core_Defines.h"
+#include <engine/Optimizer.hpp>
+
+#include <deque>
+
+namespace Engine
+{
+	/*
+		Limited-memory BFGS Optimizer:
+			Quasi-Newton method in the rotation coordinates of the spins, i.e. each spin is moved by
+			the exponential map of a rotation vector (axis times angle) perpendicular to it.
+			In these coordinates the gradient of a spin is s x grad(E) = -s x F, where F is the force of the method.
+			The inverse Hessian is approximated from the last n_history steps and gradient differences
+			with the two-loop recursion. The step is taken without a line search, but no spin is rotated
+			by more than max_rotation, and the history is discarded if the direction is not a descent direction.
+			The history vectors of a spin are rotated along with it, so that they stay in its tangent space.
+			Each image has its own history, so one iteration costs one force calculation of the chain.
+			See also Ivanov et al., "Fast and robust algorithm for energy minimization of spin systems
+			applied in an analysis of high temperature spin configurations", Comp. Phys. Comm. 260 (2021).
+	*/
+	class Optimizer_LBFGS : public Optimizer
+	{
+	public:
+		Optimizer_LBFGS(std::shared_ptr<Engine::Method> method);
+
+		// One Iteration
+		void Iteration() override;
+
+		// Optimizer name as string
+		std::string Name() override;
+		std::string FullName() override;
+
+	protected:
+		// The histories
+		void Save_State(Utility::IO::Binary_Writer & writer) override;
+		void Load_State(Utility::IO::Binary_Reader & reader) override;
+
+	private:
+		// Number of steps in the history
+		int n_history = 5;
+		// Maximum rotation of a spin in one step [rad]
+		scalar max_rotation = 0.5;
+
+		// Gradients in rotation coordinates at the configurations [noi][nos]
+		std::vector<vectorfield> gradient;
+		// Rotation vectors of the last step [noi][nos]
+		std::vector<vectorfield> rotation;
+		// Configurations after the last step, to detect changes between the iterations [noi][nos]
+		std::vector<vectorfield> spins_step;
+		// Histories of the steps and gradient differences, the newest last [noi][n_history][nos]
+		std::vector<std::deque<vectorfield>> history_step, history_gradient;
+		// Whether the gradients belong to the last step, i.e. whether the next gradient difference can be stored
+		bool has_gradient;
+
+		// The gradients in rotation coordinates -s x F
+		void Rotation_Gradient(const vectorfield & spins, const vectorfield & force, vectorfield & out);
+	};
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef OPTIMIZER_MC_H
+#define OPTIMIZER_MC_H
+
+#include "Core_Defines.h"
+#include <engine/Optimizer.hpp>
+#include <engine/Method_MC.hpp>
+
+namespace Engine
+{
+	/*
+		Monte Carlo "Optimizer":
+			Each iteration is one Metropolis sweep of the Method_MC, so that the Monte Carlo sampling
+			uses the iteration loop (logging, output, checkpoints) of the optimizers.
+	*/
+	class Optimizer_MC : public Optimizer
+	{
+
+	public:
+		Optimizer_MC(std::shared_ptr<Engine::Method_MC> method);
+		
+		// One sweep
+		void Iteration() override;
+
+		// Optimizer name as string
+		std::string Name() override;
+		std::string FullName() override;
+
+	private:
+		std::shared_ptr<Engine::Method_MC> method_mc;
+	};
+}
+
+#endif
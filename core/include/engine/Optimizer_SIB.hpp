@@ -17,6 +17,10 @@ namespace Engine
 			The Spin System is optimized w.r.t. the force while following the physical LLG trajectory.
 			Note that this means this is not a direct optimizer and the system posesses "momentum".
 			Method taken from: Mentink et. al., Stable and fast semi-implicit integration of the stochastic Landau�Lifshitz equation, J. Phys.: Condens. Matter 22 (2010) 176001 (12pp)
+			With adaptive_dt and zero temperature, the predictor (a first order step) and the corrector (second order)
+			form an embedded pair: the largest difference of a spin between them estimates the error of the step.
+			A step is rejected and repeated with a smaller dt if this error exceeds dt_tolerance, and the next dt
+			is chosen by a PI controller within [dt_min, dt_max]. All images use the same dt.
 	*/
 	class Optimizer_SIB : public Optimizer
 	{
@@ -31,26 +35,38 @@ namespace Engine
 		std::string Name() override;
 		std::string FullName() override;
 
+	protected:
+		// The state of the time step control
+		void Save_State(Utility::IO::Binary_Writer & writer) override;
+		void Load_State(Utility::IO::Binary_Reader & reader) override;
+
     private:
 		// Temporary Spins arrays
 		std::vector<std::shared_ptr<vectorfield>> spins_temp;
 
-		// Virtual Heun Forces used in the Steps
-		std::vector<vectorfield> virtualforce;
-
-		// Random vector array
-		vectorfield xi;
+		// Random vector arrays of the images, as each image has its own temperature and seed
+		std::vector<vectorfield> xi;
 		// Some variable
 		scalar epsilon;
+		// Error estimate of the last accepted step relative to the tolerance, for the PI controller
+		scalar error_previous;
+		// Whether it was reported that the time step cannot be adapted at finite temperature
+		bool warned_adaptive;
+
+		// One step with the time step adapted to the error estimate, for zero temperature
+		void Iteration_Adaptive();
 
-		// Generate an array of random spins?
+		// Generate the thermal noise, i.e. Gaussian random vectors with standard deviation eps
 		void Gen_Xi(Data::Spin_System & s, vectorfield & xi, scalar eps);
-		// Calculate the virtual Heun force to be used in the Steps
-		void VirtualForce(const int nos, vectorfield & spins, Data::Parameters_Method_LLG & llg_params, vectorfield & gradient, vectorfield & xi, vectorfield & force);
-		// First Part of one Optimization step
-		void FirstStep(const int nos, vectorfield & spins, vectorfield & force, vectorfield & spins_temp);
-		// Second Part of one Optimization step
-		void SecondStep(const int nos, vectorfield & force, vectorfield & spins);
+		/*
+			One part of an Optimization step, fused into a single pass over the spins:
+				the virtual force A_i is calculated from spins_force, gradient and xi,
+				and the semi-implicit step e_i' = (1 + A_i x)^-1 (1 - A_i x) e_i is applied to spins.
+			The first part (predictor) writes (e_i + e_i')/2 to out, the second part (corrector) e_i'.
+			out may be the same field as spins.
+		*/
+		void Step(const vectorfield & spins, const vectorfield & spins_force, const Data::Parameters_Method_LLG & llg_params, scalar dt,
+			const vectorfield & gradient, const vectorfield & xi, vectorfield & out, bool predictor);
 
     };
 }
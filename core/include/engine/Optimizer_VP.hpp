@@ -21,6 +21,11 @@ namespace Engine
 		std::string Name() override;
 		std::string FullName() override;
 
+	protected:
+		// The velocity
+		void Save_State(Utility::IO::Binary_Writer & writer) override;
+		void Load_State(Utility::IO::Binary_Reader & reader) override;
+
 	private:
 		// "Mass of our particle" which we accelerate
 		scalar m = 1.0;
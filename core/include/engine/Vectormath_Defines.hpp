@@ -1,4 +1,5 @@
 #include <Eigen/Core>
+#include <Eigen/SparseCore>
 
 #include <vector>
 
@@ -9,6 +10,10 @@ typedef Eigen::Matrix<scalar, -1,  1> VectorX;
 typedef Eigen::Matrix<scalar,  1, -1> RowVectorX;
 typedef Eigen::Matrix<scalar, -1, -1> MatrixX;
 
+// Sparse Eigen typedefs
+typedef Eigen::SparseMatrix<scalar> SpMatrixX;
+typedef Eigen::Triplet<scalar> SpTriplet;
+
 // 3D Eigen typedefs
 typedef Eigen::Matrix<scalar, 3, 1> Vector3;
 typedef Eigen::Matrix<scalar, 1, 3> RowVector3;
@@ -0,0 +1,125 @@
+#pragma once
+#ifndef VECTORMATH_SOA_H
+#define VECTORMATH_SOA_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include <Eigen/Core>
+
+#include "Core_Defines.h"
+#include <engine/Vectormath_Defines.hpp>
+
+namespace Engine
+{
+	// Allocator for std::vector which aligns the data to Alignment bytes (a power of two)
+	template<typename T, std::size_t Alignment>
+	struct aligned_allocator
+	{
+		typedef T value_type;
+		template<typename U> struct rebind { typedef aligned_allocator<U, Alignment> other; };
+
+		aligned_allocator() {}
+		template<typename U> aligned_allocator(const aligned_allocator<U, Alignment> &) {}
+
+		T * allocate(std::size_t n)
+		{
+			// Over-allocate and store the original pointer in front of the aligned block
+			void * raw = ::operator new(n * sizeof(T) + Alignment + sizeof(void*));
+			std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + Alignment - 1) & ~(std::uintptr_t)(Alignment - 1);
+			reinterpret_cast<void**>(aligned)[-1] = raw;
+			return reinterpret_cast<T*>(aligned);
+		}
+		void deallocate(T * p, std::size_t)
+		{
+			::operator delete(reinterpret_cast<void**>(p)[-1]);
+		}
+
+		template<typename U> bool operator==(const aligned_allocator<U, Alignment> &) const { return true; }
+		template<typename U> bool operator!=(const aligned_allocator<U, Alignment> &) const { return false; }
+	};
+
+	// Scalarfield aligned to 64 bytes, i.e. to the size of an AVX-512 register and of a cache line
+	typedef std::vector<scalar, aligned_allocator<scalar, 64>> aligned_scalarfield;
+
+	/*
+		Vectorfield in structure-of-arrays layout: the x, y and z components of all vectors are stored
+		in separate aligned arrays, so that the Vectormath functions below can process several vectors
+		per SIMD instruction. Its Vectormath functions mirror the ones for the vectorfield.
+	*/
+	struct vectorfield_soa
+	{
+		aligned_scalarfield x, y, z;
+
+		vectorfield_soa(int n = 0) : x(n, 0), y(n, 0), z(n, 0) {}
+		explicit vectorfield_soa(const vectorfield & vf);
+
+		int size() const { return x.size(); }
+		void resize(int n) { x.resize(n, 0); y.resize(n, 0); z.resize(n, 0); }
+
+		Vector3 get(int i) const { return Vector3{ x[i], y[i], z[i] }; }
+		void set(int i, const Vector3 & v) { x[i] = v[0]; y[i] = v[1]; z[i] = v[2]; }
+
+		// Views of the components without copying, e.g. for use in Eigen expressions
+		Eigen::Map<VectorX> component(int dim) { return Eigen::Map<VectorX>((dim == 0 ? x : dim == 1 ? y : z).data(), size()); }
+		Eigen::Map<const VectorX> component(int dim) const { return Eigen::Map<const VectorX>((dim == 0 ? x : dim == 1 ? y : z).data(), size()); }
+	};
+
+	namespace Vectormath
+	{
+		// Name of the instruction set used by the functions below (avx512, avx2 or generic),
+		//		which is chosen at runtime according to the capabilities of the CPU
+		std::string SoA_Instruction_Set();
+
+		// Conversion between the layouts (the sizes are adjusted)
+		void assign(vectorfield_soa & out, const vectorfield & vf);
+		void assign(vectorfield & out, const vectorfield_soa & vf);
+
+		// sets vf := v
+		void fill(vectorfield_soa & vf, const Vector3 & v);
+
+		// Normalize the vectors of a vectorfield
+		void normalize_vectors(vectorfield_soa & vf);
+
+		// Scale a vectorfield by a given value
+		void scale(vectorfield_soa & vf, const scalar & sc);
+
+		// Sum over a vectorfield
+		Vector3 sum(const vectorfield_soa & vf);
+
+		// Calculate the mean of a vectorfield
+		Vector3 mean(const vectorfield_soa & vf);
+
+		// computes the inner product of two vectorfields v1 and v2
+		scalar dot(const vectorfield_soa & vf1, const vectorfield_soa & vf2);
+
+		// computes the inner products of vectors in v1 and v2
+		void dot(const vectorfield_soa & vf1, const vectorfield_soa & vf2, scalarfield & out);
+
+		// computes the vector (cross) products of vectors in v1 and v2
+		void cross(const vectorfield_soa & vf1, const vectorfield_soa & vf2, vectorfield_soa & out);
+
+		// out[i] += c*a
+		void add_c_a(const scalar & c, const Vector3 & a, vectorfield_soa & out);
+
+		// out[i] += c*a[i]
+		void add_c_a(const scalar & c, const vectorfield_soa & a, vectorfield_soa & out);
+
+		// out[i] += c * a*b[i]
+		void add_c_dot(const scalar & c, const Vector3 & a, const vectorfield_soa & b, scalarfield & out);
+
+		// out[i] += c * a[i]*b[i]
+		void add_c_dot(const scalar & c, const vectorfield_soa & a, const vectorfield_soa & b, scalarfield & out);
+
+		// out[i] += c * a x b[i]
+		void add_c_cross(const scalar & c, const Vector3 & a, const vectorfield_soa & b, vectorfield_soa & out);
+
+		// out[i] += c * a[i] x b[i]
+		void add_c_cross(const scalar & c, const vectorfield_soa & a, const vectorfield_soa & b, vectorfield_soa & out);
+	}
+}
+
+#endif
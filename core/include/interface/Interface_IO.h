@@ -9,6 +9,7 @@ struct State;
 #define IO_Fileformat_Regular_Pos   1   // px py pz sx sy sz (separated by whitespace)
 #define IO_Fileformat_CSV           2   // sx, sy, sz (separated by commas)
 #define IO_Fileformat_CSV_Pos       3   // px, py, pz, sx, sy, (sz separated by commas)
+#define IO_Fileformat_Binary        4   // binary trajectory of frames (reading loads the last frame)
 
 // From Config File
 DLLEXPORT int IO_System_From_Config(State * state, const char * file, int idx_image=-1, int idx_chain=-1);
@@ -33,5 +34,13 @@ DLLEXPORT void IO_Energies_Save(State * state, const char * file, int idx_chain
 DLLEXPORT void IO_Energies_Spins_Save(State * state, const char * file, int idx_chain = -1);
 DLLEXPORT void IO_Energies_Interpolated_Save(State * state, const char * file, int idx_chain = -1);
 
+// Asynchronous output of the simulations
+//		Number of output tasks which have not been written yet
+DLLEXPORT int IO_Output_Queue_Depth(State * state);
+//		Total number of bytes written by the output functions
+DLLEXPORT long long IO_Output_Bytes_Written(State * state);
+//		Wait until all queued output has been written
+DLLEXPORT void IO_Output_Flush(State * state);
+
 #include "DLL_Undefine_Export.h"
 #endif
\ No newline at end of file
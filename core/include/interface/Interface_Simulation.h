@@ -7,6 +7,10 @@ struct State;
 
 #include <vector>
 
+// Methods: "LLG" (of one image), "LLG_Replicas" (of all images of a chain as replicas, see Method_LLG), "MC" (Metropolis Monte Carlo
+//		of one image, which ignores the optimizer type, see Method_MC), "GNEB" and "MMF"
+// Optimizers: "SIB", "SIB2", "Heun", "CG", "VP" and "LBFGS"
+
 // Single Optimization iteration with a Method
 //		To be used with caution! It does not inquire if an iteration is allowed!
 DLLEXPORT void Simulation_SingleShot(State *state, const char * c_method_type, const char * c_optimizer_type, 
@@ -31,6 +35,17 @@ DLLEXPORT float Simulation_Get_MaxTorqueComponent(State * state, int idx_image =
 //		IF a MMF simulation is running this returns the IPS on the current collection.
 DLLEXPORT float Simulation_Get_IterationsPerSecond(State *state, int idx_image = -1, int idx_chain = -1);
 
+// Get the acceptance ratio of the last sweep of a running "MC" simulation (0 otherwise).
+//		The sweeps per second are given by Simulation_Get_IterationsPerSecond.
+DLLEXPORT float Simulation_Get_MC_AcceptanceRatio(State *state, int idx_image = -1, int idx_chain = -1);
+
+// Get the observables of the replicas of an "LLG_Replicas" simulation, i.e. of the images of a chain
+//		Energies and maximum torque components: one value per image.
+//		Swap acceptance rates: one value per pair of neighbouring images (0 if no swaps were attempted).
+DLLEXPORT void Simulation_Get_Replica_Energies(State * state, float * energies, int idx_chain = -1);
+DLLEXPORT void Simulation_Get_Replica_MaxTorqueComponents(State * state, float * torques, int idx_chain = -1);
+DLLEXPORT void Simulation_Get_Replica_Swap_Acceptance(State * state, float * rates, int idx_chain = -1);
+
 // Check for running simulations
 DLLEXPORT bool Simulation_Running_Any_Anywhere(State *state);
 DLLEXPORT bool Simulation_Running_LLG_Anywhere(State *state);
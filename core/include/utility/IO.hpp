@@ -8,6 +8,8 @@
 #include <fstream>
 #include <sstream>
 #include <type_traits>
+#include <functional>
+#include <cstdint>
 
 #include "Core_Defines.h"
 #include <interface/Interface_IO.h>
@@ -31,7 +33,16 @@ namespace Utility
 			CSV_POS_SPIN = IO_Fileformat_CSV_Pos,
 			CSV_SPIN = IO_Fileformat_CSV,
 			WHITESPACE_POS_SPIN = IO_Fileformat_Regular_Pos,
-			WHITESPACE_SPIN = IO_Fileformat_Regular
+			WHITESPACE_SPIN = IO_Fileformat_Regular,
+			BINARY_TRAJECTORY = IO_Fileformat_Binary
+		};
+
+		// Storage of the spins in the frames of a binary trajectory
+		enum class Trajectory_Compression
+		{
+			NONE = 0,				// double precision
+			SINGLE_PRECISION = 1,	// float, half the size
+			FIXED_POINT_16 = 2		// 16 bit integers, a quarter of the size with a resolution of 3e-5
 		};
 
 		// ------------------------------------------------------------
@@ -77,8 +88,10 @@ namespace Utility
 
 		// ========================= Fileparser =========================
 		void Read_Spin_Configuration_CSV(std::shared_ptr<Data::Spin_System> s, const std::string file);
-		void Read_Spin_Configuration(std::shared_ptr<Data::Spin_System> s, const std::string file, VectorFileFormat format = VectorFileFormat::CSV_POS_SPIN);
-		void Read_SpinChain_Configuration(std::shared_ptr<Data::Spin_System_Chain> c, const std::string file);
+		// The frame is only used for binary trajectories, negative values count from the last frame
+		void Read_Spin_Configuration(std::shared_ptr<Data::Spin_System> s, const std::string file, VectorFileFormat format = VectorFileFormat::CSV_POS_SPIN, int frame = -1);
+		// Text chain files separate the images by 'Image No' lines, binary trajectories contain one frame per image
+		void Read_SpinChain_Configuration(std::shared_ptr<Data::Spin_System_Chain> c, const std::string file, VectorFileFormat format = VectorFileFormat::WHITESPACE_SPIN);
 		//External_Field_from_File ....
 		void Anisotropy_from_File(const std::string anisotropyFile, Data::Geometry geometry, int & n_indices,
 			intfield & anisotropy_index, scalarfield & anisotropy_magnitude,
@@ -95,6 +108,30 @@ namespace Utility
 		// Saves Spin_Chain_Configuration to file
 		void Save_SpinChain_Configuration(std::shared_ptr<Data::Spin_System_Chain> & c, const std::string fileName);
 
+		// =========================== Binary Trajectories ===========================
+		// A binary trajectory holds the geometry and any number of frames (iteration, energy and spins),
+		// which can be appended and read in any order. It is much smaller and faster than the text formats.
+		// Append the current spins of a system as a new frame, the file is created if necessary
+		void Append_Trajectory_Frame(std::shared_ptr<Data::Spin_System> & s, const int iteration, const std::string fileName,
+			Trajectory_Compression compression = Trajectory_Compression::NONE);
+		// Saves the images of a chain as the frames of a new trajectory
+		void Save_SpinChain_Trajectory(std::shared_ptr<Data::Spin_System_Chain> & c, const std::string fileName,
+			Trajectory_Compression compression = Trajectory_Compression::NONE);
+		// Number of frames of a trajectory (0 if the file is not a trajectory)
+		int Trajectory_N_Frames(const std::string fileName);
+		// Reads a frame into an existing Spin_System, negative values count from the last frame.
+		//		Optionally returns the iteration and energy stored with the frame.
+		void Read_Trajectory_Frame(std::shared_ptr<Data::Spin_System> s, const std::string fileName, int frame,
+			int * iteration = nullptr, scalar * energy = nullptr);
+
+		// =========================== Compiled Hamiltonians ===========================
+		// Hash of a config file and the interaction files it references, which identifies a compiled Hamiltonian
+		std::uint64_t Hamiltonian_Cache_Key(const std::string configFile);
+		// Writes the geometry and all arrays of an isotropic or anisotropic Hamiltonian into a binary file
+		void Save_Compiled_Hamiltonian(const std::string file, std::uint64_t key, const Data::Geometry & geometry, Engine::Hamiltonian & hamiltonian);
+		// Reads geometry and Hamiltonian from a binary file, returns false if it does not exist or has a different key
+		bool Load_Compiled_Hamiltonian(const std::string file, std::uint64_t key, std::unique_ptr<Data::Geometry> & geometry, std::unique_ptr<Engine::Hamiltonian> & hamiltonian);
+
 		// =========================== Saving Energies ===========================
 		void Write_Energy_Header(Data::Spin_System & s, const std::string fileName, std::vector<std::string> firstcolumns={"iteration", "E_tot"}, bool contributions=true);
 		// Appends the current Energy of the current image with energy contributions, without header
@@ -121,6 +158,24 @@ namespace Utility
 		// Appends the contents of the string 'text' onto a file
 		void Append_String_to_File(const std::string text, const std::string name);
 
+		// ========================= Asynchronous Output =========================
+		// Output tasks are executed one after the other on a dedicated I/O thread, if CORE_USE_THREADS is
+		// defined (otherwise immediately), so that the simulation does not wait for the disk.
+		// Queue a task and return its ticket. If the queue is full, this blocks until a task has finished.
+		std::uint64_t Queue_Output(std::function<void()> task);
+		// Wait until the task with the given ticket (and all before it) has finished
+		void Wait_For_Output(std::uint64_t ticket);
+		// Wait until all queued output has been written
+		void Flush_Output();
+		// Set the maximum number of queued tasks (default 4)
+		void Set_Output_Queue_Capacity(int capacity);
+		// Number of queued tasks which have not finished yet
+		int Output_Queue_Depth();
+		// Total number of bytes written by the output functions
+		std::uint64_t Output_Bytes_Written();
+		// Used by the output functions to count the bytes they have written
+		void Count_Output_Bytes(std::size_t n_bytes);
+
 		// ========================= Other Helpers =========================
 		// Convert an int to a formatted string
 		std::string int_to_formatted_string(int in, int n = 6);
@@ -0,0 +1,122 @@
+#pragma once
+#ifndef UTILITY_IO_BINARYFILE_H
+#define UTILITY_IO_BINARYFILE_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include <utility/IO_Mapped_File.hpp>
+
+namespace Utility
+{
+	namespace IO
+	{
+		/*
+			Binary files consisting of a header and a sequence of arrays, each stored as
+				uint64    number of elements
+				uint64    size of an element in bytes
+				          data, padded to a multiple of 8 bytes
+			Single values are stored as arrays of length one. As the data of every array is 8-byte aligned
+			and in the memory layout of the writing machine, the arrays can be copied directly from a mapped file.
+			Used by the compiled Hamiltonians and the checkpoints.
+		*/
+		class Binary_Writer
+		{
+		public:
+			Binary_Writer(const std::string & filename) : file(filename, std::ios::out | std::ios::binary | std::ios::trunc), out(file) {}
+			// Write to a stream instead of a file, e.g. to keep a state in memory
+			Binary_Writer(std::ostream & stream) : out(stream) {}
+
+			template<typename T>
+			void Write_Raw(const T & value)
+			{
+				out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+			}
+
+			template<typename T>
+			void Write_Data(const T * data, std::uint64_t n)
+			{
+				Write_Raw<std::uint64_t>(n);
+				Write_Raw<std::uint64_t>(sizeof(T));
+				out.write(reinterpret_cast<const char *>(data), n * sizeof(T));
+				static const char padding[8] = { 0 };
+				out.write(padding, (8 - (n * sizeof(T)) % 8) % 8);
+			}
+
+			template<typename V>
+			void Write_Array(const V & v) { Write_Data(v.data(), v.size()); }
+
+			template<typename T>
+			void Write_Value(const T & value) { Write_Data(&value, 1); }
+
+			// The number of arrays followed by the arrays
+			template<typename V>
+			void Write_Arrays(const std::vector<V> & v)
+			{
+				Write_Value<std::int32_t>(v.size());
+				for (auto & a : v) Write_Array(a);
+			}
+
+			std::ofstream file;
+			std::ostream & out;
+		};
+
+		class Binary_Reader
+		{
+		public:
+			// ok is set to false as soon as the data does not match what is read
+			Binary_Reader(const Mapped_File & mapped) : p(mapped.Begin()), end(mapped.End()), ok(true) {}
+			Binary_Reader(const std::string & data) : p(data.data()), end(data.data() + data.size()), ok(true) {}
+
+			template<typename T>
+			T Read_Raw()
+			{
+				T value{};
+				if (end - p < (std::ptrdiff_t)sizeof(T)) { ok = false; return value; }
+				std::memcpy(&value, p, sizeof(T));
+				p += sizeof(T);
+				return value;
+			}
+
+			template<typename V>
+			void Read_Array(V & v)
+			{
+				std::uint64_t n = Read_Raw<std::uint64_t>();
+				std::uint64_t element_size = Read_Raw<std::uint64_t>();
+				std::uint64_t bytes = n * element_size;
+				if (!ok || element_size != sizeof(typename V::value_type) || (std::uint64_t)(end - p) < bytes) { ok = false; return; }
+				v.resize(n);
+				if (bytes > 0) std::memcpy(static_cast<void *>(&v[0]), p, bytes);
+				p += bytes + (8 - bytes % 8) % 8;
+			}
+
+			template<typename T>
+			T Read_Value()
+			{
+				std::vector<T> v;
+				Read_Array(v);
+				if (v.size() != 1) { ok = false; return T{}; }
+				return v[0];
+			}
+
+			template<typename V>
+			void Read_Arrays(std::vector<V> & v)
+			{
+				std::int32_t n = Read_Value<std::int32_t>();
+				if (!ok || n < 0) { ok = false; return; }
+				v.resize(n);
+				for (auto & a : v) Read_Array(a);
+			}
+
+			const char * p;
+			const char * end;
+			bool ok;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef UTILITY_IO_MAPPEDFILE_H
+#define UTILITY_IO_MAPPEDFILE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <engine/Vectormath_Defines.hpp>
+
+namespace Utility
+{
+	namespace IO
+	{
+		/*
+			Read-only view of the whole contents of a file.
+			On POSIX systems the file is mapped into memory, otherwise it is read into a buffer.
+			The contents are not null-terminated, use End() to bound the parsing.
+		*/
+		class Mapped_File
+		{
+		public:
+			// Maps the file, throws Utility::Exception::File_not_Found if it cannot be opened
+			Mapped_File(const std::string & filename);
+			~Mapped_File();
+			Mapped_File(const Mapped_File &) = delete;
+			Mapped_File & operator=(const Mapped_File &) = delete;
+
+			const char * Begin() const { return this->data; }
+			const char * End() const { return this->data + this->size; }
+			std::size_t Size() const { return this->size; }
+
+			// Splits the contents into at most n_chunks ranges [chunks[i], chunks[i+1]),
+			// whose boundaries are at the beginning of a line
+			std::vector<const char *> Line_Chunks(int n_chunks) const;
+
+		private:
+			const char * data;
+			std::size_t size;
+			bool mapped;
+			// Only used if the file could not be mapped
+			std::vector<char> buffer;
+		};
+
+		// Parses a scalar from [begin, end) without allocating, returns the position after it
+		// or begin if there is no number at begin
+		const char * Parse_Scalar(const char * begin, const char * end, scalar & value);
+	}
+}
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef UTILITY_RANDOM_H
+#define UTILITY_RANDOM_H
+
+#include <array>
+#include <cstdint>
+
+#include "Core_Defines.h"
+#include <engine/Vectormath_Defines.hpp>
+
+namespace Utility
+{
+	namespace Random
+	{
+		/*
+			The counter-based pseudo random number generator Philox4x32-10
+			(Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC 2011).
+			Each counter gives four independent 32 bit random numbers for a key, without any state,
+			so that the random numbers can be generated in any order and on any number of threads.
+		*/
+		inline std::array<uint32_t, 4> Philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key)
+		{
+			for (int round = 0; round < 10; ++round)
+			{
+				uint64_t product0 = (uint64_t)0xD2511F53 * counter[0];
+				uint64_t product1 = (uint64_t)0xCD9E8D57 * counter[2];
+				counter = { (uint32_t)(product1 >> 32) ^ counter[1] ^ key[0], (uint32_t)product1,
+							(uint32_t)(product0 >> 32) ^ counter[3] ^ key[1], (uint32_t)product0 };
+				key[0] += 0x9E3779B9;
+				key[1] += 0xBB67AE85;
+			}
+			return counter;
+		}
+
+		// Uniform random number in the open interval (0,1), with 53 random bits taken from a and b
+		inline scalar Uniform_Open(uint32_t a, uint32_t b)
+		{
+			uint64_t bits = ((uint64_t)(a >> 5) << 26) | (b >> 6);
+			return (bits + 0.5) / 9007199254740992.0;
+		}
+
+		/*
+			The fields below are filled with the random numbers of the counter (ispin, block, iteration),
+			where block = 0, 1 and the key is (seed, 0), i.e. each variate is determined by
+			(seed, iteration, spin, component) only. This makes the fields independent of the number
+			of threads, and a stochastic trajectory can be restarted from any iteration.
+		*/
+
+		// Fill vf with Gaussian random numbers with mean 0 and standard deviation sigma
+		void Fill_Gaussian(vectorfield & vf, scalar sigma, int seed, uint64_t iteration);
+
+		// Fill vf with uniform random numbers in (min, max)
+		void Fill_Uniform(vectorfield & vf, scalar min, scalar max, int seed, uint64_t iteration);
+	}
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef UTILITY_THREADING_H
+#define UTILITY_THREADING_H
+
+#include <functional>
+
+#include "Core_Defines.h"
+
+namespace Utility
+{
+	namespace Threading
+	{
+		// Returns the number of threads used for parallel loops
+		int Get_N_Threads();
+		// Set the number of threads used for parallel loops (0 means the number of hardware threads)
+		void Set_N_Threads(int n_threads);
+
+		/*
+			Execute f(begin, end) on contiguous chunks [begin, end) which together cover [0, n).
+			The chunks are processed in parallel by a pool of threads, if CORE_USE_THREADS is defined.
+			The partitioning into chunks only depends on n and the number of threads.
+			The optional max_threads restricts the number of threads (and chunks) used for this loop.
+			Calls from within a parallel loop, or while the pool is busy with another loop,
+			are executed serially, so nested parallelism does not oversubscribe the machine.
+		*/
+		void Parallel_For(int n, const std::function<void(int begin, int end)> & f, int max_threads = 0);
+	}
+}
+
+#endif
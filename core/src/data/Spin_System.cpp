@@ -29,6 +29,10 @@ namespace Data
 		this->E_array = std::vector<std::pair<std::string, scalar>>(0);
 		this->effective_field = vectorfield(this->nos);
 
+		// The observables have not been calculated yet
+		this->spins_version = 1;
+		this->energy_version = 0;
+		this->effective_field_version = 0;
 	}//end Spin_System constructor
 
 	 // Copy Constructor
@@ -40,21 +44,13 @@ namespace Data
 		this->E = other.E;
 		this->E_array = other.E_array;
 		this->effective_field = other.effective_field;
+		this->spins_version = other.spins_version;
+		this->energy_version = other.energy_version;
+		this->effective_field_version = other.effective_field_version;
 
-		this->geometry = std::shared_ptr<Data::Geometry>(new Data::Geometry(*other.geometry));
-		
-		if (other.hamiltonian->Name() == "Isotropic Heisenberg")
-		{
-			this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Isotropic(*(Engine::Hamiltonian_Isotropic*)(other.hamiltonian.get())));
-		}
-		else if (other.hamiltonian->Name() == "Anisotropic Heisenberg")
-		{
-			this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Anisotropic(*(Engine::Hamiltonian_Anisotropic*)(other.hamiltonian.get())));
-		}
-		else if (other.hamiltonian->Name() == "Gaussian")
-		{
-			this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Gaussian(*(Engine::Hamiltonian_Gaussian*)(other.hamiltonian.get())));
-		}
+		// The geometry and Hamiltonian are shared, see Unshare_Hamiltonian
+		this->geometry = other.geometry;
+		this->hamiltonian = other.hamiltonian;
 
 		this->llg_parameters = std::shared_ptr<Data::Parameters_Method_LLG>(new Data::Parameters_Method_LLG(*other.llg_parameters));
 
@@ -72,21 +68,13 @@ namespace Data
 			this->E = other.E;
 			this->E_array = other.E_array;
 			this->effective_field = other.effective_field;
+			this->spins_version = other.spins_version;
+			this->energy_version = other.energy_version;
+			this->effective_field_version = other.effective_field_version;
 
-			this->geometry = std::shared_ptr<Data::Geometry>(new Data::Geometry(*other.geometry));
-			
-			if (other.hamiltonian->Name() == "Isotropic Heisenberg")
-			{
-				this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Isotropic(*(Engine::Hamiltonian_Isotropic*)(other.hamiltonian.get())));
-			}
-			else if (other.hamiltonian->Name() == "Anisotropic Heisenberg")
-			{
-				this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Anisotropic(*(Engine::Hamiltonian_Anisotropic*)(other.hamiltonian.get())));
-			}
-			else if (other.hamiltonian->Name() == "Gaussian")
-			{
-				this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Gaussian(*(Engine::Hamiltonian_Gaussian*)(other.hamiltonian.get())));
-			}
+			// The geometry and Hamiltonian are shared, see Unshare_Hamiltonian
+			this->geometry = other.geometry;
+			this->hamiltonian = other.hamiltonian;
 
 			this->llg_parameters = std::shared_ptr<Data::Parameters_Method_LLG>(new Data::Parameters_Method_LLG(*other.llg_parameters));
 
@@ -98,14 +86,58 @@ namespace Data
 
 	void Spin_System::UpdateEnergy()
 	{
+		if (this->energy_version == this->spins_version) return;
 		this->E_array = this->hamiltonian->Energy_Contributions(*this->spins);
-		this->E = this->hamiltonian->Energy(*this->spins);
+		this->E = 0;
+		for (auto & contribution : this->E_array) this->E += contribution.second;
+		this->energy_version = this->spins_version;
+	}
+
+	void Spin_System::UpdateEnergyAndEffectiveField()
+	{
+		// Only one of them may be outdated
+		if (this->energy_version == this->spins_version) this->UpdateEffectiveField();
+		else if (this->effective_field_version == this->spins_version) this->UpdateEnergy();
+		else
+		{
+			this->hamiltonian->Energy_and_Gradient(*this->spins, this->effective_field, this->E_array);
+			Engine::Vectormath::scale(this->effective_field, -1);
+			this->E = 0;
+			for (auto & contribution : this->E_array) this->E += contribution.second;
+			this->energy_version = this->spins_version;
+			this->effective_field_version = this->spins_version;
+		}
 	}
 
 	void Spin_System::UpdateEffectiveField()
 	{
+		if (this->effective_field_version == this->spins_version) return;
 		this->hamiltonian->Gradient(*this->spins, this->effective_field);
 		Engine::Vectormath::scale(this->effective_field, -1);
+		this->effective_field_version = this->spins_version;
+	}
+
+	void Spin_System::Invalidate()
+	{
+		++this->spins_version;
+	}
+
+	void Spin_System::Unshare_Hamiltonian()
+	{
+		if (this->hamiltonian.use_count() <= 1) return;
+
+		if (this->hamiltonian->Name() == "Isotropic Heisenberg")
+		{
+			this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Isotropic(*(Engine::Hamiltonian_Isotropic*)(this->hamiltonian.get())));
+		}
+		else if (this->hamiltonian->Name() == "Anisotropic Heisenberg")
+		{
+			this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Anisotropic(*(Engine::Hamiltonian_Anisotropic*)(this->hamiltonian.get())));
+		}
+		else if (this->hamiltonian->Name() == "Gaussian")
+		{
+			this->hamiltonian = std::shared_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Gaussian(*(Engine::Hamiltonian_Gaussian*)(this->hamiltonian.get())));
+		}
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,253 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include <engine/Dipole_FFT.hpp>
+#include <utility/Logging.hpp>
+#include <utility/Threading.hpp>
+
+using namespace Utility;
+
+namespace Engine
+{
+	// A one-dimensional discrete Fourier transform of length n.
+	//		Powers of two are transformed with the iterative radix-2 algorithm, other lengths
+	//		with Bluestein's algorithm, i.e. as a convolution of radix-2 length n2 >= 2n-1.
+	struct Dipole_FFT::Plan
+	{
+		int n, n2;
+		std::vector<int> bit_reverse;
+		std::vector<complex> twiddle;
+		// Bluestein chirp exp(-i pi k^2/n) and the transform of its padded conjugate
+		std::vector<complex> chirp, chirp_fft;
+
+		Plan(int n) : n(n)
+		{
+			n2 = 1;
+			if ((n & (n - 1)) == 0) n2 = n;
+			else while (n2 < 2*n - 1) n2 *= 2;
+
+			int bits = 0;
+			while ((1 << bits) < n2) ++bits;
+			bit_reverse = std::vector<int>(n2, 0);
+			for (int i = 0; i < n2; ++i)
+			{
+				for (int b = 0; b < bits; ++b)
+				{
+					if (i & (1 << b)) bit_reverse[i] |= 1 << (bits - 1 - b);
+				}
+			}
+			twiddle = std::vector<complex>(n2/2);
+			for (int k = 0; k < n2/2; ++k) twiddle[k] = std::polar(scalar(1), scalar(-2*M_PI*k/n2));
+
+			if (n2 != n)
+			{
+				chirp = std::vector<complex>(n);
+				for (int k = 0; k < n; ++k)
+				{
+					// k^2 modulo 2n keeps the argument small
+					long long k2 = ((long long)k * k) % (2 * n);
+					chirp[k] = std::polar(scalar(1), scalar(-M_PI*k2/n));
+				}
+				chirp_fft = std::vector<complex>(n2, 0);
+				chirp_fft[0] = std::conj(chirp[0]);
+				for (int k = 1; k < n; ++k) chirp_fft[k] = chirp_fft[n2 - k] = std::conj(chirp[k]);
+				Radix2(chirp_fft.data());
+			}
+		}
+
+		// In-place forward transform of length n2
+		void Radix2(complex * a) const
+		{
+			for (int i = 0; i < n2; ++i)
+			{
+				if (i < bit_reverse[i]) std::swap(a[i], a[bit_reverse[i]]);
+			}
+			for (int len = 2; len <= n2; len *= 2)
+			{
+				int half = len / 2, step = n2 / len;
+				for (int i = 0; i < n2; i += len)
+				{
+					for (int k = 0; k < half; ++k)
+					{
+						complex u = a[i + k];
+						complex v = a[i + k + half] * twiddle[k*step];
+						a[i + k] = u + v;
+						a[i + k + half] = u - v;
+					}
+				}
+			}
+		}
+
+		// In-place forward transform of x[0..n), using work[0..n2) as scratch space
+		void Forward(complex * x, complex * work) const
+		{
+			if (n2 == n)
+			{
+				Radix2(x);
+				return;
+			}
+			for (int k = 0; k < n; ++k) work[k] = x[k] * chirp[k];
+			for (int k = n; k < n2; ++k) work[k] = 0;
+			Radix2(work);
+			// Convolution with the chirp, transformed back via conjugation
+			for (int k = 0; k < n2; ++k) work[k] = std::conj(work[k] * chirp_fft[k]);
+			Radix2(work);
+			for (int k = 0; k < n; ++k) x[k] = chirp[k] * std::conj(work[k]) / scalar(n2);
+		}
+	};
+
+
+	Dipole_FFT::Dipole_FFT(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions, scalar cutoff_radius) :
+		cutoff_radius(cutoff_radius)
+	{
+		this->n_basis = geometry.n_spins_basic_domain;
+		this->n_grid_total = 1;
+		for (int dim = 0; dim < 3; ++dim)
+		{
+			this->n_cells[dim] = geometry.n_cells[dim];
+			// Periodic directions are transformed cyclically, open directions are zero-padded to at least 2N-1
+			if (boundary_conditions[dim] || n_cells[dim] == 1) this->n_grid[dim] = n_cells[dim];
+			else
+			{
+				this->n_grid[dim] = 1;
+				while (this->n_grid[dim] < 2*n_cells[dim] - 1) this->n_grid[dim] *= 2;
+			}
+			this->n_grid_total *= this->n_grid[dim];
+			this->plans.push_back(std::shared_ptr<Plan>(new Plan(this->n_grid[dim])));
+		}
+
+		// ------ Kernel in real space ------
+		//		The field at cell n is sum_m K(m-n) s(m), so the kernel of a translation d is stored at -d
+		const std::vector<Vector3> & t = geometry.translation_vectors;
+		this->kernel = std::vector<std::vector<complex>>(6 * n_basis * n_basis, std::vector<complex>(n_grid_total, 0));
+		int n_pairs = 0;
+		for (int ibasis = 0; ibasis < n_basis; ++ibasis)
+		{
+			for (int jbasis = 0; jbasis < n_basis; ++jbasis)
+			{
+				int idx_pair = 6 * (ibasis*n_basis + jbasis);
+				for (int dc = 1 - n_cells[2]; dc < n_cells[2]; ++dc)
+				{
+					for (int db = 1 - n_cells[1]; db < n_cells[1]; ++db)
+					{
+						for (int da = 1 - n_cells[0]; da < n_cells[0]; ++da)
+						{
+							Vector3 r = geometry.spin_pos[jbasis] + t[0]*da + t[1]*db + t[2]*dc - geometry.spin_pos[ibasis];
+							scalar distance = r.norm();
+							if (distance == 0 || (cutoff_radius > 0 && distance - cutoff_radius >= 1.0E-5)) continue;
+							Vector3 n = r / distance;
+							scalar mult = 1.0 / std::pow(distance, 3.0);
+							int ga = ((-da) % n_grid[0] + n_grid[0]) % n_grid[0];
+							int gb = ((-db) % n_grid[1] + n_grid[1]) % n_grid[1];
+							int gc = ((-dc) % n_grid[2] + n_grid[2]) % n_grid[2];
+							int g = ga + n_grid[0] * (gb + n_grid[1] * gc);
+							kernel[idx_pair + 0][g] += mult * (3 * n[0] * n[0] - 1);
+							kernel[idx_pair + 1][g] += mult * (3 * n[0] * n[1]);
+							kernel[idx_pair + 2][g] += mult * (3 * n[0] * n[2]);
+							kernel[idx_pair + 3][g] += mult * (3 * n[1] * n[1] - 1);
+							kernel[idx_pair + 4][g] += mult * (3 * n[1] * n[2]);
+							kernel[idx_pair + 5][g] += mult * (3 * n[2] * n[2] - 1);
+							++n_pairs;
+						}
+					}
+				}
+			}
+		}
+
+		// ------ Kernel in Fourier space ------
+		for (auto & component : this->kernel) this->Transform(component, false);
+
+		Log(Log_Level::Info, Log_Sender::All, "Dipole-Dipole FFT: kernel of " + std::to_string(n_pairs) + " translations on a "
+			+ std::to_string(n_grid[0]) + "x" + std::to_string(n_grid[1]) + "x" + std::to_string(n_grid[2]) + " grid");
+	}
+
+	void Dipole_FFT::Transform(std::vector<complex> & data, bool inverse) const
+	{
+		int stride = 1;
+		for (int dim = 0; dim < 3; ++dim)
+		{
+			int n = this->n_grid[dim];
+			if (n > 1)
+			{
+				auto & plan = *this->plans[dim];
+				int n_lines = this->n_grid_total / n;
+				Threading::Parallel_For(n_lines, [&](int begin, int end)
+				{
+					std::vector<complex> line(n), work(plan.n2);
+					for (int iline = begin; iline < end; ++iline)
+					{
+						// First element of the line: inner index below the stride, outer index above this dimension
+						int base = (iline % stride) + (iline / stride) * stride * n;
+						// The inverse transform is the conjugate of the transform of the conjugate
+						for (int k = 0; k < n; ++k) line[k] = inverse ? std::conj(data[base + k*stride]) : data[base + k*stride];
+						plan.Forward(line.data(), work.data());
+						for (int k = 0; k < n; ++k) data[base + k*stride] = inverse ? std::conj(line[k]) : line[k];
+					}
+				});
+			}
+			stride *= n;
+		}
+	}
+
+	void Dipole_FFT::Field(const vectorfield & spins, vectorfield & field) const
+	{
+		int n_cells_total = n_cells[0] * n_cells[1] * n_cells[2];
+		auto grid_index = [this](int icell)
+		{
+			int na = icell % n_cells[0];
+			int nb = (icell / n_cells[0]) % n_cells[1];
+			int nc = icell / (n_cells[0] * n_cells[1]);
+			return na + n_grid[0] * (nb + n_grid[1] * nc);
+		};
+
+		// Transform the spin components of each basis atom
+		std::vector<std::vector<complex>> spins_fft(3 * n_basis, std::vector<complex>(n_grid_total, 0));
+		for (int ibasis = 0; ibasis < n_basis; ++ibasis)
+		{
+			for (int icell = 0; icell < n_cells_total; ++icell)
+			{
+				int g = grid_index(icell);
+				for (int dim = 0; dim < 3; ++dim) spins_fft[3 * ibasis + dim][g] = spins[ibasis + n_basis*icell][dim];
+			}
+		}
+		for (auto & component : spins_fft) this->Transform(component, false);
+
+		// Multiply with the kernel
+		std::vector<std::vector<complex>> field_fft(3 * n_basis, std::vector<complex>(n_grid_total, 0));
+		Threading::Parallel_For(n_grid_total, [&](int begin, int end)
+		{
+			for (int g = begin; g < end; ++g)
+			{
+				for (int ibasis = 0; ibasis < n_basis; ++ibasis)
+				{
+					complex hx = 0, hy = 0, hz = 0;
+					for (int jbasis = 0; jbasis < n_basis; ++jbasis)
+					{
+						int idx_pair = 6 * (ibasis*n_basis + jbasis);
+						const complex & sx = spins_fft[3 * jbasis + 0][g];
+						const complex & sy = spins_fft[3 * jbasis + 1][g];
+						const complex & sz = spins_fft[3 * jbasis + 2][g];
+						hx += kernel[idx_pair + 0][g] * sx + kernel[idx_pair + 1][g] * sy + kernel[idx_pair + 2][g] * sz;
+						hy += kernel[idx_pair + 1][g] * sx + kernel[idx_pair + 3][g] * sy + kernel[idx_pair + 4][g] * sz;
+						hz += kernel[idx_pair + 2][g] * sx + kernel[idx_pair + 4][g] * sy + kernel[idx_pair + 5][g] * sz;
+					}
+					field_fft[3 * ibasis + 0][g] = hx;
+					field_fft[3 * ibasis + 1][g] = hy;
+					field_fft[3 * ibasis + 2][g] = hz;
+				}
+			}
+		});
+
+		// Transform back
+		for (auto & component : field_fft) this->Transform(component, true);
+		scalar norm = 1.0 / n_grid_total;
+		for (int ibasis = 0; ibasis < n_basis; ++ibasis)
+		{
+			for (int icell = 0; icell < n_cells_total; ++icell)
+			{
+				int g = grid_index(icell);
+				for (int dim = 0; dim < 3; ++dim) field[ibasis + n_basis*icell][dim] = norm * field_fft[3 * ibasis + dim][g].real();
+			}
+		}
+	}
+}
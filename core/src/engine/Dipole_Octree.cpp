@@ -0,0 +1,209 @@
+#include <engine/Dipole_Octree.hpp>
+#include <utility/Logging.hpp>
+#include <utility/Threading.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+using namespace Utility;
+
+namespace Engine
+{
+	Dipole_Octree::Dipole_Octree(const Data::Geometry & geometry, scalar theta, int leaf_size) :
+		theta(theta), positions(geometry.spin_pos)
+	{
+		int nos = this->positions.size();
+		this->order = intfield(nos);
+		for (int i = 0; i < nos; ++i) this->order[i] = i;
+		if (leaf_size < 1) leaf_size = 1;
+
+		// ------ Build the tree breadth-first ------
+		intfield sorted(nos);
+		Node root;
+		root.begin = 0;
+		root.end = nos;
+		if (nos > 0) this->nodes.push_back(root);
+		for (unsigned int inode = 0; inode < this->nodes.size(); ++inode)
+		{
+			int begin = nodes[inode].begin, end = nodes[inode].end;
+
+			// Bounding box and centre of the spins
+			Vector3 box_min = positions[order[begin]], box_max = box_min, centre{ 0,0,0 };
+			for (int k = begin; k < end; ++k)
+			{
+				const Vector3 & p = positions[order[k]];
+				box_min = box_min.cwiseMin(p);
+				box_max = box_max.cwiseMax(p);
+				centre += p;
+			}
+			nodes[inode].box_min = box_min;
+			nodes[inode].box_max = box_max;
+			nodes[inode].centre = centre / (end - begin);
+			nodes[inode].size = (box_max - box_min).norm();
+			nodes[inode].first_child = 0;
+			nodes[inode].n_children = 0;
+
+			// Leaf (spins at the same position cannot be separated)
+			if (end - begin <= leaf_size || nodes[inode].size < 1e-10) continue;
+
+			// Split into octants of the bounding box (counting sort)
+			Vector3 mid = 0.5 * (box_min + box_max);
+			auto octant = [&](int ispin)
+			{
+				const Vector3 & p = positions[ispin];
+				return int(p[0] > mid[0]) + 2 * int(p[1] > mid[1]) + 4 * int(p[2] > mid[2]);
+			};
+			int count[9] = { 0 };
+			for (int k = begin; k < end; ++k) ++count[octant(order[k]) + 1];
+			for (int o = 0; o < 8; ++o) count[o + 1] += count[o];
+			int offset[8];
+			for (int o = 0; o < 8; ++o) offset[o] = begin + count[o];
+			for (int k = begin; k < end; ++k) sorted[offset[octant(order[k])]++] = order[k];
+			std::copy(sorted.begin() + begin, sorted.begin() + end, order.begin() + begin);
+
+			nodes[inode].first_child = nodes.size();
+			for (int o = 0; o < 8; ++o)
+			{
+				if (count[o + 1] > count[o])
+				{
+					Node child;
+					child.begin = begin + count[o];
+					child.end = begin + count[o + 1];
+					nodes.push_back(child);
+					++nodes[inode].n_children;
+				}
+			}
+		}
+
+		// ------ Measure the accuracy for a random configuration ------
+		vectorfield spins(nos);
+		for (int i = 0; i < nos; ++i) spins[i] = Vector3{ std::sin(1.3*i + 0.1), std::cos(0.7*i), std::sin(2.1*i + 0.5) }.normalized();
+		int n_samples = std::min(nos, 64);
+		scalar error = this->Measure_Error(spins, n_samples);
+		Log(Log_Level::Info, Log_Sender::All, "Dipole-Dipole octree: " + std::to_string(nodes.size()) + " cells for " + std::to_string(nos)
+			+ " spins, theta = " + std::to_string(theta) + ", relative error " + std::to_string(error) + " on " + std::to_string(n_samples) + " spins");
+	}
+
+	void Dipole_Octree::Field(const vectorfield & spins, vectorfield & field) const
+	{
+		int n_nodes = this->nodes.size();
+
+		// ------ Moments of the cells, from the leaves upwards ------
+		//		dipole[n] = sum_j m_j,  moment[n] = sum_j (r_j - c_n) m_j^T
+		vectorfield dipole(n_nodes);
+		std::vector<Matrix3> moment(n_nodes);
+		for (int inode = n_nodes - 1; inode >= 0; --inode)
+		{
+			const Node & node = nodes[inode];
+			dipole[inode].setZero();
+			moment[inode].setZero();
+			if (node.n_children == 0)
+			{
+				for (int k = node.begin; k < node.end; ++k)
+				{
+					int j = order[k];
+					dipole[inode] += spins[j];
+					moment[inode] += (positions[j] - node.centre) * spins[j].transpose();
+				}
+			}
+			else
+			{
+				for (int ichild = node.first_child; ichild < node.first_child + node.n_children; ++ichild)
+				{
+					dipole[inode] += dipole[ichild];
+					moment[inode] += moment[ichild] + (nodes[ichild].centre - node.centre) * dipole[ichild].transpose();
+				}
+			}
+		}
+
+		// ------ Field at each spin ------
+		Threading::Parallel_For(spins.size(), [&](int begin, int end)
+		{
+			std::vector<int> stack;
+			for (int ispin = begin; ispin < end; ++ispin)
+			{
+				const Vector3 & p = positions[ispin];
+				Vector3 h{ 0,0,0 };
+				if (n_nodes > 0) stack.push_back(0);
+				while (!stack.empty())
+				{
+					const int inode = stack.back();
+					stack.pop_back();
+					const Node & node = nodes[inode];
+					Vector3 R = p - node.centre;
+					scalar distance = R.norm();
+					bool inside = (p.array() >= node.box_min.array()).all() && (p.array() <= node.box_max.array()).all();
+					if (!inside && node.size < theta * distance)
+					{
+						// Multipole expansion: K(R) M - sum_j ((r_j - c) . grad) K(R) m_j
+						const Vector3 & M = dipole[inode];
+						const Matrix3 & Q = moment[inode];
+						scalar r2 = distance*distance, r5 = r2*r2*distance, r7 = r5*r2;
+						h += (3 * M.dot(R) * R - M * r2) / r5;
+						h -= (3 * Q.trace() * R + 3 * (Q * R) + 3 * (Q.transpose() * R)) / r5 - 15 * R.dot(Q * R) * R / r7;
+					}
+					else if (node.n_children == 0)
+					{
+						for (int k = node.begin; k < node.end; ++k)
+						{
+							int j = order[k];
+							if (j == ispin) continue;
+							Vector3 r = positions[j] - p;
+							scalar d = r.norm();
+							Vector3 n = r / d;
+							h += (3 * n.dot(spins[j]) * n - spins[j]) / (d*d*d);
+						}
+					}
+					else
+					{
+						for (int ichild = node.first_child; ichild < node.first_child + node.n_children; ++ichild) stack.push_back(ichild);
+					}
+				}
+				field[ispin] = h;
+			}
+		});
+	}
+
+	void Dipole_Octree::Field_Direct(const vectorfield & spins, const intfield & indices, vectorfield & field) const
+	{
+		Threading::Parallel_For(indices.size(), [&](int begin, int end)
+		{
+			for (int k = begin; k < end; ++k)
+			{
+				int ispin = indices[k];
+				Vector3 h{ 0,0,0 };
+				for (unsigned int j = 0; j < spins.size(); ++j)
+				{
+					if ((int)j == ispin) continue;
+					Vector3 r = positions[j] - positions[ispin];
+					scalar d = r.norm();
+					Vector3 n = r / d;
+					h += (3 * n.dot(spins[j]) * n - spins[j]) / (d*d*d);
+				}
+				field[k] = h;
+			}
+		});
+	}
+
+	scalar Dipole_Octree::Measure_Error(const vectorfield & spins, int n_samples) const
+	{
+		int nos = spins.size();
+		if (nos == 0 || n_samples <= 0) return 0;
+		n_samples = std::min(n_samples, nos);
+
+		intfield indices(n_samples);
+		for (int k = 0; k < n_samples; ++k) indices[k] = (int)((long long)k * nos / n_samples);
+		vectorfield field(nos), field_direct(n_samples);
+		this->Field(spins, field);
+		this->Field_Direct(spins, indices, field_direct);
+
+		scalar error = 0, norm = 0;
+		for (int k = 0; k < n_samples; ++k)
+		{
+			error += (field[indices[k]] - field_direct[k]).squaredNorm();
+			norm += field_direct[k].squaredNorm();
+		}
+		if (norm == 0) return std::sqrt(error);
+		return std::sqrt(error / norm);
+	}
+}
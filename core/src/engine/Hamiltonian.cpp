@@ -154,6 +154,14 @@ namespace Engine
 		}
 	}
 
+	void Hamiltonian::Sparse_Hessian(const vectorfield & spins, SpMatrixX & hessian)
+	{
+		int nos = spins.size();
+		MatrixX dense_hessian(3*nos, 3*nos);
+		this->Hessian(spins, dense_hessian);
+		hessian = dense_hessian.sparseView();
+	}
+
     void Hamiltonian::Gradient(const vectorfield & spins, vectorfield & gradient)
     {
 		// This is a regular finite difference implementation (probably not very efficient)
@@ -190,6 +198,19 @@ namespace Engine
 		}
     }
 
+	void Hamiltonian::Gradient_SoA(const vectorfield_soa & spins, vectorfield_soa & gradient)
+	{
+		vectorfield spins_aos, gradient_aos(spins.size());
+		Vectormath::assign(spins_aos, spins);
+		this->Gradient(spins_aos, gradient_aos);
+		Vectormath::assign(gradient, gradient_aos);
+	}
+
+	void Hamiltonian::Gradient_Batch(const std::vector<std::shared_ptr<vectorfield>> & spins, std::vector<vectorfield> & gradients)
+	{
+		for (unsigned int r = 0; r < spins.size(); ++r) this->Gradient(*spins[r], gradients[r]);
+	}
+
 	scalar Hamiltonian::Energy(const vectorfield & spins)
 	{
 		scalar sum = 0;
@@ -198,17 +219,55 @@ namespace Engine
 		return sum;
 	}
 
+	scalar Hamiltonian::Energy_Difference(const vectorfield & spins, int ispin, const Vector3 & spin_new)
+	{
+		vectorfield spins_new = spins;
+		spins_new[ispin] = spin_new;
+		return this->Energy(spins_new) - this->Energy(spins);
+	}
+
+	bool Hamiltonian::Interacting_Spins(int, intfield &, intfield &)
+	{
+		return false;
+	}
+
     std::vector<std::pair<std::string, scalar>> Hamiltonian::Energy_Contributions(const vectorfield & spins)
     {
-		Energy_Contributions_per_Spin(spins, this->energy_contributions_per_spin);
-		std::vector<std::pair<std::string, scalar>> energy(this->energy_contributions_per_spin.size());
-		for (unsigned int i = 0; i < energy.size(); ++i)
-		{
-			energy[i] = { this->energy_contributions_per_spin[i].first, Vectormath::sum(this->energy_contributions_per_spin[i].second) };
-		}
+		std::vector<std::pair<std::string, scalarfield>> contributions_per_spin;
+		Energy_Contributions_per_Spin(spins, contributions_per_spin);
+		std::vector<std::pair<std::string, scalar>> energy;
+		Sum_Energy_Contributions(contributions_per_spin, energy);
 		return energy;
     }
 
+	void Hamiltonian::Prepare_Energy_Contributions(int nos, std::vector<std::pair<std::string, scalarfield>> & contributions) const
+	{
+		contributions.resize(this->energy_contributions_per_spin.size());
+		for (unsigned int i = 0; i < contributions.size(); ++i)
+		{
+			contributions[i].first = this->energy_contributions_per_spin[i].first;
+			// Allocate if not already allocated
+			if ((int)contributions[i].second.size() != nos) contributions[i].second = scalarfield(nos, 0);
+			// Otherwise set to zero
+			else Vectormath::fill(contributions[i].second, 0);
+		}
+	}
+
+	void Hamiltonian::Sum_Energy_Contributions(const std::vector<std::pair<std::string, scalarfield>> & contributions, std::vector<std::pair<std::string, scalar>> & energy_contributions) const
+	{
+		energy_contributions.resize(contributions.size());
+		for (unsigned int i = 0; i < energy_contributions.size(); ++i)
+		{
+			energy_contributions[i] = { contributions[i].first, Vectormath::sum(contributions[i].second) };
+		}
+	}
+
+	void Hamiltonian::Energy_and_Gradient(const vectorfield & spins, vectorfield & gradient, std::vector<std::pair<std::string, scalar>> & energy_contributions)
+	{
+		this->Gradient(spins, gradient);
+		energy_contributions = this->Energy_Contributions(spins);
+	}
+
 	void Hamiltonian::Energy_Contributions_per_Spin(const vectorfield & spins, std::vector<std::pair<std::string, scalarfield>> & contributions)
     {
         // Not Implemented!
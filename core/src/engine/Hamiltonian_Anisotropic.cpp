@@ -8,6 +8,7 @@
 #include <engine/Hamiltonian_Anisotropic.hpp>
 #include <engine/Vectormath.hpp>
 #include <data/Spin_System.hpp>
+#include <utility/Threading.hpp>
 
 using std::vector;
 using std::function;
@@ -24,7 +25,8 @@ namespace Engine
 			std::vector<indexPairs> DMI_indices, std::vector<scalarfield> DMI_magnitude, std::vector<vectorfield> DMI_normal,
 			std::vector<indexPairs> DD_indices, std::vector<scalarfield> DD_magnitude, std::vector<vectorfield> DD_normal,
 			std::vector<indexQuadruplets> quadruplet_indices, std::vector<scalarfield> quadruplet_magnitude,
-			std::vector<bool> boundary_conditions
+			std::vector<bool> boundary_conditions,
+			std::shared_ptr<Dipole_Solver> dipole_solver
 	) :
 		Hamiltonian(boundary_conditions),
 		mu_s(mu_s),
@@ -32,7 +34,7 @@ namespace Engine
 		anisotropy_index(anisotropy_index), anisotropy_magnitude(anisotropy_magnitude), anisotropy_normal(anisotropy_normal),
 		Exchange_indices(Exchange_indices), Exchange_magnitude(Exchange_magnitude),
 		DMI_indices(DMI_indices), DMI_magnitude(DMI_magnitude), DMI_normal(DMI_normal),
-		DD_indices(DD_indices), DD_magnitude(DD_magnitude), DD_normal(DD_normal),
+		DD_indices(DD_indices), DD_magnitude(DD_magnitude), DD_normal(DD_normal), dipole_solver(dipole_solver),
 		Quadruplet_indices(quadruplet_indices), Quadruplet_magnitude(quadruplet_magnitude)
 	{
 		// Renormalize the external field from Tesla to whatever
@@ -77,7 +79,7 @@ namespace Engine
 		}
 		else this->idx_dmi = -1;
 		// Dipole-Dipole
-		if (this->DD_indices[0].size() > 0)
+		if (this->DD_indices[0].size() > 0 || this->dipole_solver)
 		{
 			this->energy_contributions_per_spin.push_back({"DD", scalarfield(0) });
 			this->idx_dd = this->energy_contributions_per_spin.size()-1;
@@ -90,25 +92,112 @@ namespace Engine
 			this->idx_quadruplet = this->energy_contributions_per_spin.size()-1;
 		}
 		else this->idx_quadruplet = -1;
+
+		// The interaction lists may have changed
+		this->Update_Spin_Interactions();
+	}
+
+	void Hamiltonian_Anisotropic::Update_Spin_Interactions()
+	{
+		int nos = this->mu_s.size();
+		bool valid = true;
+
+		// Visit the interactions of all lists in the order of the serial loops
+		auto visit = [this](const std::function<void(int, Spin_Interaction)> & f)
+		{
+			auto interaction = [](Interaction_Type type, int periodicity, int role, int index)
+			{
+				Spin_Interaction si;
+				si.type = type;
+				si.periodicity = (char)periodicity;
+				si.role = (char)role;
+				si.index = index;
+				return si;
+			};
+			for (unsigned int i = 0; i < this->external_field_index.size(); ++i)
+				f(this->external_field_index[i], interaction(Interaction_Type::Zeeman, 0, 0, i));
+			for (unsigned int i = 0; i < this->anisotropy_index.size(); ++i)
+				f(this->anisotropy_index[i], interaction(Interaction_Type::Anisotropy, 0, 0, i));
+			for (int i_periodicity = 0; i_periodicity < 8; ++i_periodicity)
+			{
+				for (unsigned int i_pair = 0; i_pair < this->Exchange_indices[i_periodicity].size(); ++i_pair)
+					for (int role = 0; role < 2; ++role)
+						f(this->Exchange_indices[i_periodicity][i_pair][role], interaction(Interaction_Type::Exchange, i_periodicity, role, i_pair));
+				for (unsigned int i_pair = 0; i_pair < this->DMI_indices[i_periodicity].size(); ++i_pair)
+					for (int role = 0; role < 2; ++role)
+						f(this->DMI_indices[i_periodicity][i_pair][role], interaction(Interaction_Type::DMI, i_periodicity, role, i_pair));
+				for (unsigned int i_pair = 0; i_pair < this->DD_indices[i_periodicity].size(); ++i_pair)
+					for (int role = 0; role < 2; ++role)
+						f(this->DD_indices[i_periodicity][i_pair][role], interaction(Interaction_Type::DD, i_periodicity, role, i_pair));
+				for (unsigned int i_quad = 0; i_quad < this->Quadruplet_indices[i_periodicity].size(); ++i_quad)
+					for (int role = 0; role < 4; ++role)
+						f(this->Quadruplet_indices[i_periodicity][i_quad][role], interaction(Interaction_Type::Quadruplet, i_periodicity, role, i_quad));
+			}
+		};
+
+		// Count the interactions of each spin
+		intfield offset(nos + 1, 0);
+		visit([&](int ispin, Spin_Interaction)
+		{
+			if (ispin < 0 || ispin >= nos) valid = false;
+			else ++offset[ispin + 1];
+		});
+		if (!valid)
+		{
+			// The spin-wise calculation is not available and the interaction lists will be used directly
+			this->spin_interactions_offset = intfield(0);
+			this->spin_interactions = std::vector<Spin_Interaction>(0);
+			return;
+		}
+		for (int ispin = 0; ispin < nos; ++ispin) offset[ispin + 1] += offset[ispin];
+
+		// Sort the interactions into the lists of their spins
+		std::vector<Spin_Interaction> interactions(offset[nos]);
+		intfield position(offset.begin(), offset.end() - 1);
+		visit([&](int ispin, Spin_Interaction si)
+		{
+			interactions[position[ispin]++] = si;
+		});
+
+		this->spin_interactions_offset = offset;
+		this->spin_interactions = interactions;
+	}
+
+	bool Hamiltonian_Anisotropic::Periodicity_Active(int i_periodicity)
+	{
+		return (i_periodicity == 0)
+			|| (i_periodicity == 1 && this->boundary_conditions[0])
+			|| (i_periodicity == 2 && this->boundary_conditions[1])
+			|| (i_periodicity == 3 && this->boundary_conditions[2])
+			|| (i_periodicity == 4 && this->boundary_conditions[0] && this->boundary_conditions[1])
+			|| (i_periodicity == 5 && this->boundary_conditions[0] && this->boundary_conditions[2])
+			|| (i_periodicity == 6 && this->boundary_conditions[1] && this->boundary_conditions[2])
+			|| (i_periodicity == 7 && this->boundary_conditions[0] && this->boundary_conditions[1] && this->boundary_conditions[2]);
 	}
 
 	void Hamiltonian_Anisotropic::Energy_Contributions_per_Spin(const vectorfield & spins, std::vector<std::pair<std::string, scalarfield>> & contributions)
 	{
 		int nos = spins.size();
-		for (auto& pair : energy_contributions_per_spin)
+		this->Prepare_Energy_Contributions(nos, contributions);
+		
+		#ifdef CORE_USE_THREADS
+		// Calculate the energies spin-wise in parallel
+		if ((int)this->spin_interactions_offset.size() == nos + 1)
 		{
-			// Allocate if not already allocated
-			if (pair.second.size() != nos) pair.second = scalarfield(nos, 0);
-			// Otherwise set to zero
-			else for (auto& pair : energy_contributions_per_spin) Vectormath::fill(pair.second, 0);
+			Utility::Threading::Parallel_For(nos, [&](int begin, int end)
+			{
+				this->Spin_Range(spins, nullptr, &contributions, begin, end);
+			});
+			if (this->idx_dd >= 0) E_DD_Solver(spins, contributions[idx_dd].second);
+			return;
 		}
-		
+		#endif
 
 		// External field
-		if (this->idx_zeeman >=0 ) E_Zeeman(spins, energy_contributions_per_spin[idx_zeeman].second);
+		if (this->idx_zeeman >=0 ) E_Zeeman(spins, contributions[idx_zeeman].second);
 
 		// Anisotropy
-		if (this->idx_anisotropy >=0 ) E_Anisotropy(spins, energy_contributions_per_spin[idx_anisotropy].second);
+		if (this->idx_anisotropy >=0 ) E_Anisotropy(spins, contributions[idx_anisotropy].second);
 
 		// Pairs
 		//		Loop over periodicity
@@ -126,16 +215,19 @@ namespace Engine
 			{
 				//		Energies of this periodicity
 				// Exchange
-				if (this->idx_exchange >=0 ) E_Exchange(spins, Exchange_indices[i_periodicity], Exchange_magnitude[i_periodicity], energy_contributions_per_spin[idx_exchange].second);
+				if (this->idx_exchange >=0 ) E_Exchange(spins, Exchange_indices[i_periodicity], Exchange_magnitude[i_periodicity], contributions[idx_exchange].second);
 				// DMI
-				if (this->idx_dmi >=0 ) E_DMI(spins, DMI_indices[i_periodicity], DMI_magnitude[i_periodicity], DMI_normal[i_periodicity], energy_contributions_per_spin[idx_dmi].second);
+				if (this->idx_dmi >=0 ) E_DMI(spins, DMI_indices[i_periodicity], DMI_magnitude[i_periodicity], DMI_normal[i_periodicity], contributions[idx_dmi].second);
 				// DD
-				if (this->idx_dd >=0 ) E_DD(spins, DD_indices[i_periodicity], DD_magnitude[i_periodicity], DD_normal[i_periodicity], energy_contributions_per_spin[idx_dd].second);
+				if (this->idx_dd >=0 ) E_DD(spins, DD_indices[i_periodicity], DD_magnitude[i_periodicity], DD_normal[i_periodicity], contributions[idx_dd].second);
 				// Quadruplet
-				if (this->idx_quadruplet >=0 ) E_Quadruplet(spins, Quadruplet_indices[i_periodicity], Quadruplet_magnitude[i_periodicity], energy_contributions_per_spin[idx_quadruplet].second);
+				if (this->idx_quadruplet >=0 ) E_Quadruplet(spins, Quadruplet_indices[i_periodicity], Quadruplet_magnitude[i_periodicity], contributions[idx_quadruplet].second);
 			}
 		}
 
+		// Dipole-Dipole via FFT or octree
+		if (this->idx_dd >= 0) E_DD_Solver(spins, contributions[idx_dd].second);
+
 		// Return
 		//return this->E;
 	}
@@ -193,6 +285,18 @@ namespace Engine
 		}
 	}// end DipoleDipole
 
+	void Hamiltonian_Anisotropic::E_DD_Solver(const vectorfield & spins, scalarfield & Energy)
+	{
+		if (!this->dipole_solver) return;
+		scalar mult = 0.5*0.0536814951168; // see E_DD
+		vectorfield field(spins.size());
+		this->dipole_solver->Field(spins, field);
+		for (unsigned int ispin = 0; ispin < spins.size(); ++ispin)
+		{
+			Energy[ispin] -= mult * spins[ispin].dot(field[ispin]);
+		}
+	}
+
 
 	void Hamiltonian_Anisotropic::E_Quadruplet(const vectorfield & spins, indexQuadruplets & indices, scalarfield & magnitude, scalarfield & Energy)
 	{
@@ -207,9 +311,115 @@ namespace Engine
 
 
 
+	void Hamiltonian_Anisotropic::Spin_Range(const vectorfield & spins, vectorfield * gradient, std::vector<std::pair<std::string, scalarfield>> * contributions, int begin, int end)
+	{
+		// The expressions and their order are the same as in the Gradient_* and E_* functions, so that the results are identical
+		bool periodicity_active[8];
+		for (int i_periodicity = 0; i_periodicity < 8; ++i_periodicity) periodicity_active[i_periodicity] = this->Periodicity_Active(i_periodicity);
+		scalar mult_dd = 0.0536814951168;
+		scalar mult_dd_energy = 0.5*0.0536814951168;
+		bool with_gradient = gradient != nullptr, with_energy = contributions != nullptr;
+
+		for (int ispin = begin; ispin < end; ++ispin)
+		{
+			Vector3 g = Vector3::Zero();
+			for (int k = this->spin_interactions_offset[ispin]; k < this->spin_interactions_offset[ispin + 1]; ++k)
+			{
+				const Spin_Interaction & si = this->spin_interactions[k];
+				int p = si.periodicity;
+				int n = si.index;
+				if (!periodicity_active[p]) continue;
+				switch (si.type)
+				{
+				case Interaction_Type::Zeeman:
+					if (with_gradient) g -= this->external_field_magnitude[n] * this->external_field_normal[n];
+					if (with_energy && this->idx_zeeman >= 0)
+						(*contributions)[idx_zeeman].second[ispin] -= this->external_field_magnitude[n] * this->external_field_normal[n].dot(spins[ispin]);
+					break;
+				case Interaction_Type::Anisotropy:
+					if (with_gradient) g -= 2.0 * this->anisotropy_magnitude[n] * this->anisotropy_normal[n] * anisotropy_normal[n].dot(spins[ispin]);
+					if (with_energy && this->idx_anisotropy >= 0)
+						(*contributions)[idx_anisotropy].second[ispin] -= this->anisotropy_magnitude[n] * std::pow(anisotropy_normal[n].dot(spins[ispin]), 2.0);
+					break;
+				case Interaction_Type::Exchange:
+				{
+					const indexPair & pair = Exchange_indices[p][n];
+					if (with_gradient)
+					{
+						if (si.role == 0) g -= Exchange_magnitude[p][n] * spins[pair[1]];
+						else              g -= Exchange_magnitude[p][n] * spins[pair[0]];
+					}
+					if (with_energy && this->idx_exchange >= 0)
+						(*contributions)[idx_exchange].second[ispin] -= 0.5 * Exchange_magnitude[p][n] * spins[pair[0]].dot(spins[pair[1]]);
+					break;
+				}
+				case Interaction_Type::DMI:
+				{
+					const indexPair & pair = DMI_indices[p][n];
+					if (with_gradient)
+					{
+						if (si.role == 0) g -= DMI_magnitude[p][n] * spins[pair[1]].cross(DMI_normal[p][n]);
+						else              g += DMI_magnitude[p][n] * spins[pair[0]].cross(DMI_normal[p][n]);
+					}
+					if (with_energy && this->idx_dmi >= 0)
+						(*contributions)[idx_dmi].second[ispin] -= 0.5 * DMI_magnitude[p][n] * DMI_normal[p][n].dot(spins[pair[0]].cross(spins[pair[1]]));
+					break;
+				}
+				case Interaction_Type::DD:
+				{
+					if (DD_magnitude[p][n] > 0.0)
+					{
+						const indexPair & pair = DD_indices[p][n];
+						if (with_gradient)
+						{
+							scalar skalar_contrib = mult_dd / std::pow(DD_magnitude[p][n], 3.0);
+							if (si.role == 0) g -= skalar_contrib * (3 * DD_normal[p][n] * spins[pair[1]].dot(DD_normal[p][n]) - spins[pair[1]]);
+							else              g -= skalar_contrib * (3 * DD_normal[p][n] * spins[pair[0]].dot(DD_normal[p][n]) - spins[pair[0]]);
+						}
+						if (with_energy && this->idx_dd >= 0)
+							(*contributions)[idx_dd].second[ispin] -= mult_dd_energy / std::pow(DD_magnitude[p][n], 3.0) *
+								(3 * spins[pair[1]].dot(DD_normal[p][n]) * spins[pair[0]].dot(DD_normal[p][n]) - spins[pair[0]].dot(spins[pair[1]]));
+					}
+					break;
+				}
+				case Interaction_Type::Quadruplet:
+				{
+					const indexQuadruplet & quad = Quadruplet_indices[p][n];
+					scalar magnitude = Quadruplet_magnitude[p][n];
+					if (with_gradient)
+					{
+						if      (si.role == 0) g -= magnitude * spins[quad[1]] * (spins[quad[2]].dot(spins[quad[3]]));
+						else if (si.role == 1) g -= magnitude * spins[quad[0]] * (spins[quad[2]].dot(spins[quad[3]]));
+						else if (si.role == 2) g -= magnitude * (spins[quad[0]].dot(spins[quad[1]])) * spins[quad[3]];
+						else                   g -= magnitude * (spins[quad[0]].dot(spins[quad[1]])) * spins[quad[2]];
+					}
+					if (with_energy && this->idx_quadruplet >= 0)
+						(*contributions)[idx_quadruplet].second[ispin] -= 0.25*magnitude * (spins[quad[0]].dot(spins[quad[1]])) * (spins[quad[2]].dot(spins[quad[3]]));
+					break;
+				}
+				}
+			}
+			if (with_gradient) (*gradient)[ispin] = g;
+		}
+	}
+
 	void Hamiltonian_Anisotropic::Gradient(const vectorfield & spins, vectorfield & gradient)
 	{
 		int nos = spins.size();
+
+		#ifdef CORE_USE_THREADS
+		// Calculate the gradient spin-wise in parallel
+		if ((int)this->spin_interactions_offset.size() == nos + 1)
+		{
+			Utility::Threading::Parallel_For(nos, [&](int begin, int end)
+			{
+				this->Spin_Range(spins, &gradient, nullptr, begin, end);
+			});
+			this->Gradient_DD_Solver(spins, gradient);
+			return;
+		}
+		#endif
+
 		// Loop over Spins
 		for (int i = 0; i < nos; ++i)
 		{
@@ -248,11 +458,141 @@ namespace Engine
 			}
 		}
 
+		// Dipole-Dipole via FFT or octree
+		this->Gradient_DD_Solver(spins, gradient);
+
 		// Triplet Interactions
 
 		// Quadruplet Interactions
 	}
 
+	void Hamiltonian_Anisotropic::Energy_and_Gradient(const vectorfield & spins, vectorfield & gradient, std::vector<std::pair<std::string, scalar>> & energy_contributions)
+	{
+		int nos = spins.size();
+		// The contributions per spin are kept per thread, as the Hamiltonian may be shared between images
+		//		(the reference makes the worker threads below use the buffer of the calling thread)
+		thread_local std::vector<std::pair<std::string, scalarfield>> buffer;
+		auto & contributions_per_spin = buffer;
+		this->Prepare_Energy_Contributions(nos, contributions_per_spin);
+		// The energy contributions which are active (nullptr otherwise)
+		auto contribution = [&](int idx) { return idx >= 0 ? contributions_per_spin[idx].second.data() : nullptr; };
+		scalar * E_zeeman = contribution(idx_zeeman), * E_anisotropy = contribution(idx_anisotropy), * E_exchange = contribution(idx_exchange);
+		scalar * E_dmi = contribution(idx_dmi), * E_dd = contribution(idx_dd), * E_quadruplet = contribution(idx_quadruplet);
+		scalar mult_dd = 0.0536814951168; // see Gradient_DD
+
+		#ifdef CORE_USE_THREADS
+		// Calculate gradient and energies spin-wise in parallel, in a single pass over the interactions of each spin
+		if ((int)this->spin_interactions_offset.size() == nos + 1)
+		{
+			Utility::Threading::Parallel_For(nos, [&](int begin, int end)
+			{
+				this->Spin_Range(spins, &gradient, &contributions_per_spin, begin, end);
+			});
+		}
+		else
+		#endif
+		{
+			// A single pass over each interaction list, with the expressions of the Gradient_* and E_* functions
+			for (int i = 0; i < nos; ++i) gradient[i].setZero();
+
+			// External field
+			for (unsigned int i = 0; i < this->external_field_index.size(); ++i)
+			{
+				int ispin = external_field_index[i];
+				gradient[ispin] -= this->external_field_magnitude[i] * this->external_field_normal[i];
+				if (E_zeeman) E_zeeman[ispin] -= this->external_field_magnitude[i] * this->external_field_normal[i].dot(spins[ispin]);
+			}
+
+			// Anisotropy
+			for (unsigned int i = 0; i < this->anisotropy_index.size(); ++i)
+			{
+				int ispin = anisotropy_index[i];
+				gradient[ispin] -= 2.0 * this->anisotropy_magnitude[i] * this->anisotropy_normal[i] * anisotropy_normal[i].dot(spins[ispin]);
+				if (E_anisotropy) E_anisotropy[ispin] -= this->anisotropy_magnitude[i] * std::pow(anisotropy_normal[i].dot(spins[ispin]), 2.0);
+			}
+
+			// Pairs and quadruplets of the periodicities contained in the boundary conditions
+			for (int p = 0; p < 8; ++p)
+			{
+				if (!this->Periodicity_Active(p)) continue;
+
+				// Exchange
+				for (unsigned int n = 0; n < Exchange_indices[p].size(); ++n)
+				{
+					const indexPair & pair = Exchange_indices[p][n];
+					gradient[pair[0]] -= Exchange_magnitude[p][n] * spins[pair[1]];
+					gradient[pair[1]] -= Exchange_magnitude[p][n] * spins[pair[0]];
+					if (E_exchange)
+					{
+						scalar E = 0.5 * Exchange_magnitude[p][n] * spins[pair[0]].dot(spins[pair[1]]);
+						E_exchange[pair[0]] -= E;
+						E_exchange[pair[1]] -= E;
+					}
+				}
+				// DMI
+				for (unsigned int n = 0; n < DMI_indices[p].size(); ++n)
+				{
+					const indexPair & pair = DMI_indices[p][n];
+					gradient[pair[0]] -= DMI_magnitude[p][n] * spins[pair[1]].cross(DMI_normal[p][n]);
+					gradient[pair[1]] += DMI_magnitude[p][n] * spins[pair[0]].cross(DMI_normal[p][n]);
+					if (E_dmi)
+					{
+						scalar E = 0.5 * DMI_magnitude[p][n] * DMI_normal[p][n].dot(spins[pair[0]].cross(spins[pair[1]]));
+						E_dmi[pair[0]] -= E;
+						E_dmi[pair[1]] -= E;
+					}
+				}
+				// DD
+				for (unsigned int n = 0; n < DD_indices[p].size(); ++n)
+				{
+					if (DD_magnitude[p][n] > 0.0)
+					{
+						const indexPair & pair = DD_indices[p][n];
+						scalar skalar_contrib = mult_dd / std::pow(DD_magnitude[p][n], 3.0);
+						gradient[pair[0]] -= skalar_contrib * (3 * DD_normal[p][n] * spins[pair[1]].dot(DD_normal[p][n]) - spins[pair[1]]);
+						gradient[pair[1]] -= skalar_contrib * (3 * DD_normal[p][n] * spins[pair[0]].dot(DD_normal[p][n]) - spins[pair[0]]);
+						if (E_dd)
+						{
+							scalar E = 0.5*mult_dd / std::pow(DD_magnitude[p][n], 3.0) *
+								(3 * spins[pair[1]].dot(DD_normal[p][n]) * spins[pair[0]].dot(DD_normal[p][n]) - spins[pair[0]].dot(spins[pair[1]]));
+							E_dd[pair[0]] -= E;
+							E_dd[pair[1]] -= E;
+						}
+					}
+				}
+				// Quadruplet
+				for (unsigned int n = 0; n < Quadruplet_indices[p].size(); ++n)
+				{
+					const indexQuadruplet & quad = Quadruplet_indices[p][n];
+					scalar magnitude = Quadruplet_magnitude[p][n];
+					gradient[quad[0]] -= magnitude * spins[quad[1]] * (spins[quad[2]].dot(spins[quad[3]]));
+					gradient[quad[1]] -= magnitude * spins[quad[0]] * (spins[quad[2]].dot(spins[quad[3]]));
+					gradient[quad[2]] -= magnitude * (spins[quad[0]].dot(spins[quad[1]])) * spins[quad[3]];
+					gradient[quad[3]] -= magnitude * (spins[quad[0]].dot(spins[quad[1]])) * spins[quad[2]];
+					if (E_quadruplet)
+					{
+						scalar E = 0.25*magnitude * (spins[quad[0]].dot(spins[quad[1]])) * (spins[quad[2]].dot(spins[quad[3]]));
+						for (int role = 0; role < 4; ++role) E_quadruplet[quad[role]] -= E;
+					}
+				}
+			}
+		}
+
+		// Dipole-Dipole via FFT or octree, with a single evaluation of the field for both
+		if (this->dipole_solver)
+		{
+			vectorfield field(nos);
+			this->dipole_solver->Field(spins, field);
+			for (int ispin = 0; ispin < nos; ++ispin)
+			{
+				gradient[ispin] -= mult_dd * field[ispin];
+				if (E_dd) E_dd[ispin] -= 0.5*mult_dd * spins[ispin].dot(field[ispin]);
+			}
+		}
+
+		this->Sum_Energy_Contributions(contributions_per_spin, energy_contributions);
+	}
+
 	void Hamiltonian_Anisotropic::Gradient_Zeeman(const vectorfield & spins, vectorfield & gradient)
 	{
 		for (unsigned int i = 0; i < this->external_field_index.size(); ++i)
@@ -303,6 +643,18 @@ namespace Engine
 		}
 	}//end Field_DipoleDipole
 
+	void Hamiltonian_Anisotropic::Gradient_DD_Solver(const vectorfield & spins, vectorfield & gradient)
+	{
+		if (!this->dipole_solver) return;
+		scalar mult = 0.0536814951168; // see Gradient_DD
+		vectorfield field(spins.size());
+		this->dipole_solver->Field(spins, field);
+		for (unsigned int ispin = 0; ispin < spins.size(); ++ispin)
+		{
+			gradient[ispin] -= mult * field[ispin];
+		}
+	}
+
 
 	void Hamiltonian_Anisotropic::Gradient_Quadruplet(const vectorfield & spins, indexQuadruplets & indices, scalarfield & magnitude, vectorfield & gradient)
 	{
@@ -421,6 +773,81 @@ namespace Engine
 		 }// end for periodicity
 	}
 
+	void Hamiltonian_Anisotropic::Sparse_Hessian(const vectorfield & spins, SpMatrixX & hessian)
+	{
+		int nos = spins.size();
+
+		// The Hessian is assembled from triplets, which are summed up on insertion
+		std::vector<SpTriplet> triplets;
+		int n_pairs = 0;
+		for (int i_periodicity = 0; i_periodicity < 8; ++i_periodicity)
+			n_pairs += Exchange_indices[i_periodicity].size() + DMI_indices[i_periodicity].size();
+		triplets.reserve(3*anisotropy_index.size() + 12*n_pairs);
+
+		// Single Spin elements
+		for (int alpha = 0; alpha < 3; ++alpha)
+		{
+			for (unsigned int i = 0; i < anisotropy_index.size(); ++i)
+			{
+				int idx = anisotropy_index[i];
+				triplets.push_back(SpTriplet(3*idx + alpha, 3*idx + alpha, -2.0*this->anisotropy_magnitude[i]*std::pow(this->anisotropy_normal[i][alpha],2)));
+			}
+		}
+
+		// Spin Pair elements
+		for (int i_periodicity = 0; i_periodicity < 8; ++i_periodicity)
+		{
+			//		Check if boundary conditions contain this periodicity
+			if ((i_periodicity == 0)
+				|| (i_periodicity == 1 && this->boundary_conditions[0])
+				|| (i_periodicity == 2 && this->boundary_conditions[1])
+				|| (i_periodicity == 3 && this->boundary_conditions[2])
+				|| (i_periodicity == 4 && this->boundary_conditions[0] && this->boundary_conditions[1])
+				|| (i_periodicity == 5 && this->boundary_conditions[0] && this->boundary_conditions[2])
+				|| (i_periodicity == 6 && this->boundary_conditions[1] && this->boundary_conditions[2])
+				|| (i_periodicity == 7 && this->boundary_conditions[0] && this->boundary_conditions[1] && this->boundary_conditions[2]))
+			{
+				//		Loop over pairs of this periodicity
+				// Exchange
+				for (unsigned int i_pair = 0; i_pair < this->Exchange_indices[i_periodicity].size(); ++i_pair)
+				{
+					for (int alpha = 0; alpha < 3; ++alpha)
+					{
+						int idx_i = 3*Exchange_indices[i_periodicity][i_pair][0] + alpha;
+						int idx_j = 3*Exchange_indices[i_periodicity][i_pair][1] + alpha;
+						triplets.push_back(SpTriplet(idx_i, idx_j, -Exchange_magnitude[i_periodicity][i_pair]));
+						triplets.push_back(SpTriplet(idx_j, idx_i, -Exchange_magnitude[i_periodicity][i_pair]));
+					}
+				}
+				// DMI
+				for (unsigned int i_pair = 0; i_pair < this->DMI_indices[i_periodicity].size(); ++i_pair)
+				{
+					// Off-diagonal components of the pair block, using the same convention as the dense Hessian
+					scalar D = DMI_magnitude[i_periodicity][i_pair];
+					const Vector3 & normal = DMI_normal[i_periodicity][i_pair];
+					Matrix3 block;
+					block <<         0,  D*normal[2], -D*normal[1],
+					          D*normal[2],          0,  D*normal[0],
+					         -D*normal[1],  D*normal[0],          0;
+					for (int alpha = 0; alpha < 3; ++alpha)
+					{
+						for (int beta = 0; beta < 3; ++beta)
+						{
+							if (alpha == beta) continue;
+							int idx_i = 3*DMI_indices[i_periodicity][i_pair][0] + alpha;
+							int idx_j = 3*DMI_indices[i_periodicity][i_pair][1] + beta;
+							triplets.push_back(SpTriplet(idx_i, idx_j, block(alpha, beta)));
+							triplets.push_back(SpTriplet(idx_j, idx_i, block(alpha, beta)));
+						}
+					}
+				}
+			}// end if periodicity
+		}// end for periodicity
+
+		hessian.resize(3*nos, 3*nos);
+		hessian.setFromTriplets(triplets.begin(), triplets.end());
+	}
+
 	// Hamiltonian name as string
 	static const std::string name = "Anisotropic Heisenberg";
 	const std::string& Hamiltonian_Anisotropic::Name() { return name; }
@@ -78,11 +78,7 @@ namespace Engine
 	{
 		int nos = spins.size();
 
-		// Allocate if not already allocated
-		if (this->energy_contributions_per_spin[0].second.size() != nos) this->energy_contributions_per_spin = { { "Gaussian", scalarfield(nos,0) } };
-
-		// Set to zero
-		for (auto& pair : energy_contributions_per_spin) Vectormath::fill(pair.second, 0);
+		this->Prepare_Energy_Contributions(nos, contributions);
 
 		for (int i = 0; i < this->n_gaussians; ++i)
 		{
@@ -91,9 +87,36 @@ namespace Engine
 				// Distance between spin and gaussian center
 				scalar l = 1 - this->center[i].dot(spins[ispin]); //Utility::Manifoldmath::Dist_Greatcircle(this->center[i], n);
 																  // Energy contribution
-				this->energy_contributions_per_spin[0].second[ispin] += this->amplitude[i] * std::exp(-std::pow(l, 2) / (2.0*std::pow(this->width[i], 2)));
+				contributions[0].second[ispin] += this->amplitude[i] * std::exp(-std::pow(l, 2) / (2.0*std::pow(this->width[i], 2)));
+			}
+		}
+	}
+
+	void Hamiltonian_Gaussian::Energy_and_Gradient(const vectorfield & spins, vectorfield & gradient, std::vector<std::pair<std::string, scalar>> & energy_contributions)
+	{
+		int nos = spins.size();
+
+		// The contributions per spin are kept per thread, as the Hamiltonian may be shared between images
+		thread_local std::vector<std::pair<std::string, scalarfield>> contributions_per_spin;
+		this->Prepare_Energy_Contributions(nos, contributions_per_spin);
+
+		for (int ispin = 0; ispin < nos; ++ispin)
+		{
+			scalar energy = 0;
+			gradient[ispin] = { 0,0,0 };
+			for (int i = 0; i < this->n_gaussians; ++i)
+			{
+				// Distance between spin and gaussian center
+				scalar l = 1 - this->center[i].dot(spins[ispin]);
+				// The gaussian is evaluated once for the energy and the gradient
+				scalar gaussian = this->amplitude[i] * std::exp(-std::pow(l, 2) / (2.0*std::pow(this->width[i], 2)));
+				energy += gaussian;
+				gradient[ispin] -= gaussian * l / std::pow(this->width[i], 2) * this->center[i];
 			}
+			contributions_per_spin[0].second[ispin] = energy;
 		}
+
+		this->Sum_Energy_Contributions(contributions_per_spin, energy_contributions);
 	}
 
 	// Hamiltonian name as string
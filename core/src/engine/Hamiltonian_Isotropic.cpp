@@ -1,6 +1,7 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <iostream>
+#include <algorithm>
 
 #include <Eigen/Dense>
 
@@ -8,35 +9,81 @@
 #include <engine/Vectormath.hpp>
 #include <engine/Neighbours.hpp>
 #include <utility/Logging.hpp>
+#include <utility/Threading.hpp>
 
 using namespace Utility;
 
 namespace Engine
 {
+	// Heap and header size of a std::vector in bytes
+	template<typename T, typename A>
+	std::size_t Vector_Bytes(const std::vector<T, A> & v)
+	{
+		return sizeof(v) + v.capacity()*sizeof(T);
+	}
+
+	Hamiltonian_Isotropic::Neighbour_Lists Hamiltonian_Isotropic::Create_Neighbour_Lists(const Data::Geometry & geometry,
+		const std::vector<bool> & boundary_conditions, int n_neigh_shells, scalar dd_radius, bool with_dd)
+	{
+		Neighbour_Lists lists;
+
+		// Calculate the Neighbours directly in compressed layout
+		Log(Log_Level::Info, Log_Sender::All, "Building Neighbours ...");
+		Engine::Neighbours::Create_Neighbours_Compressed(geometry, boundary_conditions, n_neigh_shells,
+			lists.neigh_offset, lists.neigh, lists.dm_normal, lists.max_n_4spin, lists.n_4spin_offset, lists.neigh_4spin);
+		Engine::Neighbours::Create_Dipole_Neighbours_Compressed(geometry, boundary_conditions, with_dd ? dd_radius : 0,
+			lists.dd_offset, lists.dd_neigh, lists.dd_normal, lists.dd_distance);
+		Log(Log_Level::Info, Log_Sender::All, "Done Caclulating Neighbours");
+
+		return lists;
+	}
+
 	Hamiltonian_Isotropic::Hamiltonian_Isotropic(
 		std::vector<bool> boundary_conditions, scalar external_field_magnitude_i, Vector3 external_field_normal, scalar mu_s,
 		scalar anisotropy_magnitude, Vector3 anisotropy_normal,
 		int n_neigh_shells, std::vector<scalar> jij, scalar dij, scalar bij, scalar kijkl, scalar dd_radius,
-		Data::Geometry geometry) :
+		Data::Geometry geometry, std::shared_ptr<Dipole_Solver> dipole_solver) :
+		Hamiltonian_Isotropic(boundary_conditions, external_field_magnitude_i, external_field_normal, mu_s,
+			anisotropy_magnitude, anisotropy_normal, n_neigh_shells, jij, dij, bij, kijkl, dd_radius,
+			Create_Neighbour_Lists(geometry, boundary_conditions, n_neigh_shells, dd_radius, !dipole_solver), dipole_solver)
+	{
+	}
+
+	Hamiltonian_Isotropic::Hamiltonian_Isotropic(
+		std::vector<bool> boundary_conditions, scalar external_field_magnitude_i, Vector3 external_field_normal, scalar mu_s,
+		scalar anisotropy_magnitude, Vector3 anisotropy_normal,
+		int n_neigh_shells, std::vector<scalar> jij, scalar dij, scalar bij, scalar kijkl, scalar dd_radius,
+		Neighbour_Lists neighbours, std::shared_ptr<Dipole_Solver> dipole_solver) :
 		Hamiltonian(boundary_conditions),
 		mu_s(mu_s),
 		external_field_magnitude(external_field_magnitude_i), external_field_normal(external_field_normal),
 		anisotropy_magnitude(anisotropy_magnitude), anisotropy_normal(anisotropy_normal),
-		n_neigh_shells(n_neigh_shells), jij(jij), dij(dij), bij(bij), kijkl(kijkl), dd_radius(dd_radius)
+		n_neigh_shells(n_neigh_shells),
+		neigh_offset(std::move(neighbours.neigh_offset)), neigh(std::move(neighbours.neigh)),
+		jij(jij), dij(dij), dm_normal(std::move(neighbours.dm_normal)), bij(bij), dd_radius(dd_radius),
+		dd_offset(std::move(neighbours.dd_offset)), dd_neigh(std::move(neighbours.dd_neigh)),
+		dd_normal(std::move(neighbours.dd_normal)), dd_distance(std::move(neighbours.dd_distance)), dipole_solver(dipole_solver),
+		kijkl(kijkl), max_n_4spin(neighbours.max_n_4spin),
+		n_4spin_offset(std::move(neighbours.n_4spin_offset)), neigh_4spin(std::move(neighbours.neigh_4spin))
 	{
 		// Rescale magnetic field from Tesla to meV
 		external_field_magnitude = external_field_magnitude * Vectormath::MuB() * mu_s;
 		external_field_normal.normalize();
 
+		// Report the memory used by the neighbour lists
+		Log(Log_Level::Info, Log_Sender::All, "Neighbour lists: " + std::to_string(this->neigh.size()) + " pairs, "
+			+ std::to_string(this->dd_neigh.size()) + " dipole pairs, " + std::to_string(this->neigh_4spin.size()) + " 4-spin quadruplets");
+		Log(Log_Level::Info, Log_Sender::All, "Neighbour lists use " + std::to_string(this->Neighbours_Memory_Footprint() / 1048576.0) + " MB");
+
 		this->Update_Energy_Contributions();
+	}
 
-		// Calculate Neighbours
-		Log(Log_Level::Info, Log_Sender::All, "Building Neighbours ...");
-		Engine::Neighbours::Create_Neighbours(geometry, boundary_conditions, n_neigh_shells,
-			n_spins_in_shell, neigh, n_4spin, max_n_4spin, neigh_4spin, dm_normal, segments, segments_pos);
-		Engine::Neighbours::Create_Dipole_Neighbours(geometry, boundary_conditions,
-			dd_radius, dd_neigh, dd_neigh_pos, dd_normal, dd_distance);
-		Log(Log_Level::Info, Log_Sender::All, "Done Caclulating Neighbours");
+	std::size_t Hamiltonian_Isotropic::Neighbours_Memory_Footprint()
+	{
+		return Vector_Bytes(this->neigh_offset) + Vector_Bytes(this->neigh) + Vector_Bytes(this->neigh_jij) + Vector_Bytes(this->dm_normal)
+			+ Vector_Bytes(this->dd_offset) + Vector_Bytes(this->dd_neigh) + Vector_Bytes(this->dd_normal) + Vector_Bytes(this->dd_distance)
+			+ Vector_Bytes(this->n_4spin_offset) + Vector_Bytes(this->neigh_4spin)
+			+ Vector_Bytes(this->quadruplets_of_spin_offset) + Vector_Bytes(this->quadruplets_of_spin);
 	}
 
 
@@ -91,12 +138,53 @@ namespace Engine
 		}
 		else this->idx_fsc = -1;
 		// Dipole-Dipole
-		if (this->dd_radius > 0)
+		if (this->dd_radius > 0 || this->dipole_solver)
 		{
 			this->energy_contributions_per_spin.push_back({"DD", scalarfield(0)});
 			this->idx_dd = this->energy_contributions_per_spin.size()-1;
 		}
 		else this->idx_dd = -1;
+
+		// Exchange constants of the neighbour pairs
+		this->neigh_jij = scalarfield(this->neigh.size());
+		int nos = 0;
+		if (this->n_neigh_shells > 0 && this->neigh_offset.size() > 0) nos = (this->neigh_offset.size() - 1) / this->n_neigh_shells;
+		for (int ispin = 0; ispin < nos; ++ispin)
+		{
+			for (int shell = 0; shell < this->n_neigh_shells; ++shell)
+			{
+				int idx = ispin*this->n_neigh_shells + shell;
+				for (int k = this->neigh_offset[idx]; k < this->neigh_offset[idx + 1]; ++k)
+					this->neigh_jij[k] = this->jij[shell];
+			}
+		}
+
+		// The 4 spin interactions in which each spin takes part, for Energy_Difference
+		this->quadruplets_of_spin_offset = intfield(0);
+		this->quadruplets_of_spin = std::vector<std::array<int, 2>>(0);
+		if (this->kijkl != 0 && this->n_4spin_offset.size() > 0)
+		{
+			int nos_4spin = this->n_4spin_offset.size() - 1;
+			this->quadruplets_of_spin_offset = intfield(nos_4spin + 1, 0);
+			for (unsigned int t = 0; t < this->neigh_4spin.size(); ++t)
+			{
+				for (int jspin : this->neigh_4spin[t]) ++this->quadruplets_of_spin_offset[jspin + 1];
+			}
+			for (int ispin = 0; ispin < nos_4spin; ++ispin)
+			{
+				this->quadruplets_of_spin_offset[ispin + 1] += this->quadruplets_of_spin_offset[ispin] + this->n_4spin_offset[ispin + 1] - this->n_4spin_offset[ispin];
+			}
+			this->quadruplets_of_spin = std::vector<std::array<int, 2>>(this->quadruplets_of_spin_offset[nos_4spin]);
+			intfield fill(this->quadruplets_of_spin_offset.begin(), this->quadruplets_of_spin_offset.end() - 1);
+			for (int ispin = 0; ispin < nos_4spin; ++ispin)
+			{
+				for (int t = this->n_4spin_offset[ispin]; t < this->n_4spin_offset[ispin + 1]; ++t)
+				{
+					this->quadruplets_of_spin[fill[ispin]++] = { ispin, t };
+					for (int jspin : this->neigh_4spin[t]) this->quadruplets_of_spin[fill[jspin]++] = { ispin, t };
+				}
+			}
+		}
 	}
 
 
@@ -110,21 +198,15 @@ namespace Engine
 		if (istart == -1) { istart = 0; istop = nos; f0 = 0.5; }
 		//------------------------ End Init ----------------------------------------
 
-		for (auto& pair : energy_contributions_per_spin)
-		{
-			// Allocate if not already allocated
-			if (pair.second.size() != nos) pair.second = scalarfield(nos, 0);
-			// Otherwise set to zero
-			else for (auto& pair : energy_contributions_per_spin) Vectormath::fill(pair.second, 0);
-		}
+		this->Prepare_Energy_Contributions(nos, contributions);
 
-		if (idx_zeeman >= 0)     E_Zeeman(spins, energy_contributions_per_spin[idx_zeeman].second);
-		if (idx_exchange >= 0)   E_Exchange(spins, energy_contributions_per_spin[idx_exchange].second);
-		if (idx_anisotropy >= 0) E_Anisotropic(spins, energy_contributions_per_spin[idx_anisotropy].second);
-		if (idx_bqc >= 0)        E_BQC(spins, energy_contributions_per_spin[idx_bqc].second);
-		if (idx_fsc >= 0)        E_FourSC(spins, energy_contributions_per_spin[idx_fsc].second);
-		if (idx_dmi >= 0)        E_DM(spins, energy_contributions_per_spin[idx_dmi].second);
-		if (idx_dd >= 0)         E_DipoleDipole(spins, energy_contributions_per_spin[idx_dd].second);
+		if (idx_zeeman >= 0)     E_Zeeman(spins, contributions[idx_zeeman].second);
+		if (idx_exchange >= 0)   E_Exchange(spins, contributions[idx_exchange].second);
+		if (idx_anisotropy >= 0) E_Anisotropic(spins, contributions[idx_anisotropy].second);
+		if (idx_bqc >= 0)        E_BQC(spins, contributions[idx_bqc].second);
+		if (idx_fsc >= 0)        E_FourSC(spins, contributions[idx_fsc].second);
+		if (idx_dmi >= 0)        E_DM(spins, contributions[idx_dmi].second);
+		if (idx_dd >= 0)         E_DipoleDipole(spins, contributions[idx_dd].second);
 	};
 
 	void Hamiltonian_Isotropic::E_Zeeman(const vectorfield & spins, scalarfield & Energy)
@@ -139,13 +221,11 @@ namespace Engine
 	{
 		for (unsigned int ispin = 0; ispin < spins.size(); ++ispin)
 		{
-			for (int shell = 0; shell < this->n_neigh_shells; ++shell)
+			// All shells of a spin are stored contiguously
+			for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[(ispin + 1)*n_neigh_shells]; ++k)
 			{
-				for (int jneigh = 0; jneigh < this->n_spins_in_shell[ispin][shell]; ++jneigh)
-				{
-					int jspin = this->neigh[ispin][shell][jneigh];
-					Energy[ispin] -= 0.5 * this->jij[shell] * spins[ispin].dot(spins[jspin]);
-				}
+				int jspin = this->neigh[k];
+				Energy[ispin] -= 0.5 * this->neigh_jij[k] * spins[ispin].dot(spins[jspin]);
 			}
 		}
 	}//end Exchange
@@ -162,10 +242,10 @@ namespace Engine
 	{
 		for (unsigned int ispin = 0; ispin < spins.size(); ++ispin)
 		{
-			int shell = 0;
-			for (int jneigh = 0; jneigh < this->n_spins_in_shell[ispin][shell]; ++jneigh)
+			// First shell
+			for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[ispin*n_neigh_shells + 1]; ++k)
 			{
-				int jspin = this->neigh[ispin][shell][jneigh];
+				int jspin = this->neigh[k];
 				Energy[ispin] -= 0.5 * this->bij * spins[ispin].dot(spins[jspin]);
 			}
 		}
@@ -177,11 +257,11 @@ namespace Engine
 		{
 			scalar result = 0.0;
 			scalar products[6];
-			for (int t = 0; t < this->n_4spin[ispin]; ++t)
+			for (int t = this->n_4spin_offset[ispin]; t < this->n_4spin_offset[ispin + 1]; ++t)
 			{
-				int jspin = this->neigh_4spin[0][ispin][t];
-				int kspin = this->neigh_4spin[1][ispin][t];
-				int lspin = this->neigh_4spin[2][ispin][t];
+				int jspin = this->neigh_4spin[t][0];
+				int kspin = this->neigh_4spin[t][1];
+				int lspin = this->neigh_4spin[t][2];
 
 				products[0] = spins[ispin].dot(spins[jspin]);
 				products[1] = spins[kspin].dot(spins[lspin]);
@@ -202,11 +282,11 @@ namespace Engine
 	{
 		for (unsigned int ispin = 0; ispin < spins.size(); ++ispin)
 		{
-			int shell = 0;
-			for (int jneigh = 0; jneigh < this->n_spins_in_shell[ispin][shell]; ++jneigh)
+			// First shell
+			for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[ispin*n_neigh_shells + 1]; ++k)
 			{
-				int jspin = this->neigh[ispin][shell][jneigh];
-				Energy[ispin] -= 0.5 * this->dij * this->dm_normal[ispin][jneigh].dot(spins[ispin].cross(spins[jspin]));
+				int jspin = this->neigh[k];
+				Energy[ispin] -= 0.5 * this->dij * this->dm_normal[k].dot(spins[ispin].cross(spins[jspin]));
 			}
 		}
 	}// end DM
@@ -217,18 +297,125 @@ namespace Engine
 
 		for (unsigned int ispin = 0; ispin < spins.size(); ++ispin)
 		{
-			for (int jneigh = 0; jneigh < (int)this->dd_neigh[ispin].size(); ++jneigh)
+			for (int k = this->dd_offset[ispin]; k < this->dd_offset[ispin + 1]; ++k)
 			{
-				if (dd_distance[ispin][jneigh] > 0.0)
+				if (dd_distance[k] > 0.0)
 				{
-					int jspin = this->dd_neigh[ispin][jneigh];
-					Energy[ispin] += 0.5 * mult / std::pow(dd_distance[ispin][jneigh], 3.0) *
-						(3 * spins[jspin].dot(dd_normal[ispin][jneigh]) * spins[ispin].dot(dd_normal[ispin][jneigh]) - spins[ispin].dot(spins[jspin]));
+					int jspin = this->dd_neigh[k];
+					Energy[ispin] += 0.5 * mult / std::pow(dd_distance[k], 3.0) *
+						(3 * spins[jspin].dot(dd_normal[k]) * spins[ispin].dot(dd_normal[k]) - spins[ispin].dot(spins[jspin]));
 				}
 			}
 		}
+
+		// Interaction of the whole system via FFT or octree
+		if (this->dipole_solver)
+		{
+			vectorfield field(spins.size());
+			this->dipole_solver->Field(spins, field);
+			for (unsigned int ispin = 0; ispin < spins.size(); ++ispin)
+			{
+				Energy[ispin] += 0.5 * mult * spins[ispin].dot(field[ispin]);
+			}
+		}
 	}// end DipoleDipole
 
+	scalar Hamiltonian_Isotropic::Energy_Difference(const vectorfield & spins, int ispin, const Vector3 & spin_new)
+	{
+		// The interaction of the whole system via FFT or octree is not local
+		if (this->dipole_solver) return Hamiltonian::Energy_Difference(spins, ispin, spin_new);
+
+		// The pair interactions of spin ispin appear in the energies of both spins of each pair,
+		//		i.e. the factors 0.5 of the E_ functions cancel
+		const Vector3 & spin_old = spins[ispin];
+		Vector3 ds = spin_new - spin_old;
+		scalar dE = 0;
+		if (idx_zeeman >= 0)
+			dE -= this->external_field_magnitude * this->external_field_normal.dot(ds);
+		if (idx_anisotropy >= 0)
+			dE -= this->anisotropy_magnitude * (std::pow(this->anisotropy_normal.dot(spin_new), 2.0) - std::pow(this->anisotropy_normal.dot(spin_old), 2.0));
+		if (idx_exchange >= 0)
+		{
+			for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[(ispin + 1)*n_neigh_shells]; ++k)
+				dE -= this->neigh_jij[k] * ds.dot(spins[this->neigh[k]]);
+		}
+		if (idx_bqc >= 0)
+		{
+			for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[ispin*n_neigh_shells + 1]; ++k)
+				dE -= this->bij * ds.dot(spins[this->neigh[k]]);
+		}
+		if (idx_dmi >= 0)
+		{
+			// The DM normal of the pair (j, i) is the negative of the one of (i, j)
+			for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[ispin*n_neigh_shells + 1]; ++k)
+				dE -= this->dij * this->dm_normal[k].dot(ds.cross(spins[this->neigh[k]]));
+		}
+		if (idx_dd >= 0)
+		{
+			scalar mult = -std::pow(Vectormath::MuB(), 2) * 1.0 / 4.0 / M_PI * this->mu_s * this->mu_s; // see E_DipoleDipole
+			for (int k = this->dd_offset[ispin]; k < this->dd_offset[ispin + 1]; ++k)
+			{
+				if (dd_distance[k] > 0.0)
+				{
+					const Vector3 & spin_j = spins[this->dd_neigh[k]];
+					dE += mult / std::pow(dd_distance[k], 3.0) * (3 * spin_j.dot(dd_normal[k]) * ds.dot(dd_normal[k]) - ds.dot(spin_j));
+				}
+			}
+		}
+		if (idx_fsc >= 0)
+		{
+			// Each 4 spin interaction in which spin ispin takes part, with the old and the new spin
+			auto energy = [&](const std::array<int, 4> & q, const Vector3 & spin_i)
+			{
+				const Vector3 & s0 = q[0] == ispin ? spin_i : spins[q[0]];
+				const Vector3 & s1 = q[1] == ispin ? spin_i : spins[q[1]];
+				const Vector3 & s2 = q[2] == ispin ? spin_i : spins[q[2]];
+				const Vector3 & s3 = q[3] == ispin ? spin_i : spins[q[3]];
+				return -0.25 * this->kijkl * (s0.dot(s1) * s2.dot(s3) + s0.dot(s3) * s1.dot(s2) - s0.dot(s2) * s1.dot(s3));
+			};
+			for (int q = this->quadruplets_of_spin_offset[ispin]; q < this->quadruplets_of_spin_offset[ispin + 1]; ++q)
+			{
+				int t = this->quadruplets_of_spin[q][1];
+				std::array<int, 4> quadruplet{ { this->quadruplets_of_spin[q][0], this->neigh_4spin[t][0], this->neigh_4spin[t][1], this->neigh_4spin[t][2] } };
+				dE += energy(quadruplet, spin_new) - energy(quadruplet, spin_old);
+			}
+		}
+		return dE;
+	}
+
+	bool Hamiltonian_Isotropic::Interacting_Spins(int nos, intfield & offset, intfield & interacting)
+	{
+		if (this->dipole_solver) return false;
+
+		offset = intfield(nos + 1, 0);
+		interacting = intfield(0);
+		intfield spins_i;
+		for (int ispin = 0; ispin < nos; ++ispin)
+		{
+			spins_i.clear();
+			for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[(ispin + 1)*n_neigh_shells]; ++k)
+				spins_i.push_back(this->neigh[k]);
+			if (this->dd_offset.size() > 0)
+			{
+				for (int k = this->dd_offset[ispin]; k < this->dd_offset[ispin + 1]; ++k)
+					spins_i.push_back(this->dd_neigh[k]);
+			}
+			if (this->quadruplets_of_spin_offset.size() > 0)
+			{
+				for (int q = this->quadruplets_of_spin_offset[ispin]; q < this->quadruplets_of_spin_offset[ispin + 1]; ++q)
+				{
+					spins_i.push_back(this->quadruplets_of_spin[q][0]);
+					for (int jspin : this->neigh_4spin[this->quadruplets_of_spin[q][1]]) spins_i.push_back(jspin);
+				}
+			}
+			std::sort(spins_i.begin(), spins_i.end());
+			spins_i.erase(std::unique(spins_i.begin(), spins_i.end()), spins_i.end());
+			for (int jspin : spins_i) if (jspin != ispin) interacting.push_back(jspin);
+			offset[ispin + 1] = interacting.size();
+		}
+		return true;
+	}
+
 	void Hamiltonian_Isotropic::Gradient(const vectorfield & spins, vectorfield & gradient)
 	{
 		//========================= Init local vars ================================
@@ -297,10 +484,205 @@ namespace Engine
 				Field_FourSC(nos, spins, gradient, i);
 			}//endfor i
 		}//endif kijkl != 0 & dij ==0
+		// Dipole-Dipole interaction of the whole system via FFT or octree
+		if (this->dipole_solver)
+		{
+			scalar mult = 1.0 / 4.0 / M_PI * this->mu_s * this->mu_s; // see Field_DipoleDipole
+			vectorfield field(nos);
+			this->dipole_solver->Field(spins, field);
+			for (i = istart; i < istop; ++i) gradient[i] += mult * field[i];
+		}
 		// Turn the effective field into a gradient
 		Vectormath::scale(gradient, -1);
 	}
 
+	void Hamiltonian_Isotropic::Gradient_Batch(const std::vector<std::shared_ptr<vectorfield>> & spins, std::vector<vectorfield> & gradients)
+	{
+		// The batched kernel covers the Zeeman, Exchange, Anisotropy, BQC and DM contributions
+		if (this->kijkl != 0.0 || this->dd_radius != 0.0)
+		{
+			Hamiltonian::Gradient_Batch(spins, gradients);
+			return;
+		}
+
+		int n_replicas = spins.size();
+		if (n_replicas == 0) return;
+		int nos = spins[0]->size();
+		std::vector<const Vector3 *> s(n_replicas);
+		std::vector<Vector3 *> g(n_replicas);
+		for (int r = 0; r < n_replicas; ++r)
+		{
+			s[r] = spins[r]->data();
+			g[r] = gradients[r].data();
+		}
+		Vector3 zeeman = this->external_field_magnitude*this->external_field_normal;
+
+		// The neighbours of a spin are read once for (up to max_batch) replicas, whose fields are accumulated in
+		//		registers. The contributions are added in the same order as in Gradient, so that the results are identical.
+		const int max_batch = 8;
+		Utility::Threading::Parallel_For(nos, [&](int begin, int end)
+		{
+			Vector3 field[max_batch];
+			for (int r0 = 0; r0 < n_replicas; r0 += max_batch)
+			{
+				int n_batch = std::min(max_batch, n_replicas - r0);
+				const Vector3 * const * sb = &s[r0];
+				for (int i = begin; i < end; ++i)
+				{
+					for (int r = 0; r < n_batch; ++r) field[r] = zeeman;
+					// Exchange
+					for (int k = this->neigh_offset[i*n_neigh_shells]; k < this->neigh_offset[(i + 1)*n_neigh_shells]; ++k)
+					{
+						int j = this->neigh[k];
+						scalar jij = this->neigh_jij[k];
+						for (int r = 0; r < n_batch; ++r) field[r] += jij * sb[r][j];
+					}
+					// Anisotropy
+					for (int r = 0; r < n_batch; ++r) field[r] += 2 * this->anisotropy_magnitude*this->anisotropy_normal * this->anisotropy_normal.dot(sb[r][i]);
+					// BQC (first shell)
+					if (this->bij != 0.0)
+					{
+						for (int k = this->neigh_offset[i*n_neigh_shells]; k < this->neigh_offset[i*n_neigh_shells + 1]; ++k)
+						{
+							int j = this->neigh[k];
+							for (int r = 0; r < n_batch; ++r) field[r] += 2 * this->bij * sb[r][j] * sb[r][i].dot(sb[r][j]);
+						}
+					}
+					// DMI (first shell)
+					if (this->dij != 0.0)
+					{
+						for (int k = this->neigh_offset[i*n_neigh_shells]; k < this->neigh_offset[i*n_neigh_shells + 1]; ++k)
+						{
+							int j = this->neigh[k];
+							for (int r = 0; r < n_batch; ++r) field[r] += this->dij * this->dm_normal[k].cross(sb[r][j]);
+						}
+					}
+					// Turn the effective field into a gradient
+					for (int r = 0; r < n_batch; ++r) g[r0 + r][i] = -field[r];
+				}
+			}
+		});
+
+		// Dipole-Dipole interaction of the whole system via FFT or octree
+		if (this->dipole_solver)
+		{
+			scalar mult = 1.0 / 4.0 / M_PI * this->mu_s * this->mu_s; // see Field_DipoleDipole
+			vectorfield field(nos);
+			for (int r = 0; r < n_replicas; ++r)
+			{
+				this->dipole_solver->Field(*spins[r], field);
+				for (int i = 0; i < nos; ++i) gradients[r][i] -= mult * field[i];
+			}
+		}
+	}
+
+	void Hamiltonian_Isotropic::Energy_and_Gradient(const vectorfield & spins, vectorfield & gradient, std::vector<std::pair<std::string, scalar>> & energy_contributions)
+	{
+		int nos = spins.size();
+		// The contributions per spin are kept per thread, as the Hamiltonian may be shared between images
+		//		(the reference makes the worker threads below use the buffer of the calling thread)
+		thread_local std::vector<std::pair<std::string, scalarfield>> buffer;
+		auto & contributions_per_spin = buffer;
+		this->Prepare_Energy_Contributions(nos, contributions_per_spin);
+
+		// The energy contributions which are active (nullptr otherwise)
+		auto contribution = [&](int idx) { return idx >= 0 ? contributions_per_spin[idx].second.data() : nullptr; };
+		scalar * E_zeeman = contribution(idx_zeeman), * E_anisotropy = contribution(idx_anisotropy), * E_exchange = contribution(idx_exchange);
+		scalar * E_dmi = contribution(idx_dmi), * E_bqc = contribution(idx_bqc), * E_fsc = contribution(idx_fsc), * E_dd = contribution(idx_dd);
+		scalar mult_dd_energy = -std::pow(Vectormath::MuB(), 2) * 1.0 / 4.0 / M_PI * this->mu_s * this->mu_s; // see E_DipoleDipole
+		scalar mult_dd_field = 1.0 / 4.0 / M_PI * this->mu_s * this->mu_s; // see Field_DipoleDipole
+
+		// Effective field and energies of each spin from a single pass over its neighbours,
+		//		with the same expressions as the Field_* and E_* functions
+		Utility::Threading::Parallel_For(nos, [&](int begin, int end)
+		{
+			for (int ispin = begin; ispin < end; ++ispin)
+			{
+				const Vector3 & spin = spins[ispin];
+				Vector3 field = Vector3::Zero();
+
+				// Zeeman
+				field += this->external_field_magnitude*this->external_field_normal;
+				if (E_zeeman) E_zeeman[ispin] -= this->external_field_magnitude * this->external_field_normal.dot(spin);
+
+				// Exchange (all shells of a spin are stored contiguously)
+				for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[(ispin + 1)*n_neigh_shells]; ++k)
+				{
+					int jspin = this->neigh[k];
+					field += this->neigh_jij[k] * spins[jspin];
+					if (E_exchange) E_exchange[ispin] -= 0.5 * this->neigh_jij[k] * spin.dot(spins[jspin]);
+				}
+
+				// Anisotropy
+				field += 2 * this->anisotropy_magnitude*this->anisotropy_normal * this->anisotropy_normal.dot(spin);
+				if (E_anisotropy) E_anisotropy[ispin] -= this->anisotropy_magnitude * std::pow(this->anisotropy_normal.dot(spin), 2.0);
+
+				// BQC (first shell)
+				for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[ispin*n_neigh_shells + 1]; ++k)
+				{
+					int jspin = this->neigh[k];
+					field += 2 * this->bij * spins[jspin] * spin.dot(spins[jspin]);
+					if (E_bqc) E_bqc[ispin] -= 0.5 * this->bij * spin.dot(spins[jspin]);
+				}
+
+				// Four spin interaction
+				if (this->kijkl != 0.0)
+				{
+					for (int t = this->n_4spin_offset[ispin]; t < this->n_4spin_offset[ispin + 1]; ++t)
+					{
+						const Vector3 & sj = spins[this->neigh_4spin[t][0]];
+						const Vector3 & sk = spins[this->neigh_4spin[t][1]];
+						const Vector3 & sl = spins[this->neigh_4spin[t][2]];
+						field += this->kijkl * (sj * sk.dot(sl) + sl * sj.dot(sk) - sk * sj.dot(sl));
+						if (E_fsc) E_fsc[ispin] -= 0.25 * this->kijkl * (spin.dot(sj) * sk.dot(sl) + spin.dot(sl) * sj.dot(sk) - spin.dot(sk) * sj.dot(sl));
+					}
+				}
+
+				// DMI
+				if (this->dij != 0.0)
+				{
+					for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[ispin*n_neigh_shells + 1]; ++k)
+					{
+						int jspin = this->neigh[k];
+						field += this->dij * this->dm_normal[k].cross(spins[jspin]);
+						if (E_dmi) E_dmi[ispin] -= 0.5 * this->dij * this->dm_normal[k].dot(spin.cross(spins[jspin]));
+					}
+				}
+
+				// Dipole-Dipole neighbours
+				for (int k = this->dd_offset[ispin]; k < this->dd_offset[ispin + 1]; ++k)
+				{
+					if (dd_distance[k] > 0.0)
+					{
+						int jspin = this->dd_neigh[k];
+						field += mult_dd_field / std::pow(dd_distance[k], 3.0) * (3 * dd_normal[k]*spins[jspin].dot(dd_normal[k]) - spins[jspin]);
+						if (E_dd) E_dd[ispin] += 0.5 * mult_dd_energy / std::pow(dd_distance[k], 3.0) *
+							(3 * spins[jspin].dot(dd_normal[k]) * spin.dot(dd_normal[k]) - spin.dot(spins[jspin]));
+					}
+				}
+
+				gradient[ispin] = field;
+			}
+		});
+
+		// Dipole-Dipole interaction of the whole system via FFT or octree, with a single evaluation of the field for both
+		if (this->dipole_solver)
+		{
+			vectorfield field(nos);
+			this->dipole_solver->Field(spins, field);
+			for (int ispin = 0; ispin < nos; ++ispin)
+			{
+				gradient[ispin] += mult_dd_field * field[ispin];
+				if (E_dd) E_dd[ispin] += 0.5 * mult_dd_energy * spins[ispin].dot(field[ispin]);
+			}
+		}
+
+		// Turn the effective field into a gradient
+		Vectormath::scale(gradient, -1);
+
+		this->Sum_Energy_Contributions(contributions_per_spin, energy_contributions);
+	}
+
 	void Hamiltonian_Isotropic::Field_Zeeman(int nos, const vectorfield & spins, vectorfield & eff_field, const int ispin)
 	{
 		eff_field[ispin] += this->external_field_magnitude*this->external_field_normal;
@@ -309,13 +691,11 @@ namespace Engine
 	//Exchange Interaction
 	void Hamiltonian_Isotropic::Field_Exchange(int nos, const vectorfield & spins, vectorfield & eff_field, const int ispin)
 	{
-		for (int shell = 0; shell < this->n_neigh_shells; ++shell)
+		// All shells of a spin are stored contiguously
+		for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[(ispin + 1)*n_neigh_shells]; ++k)
 		{
-			for (int jneigh = 0; jneigh < this->n_spins_in_shell[ispin][shell]; ++jneigh)
-			{
-				int jspin = this->neigh[ispin][shell][jneigh];
-				eff_field[ispin] += this->jij[shell] * spins[jspin];
-			}
+			int jspin = this->neigh[k];
+			eff_field[ispin] += this->neigh_jij[k] * spins[jspin];
 		}
 	}//end Exchange
 
@@ -328,10 +708,10 @@ namespace Engine
 	 // Biquadratic Coupling
 	void Hamiltonian_Isotropic::Field_BQC(int nos, const vectorfield & spins, vectorfield & eff_field, const int ispin)
 	{
-		int shell = 0;
-		for (int jneigh = 0; jneigh < this->n_spins_in_shell[ispin][shell]; ++jneigh)
+		// First shell
+		for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[ispin*n_neigh_shells + 1]; ++k)
 		{
-			int jspin = this->neigh[ispin][shell][jneigh];
+			int jspin = this->neigh[k];
 			eff_field[ispin] += 2 * this->bij * spins[jspin] * spins[ispin].dot(spins[jspin]);
 		}
 	}//end BQC
@@ -339,39 +719,39 @@ namespace Engine
 	 // Four Spin Interaction
 	void Hamiltonian_Isotropic::Field_FourSC(int nos, const vectorfield & spins, vectorfield & eff_field, const int ispin)
 	{
-		for (int t = 0; t < this->n_4spin[ispin]; ++t)
+		for (int t = this->n_4spin_offset[ispin]; t < this->n_4spin_offset[ispin + 1]; ++t)
 		{
-			int jspin = this->neigh_4spin[0][ispin][t];
-			int kspin = this->neigh_4spin[0][ispin][t];
-			int lspin = this->neigh_4spin[0][ispin][t];
+			int jspin = this->neigh_4spin[t][0];
+			int kspin = this->neigh_4spin[t][1];
+			int lspin = this->neigh_4spin[t][2];
 			eff_field[ispin] += this->kijkl
-				* spins[jspin] * spins[kspin].dot(spins[lspin])
+				* (spins[jspin] * spins[kspin].dot(spins[lspin])
 				+ spins[lspin] * spins[jspin].dot(spins[kspin])
-				- spins[kspin] * spins[jspin].dot(spins[lspin]);
+				- spins[kspin] * spins[jspin].dot(spins[lspin]));
 		}
 	}//end FourSC effective field
 
 	 // Dzyaloshinskii-Moriya Interaction 
 	void Hamiltonian_Isotropic::Field_DM(int nos, const vectorfield & spins, vectorfield & eff_field, const int ispin)
 	{
-		int shell = 0;
-		for (int jneigh = 0; jneigh < this->n_spins_in_shell[ispin][shell]; ++jneigh)
+		// First shell
+		for (int k = this->neigh_offset[ispin*n_neigh_shells]; k < this->neigh_offset[ispin*n_neigh_shells + 1]; ++k)
 		{
-			int jspin = this->neigh[ispin][shell][jneigh];
-			eff_field[ispin] += this->dij * this->dm_normal[ispin][jneigh].cross(spins[jspin]);
+			int jspin = this->neigh[k];
+			eff_field[ispin] += this->dij * this->dm_normal[k].cross(spins[jspin]);
 		}
 	}//end DM effective Field
 
 	void Hamiltonian_Isotropic::Field_DipoleDipole(int nos, const vectorfield & spins, vectorfield & eff_field, const int ispin)
 	{
 		scalar mult = 1.0 / 4.0 / M_PI * this->mu_s * this->mu_s; // multiply with mu_B^2
-		for (int jneigh = 0; jneigh < (int)this->dd_neigh[ispin].size(); ++jneigh)
+		for (int k = this->dd_offset[ispin]; k < this->dd_offset[ispin + 1]; ++k)
 		{
-			if (dd_distance[ispin][jneigh] > 0.0)
+			if (dd_distance[k] > 0.0)
 			{
-				int jspin = this->dd_neigh[ispin][jneigh];
-				scalar skalar_contrib = mult / std::pow(dd_distance[ispin][jneigh], 3.0);
-				eff_field[ispin] += skalar_contrib * (3 * dd_normal[ispin][jneigh]*spins[jspin].dot(dd_normal[ispin][jneigh]) - spins[jspin]);
+				int jspin = this->dd_neigh[k];
+				scalar skalar_contrib = mult / std::pow(dd_distance[k], 3.0);
+				eff_field[ispin] += skalar_contrib * (3 * dd_normal[k]*spins[jspin].dot(dd_normal[k]) - spins[jspin]);
 			}
 		}
 	}//end Field_DipoleDipole
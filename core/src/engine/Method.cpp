@@ -1,11 +1,12 @@
 #include <engine/Method.hpp>
+#include <utility/IO.hpp>
 
 #include <algorithm>
 
 namespace Engine
 {
     Method::Method(std::shared_ptr<Data::Parameters_Method> parameters, int idx_img, int idx_chain) :
-        parameters(parameters), idx_image(idx_img), idx_chain(idx_chain)
+        parameters(parameters), idx_image(idx_img), idx_chain(idx_chain), output_tickets{ 0, 0 }, output_buffer(0)
     {
         this->SenderName = Utility::Log_Sender::All;
 		this->force_maxAbsComponent = parameters->force_convergence + 1.0;
@@ -61,6 +62,16 @@ namespace Engine
         throw Utility::Exception::Not_Implemented;
     }
 
+    void Method::Save_State(Utility::IO::Binary_Writer & writer)
+    {
+        writer.Write_Value(this->force_maxAbsComponent);
+    }
+
+    void Method::Load_State(Utility::IO::Binary_Reader & reader)
+    {
+        this->force_maxAbsComponent = reader.Read_Value<scalar>();
+    }
+
 	std::pair<scalar, scalar> minmax_component(vectorfield v1)
 	{
 		scalar min=1e6, max=-1e6;
@@ -108,4 +119,38 @@ namespace Engine
         Log(Utility::Log_Level::Error, Utility::Log_Sender::All, std::string("Tried to use Method::Name() of the Method base class!"));
         return "--";
     }
+
+    std::shared_ptr<Data::Spin_System> Method::Output_Snapshot(std::shared_ptr<Data::Spin_System> system)
+    {
+        // The energy is calculated here, as the output thread must not use the Hamiltonian
+        system->UpdateEnergy();
+
+        // Wait until the last output of this buffer has been written
+        Utility::IO::Wait_For_Output(this->output_tickets[this->output_buffer]);
+        auto & buffer = this->output_buffers[this->output_buffer];
+        if (!buffer || buffer->nos != system->nos)
+        {
+            buffer = std::shared_ptr<Data::Spin_System>(new Data::Spin_System(*system));
+        }
+        else
+        {
+            *buffer->spins = *system->spins;
+            buffer->E = system->E;
+            buffer->E_array = system->E_array;
+        }
+        buffer->hamiltonian = system->hamiltonian;
+        buffer->geometry = system->geometry;
+        buffer->llg_parameters = system->llg_parameters;
+        // The energy is up to date, the effective field is not copied
+        buffer->spins_version = system->spins_version;
+        buffer->energy_version = system->energy_version;
+        buffer->effective_field_version = 0;
+        return buffer;
+    }
+
+    void Method::Queue_Output(std::function<void()> task)
+    {
+        this->output_tickets[this->output_buffer] = Utility::IO::Queue_Output(std::move(task));
+        this->output_buffer = 1 - this->output_buffer;
+    }
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <utility/IO.hpp>
 #include <utility/Timing.hpp>
 #include <utility/Logging.hpp>
+#include <utility/Threading.hpp>
 
 #include <iostream>
 #include <math.h>
@@ -44,72 +45,108 @@ namespace Engine
 	void Method_GNEB::Calculate_Force(std::vector<std::shared_ptr<vectorfield>> configurations, std::vector<vectorfield> & forces)
 	{
 		int nos = configurations[0]->size();
+		int noi = chain->noi;
+		// The images are independent, so they are evaluated concurrently, each by one thread, if there are
+		//		enough of them to occupy all threads. The parallel loops inside the Hamiltonians are then executed
+		//		serially, so with fewer images they are evaluated one after the other, each by all threads.
+		int n_threads = this->chain->gneb_parameters->n_threads_images;
+		if (n_threads == 0 && noi - 2 < Utility::Threading::Get_N_Threads()) n_threads = 1;
 
 		// We assume here that we receive a vector of configurations that corresponds to the vector of systems we gave the optimizer.
 		//		The Optimizer shuld respect this, but there is no way to enforce it.
 		// Get Energy and Gradient of configurations
-		for (int i = 0; i < chain->noi; ++i)
+		std::vector<scalar> distances(noi, 0);
+		Utility::Threading::Parallel_For(noi, [&](int begin, int end)
 		{
-			// Calculate the Energy of the image
-			energies[i] = this->chain->images[i]->hamiltonian->Energy(*configurations[i]);
-			if (i>0) Rx[i] = Rx[i - 1] + Engine::Manifoldmath::dist_geodesic(*configurations[i], *configurations[i - 1]);
-		}
+			std::vector<std::pair<std::string, scalar>> energy_contributions;
+			for (int i = begin; i < end; ++i)
+			{
+				auto& image = *this->chain->images[i];
+				if (i>0) distances[i] = Engine::Manifoldmath::dist_geodesic(*configurations[i], *configurations[i - 1]);
+
+				if (i>0 && i<noi-1)
+				{
+					// Calculate the Energy and the gradient force (unprojected), which is simply the effective field,
+					//		of the configuration in one evaluation of the Hamiltonian
+					image.hamiltonian->Energy_and_Gradient(*configurations[i], F_gradient[i], energy_contributions);
+					Vectormath::scale(F_gradient[i], -1);
+					energies[i] = 0;
+					for (auto & contribution : energy_contributions) energies[i] += contribution.second;
+					// We keep a copy so that the effective field can be e.g. displayed,
+					//		while the gradient force is manipulated (e.g. projected)
+					image.effective_field = F_gradient[i];
+				}
+				else
+				{
+					// Calculate the Energy of the image
+					energy_contributions = image.hamiltonian->Energy_Contributions(*configurations[i]);
+					energies[i] = 0;
+					for (auto & contribution : energy_contributions) energies[i] += contribution.second;
+				}
+
+				// If these are the spins of the image, its energy (and effective field) are up to date
+				if (configurations[i] == image.spins)
+				{
+					image.E = energies[i];
+					image.E_array = energy_contributions;
+					image.energy_version = image.spins_version;
+					if (i>0 && i<noi-1) image.effective_field_version = image.spins_version;
+				}
+			}
+		}, n_threads);
+
+		// Reaction coordinate (summed in the order of the images, independent of the threads)
+		for (int i = 1; i < noi; ++i) Rx[i] = Rx[i - 1] + distances[i];
 
 		// Calculate relevant tangent to magnetisation sphere, considering also the energies of images
 		Engine::Manifoldmath::Tangents(configurations, energies, tangents);
 
 		// Get the total force on the image chain
 		// Loop over images to calculate the total force on each Image
-		for (int img = 1; img < chain->noi - 1; ++img)
+		Utility::Threading::Parallel_For(noi - 2, [&](int begin, int end)
 		{
-			auto& image = *configurations[img];
-			// The gradient force (unprojected) is simply the effective field
-			//this->chain->images[img]->hamiltonian->Effective_Field(image, F_gradient[img]);
-			// We do it the following way so that the effective field can be e.g. displayed,
-			//		while the gradient force is manipulated (e.g. projected)
-			this->chain->images[img]->UpdateEffectiveField();
-			//this->chain->images[img]->hamiltonian->Effective_Field(image, this->chain->images[img]->effective_field);
-			F_gradient[img] = this->chain->images[img]->effective_field;
-
-			// Calculate Force
-			if (chain->image_type[img] == Data::GNEB_Image_Type::Climbing)
-			{
-				// We reverse the component in tangent direction
-				Engine::Manifoldmath::invert_parallel(F_gradient[img], tangents[img]);
-				// And Spring Force is zero
-				F_total[img] = F_gradient[img];
-			}
-			else if (chain->image_type[img] == Data::GNEB_Image_Type::Falling)
+			for (int img = begin + 1; img < end + 1; ++img)
 			{
-				// Spring Force is zero
-				F_total[img] = F_gradient[img];
-			}
-			else if (chain->image_type[img] == Data::GNEB_Image_Type::Normal)
-			{
-				// We project the gradient force orthogonal to the TANGENT
-				Engine::Manifoldmath::project_orthogonal(F_gradient[img], tangents[img]);
-
-				// Calculate the spring force
-				scalar d = this->chain->gneb_parameters->spring_constant * (Rx[img+1] - 2*Rx[img] + Rx[img-1]);
-				for (int i = 0; i < nos; ++i)
+				// Calculate Force
+				if (chain->image_type[img] == Data::GNEB_Image_Type::Climbing)
 				{
-					F_spring[img][i] = d * tangents[img][i];
+					// We reverse the component in tangent direction
+					Engine::Manifoldmath::invert_parallel(F_gradient[img], tangents[img]);
+					// And Spring Force is zero
+					F_total[img] = F_gradient[img];
 				}
+				else if (chain->image_type[img] == Data::GNEB_Image_Type::Falling)
+				{
+					// Spring Force is zero
+					F_total[img] = F_gradient[img];
+				}
+				else if (chain->image_type[img] == Data::GNEB_Image_Type::Normal)
+				{
+					// We project the gradient force orthogonal to the TANGENT
+					Engine::Manifoldmath::project_orthogonal(F_gradient[img], tangents[img]);
 
-				// Calculate the total force
-				for (int j = 0; j < nos; ++j)
+					// Calculate the spring force
+					scalar d = this->chain->gneb_parameters->spring_constant * (Rx[img+1] - 2*Rx[img] + Rx[img-1]);
+					for (int i = 0; i < nos; ++i)
+					{
+						F_spring[img][i] = d * tangents[img][i];
+					}
+
+					// Calculate the total force
+					for (int j = 0; j < nos; ++j)
+					{
+						F_total[img][j] = F_gradient[img][j] + F_spring[img][j];
+					}
+				}
+				else
 				{
-					F_total[img][j] = F_gradient[img][j] + F_spring[img][j];
+					Vectormath::fill(F_total[img], { 0,0,0 });
 				}
-			}
-			else
-			{
-				Vectormath::fill(F_total[img], { 0,0,0 });
-			}
 
-			// Copy out
-			forces[img] = F_total[img];
-		}// end for img=1..noi-1
+				// Copy out
+				forces[img] = F_total[img];
+			}
+		}, n_threads);// end for img=1..noi-1
 	}// end Calculate
 
 	bool Method_GNEB::Force_Converged()
@@ -157,8 +194,6 @@ namespace Engine
 		// Update the chain
 		//		Rx
 		chain->Rx = this->Rx;
-		//		E
-		for (int img = 1; img < chain->noi; ++img) chain->images[img]->E = this->energies[img];
 		//		Rx interpolated
 		chain->Rx_interpolated = interp[0];
 		//		E interpolated
@@ -170,6 +205,23 @@ namespace Engine
         this->chain->iteration_allowed=false;
     }
 
+	void Method_GNEB::Save_State(Utility::IO::Binary_Writer & writer)
+	{
+		Method::Save_State(writer);
+		std::vector<std::int32_t> types;
+		for (auto type : this->chain->image_type) types.push_back((std::int32_t)type);
+		writer.Write_Array(types);
+	}
+
+	void Method_GNEB::Load_State(Utility::IO::Binary_Reader & reader)
+	{
+		Method::Load_State(reader);
+		std::vector<std::int32_t> types;
+		reader.Read_Array(types);
+		if (types.size() != this->chain->image_type.size()) { reader.ok = false; return; }
+		for (unsigned int img = 0; img < types.size(); ++img) this->chain->image_type[img] = (Data::GNEB_Image_Type)types[img];
+	}
+
 
 	void Method_GNEB::Save_Current(std::string starttime, int iteration, bool initial, bool final)
 	{
@@ -184,8 +236,10 @@ namespace Engine
 			auto s_iter = IO::int_to_formatted_string(iteration, 6);
 
 			// Save current Image Chain
-			auto imagesFile = this->chain->gneb_parameters->output_folder + "/" + starttime + "_Images_" + s_iter + suffix + ".txt";
-			Utility::IO::Save_SpinChain_Configuration(this->chain, imagesFile);
+			bool binary = this->chain->gneb_parameters->save_output_binary;
+			auto imagesFile = this->chain->gneb_parameters->output_folder + "/" + starttime + "_Images_" + s_iter + suffix + (binary ? ".bin" : ".txt");
+			if (binary) Utility::IO::Save_SpinChain_Trajectory(this->chain, imagesFile);
+			else Utility::IO::Save_SpinChain_Configuration(this->chain, imagesFile);
 
 			if (this->parameters->save_output_energy)
 			{
@@ -8,8 +8,10 @@
 #include <utility/Timing.hpp>
 #include <utility/Exception.hpp>
 #include <utility/Logging.hpp>
+#include <utility/Random.hpp>
 
 #include <iostream>
+#include <algorithm>
 #include <ctime>
 #include <math.h>
 
@@ -20,16 +22,41 @@ namespace Engine
     Method_LLG::Method_LLG(std::shared_ptr<Data::Spin_System> system, int idx_img, int idx_chain) :
 		Method(system->llg_parameters, idx_img, idx_chain)
 	{
-		// Currently we only support a single image being iterated at once:
 		this->systems = std::vector<std::shared_ptr<Data::Spin_System>>(1, system);
 		this->SenderName = Utility::Log_Sender::LLG;
 
 		// We assume it is not converged before the first iteration
 		this->force_converged = std::vector<bool>(systems.size(), false);
 		this->force_maxAbsComponent = system->llg_parameters->force_convergence + 1.0;
+		this->force_maxAbsComponent_image = std::vector<scalar>(systems.size(), this->force_maxAbsComponent);
 
 		// Forces
 		this->F_total = std::vector<vectorfield>(systems.size(), vectorfield(systems[0]->spins->size()));	// [noi][3nos]
+
+		this->n_iterations_done = 0;
+		this->n_swap_steps = 0;
+	}
+
+	Method_LLG::Method_LLG(std::shared_ptr<Data::Spin_System_Chain> chain, int idx_chain) :
+		Method(chain->images[0]->llg_parameters, 0, idx_chain)
+	{
+		// The images are the replicas
+		this->systems = chain->images;
+		this->SenderName = Utility::Log_Sender::LLG;
+
+		// We assume it is not converged before the first iteration
+		this->force_converged = std::vector<bool>(systems.size(), false);
+		this->force_maxAbsComponent = systems[0]->llg_parameters->force_convergence + 1.0;
+		this->force_maxAbsComponent_image = std::vector<scalar>(systems.size(), this->force_maxAbsComponent);
+
+		// Forces
+		this->F_total = std::vector<vectorfield>(systems.size(), vectorfield(systems[0]->spins->size()));	// [noi][3nos]
+
+		// Swap statistics of the pairs of neighbouring replicas
+		this->n_swaps_attempted = std::vector<long int>(systems.size() - 1, 0);
+		this->n_swaps_accepted = std::vector<long int>(systems.size() - 1, 0);
+		this->n_iterations_done = 0;
+		this->n_swap_steps = 0;
 	}
 
 
@@ -39,11 +66,17 @@ namespace Engine
 		// this->Force_Converged = std::vector<bool>(configurations.size(), false);
 		//this->force_maxAbsComponent = 0;
 
+		// Replicas which share their Hamiltonian are calculated together
+		auto & hamiltonian = systems[0]->hamiltonian;
+		bool batch = systems.size() > 1 && std::all_of(systems.begin(), systems.end(),
+			[&hamiltonian](const std::shared_ptr<Data::Spin_System> & s) { return s->hamiltonian == hamiltonian; });
+		if (batch) hamiltonian->Gradient_Batch(configurations, F_total);
+
 		// Loop over images to calculate the total force on each Image
 		for (unsigned int img = 0; img < systems.size(); ++img)
 		{
 			// Minus the gradient is the total Force here
-			systems[img]->hamiltonian->Gradient(*configurations[img], F_total[img]);
+			if (!batch) systems[img]->hamiltonian->Gradient(*configurations[img], F_total[img]);
 			Vectormath::scale(F_total[img], -1);
 			// Copy out
 			forces[img] = F_total[img];
@@ -59,9 +92,51 @@ namespace Engine
 							[](bool b) { return b; });
 	}
 
+	bool Method_LLG::Iterations_Allowed()
+	{
+		return std::all_of(this->systems.begin(), this->systems.end(),
+							[](const std::shared_ptr<Data::Spin_System> & s) { return s->iteration_allowed; });
+	}
+
 	void Method_LLG::Hook_Pre_Iteration()
     {
+		// Parallel tempering swaps of the replicas after every n_iterations_swap iterations
+		long int n_iterations_swap = this->systems[0]->llg_parameters->n_iterations_swap;
+		if (this->systems.size() > 1 && n_iterations_swap > 0 && this->n_iterations_done > 0 && this->n_iterations_done % n_iterations_swap == 0)
+			this->Swap_Replicas();
+		++this->n_iterations_done;
+	}
+
+	void Method_LLG::Swap_Replicas()
+	{
+		int n_replicas = this->systems.size();
+		std::vector<scalar> energy(n_replicas);
+		for (int r = 0; r < n_replicas; ++r) energy[r] = this->systems[r]->hamiltonian->Energy(*this->systems[r]->spins);
+
+		// The random numbers are determined by the seed of the first replica, the pair and the swap step,
+		//		using a different key than the thermal noise
+		int seed = this->systems[0]->llg_parameters->seed;
+		for (int r = this->n_swap_steps % 2; r < n_replicas - 1; r += 2)
+		{
+			scalar T1 = this->systems[r]->llg_parameters->temperature;
+			scalar T2 = this->systems[r + 1]->llg_parameters->temperature;
+			// Replicas at zero temperature do not take part in the swaps
+			if (T1 <= 0 || T2 <= 0) continue;
 
+			scalar delta = (1 / T1 - 1 / T2) / Vectormath::kB() * (energy[r] - energy[r + 1]);
+			auto random = Utility::Random::Philox4x32({ (uint32_t)r, (uint32_t)this->n_swap_steps, (uint32_t)(this->n_swap_steps >> 32), 0 }, { (uint32_t)seed, 1 });
+			++this->n_swaps_attempted[r];
+			if (delta >= 0 || Utility::Random::Uniform_Open(random[0], random[1]) < std::exp(delta))
+			{
+				// The temperatures stay with the images, the configurations are exchanged
+				std::swap(*this->systems[r]->spins, *this->systems[r + 1]->spins);
+				std::swap(energy[r], energy[r + 1]);
+				this->systems[r]->Invalidate();
+				this->systems[r + 1]->Invalidate();
+				++this->n_swaps_accepted[r];
+			}
+		}
+		++this->n_swap_steps;
 	}
 
     void Method_LLG::Hook_Post_Iteration()
@@ -73,19 +148,14 @@ namespace Engine
 		{
 			this->force_converged[img] = false;
 			auto fmax = this->Force_on_Image_MaxAbsComponent(*(systems[img]->spins), F_total[img]);
+			this->force_maxAbsComponent_image[img] = fmax;
 			if (fmax > this->force_maxAbsComponent) this->force_maxAbsComponent = fmax;
 			if (fmax < this->systems[img]->llg_parameters->force_convergence) this->force_converged[img] = true;
 		}
 
 		// --- Image Data Update
-		// Update the system's Energy
-		// ToDo: copy instead of recalculating
-		systems[0]->UpdateEnergy();
-
-		// ToDo: How to update eff_field without numerical overhead?
-		systems[0]->effective_field = F_total[0];
-		Vectormath::scale(systems[0]->effective_field, -1);
-		// systems[0]->UpdateEffectiveField();
+		// The system's Energy and effective field are calculated only when they are requested
+		//		(by the output, the API or the GUI), so nothing has to be done here
 		
 		// TODO: In order to update Rx with the neighbouring images etc., we need the state -> how to do this?
 
@@ -110,65 +180,121 @@ namespace Engine
 
 	void Method_LLG::Finalize()
     {
-		this->systems[0]->iteration_allowed = false;
+		for (auto & system : this->systems) system->iteration_allowed = false;
+		// Wait for the output to be written
+		Utility::IO::Flush_Output();
     }
 
+	void Method_LLG::Save_State(Utility::IO::Binary_Writer & writer)
+	{
+		Method::Save_State(writer);
+		writer.Write_Array(std::vector<std::int32_t>(this->force_converged.begin(), this->force_converged.end()));
+		writer.Write_Value(this->n_iterations_done);
+		writer.Write_Value(this->n_swap_steps);
+		writer.Write_Array(this->n_swaps_attempted);
+		writer.Write_Array(this->n_swaps_accepted);
+	}
+
+	void Method_LLG::Load_State(Utility::IO::Binary_Reader & reader)
+	{
+		Method::Load_State(reader);
+		std::vector<std::int32_t> converged;
+		reader.Read_Array(converged);
+		if (converged.size() == this->force_converged.size()) this->force_converged.assign(converged.begin(), converged.end());
+		else reader.ok = false;
+		this->n_iterations_done = reader.Read_Value<std::int64_t>();
+		this->n_swap_steps = reader.Read_Value<std::int64_t>();
+		reader.Read_Array(this->n_swaps_attempted);
+		reader.Read_Array(this->n_swaps_accepted);
+	}
+
 	
 	void Method_LLG::Save_Current(std::string starttime, int iteration, bool initial, bool final)
 	{
 		if (this->parameters->save_output_any)
 		{
-			auto writeoutput = [this, starttime, iteration](std::string suffix, bool override_single)
+			// With replicas, the files of each image are written as for single images
+			for (unsigned int img = 0; img < this->systems.size(); ++img)
 			{
+				// The files are written by the output thread, from a snapshot of the system
+				auto system = this->Output_Snapshot(this->systems[img]);
+				auto folder = this->parameters->output_folder;
+				bool save_energy = this->parameters->save_output_energy;
 				// Convert indices to formatted strings
-				auto s_img = IO::int_to_formatted_string(this->idx_image, 2);
+				auto s_img = IO::int_to_formatted_string(this->idx_image + img, 2);
 				auto s_iter = IO::int_to_formatted_string(iteration, 6);
+
+				auto writeoutput = [system, folder, save_energy, s_img, s_iter, starttime, iteration](std::string suffix, bool override_single) mutable
+				{
+					bool binary = system->llg_parameters->save_output_binary;
+					if (system->llg_parameters->save_output_archive)
+					{
+						// Append Spin configuration to Spin_Archieve_File
+						auto spinsFile = folder + "/" + starttime + "_" + "Spins_" + s_img + suffix + (binary ? ".bin" : ".txt");
+						if (binary) Utility::IO::Append_Trajectory_Frame(system, iteration, spinsFile);
+						else Utility::IO::Append_Spin_Configuration(system, iteration, spinsFile);
+					}
 				
-				if (this->systems[0]->llg_parameters->save_output_archive)
+					if (system->llg_parameters->save_output_archive && save_energy)
+					{
+						// Check if Energy File exists and write Header if it doesn't
+						auto energyFile = folder + "/" + starttime + "_Energy_" + s_img + suffix + ".txt";
+						std::ifstream f(energyFile);
+						if (!f.good()) Utility::IO::Write_Energy_Header(*system, energyFile);
+						// Append Energy to File
+						Utility::IO::Append_Energy(*system, iteration, energyFile);
+					}
+
+					if (system->llg_parameters->save_output_single || override_single)
+					{
+						// Save Spin configuration to new "spins" File
+						auto spinsIterFile = folder + "/" + starttime + "_" + "Spins_" + s_img + "_" + s_iter + (binary ? ".bin" : ".txt");
+						if (binary) Utility::IO::Append_Trajectory_Frame(system, iteration, spinsIterFile);
+						else Utility::IO::Append_Spin_Configuration(system, iteration, spinsIterFile);
+					}
+				};
+			
+				std::string suffix = "";
+			
+				if (initial && this->parameters->save_output_initial)
 				{
-					// Append Spin configuration to Spin_Archieve_File
-					auto spinsFile = this->parameters->output_folder + "/" + starttime + "_" + "Spins_" + s_img + suffix + ".txt";
-					Utility::IO::Append_Spin_Configuration(this->systems[0], iteration, spinsFile);
+					auto s_fix = "_" + IO::int_to_formatted_string(iteration, (int)log10(this->parameters->n_iterations)) + "_initial";
+					suffix = s_fix;
 				}
-				
-				if (this->systems[0]->llg_parameters->save_output_archive && this->parameters->save_output_energy)
+				else if (final && this->parameters->save_output_final)
 				{
-					// Check if Energy File exists and write Header if it doesn't
-					auto energyFile = this->parameters->output_folder + "/" + starttime + "_Energy_" + s_img + suffix + ".txt";
-					std::ifstream f(energyFile);
-					if (!f.good()) Utility::IO::Write_Energy_Header(*this->systems[0], energyFile);
-					// Append Energy to File
-					Utility::IO::Append_Energy(*this->systems[0], iteration, energyFile);
+					auto s_fix = "_" + IO::int_to_formatted_string(iteration, (int)log10(this->parameters->n_iterations)) + "_final";
+					suffix = s_fix;
 				}
 
-				if (this->systems[0]->llg_parameters->save_output_single || override_single)
+				// The accepted time steps since the last output, if dt is adapted
+				std::vector<scalar> dt_history;
+				dt_history.swap(this->systems[img]->llg_parameters->dt_history);
+				scalar time = this->systems[img]->llg_parameters->time;
+
+				this->Queue_Output([writeoutput, suffix, folder, starttime, s_img, dt_history, time]() mutable
 				{
-					// Save Spin configuration to new "spins" File
-					auto spinsIterFile = this->parameters->output_folder + "/" + starttime + "_" + "Spins_" + s_img + "_" + s_iter + ".txt";
-					Utility::IO::Append_Spin_Configuration(this->systems[0], iteration, spinsIterFile);
-				}
-			};
-			
-			std::string suffix = "";
-			
-			if (initial && this->parameters->save_output_initial)
-			{
-				auto s_fix = "_" + IO::int_to_formatted_string(iteration, (int)log10(this->parameters->n_iterations)) + "_initial";
-				suffix = s_fix;
-				writeoutput(suffix, true);
-			}
-			else if (final && this->parameters->save_output_final)
-			{
-				auto s_fix = "_" + IO::int_to_formatted_string(iteration, (int)log10(this->parameters->n_iterations)) + "_final";
-				suffix = s_fix;
-				writeoutput(suffix, true);
-			}
-			
-			suffix = "_archive";
-			writeoutput(suffix, false);
+					if (suffix != "") writeoutput(suffix, true);
+					writeoutput("_archive", false);
 
-			// Save Log
-			Log.Append_to_File();
+					if (!dt_history.empty())
+					{
+						auto timestepsFile = folder + "/" + starttime + "_Timesteps_" + s_img + "_archive.txt";
+						std::ifstream f(timestepsFile);
+						std::string output = f.good() ? "" : "#              time                dt\n";
+						for (scalar dt : dt_history) time -= dt;
+						for (scalar dt : dt_history)
+						{
+							time += dt;
+							output += IO::center(time, 10, 20) + IO::center(dt, 10, 20) + "\n";
+						}
+						IO::Append_String_to_File(output, timestepsFile);
+					}
+
+					// Save Log
+					Log.Append_to_File();
+				});
+			}
 		}
 	}
 
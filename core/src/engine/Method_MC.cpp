@@ -0,0 +1,287 @@
+#include <engine/Method_MC.hpp>
+#include <engine/Vectormath.hpp>
+#include <data/Spin_System.hpp>
+#include <utility/IO.hpp>
+#include <utility/Timing.hpp>
+#include <utility/Logging.hpp>
+#include <utility/Random.hpp>
+#include <utility/Threading.hpp>
+
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Dense>
+
+using namespace Utility;
+
+namespace Engine
+{
+	Method_MC::Method_MC(std::shared_ptr<Data::Spin_System> system, int idx_img, int idx_chain) :
+		Method(system->llg_parameters, idx_img, idx_chain)
+	{
+		this->systems = std::vector<std::shared_ptr<Data::Spin_System>>(1, system);
+		this->SenderName = Utility::Log_Sender::LLG;
+
+		// There are no forces, the sampling never converges
+		this->force_maxAbsComponent = 0;
+
+		this->acceptance_ratio = 0;
+		this->cone_angle = system->llg_parameters->mc_cone_angle * M_PI / 180.0;
+		this->n_sweeps = 0;
+		this->n_accepted_log = 0;
+		this->n_attempted_log = 0;
+		this->t_last_log = std::chrono::system_clock::now();
+
+		this->Colour_Spins();
+	}
+
+
+	void Method_MC::Colour_Spins()
+	{
+		int nos = this->systems[0]->nos;
+		intfield offset, interacting;
+		this->parallel = this->systems[0]->hamiltonian->Interacting_Spins(nos, offset, interacting);
+		if (!this->parallel)
+		{
+			// All spins may interact, so they are updated one after the other
+			intfield all(nos);
+			for (int i = 0; i < nos; ++i) all[i] = i;
+			this->colours = std::vector<intfield>(1, all);
+			Log(Log_Level::Info, this->SenderName, "MC: the interactions are not local, the spins are updated serially", this->idx_image, this->idx_chain);
+			return;
+		}
+
+		// The interaction graph, made symmetric in case a Hamiltonian lists only one direction of a pair
+		intfield degree(nos + 1, 0);
+		for (int i = 0; i < nos; ++i)
+		{
+			for (int k = offset[i]; k < offset[i + 1]; ++k)
+			{
+				++degree[i + 1];
+				++degree[interacting[k] + 1];
+			}
+		}
+		for (int i = 0; i < nos; ++i) degree[i + 1] += degree[i];
+		intfield graph(degree[nos]), fill(degree.begin(), degree.end() - 1);
+		for (int i = 0; i < nos; ++i)
+		{
+			for (int k = offset[i]; k < offset[i + 1]; ++k)
+			{
+				int j = interacting[k];
+				graph[fill[i]++] = j;
+				graph[fill[j]++] = i;
+			}
+		}
+
+		// Greedy colouring: each spin gets the lowest colour none of its already coloured neighbours has
+		intfield colour(nos, -1), used;
+		for (int i = 0; i < nos; ++i)
+		{
+			for (int k = degree[i]; k < degree[i + 1]; ++k)
+			{
+				int c = colour[graph[k]];
+				if (c >= 0) used.push_back(c);
+			}
+			std::sort(used.begin(), used.end());
+			int c = 0;
+			for (int u : used)
+			{
+				if (u == c) ++c;
+				else if (u > c) break;
+			}
+			used.clear();
+			colour[i] = c;
+			if (c >= (int)this->colours.size()) this->colours.resize(c + 1);
+			this->colours[c].push_back(i);
+		}
+		Log(Log_Level::Info, this->SenderName, "MC: the spins are updated in " + std::to_string(this->colours.size()) + " sets of non-interacting spins", this->idx_image, this->idx_chain);
+	}
+
+	int Method_MC::Number_of_Colours()
+	{
+		return this->colours.size();
+	}
+
+
+	void Method_MC::Sweep()
+	{
+		auto & system = *this->systems[0];
+		auto & spins = *system.spins;
+		auto & hamiltonian = *system.hamiltonian;
+		auto & params = *system.llg_parameters;
+
+		scalar kT = Vectormath::kB() * params.temperature;
+		bool cone = params.mc_metropolis_cone;
+		scalar cos_cone = std::cos(this->cone_angle);
+		// The random numbers are determined by the seed, the spin and the sweep, using a different key than the thermal noise
+		std::array<uint32_t, 2> key = { (uint32_t)params.seed, 2 };
+		uint32_t sweep_lo = (uint32_t)this->n_sweeps, sweep_hi = (uint32_t)(this->n_sweeps >> 32);
+
+		std::atomic<std::int64_t> n_accepted(0);
+		for (auto & colour : this->colours)
+		{
+			auto update = [&](int begin, int end)
+			{
+				std::int64_t accepted = 0;
+				for (int k = begin; k < end; ++k)
+				{
+					int ispin = colour[k];
+					auto r1 = Random::Philox4x32({ (uint32_t)ispin, sweep_lo, sweep_hi, 0 }, key);
+					auto r2 = Random::Philox4x32({ (uint32_t)ispin, sweep_lo, sweep_hi, 1 }, key);
+					scalar phi = 2 * M_PI * Random::Uniform_Open(r1[0], r1[1]);
+					scalar u = Random::Uniform_Open(r1[2], r1[3]);
+
+					// Trial move
+					const Vector3 & spin = spins[ispin];
+					Vector3 spin_new;
+					if (cone)
+					{
+						// Uniformly distributed in the cone of opening angle cone_angle around the spin
+						scalar cos_theta = 1 - u * (1 - cos_cone);
+						scalar sin_theta = std::sqrt(std::max(scalar(0), 1 - cos_theta*cos_theta));
+						Vector3 e1 = std::abs(spin[0]) < 0.9 ? Vector3{ 1,0,0 } : Vector3{ 0,1,0 };
+						e1 = (e1 - e1.dot(spin)*spin).normalized();
+						Vector3 e2 = spin.cross(e1);
+						spin_new = cos_theta*spin + sin_theta*(std::cos(phi)*e1 + std::sin(phi)*e2);
+						spin_new.normalize();
+					}
+					else
+					{
+						// Uniformly distributed on the sphere
+						scalar z = 2 * u - 1;
+						scalar rho = std::sqrt(std::max(scalar(0), 1 - z*z));
+						spin_new = { rho*std::cos(phi), rho*std::sin(phi), z };
+					}
+
+					// Metropolis criterion
+					scalar dE = hamiltonian.Energy_Difference(spins, ispin, spin_new);
+					if (dE <= 0 || (kT > 0 && Random::Uniform_Open(r2[0], r2[1]) < std::exp(-dE / kT)))
+					{
+						spins[ispin] = spin_new;
+						++accepted;
+					}
+				}
+				n_accepted += accepted;
+			};
+			if (this->parallel) Threading::Parallel_For(colour.size(), update);
+			else update(0, colour.size());
+		}
+
+		int nos = spins.size();
+		this->acceptance_ratio = (scalar)n_accepted / nos;
+		this->n_accepted_log += n_accepted;
+		this->n_attempted_log += nos;
+		++this->n_sweeps;
+
+		// Adapt the cone angle such that the acceptance ratio approaches the target
+		if (cone && params.mc_adaptive_cone)
+		{
+			if (this->acceptance_ratio > params.mc_acceptance_target) this->cone_angle = std::min(scalar(M_PI), scalar(1.05) * this->cone_angle);
+			else this->cone_angle *= 0.95;
+		}
+	}
+
+
+	void Method_MC::Calculate_Force(std::vector<std::shared_ptr<vectorfield>>, std::vector<vectorfield> &)
+	{
+		// Monte Carlo moves do not use the forces, which are left zero
+	}
+
+	bool Method_MC::Force_Converged()
+	{
+		return false;
+	}
+
+	void Method_MC::Hook_Pre_Iteration()
+	{
+	}
+
+	void Method_MC::Hook_Post_Iteration()
+	{
+		// Report the acceptance ratio and sweeps per second every n_iterations_log sweeps
+		if (this->n_sweeps > 0 && this->n_sweeps % this->parameters->n_iterations_log == 0)
+		{
+			auto t_now = std::chrono::system_clock::now();
+			scalar seconds = Timing::SecondsPassed(this->t_last_log, t_now);
+			scalar ratio = this->n_attempted_log > 0 ? (scalar)this->n_accepted_log / this->n_attempted_log : 0;
+			Log.SendBlock(Log_Level::Info, this->SenderName,
+				{
+					"----- MC sweep " + std::to_string(this->n_sweeps),
+					"    Acceptance ratio:            " + std::to_string(ratio),
+					"    Cone angle:                  " + std::to_string(this->cone_angle * 180.0 / M_PI) + " degrees",
+					"    Sweeps / sec:                " + std::to_string(seconds > 0 ? this->parameters->n_iterations_log / seconds : 0)
+				}, this->idx_image, this->idx_chain);
+			this->t_last_log = t_now;
+			this->n_accepted_log = 0;
+			this->n_attempted_log = 0;
+		}
+	}
+
+	void Method_MC::Finalize()
+	{
+		this->systems[0]->iteration_allowed = false;
+		// Wait for the output to be written
+		Utility::IO::Flush_Output();
+	}
+
+	void Method_MC::Save_State(Utility::IO::Binary_Writer & writer)
+	{
+		Method::Save_State(writer);
+		writer.Write_Value(this->n_sweeps);
+		writer.Write_Value(this->cone_angle);
+		writer.Write_Value(this->acceptance_ratio);
+	}
+
+	void Method_MC::Load_State(Utility::IO::Binary_Reader & reader)
+	{
+		Method::Load_State(reader);
+		this->n_sweeps = reader.Read_Value<std::int64_t>();
+		this->cone_angle = reader.Read_Value<scalar>();
+		this->acceptance_ratio = reader.Read_Value<scalar>();
+	}
+
+
+	void Method_MC::Save_Current(std::string starttime, int iteration, bool initial, bool final)
+	{
+		if (!this->parameters->save_output_any) return;
+
+		// The files are written by the output thread, from a snapshot of the system
+		auto system = this->Output_Snapshot(this->systems[0]);
+		auto folder = this->parameters->output_folder;
+		bool save_energy = this->parameters->save_output_energy;
+		auto s_img = IO::int_to_formatted_string(this->idx_image, 2);
+		auto s_iter = IO::int_to_formatted_string(iteration, 6);
+		bool single = (initial && this->parameters->save_output_initial) || (final && this->parameters->save_output_final);
+
+		this->Queue_Output([system, folder, save_energy, s_img, s_iter, starttime, iteration, single]() mutable
+		{
+			bool binary = system->llg_parameters->save_output_binary;
+			if (system->llg_parameters->save_output_archive)
+			{
+				auto spinsFile = folder + "/" + starttime + "_MC_Spins_" + s_img + "_archive" + (binary ? ".bin" : ".txt");
+				if (binary) Utility::IO::Append_Trajectory_Frame(system, iteration, spinsFile);
+				else Utility::IO::Append_Spin_Configuration(system, iteration, spinsFile);
+				if (save_energy)
+				{
+					auto energyFile = folder + "/" + starttime + "_MC_Energy_" + s_img + "_archive.txt";
+					std::ifstream f(energyFile);
+					if (!f.good()) Utility::IO::Write_Energy_Header(*system, energyFile);
+					Utility::IO::Append_Energy(*system, iteration, energyFile);
+				}
+			}
+			if (system->llg_parameters->save_output_single || single)
+			{
+				auto spinsIterFile = folder + "/" + starttime + "_MC_Spins_" + s_img + "_" + s_iter + (binary ? ".bin" : ".txt");
+				if (binary) Utility::IO::Append_Trajectory_Frame(system, iteration, spinsIterFile);
+				else Utility::IO::Append_Spin_Configuration(system, iteration, spinsIterFile);
+			}
+
+			// Save Log
+			Log.Append_to_File();
+		});
+	}
+
+	// Method name as string
+	std::string Method_MC::Name() { return "MC"; }
+}
@@ -7,8 +7,7 @@
 #include <Eigen/Core>
 #include <Eigen/Eigenvalues>
 //#include <unsupported/Eigen/CXX11/Tensor>
-#include <GenEigsSolver.h>  // Also includes <MatOp/DenseGenMatProd.h>
-#include <GenEigsRealShiftSolver.h>
+#include <SymEigsSolver.h>
 
 using Utility::Log_Level;
 using Utility::Log_Sender;
@@ -33,7 +32,7 @@ namespace Engine
 		// We assume that the systems are not converged before the first iteration
 		this->force_maxAbsComponent = this->collection->parameters->force_convergence + 1.0;
 
-		this->hessian = std::vector<MatrixX>(noc, MatrixX(3*nos, 3*nos));	// [noc][3nos]
+		this->hessian = std::vector<SpMatrixX>(noc, SpMatrixX(3*nos, 3*nos));	// [noc][3nos]
 		// Forces
 		this->F_gradient   = std::vector<vectorfield>(noc, vectorfield(nos));	// [noc][3nos]
 		this->minimum_mode = std::vector<vectorfield>(noc, vectorfield(nos));	// [noc][3nos]
@@ -65,88 +64,88 @@ namespace Engine
 		}*/
     }
 
-	MatrixX projector(vectorfield & image)
+	/*
+		Spectra operator for the Hessian projected into the tangent space of an image,
+			H_p = P*H*P - (x.g)*P,
+		where P is the block-diagonal projector 1 - x_i*x_i^T.
+		The product with a vector is calculated spin-wise and via the sparse Hessian, so
+		the projected Hessian is never formed as a matrix.
+		On the tangent space the outer product term -(P*g)*x^T vanishes, which makes the
+		operator symmetric. The directions normal to the spins are shifted to the
+		eigenvalue `normal_shift`, so that they do not interfere with the lowest modes.
+	*/
+	class Projected_Hessian_Op
 	{
-		int nos = image.size();
-		int size = 3*nos;
-		//		Get the image as Eigen vector
-		//Eigen::VectorXd e_image = Eigen::Map<Eigen::VectorXd>(image.data(), size);
-		// 		Get basis change matrix M=1-S, S=x*x^T
-		//Log(Log_Level::Debug, Log_Sender::MMF, "before basis matrix creation");
-
-		MatrixX proj = MatrixX::Identity(size, size);// -e_image*e_image.transpose();
-		// TODO: do this with stride, instead of deordering later
-		for (int i = 0; i < nos; ++i)
+	public:
+		Projected_Hessian_Op(const vectorfield & image, const SpMatrixX & hessian, scalar x_dot_grad, scalar normal_shift) :
+			image(image), hessian(hessian), x_dot_grad(x_dot_grad), normal_shift(normal_shift),
+			projected(3*image.size()), product(3*image.size())
 		{
-			proj.block<3, 3>(3*i, 3*i) -= image[i] * image[i].transpose();
 		}
-		//std::cerr << "projector orig: " << std::endl << proj << std::endl;
-		// 		Change the basis of the Hessian: H -> H - SHS
-		//Log(Log_Level::Debug, Log_Sender::MMF, "after basis matrix creation");
-		return proj;
-	}
+
+		int rows() { return 3*image.size(); }
+		int cols() { return 3*image.size(); }
+
+		// y_out = H_p * x_in
+		void perform_op(const scalar * x_in, scalar * y_out)
+		{
+			int nos = image.size();
+
+			// Project the input into the tangent space
+			for (int i = 0; i < nos; ++i)
+			{
+				Eigen::Map<const Vector3> v(x_in + 3*i);
+				projected.segment<3>(3*i) = v - image[i] * image[i].dot(v);
+			}
+
+			product = hessian * projected;
+
+			// Project the output and add the gradient and normal contributions
+			for (int i = 0; i < nos; ++i)
+			{
+				Eigen::Map<const Vector3> v(x_in + 3*i);
+				Eigen::Map<Vector3> y(y_out + 3*i);
+				Vector3 h = product.segment<3>(3*i);
+				y = h - image[i] * image[i].dot(h) - x_dot_grad * projected.segment<3>(3*i)
+					+ normal_shift * image[i] * image[i].dot(v);
+			}
+		}
+
+	private:
+		const vectorfield & image;
+		const SpMatrixX & hessian;
+		scalar x_dot_grad;
+		scalar normal_shift;
+		VectorX projected;
+		VectorX product;
+	};
 
 	void Method_MMF::Calculate_Force_Spectra_Matrix(std::vector<std::shared_ptr<vectorfield>> configurations, std::vector<vectorfield> & forces)
 	{
-		//std::cerr << "calculating force" << std::endl;
 		const int nos = configurations[0]->size();
-		// std::cerr << "mmf iteration" << std::endl;
 		
 		// Loop over chains and calculate the forces
 		for (int ichain = 0; ichain < collection->noc; ++ichain)
 		{
 			auto& image = *configurations[ichain];
 
-			// Copy std::vector<Eigen::Vector3> into one single Eigen::VectorX
-			VectorX x = Eigen::Map<VectorX>(image[0].data(), 3 * nos);
-
 			// The gradient force (unprojected)
 			this->systems[ichain]->hamiltonian->Gradient(image, F_gradient[ichain]);
-			VectorX grad = Eigen::Map<VectorX>(F_gradient[ichain][0].data(), 3 * nos);
+			scalar x_dot_grad = Vectormath::dot(image, F_gradient[ichain]);
 			Vectormath::scale(F_gradient[ichain], -1);
-			//std::cerr << F_gradient[0][0] << std::endl;
-			//std::cerr << grad[0] << std::endl;
-			//grad = -grad;
-			// std::cerr << "grad1 " << F_gradient[0][0] << std::endl;
-			// std::cerr << "grad2 " << grad[0] << " " << grad[1] << " " << grad[2] << std::endl;
 
 			// Get the unprojected Hessian
-			this->systems[ichain]->hamiltonian->Hessian(image, hessian[ichain]);
-			//MatrixX H = Eigen::Map<MatrixX>(hessian[ichain].data(), 3 * nos, 3 * nos);
-
-
-			// Remove Hessian's components in the basis of the image (project it into tangent space)
-			//		and add the gradient contributions (inner and outer product)
-			auto P = projector(image);
-
-			// std::cerr << "------------------------" << std::endl;
-			// std::cerr << "x:             " << x.transpose() << std::endl;
-			// std::cerr << "gradient:      " << grad.transpose() << std::endl;
-			// std::cerr << "hessian:       " << std::endl << hessian[ichain] << std::endl;
-			// std::cerr << "projector:     " << std::endl << P << std::endl;
-			// std::cerr << "hessian proj:  " << std::endl << P*hessian[ichain]*P << std::endl;
-
-			// TODO: the follwing expression can be optimized, as P is a block-matrix! P*grad can be split up into spin-wise blocks
-			// TODO: also x.dot(grad) can be split into spin-wise parts
-			MatrixX H = P*hessian[ichain]*P - P*(x.dot(grad)) - (P*grad)*x.transpose(); //- P*(x.dot(grad));// -(P*grad)*x.transpose();
-			
-			//Log(Log_Level::Debug, Log_Sender::MMF, "after basis change");
-			
-			// std::cerr << "gradient proj: " << std::endl << (P*grad).transpose() << std::endl;
-			// std::cerr << "hessian final: " << std::endl << H << std::endl;
-			
-
-			//Eigen::EigenSolver<Eigen::MatrixXd> estest1(reorder_matrix(H));
-			// std::cerr << "hessian:    " << std::endl << H << std::endl;
-			//std::cerr << "eigen vals: " << std::endl << estest1.eigenvalues() << std::endl;
-			//std::cerr << "eigen vecs: " << std::endl << estest1.eigenvectors().real() << std::endl;
-			//Eigen::EigenSolver<Eigen::MatrixXd> estest2(H);
-			//std::cerr << "eigen vals: " << std::endl << estest2.eigenvalues() << std::endl;
-			//std::cerr << "eigen vecs: " << std::endl << (estest2.eigenvectors().real()) << std::endl;
+			this->systems[ichain]->hamiltonian->Sparse_Hessian(image, hessian[ichain]);
+
+			// The normal directions are shifted above the spectrum of the tangent space,
+			//		which is bounded by the maximum absolute row sum of the Hessian
+			VectorX row_sums = hessian[ichain].cwiseAbs() * VectorX::Ones(3*nos);
+			scalar normal_shift = row_sums.maxCoeff() + std::abs(x_dot_grad) + 1;
+
 			// Get the lowest Eigenvector
 			//		Create a Spectra solver
-			Spectra::DenseGenMatProd<scalar> op(H);
-			Spectra::GenEigsSolver< scalar, Spectra::SMALLEST_REAL, Spectra::DenseGenMatProd<scalar> > hessian_spectrum(&op, 1, 3*nos);
+			Projected_Hessian_Op op(image, hessian[ichain], x_dot_grad, normal_shift);
+			Spectra::SymEigsSolver< scalar, Spectra::SMALLEST_ALGE, Projected_Hessian_Op > hessian_spectrum(&op, 1, std::min(3*nos, 20));
 			hessian_spectrum.init();
 			//		Compute the specified spectrum
 			int nconv = hessian_spectrum.compute();
@@ -154,89 +153,33 @@ namespace Engine
 			{
 				// Calculate the Force
 				// 		Retrieve the Eigenvalues
-				VectorX evalues = hessian_spectrum.eigenvalues().real();
-				//std::cerr << "spectra val: " << std::endl << hessian_spectrum.eigenvalues() << std::endl;
-				//std::cerr << "spectra vec: " << std::endl << -reorder_vector(hessian_spectrum.eigenvectors().col(0).real()) << std::endl;
+				VectorX evalues = hessian_spectrum.eigenvalues();
+				// 		Retrieve the Eigenvectors
+				MatrixX evectors = hessian_spectrum.eigenvectors();
+				Eigen::Ref<VectorX> evec = evectors.col(0);
+				for (int n=0; n<nos; ++n)
+				{
+					this->minimum_mode[ichain][n] = {evec[3*n], evec[3*n+1], evec[3*n+2]};
+				}
+				// 		Normalize the mode vector in 3N dimensions
+				Engine::Manifoldmath::normalize(this->minimum_mode[ichain]);
+
 				// 		Check if the lowest eigenvalue is negative
-				if (evalues[0] < -1e-5)// || switched2)
+				if (evalues[0] < -1e-5)
 				{
 					if (switched1)
 						switched2 = true;
-					// Create the Minimum Mode
-					// 		Retrieve the Eigenvectors
-					MatrixX evectors = hessian_spectrum.eigenvectors().real();
-					Eigen::Ref<VectorX> evec = evectors.col(0);
-					// std::cerr << "min mode:   " << std::endl << evec << std::endl;
 					// We have found the mode towards a saddle point
-					// 		Copy via assignment
-					// The following line does not seem to work with Eigen3.3
-					// this->minimum_mode[ichain] = vectorfield(evec.data(), evec.data() + evec.rows()*evec.cols());
-					for (int n=0; n<nos; ++n)
-					{
-						this->minimum_mode[ichain][n] = {evec[3*n], evec[3*n+1], evec[3*n+2]};
-					}
-					//for (int _i = 0; _i < forces[ichain].size(); ++_i) minimum_mode[ichain][_i] = -minimum_mode[ichain][_i];
-					// 		Normalize the mode vector in 3N dimensions
-					Engine::Manifoldmath::normalize(this->minimum_mode[ichain]);
-					//std::cerr << "grad " << F_gradient[ichain][0] << " " << F_gradient[ichain][1] << " " << F_gradient[ichain][2] << std::endl;
-					//std::cerr << "mode " << minimum_mode[ichain][0] << " " << minimum_mode[ichain][1] << " " << minimum_mode[ichain][2] << std::endl;
 					// Invert the gradient force along the minimum mode
 					Engine::Manifoldmath::invert_parallel(F_gradient[ichain], minimum_mode[ichain]);
 					// Copy out the forces
 					for (unsigned int _i = 0; _i < forces[ichain].size(); ++_i) forces[ichain][_i] = F_gradient[ichain][_i];
-					//forces[ichain] = F_gradient[ichain];
-					//std::cerr << "force " << forces[ichain][0] << " " << forces[ichain][1] << " " << forces[ichain][2] << std::endl;
 				}
-				//		Otherwise we seek for the lowest nonzero eigenvalue
+				//		Otherwise we use the lowest nonzero eigenvalue, which is the lowest one
+				//		as the zero modes of the normal directions have been shifted away
 				else
 				{
 					switched1 = true;
-					// std::cerr << "sticky region " << evalues[0] << std::endl;
-					///////////////////////////////////
-					//// The Eigen way... calculate them all... Inefficient! Do it the spectra way instead!
-					//Eigen::EigenSolver<Eigen::MatrixXd> estest1(H);
-					//std::cerr << "hessian unreordered:" << std::endl << H << std::endl;
-					//std::cerr << "eigen vals: " << std::endl << estest1.eigenvalues() << std::endl;
-					//std::cerr << "eigen vecs: " << std::endl << reorder_matrix(estest1.eigenvectors().real()) << std::endl;
-					//Eigen::EigenSolver<Eigen::MatrixXd> estest2(reorder_matrix(H));
-					//std::cerr << "hessian:    " << std::endl << reorder_matrix(H) << std::endl;
-					//std::cerr << "eigen vals: " << std::endl << estest2.eigenvalues() << std::endl;
-					//std::cerr << "eigen vecs: " << std::endl << estest2.eigenvectors().real() << std::endl << std::endl;
-					///////////////////////////////////
-
-					// Create the Minimum Mode
-					Spectra::DenseGenRealShiftSolve<scalar> op_pos(H);
-					Spectra::GenEigsRealShiftSolver< scalar, Spectra::SMALLEST_REAL, Spectra::DenseGenRealShiftSolve<scalar> > hessian_spectrum_pos(&op_pos, 1, 3 * nos, 1.0e-5);
-					hessian_spectrum_pos.init();
-					//		Compute the specified spectrum
-					int nconv = hessian_spectrum_pos.compute();
-					// 		Retrieve the Eigenvectors
-					//std::cerr << "-----" << std::endl;
-					//std::cerr << "spectra:" << std::endl;
-					//std::cerr << hessian_spectrum_pos.eigenvalues() << std::endl;
-					//std::cerr << hessian_spectrum_pos.eigenvectors().real() << std::endl;
-					//std::cerr << "-----" << std::endl;
-					Eigen::MatrixXd evectors = hessian_spectrum_pos.eigenvectors().real();
-					//auto evec = evectors.col(0);
-					Eigen::Ref<Eigen::VectorXd> evec = evectors.col(0);
-
-					for (int n=0; n<nos; ++n)
-					{
-						this->minimum_mode[ichain][n] = {evec[3*n], evec[3*n+1], evec[3*n+2]};
-					}
-
-					Engine::Manifoldmath::normalize(this->minimum_mode[ichain]);
-
-
-					//this->minimum_mode[ichain] = std::vector<scalar>(evec.data(), evec.data() + evec.rows()*evec.cols());
-					////for (int _i = 0; _i < forces[ichain].size(); ++_i) minimum_mode[ichain][_i] = -minimum_mode[ichain][_i];
-					//// 		Normalize the mode vector in 3N dimensions
-					//Utility::Vectormath::Normalize(this->minimum_mode[ichain]);
-
-					////// 		Copy via assignment
-					////this->minimum_mode[ichain] = std::vector<scalar>(evec_min.data(), evec_min.data() + evec_min.rows()*evec_min.cols());
-					////// 		Normalize the mode vector in 3N dimensions
-					////Utility::Vectormath::Normalize(this->minimum_mode[ichain]);
 
 					// We are too close to the local minimum so we have to use a strong force
 					//		We apply the force against the minimum mode of the positive eigenvalue
@@ -250,19 +193,14 @@ namespace Engine
 					// Copy out the forces
 					forces[ichain] = F_gradient[ichain];
 				}
-				//std::cerr << "------------------------" << std::endl;
 			}
 			else
 			{
 				Log(Log_Level::Error, Log_Sender::MMF, "Failed to calculate eigenvectors of the Hessian!");
-				// for (int _i = 0; _i < 6; ++_i) std::cerr << minimum_mode[ichain][_i] << " "; std::cerr << std::endl;
-				// for (int _i = 0; _i < 6; ++_i) std::cerr << F_gradient[ichain][_i] << " "; std::cerr << std::endl;
-				// std::cerr << H << std::endl;
 				Log(Log_Level::Info, Log_Sender::MMF, "Zeroing the MMF force...");
-				for (Vector3 x : forces[ichain]) x.setZero();
+				for (Vector3 & x : forces[ichain]) x.setZero();
 			}
 		}
-		// std::cerr << "mmf iteration done" << std::endl;
 	}
 
 	
@@ -296,7 +234,6 @@ namespace Engine
 		}
 
         // --- Update the chains' last images
-		for (auto system : systems) system->UpdateEnergy();
 		for (auto chain : collection->chains)
 		{
 			int i = chain->noi - 1;
@@ -358,6 +295,7 @@ namespace Engine
 						auto energyFile = this->parameters->output_folder + "/" + starttime + "_" + "Energy_" + s_img + suffix + ".txt";
 						//
 						scalar Rx = Rx_last + Engine::Manifoldmath::dist_geodesic(spins_last[0], *this->systems[0]->spins);
+						this->systems[0]->UpdateEnergy();
 						//
 						snprintf(buffer_string_conversion, buffer_length, "    %18.10f    %18.10f\n",
 							Rx, this->systems[0]->E * nd);
@@ -4,6 +4,7 @@
 #include <utility/IO.hpp>
 #include <utility/Logging.hpp>
 #include <utility/Exception.hpp>
+#include <utility/Threading.hpp>
 
 #include <Eigen/Dense>
 
@@ -12,11 +13,29 @@
 #include <cstdio>
 #include <cmath>
 #include <algorithm>
+#include <array>
+#include <functional>
 
 using namespace Utility;
 
 namespace Engine
 {
+	// Throws if a shell does not fit into the periodic images of the simulated domain
+	static void Check_Domain_Size(const std::vector<Vector3> & boundary_vectors, const int n_shells, const std::vector<scalar> & shell_radius)
+	{
+		for (unsigned int i = 1; i < boundary_vectors.size(); ++i) {
+			for (int j = 0; j < n_shells; ++j) {
+				if (2 * shell_radius[j] >= boundary_vectors[i].norm())
+				{
+					Log(Log_Level::Severe, Log_Sender::All, "Simulated domain is too small!\n     Shell " + std::to_string(n_shells) + " diameter=" + std::to_string(2 * shell_radius[j])
+					+ "\n    B.V.  " + std::to_string(i) + "   length=" + std::to_string(boundary_vectors[i].norm())
+					+ "\n    B.V.  " + std::to_string(i) + "   vec   =" + std::to_string(boundary_vectors[i][0]) + " " + std::to_string(boundary_vectors[i][1]) + " " + std::to_string(boundary_vectors[i][2]));
+					throw Exception::Simulated_domain_too_small;
+				}//endif shell_radius >= Length(boundary_vecs)
+			}//endfor jneigh
+		}//endfor ispin
+	}
+
 	void Neighbours::Create_Neighbours(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions, 
 		const int n_shells, std::vector<std::vector<int>> &n_spins_in_shell,
 		std::vector<std::vector<std::vector<int>>> & neigh,
@@ -27,7 +46,7 @@ namespace Engine
 		//========================= Init local vars ================================
 		auto nos = geometry.nos;
 		//int max_neigh_number = 0, max_nt4_spin, max_ndm, ispin, jneigh;
-		int max_ndm, i, j;
+		int max_ndm, i;
 		scalar spin_sum_3d = 0;
 		std::vector<int> max_number_n_in_shell;
 		std::vector<scalar> shell_radius;
@@ -43,17 +62,7 @@ namespace Engine
 		// Calculate shell radii
 		shell_radius = Get_Shell_Radius(geometry, n_shells);
 		// Check if domain makes sense
-		for (i = 1; i < n_boundary_vectors; ++i) {
-			for (j = 0; j < n_shells; ++j) {
-				if (2 * shell_radius[j] >= boundary_vectors[i].norm())
-				{
-					Log(Log_Level::Severe, Log_Sender::All, "Simulated domain is too small!\n     Shell " + std::to_string(n_shells) + " diameter=" + std::to_string(2 * shell_radius[j])
-					+ "\n    B.V.  " + std::to_string(i) + "   length=" + std::to_string(boundary_vectors[i].norm())
-					+ "\n    B.V.  " + std::to_string(i) + "   vec   =" + std::to_string(boundary_vectors[i][0]) + " " + std::to_string(boundary_vectors[i][1]) + " " + std::to_string(boundary_vectors[i][2]));
-					throw Exception::Simulated_domain_too_small;
-				}//endif shell_radius >= Length(boundary_vecs)
-			}//endfor jneigh
-		}//endfor ispin
+		Check_Domain_Size(boundary_vectors, n_shells, shell_radius);
 
 		// to calculate MaxNumber_NInShell one needs periodical BC - this vector is used to ensure this
 		std::vector<Vector3> boundary_vectors_true = Get_Boundary_Vectors(geometry, std::vector<bool>(3, true));
@@ -131,6 +140,93 @@ namespace Engine
 	}//end Neighbours::Create_Neighbours
 
 
+	void Neighbours::Create_Neighbours_Compressed(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions,
+		const int n_shells, intfield & neigh_offset, intfield & neigh, vectorfield & dm_normal,
+		int & max_n_4spin, intfield & n_4spin_offset, std::vector<std::array<int, 3>> & neigh_4spin)
+	{
+		int nos = geometry.nos;
+		auto boundary_vectors = Get_Boundary_Vectors(geometry, boundary_conditions);
+		auto shell_radius = Get_Shell_Radius(geometry, n_shells);
+		Check_Domain_Size(boundary_vectors, n_shells, shell_radius);
+
+		// The number of nearest neighbours in the periodic lattice determines the type of the lattice
+		auto max_number_n_in_shell = Get_MaxNumber_NInShell(geometry, n_shells, shell_radius,
+			Get_Boundary_Vectors(geometry, std::vector<bool>(3, true)), true);
+
+		// Calculate the Neighbours, dm_normal holds their positions until the DM normal vectors are calculated
+		Get_Neighbours_in_Shells_Compressed(geometry, n_shells, shell_radius, boundary_vectors, neigh_offset, neigh, dm_normal, true);
+
+		// Four-Spin Neighbours (diamonds of nearest neighbours) on the square and hexagonal 2D lattices
+		max_n_4spin = 1;
+		n_4spin_offset = intfield(nos + 1, 0);
+		neigh_4spin = std::vector<std::array<int, 3>>(0);
+		scalar spin_sum_3d = 0;
+		for (int ispin = 0; ispin < nos; ++ispin) spin_sum_3d += std::abs(geometry.spin_pos[ispin][2]);
+		if (spin_sum_3d == 0)
+		{
+			Log(Log_Level::Info, Log_Sender::All, "------------- 2D Case -------------");
+			if (max_number_n_in_shell[0] == 4)
+			{
+				max_n_4spin = 4;
+				Log(Log_Level::Info, Log_Sender::All, "4-spin for square lattice!");
+			}
+			else if (max_number_n_in_shell[0] == 6)
+			{
+				max_n_4spin = 12;
+				Log(Log_Level::Info, Log_Sender::All, "4-spin for hexagonal lattice!");
+			}
+			else Log(Log_Level::Warning, Log_Sender::All, "4-spin interaction is not defined for this type of lattice!");
+		}
+		else
+		{
+			Log(Log_Level::Info, Log_Sender::All, "------------- 3D Case -------------");
+			Log(Log_Level::Warning, Log_Sender::All, "4-spin interaction is not defined for the 3D case");
+		}
+		if (max_n_4spin > 1)
+		{
+			auto first = [&](int ispin) { return neigh_offset[ispin*n_shells]; };
+			auto last  = [&](int ispin) { return neigh_offset[ispin*n_shells + 1]; };
+			// Same order as Create_Neighbours_4Spin
+			for (int ispin = 0; ispin < nos; ++ispin)
+			{
+				for (int jneigh = first(ispin); jneigh < last(ispin); ++jneigh)
+				{
+					int jspin = neigh[jneigh];
+					for (int lneigh = jneigh + 1; lneigh < last(ispin); ++lneigh)
+					{
+						int lspin = neigh[lneigh];
+						for (int kneigh = first(jspin); kneigh < last(jspin); ++kneigh)
+						{
+							int kspin = neigh[kneigh];
+							for (int mneigh = first(lspin); mneigh < last(lspin); ++mneigh)
+							{
+								if (neigh[mneigh] == kspin && kspin != ispin) neigh_4spin.push_back({ jspin, kspin, lspin });
+							}
+						}
+					}
+				}
+				n_4spin_offset[ispin + 1] = neigh_4spin.size();
+			}
+			neigh_4spin.shrink_to_fit();
+		}
+
+		// Bulk DM normal vectors of the nearest neighbours, zero for the other shells
+		for (int ispin = 0; ispin < nos; ++ispin)
+		{
+			for (int k = neigh_offset[ispin*n_shells]; k < neigh_offset[(ispin + 1)*n_shells]; ++k)
+			{
+				if (k < neigh_offset[ispin*n_shells + 1])
+				{
+					Vector3 r_a = dm_normal[k] - geometry.spin_pos[ispin];
+					r_a.normalize();
+					dm_normal[k] = r_a;
+				}
+				else dm_normal[k] = Vector3::Zero();
+			}
+		}
+	}//end Neighbours::Create_Neighbours_Compressed
+
+
 	std::vector<scalar> Neighbours::Get_Shell_Radius(const Data::Geometry & geometry, const int n_shells)
 	{
 		auto shell_radius = std::vector<scalar>(n_shells);
@@ -192,34 +288,89 @@ namespace Engine
 	}//end Neighbours::Get_Shell_Radius
 
 
+	std::vector<Neighbours::Neighbour_Offset> Neighbours::Get_Neighbour_Offsets(const Data::Geometry & geometry, const scalar radius, const std::vector<int> & max_translations)
+	{
+		std::vector<Neighbour_Offset> offsets;
+		int N = geometry.n_spins_basic_domain;
+		const std::vector<Vector3> & t = geometry.translation_vectors;
+
+		// A translation d along t[0] shifts a position by d*V/|t[1] x t[2]| perpendicular to the plane of t[1] and t[2].
+		//		The vector between two atoms can only be shorter than radius if this shift is smaller than
+		//		radius plus the largest separation of two basis atoms, and analogous for the other directions.
+		scalar basis_extent = 0;
+		for (int iatom = 0; iatom < N; ++iatom)
+		{
+			for (int jatom = 0; jatom < N; ++jatom)
+			{
+				basis_extent = std::max(basis_extent, (geometry.spin_pos[jatom] - geometry.spin_pos[iatom]).norm());
+			}
+		}
+		scalar volume = std::abs(t[0].dot(t[1].cross(t[2])));
+		int max_d[3];
+		for (int dim = 0; dim < 3; ++dim)
+		{
+			scalar plane_area = t[(dim + 1) % 3].cross(t[(dim + 2) % 3]).norm();
+			// Clamp before converting, as the bound can exceed the range of int for large radii
+			scalar bound = max_translations[dim];
+			if (volume > 0) bound = std::min(bound, std::ceil((radius + 1.0E-5 + basis_extent) * plane_area / volume));
+			max_d[dim] = std::max((int)bound, 0);
+		}
+
+		// Because the terms with the largest distance are the smallest, we start with the largest translations
+		for (int iatom = 0; iatom < N; ++iatom)
+		{
+			for (int jatom = 0; jatom < N; ++jatom)
+			{
+				for (int da = max_d[0]; da >= 0; --da)
+				{
+					for (int db = max_d[1]; db >= 0; --db)
+					{
+						for (int dc = max_d[2]; dc >= 0; --dc)
+						{
+							for (int sign_a = -1; sign_a <= 1; sign_a += 2)
+							{
+							for (int sign_b = -1; sign_b <= 1; sign_b += 2)
+							{
+							for (int sign_c = -1; sign_c <= 1; sign_c += 2)
+							{
+								// Zero translations are visited only once
+								if ((da == 0 && sign_a == -1) || (db == 0 && sign_b == -1) || (dc == 0 && sign_c == -1)) continue;
+								Neighbour_Offset offset;
+								offset.iatom = iatom;
+								offset.jatom = jatom;
+								offset.translation[0] = sign_a * da;
+								offset.translation[1] = sign_b * db;
+								offset.translation[2] = sign_c * dc;
+								Vector3 jpos = geometry.spin_pos[jatom]
+													+ t[0]*offset.translation[0]
+													+ t[1]*offset.translation[1]
+													+ t[2]*offset.translation[2];
+								offset.vector_ij = jpos - geometry.spin_pos[iatom];
+								offset.distance = offset.vector_ij.norm();
+								if (offset.distance > 0 && offset.distance - radius < 1.0E-5) offsets.push_back(offset);
+							}
+							}
+							}
+						}
+					}
+				}
+			}
+		}
+		return offsets;
+	}//end Neighbours::Get_Neighbour_Offsets
+
+
 	std::vector<int> Neighbours::Get_MaxNumber_NInShell(const Data::Geometry & geometry, const int n_shells, const std::vector<scalar> & shell_radius, 
 		std::vector<Vector3> boundary_vectors, const bool borderOnly)
 	{
 		auto max_number_n_in_shell = std::vector<int>(n_shells, 0);
-		auto max_temp = std::vector<int>(n_shells, 0);
 		//========================= Init local vars ================================
-		Vector3 ipos = { 0, 0, 0 };
-		Vector3 jpos = { 0, 0, 0 };
-		scalar dist;
-		unsigned int bvector, number_b_vectors = boundary_vectors.size();
-		int iatom, jatom, shell;
-		Vector3 build_array = { 0, 0, 0 };
-		int nos = geometry.nos;
-
-		int imax = 10, jmax = 10, kmax = 10;
-		if (!borderOnly) {
-			// Set the n_cells in which to fit this shell and determine MaxNumber_NInShell
-			imax = 30; jmax = 30; kmax = 30;
-			Log(Utility::Log_Level::Debug, Utility::Log_Sender::All, "Remember Maximum size of Dipole shell should fit into " + std::to_string(imax) + "x" + std::to_string(jmax) + "x" + std::to_string(kmax) + " translations. Neighbours.cpp line 178 to change this");
-		}
-		// Retrieve basis vectors from geometry.basis
-		Vector3 a = geometry.basis[0];
-		Vector3 b = geometry.basis[1];
-		Vector3 c = geometry.basis[2];
-		//abort condidions for all 3 vectors
-		if (a.norm() == 0.0) imax = 0;
-		if (b.norm() == 0.0) jmax = 0;
-		if (c.norm() == 0.0) kmax = 0;
+		int N = geometry.n_spins_basic_domain;
+		int Na = geometry.n_cells[0];
+		int Nb = geometry.n_cells[1];
+		int Nc = geometry.n_cells[2];
+		int n_cells[3] = { Na, Nb, Nc };
+		int iatom, shell, dim;
 		//------------------------ End Init ----------------------------------------
 		// Create stub for function to check wether the atom is in the shell
 		std::function<bool(scalar)> check = [](scalar d) { return false; };
@@ -239,33 +390,66 @@ namespace Engine
 				return d < 1.0E-5;
         	};
 		}
-		// Loop over all atoms
-		for (iatom = 0; iatom < 1; ++iatom)//geometry.nos; ++iatom)
+
+		// Each boundary vector translates by -1, 0 or +1 times the lattice along each direction.
+		//		Look up its position in the list, as only the first matching boundary vector is counted for each atom.
+		std::vector<int> bvector_index(27, -1);
+		Matrix3 lattice;
+		for (dim = 0; dim < 3; ++dim) lattice.col(dim) = geometry.translation_vectors[dim] * geometry.n_cells[dim];
+		Matrix3 lattice_inverse = lattice.inverse();
+		for (unsigned int bvector = 0; bvector < boundary_vectors.size(); ++bvector)
 		{
-			for (shell = 0; shell < n_shells; ++shell) max_temp[shell] = 0;
-			ipos = geometry.spin_pos[iatom];
-			// Loop over neighbours, avoid scalar counting
-			for (jatom = iatom + 1; jatom < geometry.nos; ++jatom)
+			Vector3 coefficients = lattice_inverse * boundary_vectors[bvector];
+			int key = 0;
+			for (dim = 0; dim < 3; ++dim) key = 3 * key + (int)std::round(coefficients[dim]) + 1;
+			if (key >= 0 && key < 27 && bvector_index[key] < 0) bvector_index[key] = bvector;
+		}
+
+		// Offsets to all atoms which could be in a shell, including their images across the boundaries
+		scalar radius = *std::max_element(shell_radius.begin(), shell_radius.end()) + 1.0E-4;
+		auto offsets = Get_Neighbour_Offsets(geometry, radius, std::vector<int>{ 2 * Na - 1, 2 * Nb - 1, 2 * Nc - 1 });
+
+		// Loop over the basis atoms of the first cell
+		for (iatom = 0; iatom < N; ++iatom)
+		{
+			// For every neighbour: spin index, index of the boundary vector and shell
+			std::vector<std::array<int, 3>> matches;
+			for (auto & offset : offsets)
 			{
-				// Loop also over atoms translated by boundary conditions
-				for (bvector = 0; bvector < number_b_vectors; ++bvector)
+				if (offset.iatom != iatom) continue;
+				// Split the translation into a cell of the lattice and a boundary vector
+				int cell[3], key = 0;
+				bool valid = true;
+				for (dim = 0; dim < 3; ++dim)
 				{
-					jpos = geometry.spin_pos[jatom] + boundary_vectors[bvector];
-					// ipos - jpos
-					build_array = ipos - jpos;
-					// dist = |ipos-jpos|
-					dist = build_array.norm();
-					// Test if the distance corresponds to a shell
-					for (shell = 0; shell < n_shells; ++shell)
+					int d = offset.translation[dim];
+					int image = (d >= 0) ? d / n_cells[dim] : -((n_cells[dim] - 1 - d) / n_cells[dim]);
+					if (image < -1 || image > 1) valid = false;
+					cell[dim] = d - image * n_cells[dim];
+					key = 3 * key + image + 1;
+				}
+				if (!valid || bvector_index[key] < 0) continue;
+				int jspin = offset.jatom + N*cell[0] + N*Na*cell[1] + N*Na*Nb*cell[2];
+				// The atom itself is not its own neighbour
+				if (jspin == iatom) continue;
+				// Same distance as in Get_Neighbours_in_Shells
+				Vector3 jpos = geometry.spin_pos[jspin] + boundary_vectors[bvector_index[key]];
+				scalar dist = (geometry.spin_pos[iatom] - jpos).norm();
+				for (shell = 0; shell < n_shells; ++shell)
+				{
+					if ( check(dist - shell_radius[shell]) )
 					{
-						if ( check(dist - shell_radius[shell]) )
-						{
-							++max_temp[shell];
-							goto B;
-						}
+						matches.push_back({ jspin, bvector_index[key], shell });
+						break;
 					}
 				}
-			B:;
+			}
+			// Count every neighbour once, in the shell of its first matching boundary vector
+			std::sort(matches.begin(), matches.end());
+			auto max_temp = std::vector<int>(n_shells, 0);
+			for (unsigned int i = 0; i < matches.size(); ++i)
+			{
+				if (i == 0 || matches[i][0] != matches[i - 1][0]) ++max_temp[matches[i][2]];
 			}
 			// Test if current atom has a greater number of neighbours than the previous ones
 			for (shell = 0; shell < n_shells; ++shell)
@@ -278,19 +462,144 @@ namespace Engine
 	}//end Neighbours::Get_MaxNumber_NInShell
 
 
+	// Calls found(iatom, jatom, shell, jpos) for every neighbour jatom (at position jpos) of every atom iatom.
+	//		The atoms are processed in parallel, so found may only write the data of iatom. For each atom,
+	//		the neighbours are found in ascending order, i.e. in the order of Get_Neighbours_in_Shells_Reference.
+	static void Search_Neighbours(const Data::Geometry & geometry, const int n_shells, const std::vector<scalar> & shell_radius,
+		const std::vector<Vector3> & boundary_vectors, const bool borderOnly, const std::function<void(int, int, int, const Vector3 &)> & found)
+	{
+		//========================= Init local vars ================================
+		unsigned int number_b_vectors = boundary_vectors.size();
+		int iatom, dim;
+		int nos = geometry.nos;
+		//------------------------ End Init ----------------------------------------
+		// Create stub for function to check wether the atom is in the shell
+		std::function<bool(scalar)> check = [](scalar d) { return false; };
+		if (borderOnly) 
+		{
+			// Consider only the atoms on a specific distance d
+			check = [](scalar d)
+			{
+				return std::abs(d) < 1.0E-5;
+        	};
+		}
+		else
+		{
+			// Consider all the atoms inside a distance d
+			check = [](scalar d)
+			{
+				return d < 1.0E-5;
+        	};
+		}
+
+		// ------ Sort the atoms into bins ------
+		// The bins are at least as large as the outermost shell, so all neighbours
+		// of a position lie in the 3x3x3 bins around it
+		scalar bin_size = *std::max_element(shell_radius.begin(), shell_radius.end()) + 2.0E-5;
+		Vector3 pos_min = geometry.spin_pos[0], pos_max = geometry.spin_pos[0];
+		for (iatom = 1; iatom < nos; ++iatom)
+		{
+			pos_min = pos_min.cwiseMin(geometry.spin_pos[iatom]);
+			pos_max = pos_max.cwiseMax(geometry.spin_pos[iatom]);
+		}
+		int n_bins[3];
+		while (true)
+		{
+			for (dim = 0; dim < 3; ++dim) n_bins[dim] = 1 + (int)((pos_max[dim] - pos_min[dim]) / bin_size);
+			// Sparse geometries should not produce more bins than atoms
+			if ((long long)n_bins[0] * n_bins[1] * n_bins[2] <= 4 * (long long)nos + 64) break;
+			bin_size *= 2;
+		}
+		auto bin_coordinate = [&](scalar x, int dim)
+		{
+			return (int)std::floor((x - pos_min[dim]) / bin_size);
+		};
+		auto bin_index = [&](const Vector3 & pos)
+		{
+			int b[3];
+			for (int d = 0; d < 3; ++d) b[d] = std::min(std::max(bin_coordinate(pos[d], d), 0), n_bins[d] - 1);
+			return b[0] + n_bins[0] * (b[1] + n_bins[1] * b[2]);
+		};
+		// Counting sort keeps the atoms in each bin in ascending order
+		std::vector<int> bin_offset(n_bins[0] * n_bins[1] * n_bins[2] + 1, 0);
+		std::vector<int> bin_atoms(nos);
+		for (iatom = 0; iatom < nos; ++iatom) ++bin_offset[bin_index(geometry.spin_pos[iatom]) + 1];
+		for (unsigned int ibin = 1; ibin < bin_offset.size(); ++ibin) bin_offset[ibin] += bin_offset[ibin - 1];
+		auto bin_fill = std::vector<int>(bin_offset.begin(), bin_offset.end() - 1);
+		for (iatom = 0; iatom < nos; ++iatom) bin_atoms[bin_fill[bin_index(geometry.spin_pos[iatom])]++] = iatom;
+
+		// ------ Search the neighbours of each atom ------
+		// The candidates are tested in ascending order with the same expressions as
+		// Get_Neighbours_in_Shells_Reference, so that the lists are identical.
+		Utility::Threading::Parallel_For(nos, [&](int begin, int end)
+		{
+			std::vector<int> candidates;
+			for (int iatom = begin; iatom < end; ++iatom)
+			{
+				// Gather the atoms in the bins around all periodic images of iatom
+				candidates.clear();
+				for (unsigned int bvector = 0; bvector < number_b_vectors; ++bvector)
+				{
+					for (int sign = -1; sign <= 1; sign += 2)
+					{
+						Vector3 center = geometry.spin_pos[iatom] + sign * boundary_vectors[bvector];
+						int lower[3], upper[3];
+						for (int d = 0; d < 3; ++d)
+						{
+							int b = bin_coordinate(center[d], d);
+							lower[d] = std::max(b - 1, 0);
+							upper[d] = std::min(b + 1, n_bins[d] - 1);
+						}
+						for (int bc = lower[2]; bc <= upper[2]; ++bc)
+						{
+							for (int bb = lower[1]; bb <= upper[1]; ++bb)
+							{
+								for (int ba = lower[0]; ba <= upper[0]; ++ba)
+								{
+									int ibin = ba + n_bins[0] * (bb + n_bins[1] * bc);
+									for (int k = bin_offset[ibin]; k < bin_offset[ibin + 1]; ++k)
+									{
+										if (bin_atoms[k] != iatom) candidates.push_back(bin_atoms[k]);
+									}
+								}
+							}
+						}
+					}
+				}
+				std::sort(candidates.begin(), candidates.end());
+				candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+				for (int jatom : candidates)
+				{
+					// The reference loop visits every pair once, with the lower index first
+					int ilow = std::min(iatom, jatom), ihigh = std::max(iatom, jatom);
+					for (unsigned int bvector = 0; bvector < number_b_vectors; ++bvector)
+					{
+						Vector3 jpos = geometry.spin_pos[ihigh] + boundary_vectors[bvector];
+						scalar dist = (geometry.spin_pos[ilow] - jpos).norm();
+						for (int shell = 0; shell < n_shells; ++shell)
+						{
+							if ( check(dist - shell_radius[shell]) )
+							{
+								if (iatom == ilow) found(iatom, jatom, shell, jpos);
+								else found(iatom, jatom, shell, geometry.spin_pos[jatom] - boundary_vectors[bvector]);
+								goto A;
+							}
+						}//endfor shell
+					}//endfor bvector
+				A:;
+				}//endfor jatom
+			}//endfor iatom
+		});
+	}
+
+
 	void Neighbours::Get_Neighbours_in_Shells(const Data::Geometry & geometry, const int n_shells, const std::vector<scalar> & shell_radius,
 		const std::vector<Vector3> &boundary_vectors, std::vector<std::vector<int>> &n_spins_in_shell,
 		std::vector<std::vector<std::vector<int>>> & neigh, std::vector<std::vector<std::vector<Vector3>>> & neigh_pos, const bool borderOnly)
 	{
 		//========================= Init local vars ================================
-		Vector3 ipos = { 0, 0, 0 };
-		Vector3 jpos = { 0, 0, 0 };
-		scalar dist;
-		unsigned int bvector, number_b_vectors = boundary_vectors.size();
 		int iatom, jatom, jspin, shell;
-		Vector3 build_array = { 0, 0, 0 };
-
-		int nos = geometry.nos;
 
 		std::string output_to_file;
 		if (geometry.nos < 5E+06)
@@ -303,6 +612,86 @@ namespace Engine
 		char buffer_file_name[name_length + 2];
 		char buffer_string_conversion[buffer_length + 2];
 		//------------------------ End Init ----------------------------------------
+
+		Search_Neighbours(geometry, n_shells, shell_radius, boundary_vectors, borderOnly, [&](int iatom, int jatom, int shell, const Vector3 & jpos)
+		{
+			neigh[iatom][shell][n_spins_in_shell[iatom][shell]] = jatom;
+			neigh_pos[iatom][shell][n_spins_in_shell[iatom][shell]] = jpos;
+			n_spins_in_shell[iatom][shell] = n_spins_in_shell[iatom][shell] + 1;
+		});
+
+		for (shell = 0; shell < n_shells; ++shell)
+		{
+			snprintf(buffer_file_name, name_length, "output/neighbours_in_shell_%03i.dat", (shell + 1));
+			output_to_file = "List of neighbours in the ";
+			snprintf(buffer_string_conversion, buffer_length, "%03i-th shell\n Spin   Number of |List of   \n number|neighbours|neighbours", shell + 1);
+			output_to_file.append(buffer_string_conversion);
+			for (iatom = 0; iatom < geometry.nos; ++iatom)
+			{
+				snprintf(buffer_string_conversion, buffer_length, "\n%7i| %7i  |", iatom, n_spins_in_shell[iatom][shell]);
+				output_to_file.append(buffer_string_conversion);
+				for (jatom = 0; jatom < n_spins_in_shell[iatom][shell]; ++jatom)
+				{
+					snprintf(buffer_string_conversion, buffer_length, "%6i", neigh[iatom][shell][jatom]);
+					output_to_file.append(buffer_string_conversion);
+				}//endfor jatom
+			}//endfor iatom
+			IO::Dump_to_File(output_to_file, buffer_file_name);
+		}//endfor shell
+
+		output_to_file = "";
+		for (iatom = 0; iatom < geometry.nos; ++iatom)
+		{
+			snprintf(buffer_string_conversion, buffer_length, "\n %06i|", iatom);
+			output_to_file.append(buffer_string_conversion);
+			for (jatom = 0; jatom < n_spins_in_shell[iatom][0]; ++jatom)
+			{
+				jspin = neigh[iatom][0][jatom];
+				snprintf(buffer_string_conversion, buffer_length, " %12.6f %12.6f %12.6f", neigh_pos[iatom][0][jatom][0], neigh_pos[iatom][0][jatom][1], neigh_pos[iatom][0][jatom][2]);
+				output_to_file.append(buffer_string_conversion);
+			}//endfor jatom
+		}//endfor iatom
+		IO::Dump_to_File(output_to_file, "output/neighbours_pos_shell_1.dat");
+	}//end Neighbours::Get_Neighbours_in_Shells
+
+
+	void Neighbours::Get_Neighbours_in_Shells_Compressed(const Data::Geometry & geometry, const int n_shells, const std::vector<scalar> & shell_radius,
+		const std::vector<Vector3> & boundary_vectors, intfield & offset, intfield & neigh, vectorfield & neigh_pos, const bool borderOnly)
+	{
+		int nos = geometry.nos;
+		// Count the neighbours of each atom in each shell
+		offset = intfield(nos*n_shells + 1, 0);
+		Search_Neighbours(geometry, n_shells, shell_radius, boundary_vectors, borderOnly, [&](int iatom, int, int shell, const Vector3 &)
+		{
+			++offset[iatom*n_shells + shell + 1];
+		});
+		for (int idx = 0; idx < nos*n_shells; ++idx) offset[idx + 1] += offset[idx];
+
+		// Search again to store them
+		neigh = intfield(offset.back());
+		neigh_pos = vectorfield(offset.back());
+		auto fill = intfield(offset.begin(), offset.end() - 1);
+		Search_Neighbours(geometry, n_shells, shell_radius, boundary_vectors, borderOnly, [&](int iatom, int jatom, int shell, const Vector3 & jpos)
+		{
+			int k = fill[iatom*n_shells + shell]++;
+			neigh[k] = jatom;
+			neigh_pos[k] = jpos;
+		});
+	}//end Neighbours::Get_Neighbours_in_Shells_Compressed
+
+
+	void Neighbours::Get_Neighbours_in_Shells_Reference(const Data::Geometry & geometry, const int n_shells, const std::vector<scalar> & shell_radius,
+		const std::vector<Vector3> &boundary_vectors, std::vector<std::vector<int>> &n_spins_in_shell,
+		std::vector<std::vector<std::vector<int>>> & neigh, std::vector<std::vector<std::vector<Vector3>>> & neigh_pos, const bool borderOnly)
+	{
+		//========================= Init local vars ================================
+		Vector3 ipos = { 0, 0, 0 };
+		Vector3 jpos = { 0, 0, 0 };
+		scalar dist;
+		unsigned int bvector, number_b_vectors = boundary_vectors.size();
+		int iatom, jatom, shell;
+		Vector3 build_array = { 0, 0, 0 };
+		//------------------------ End Init ----------------------------------------
 		// Create stub for function to check wether the atom is in the shell
 		std::function<bool(scalar)> check = [](scalar d) { return false; };
 		if (borderOnly) 
@@ -361,40 +750,7 @@ namespace Engine
 			A:;
 			}//endfor jatom
 		}//endfor iatom
-
-		for (shell = 0; shell < n_shells; ++shell)
-		{
-			snprintf(buffer_file_name, name_length, "output/neighbours_in_shell_%03i.dat", (shell + 1));
-			output_to_file = "List of neighbours in the ";
-			snprintf(buffer_string_conversion, buffer_length, "%03i-th shell\n Spin   Number of |List of   \n number|neighbours|neighbours", shell + 1);
-			output_to_file.append(buffer_string_conversion);
-			for (iatom = 0; iatom < geometry.nos; ++iatom)
-			{
-				snprintf(buffer_string_conversion, buffer_length, "\n%7i| %7i  |", iatom, n_spins_in_shell[iatom][shell]);
-				output_to_file.append(buffer_string_conversion);
-				for (jatom = 0; jatom < n_spins_in_shell[iatom][shell]; ++jatom)
-				{
-					snprintf(buffer_string_conversion, buffer_length, "%6i", neigh[iatom][shell][jatom]);
-					output_to_file.append(buffer_string_conversion);
-				}//endfor jatom
-			}//endfor iatom
-			IO::Dump_to_File(output_to_file, buffer_file_name);
-		}//endfor shell
-
-		output_to_file = "";
-		for (iatom = 0; iatom < geometry.nos; ++iatom)
-		{
-			snprintf(buffer_string_conversion, buffer_length, "\n %06i|", iatom);
-			output_to_file.append(buffer_string_conversion);
-			for (jatom = 0; jatom < n_spins_in_shell[iatom][0]; ++jatom)
-			{
-				jspin = neigh[iatom][0][jatom];
-				snprintf(buffer_string_conversion, buffer_length, " %12.6f %12.6f %12.6f", neigh_pos[iatom][0][jatom][0], neigh_pos[iatom][0][jatom][1], neigh_pos[iatom][0][jatom][2]);
-				output_to_file.append(buffer_string_conversion);
-			}//endfor jatom
-		}//endfor iatom
-		IO::Dump_to_File(output_to_file, "output/neighbours_pos_shell_1.dat");
-	}//end Neighbours::Get_Neighbours_in_Shells
+	}//end Neighbours::Get_Neighbours_in_Shells_Reference
 
 
 	void Neighbours::Create_Neighbours_4Spin(const int nos, const int n_shells, const std::vector<std::vector<std::vector<int>>> & neigh,
@@ -602,156 +958,106 @@ namespace Engine
 	void Neighbours::Create_Dipole_Pairs(const Data::Geometry & geometry, scalar dd_radius,
 		std::vector<indexPairs> & DD_indices, std::vector<scalarfield> & DD_magnitude, std::vector<vectorfield> & DD_normal)
 	{
-		// Get the boundary vectors
-		// auto boundary_vectors = Engine::Neighbours::Get_Boundary_Vectors(geometry, std::vector<bool>{ true, true, true });
-		
 		// ------ Find the pairs for the first cell ------
-		Vector3 vector_ij,  build_array, ipos, jpos;
-		scalar magnitude;
-		
-		int iatom, jatom;
-		int da, db, dc;
-		int sign_a, sign_b, sign_c;
-		int pair_da, pair_db, pair_dc;
 		int na, nb, nc;
+		int pair_da, pair_db, pair_dc;
 
 		int idx_i = 0, idx_j = 0;
 		int Na = geometry.n_cells[0];
 		int Nb = geometry.n_cells[1];
 		int Nc = geometry.n_cells[2];
 		int N = geometry.n_spins_basic_domain;
-		int nos = geometry.nos;
 		
 		int periods_a, periods_b, periods_c, pair_periodicity;
 
-		// Loop over all basis atoms
-		for (iatom = 0; iatom < N; ++iatom)
+		if (dd_radius <= 0) return;
+
+		// Pairs of basis atoms within the DD radius, translated by less than the size of the lattice
+		auto offsets = Get_Neighbour_Offsets(geometry, dd_radius, std::vector<int>{ Na - 1, Nb - 1, Nc - 1 });
+
+		for (auto & offset : offsets)
 		{
-			for (jatom = 0; jatom < N; ++jatom)
+			pair_da = offset.translation[0];
+			pair_db = offset.translation[1];
+			pair_dc = offset.translation[2];
+			// Normal
+			Vector3 normal = offset.vector_ij.normalized();
+
+			// ------ Translate for the whole lattice ------
+			// Create all Pairs of this Kind through translation
+			for (na = 0; na < Na; ++na)
 			{
-				// Because the terms with the largest distance are the smallest, we start with the largest indices
-				for (da = Na-1; da >= 0; --da)
+				for (nb = 0; nb < Nb; ++nb)
 				{
-					for (db = Nb-1; db >= 0; --db)
+					for (nc = 0; nc < Nc; ++nc)
 					{
-						for (dc = Nc-1; dc >= 0; --dc)
+						idx_i = offset.iatom + N*na + N*Na*nb + N*Na*Nb*nc;
+						// na + pair_da is absolute position of cell in x direction
+						// if (na + pair_da) > Na (number of atoms in x)
+						// go to the other side with % Na
+						// if (na + pair_da) negative (or multiply (of Na) negative)
+						// add Na and modulo again afterwards
+						// analogous for y and z direction with nb, nc
+						idx_j = offset.jatom	+ N*( (((na + pair_da) % Na) + Na) % Na )
+												+ N*Na*( (((nb + pair_db) % Nb) + Nb) % Nb )
+												+ N*Na*Nb*( (((nc + pair_dc) % Nc) + Nc) % Nc );
+						// Determine the periodicity
+						periods_a = (na + pair_da < 0 || na + pair_da >= Na);
+						periods_b = (nb + pair_db < 0 || nb + pair_db >= Nb);
+						periods_c = (nc + pair_dc < 0 || nc + pair_dc >= Nc);
+						pair_periodicity = 0;
+						//		none
+						if (periods_a == 0 && periods_b == 0 && periods_c == 0)
 						{
-							for (sign_a = -1; sign_a <= 1; sign_a+=2)
-							{
-							for (sign_b = -1; sign_b <= 1; sign_b+=2)
-							{
-							for (sign_c = -1; sign_c <= 1; sign_c+=2)
-							{
-								pair_da = sign_a * da;
-								pair_db = sign_b * db;
-								pair_dc = sign_c * dc;
-								// Calculate positions and difference vector
-								ipos 		= geometry.spin_pos[iatom];
-								jpos 		= geometry.spin_pos[jatom]
-													+ geometry.translation_vectors[0]*pair_da
-													+ geometry.translation_vectors[1]*pair_db
-													+ geometry.translation_vectors[2]*pair_dc;
-								vector_ij  = jpos - ipos;
-								
-								// Length of difference vector
-								magnitude = vector_ij.norm();
-								if ( magnitude==0.0 || (da==0 && sign_a==-1) || (db==0 && sign_b==-1) || (dc==0 && sign_c==-1) )
-								{
-									magnitude = dd_radius + 1.0;
-								}
-								// Check if inside DD radius
-								if ( magnitude - dd_radius < 1.0E-5 )
-								{
-									// std::cerr << "found " << iatom << " " << jatom << std::endl;
-									// std::cerr << "      " << pair_da << " " << pair_db << " " << pair_dc << std::endl;
-									// Normal
-									vector_ij.normalize();
-
-									// ------ Translate for the whole lattice ------
-									// Create all Pairs of this Kind through translation
-									for (na = 0; na < Na; ++na)
-									{
-										for (nb = 0; nb < Nb; ++nb)
-										{
-											for (nc = 0; nc < Nc; ++nc)
-											{
-												idx_i = iatom + N*na + N*Na*nb + N*Na*Nb*nc;
-												// na + pair_da is absolute position of cell in x direction
-												// if (na + pair_da) > Na (number of atoms in x)
-												// go to the other side with % Na
-												// if (na + pair_da) negative (or multiply (of Na) negative)
-												// add Na and modulo again afterwards
-												// analogous for y and z direction with nb, nc
-												idx_j = jatom	+ N*( (((na + pair_da) % Na) + Na) % Na )
-																+ N*Na*( (((nb + pair_db) % Nb) + Nb) % Nb )
-																+ N*Na*Nb*( (((nc + pair_dc) % Nc) + Nc) % Nc );
-												// Determine the periodicity
-												periods_a = (na + pair_da) / Na;
-												periods_b = (nb + pair_db) / Nb;
-												periods_c = (nc + pair_dc) / N;
-												//		none
-												if (periods_a == 0 && periods_b == 0 && periods_c == 0)
-												{
-													pair_periodicity = 0;
-												}
-												//		a
-												else if (periods_a != 0 && periods_b == 0 && periods_c == 0)
-												{
-													pair_periodicity = 1;
-												}
-												//		b
-												else if (periods_a == 0 && periods_b != 0 && periods_c == 0)
-												{
-													pair_periodicity = 2;
-												}
-												//		c
-												else if (periods_a == 0 && periods_b == 0 && periods_c != 0)
-												{
-													pair_periodicity = 3;
-												}
-												//		ab
-												else if (periods_a != 0 && periods_b != 0 && periods_c == 0)
-												{
-													pair_periodicity = 4;
-												}
-												//		ac
-												else if (periods_a != 0 && periods_b == 0 && periods_c != 0)
-												{
-													pair_periodicity = 5;
-												}
-												//		bc
-												else if (periods_a == 0 && periods_b != 0 && periods_c != 0)
-												{
-													pair_periodicity = 6;
-												}
-												//		abc
-												else if (periods_a != 0 && periods_b != 0 && periods_c != 0)
-												{
-													pair_periodicity = 7;
-												}
-
-												// Add the indices and parameters to the corresponding lists
-												if (idx_i < idx_j)
-												{
-													// std::cerr << "   made pair " << idx_i << " " << idx_j << std::endl;
-													DD_indices[pair_periodicity].push_back(indexPair{ idx_i, idx_j });
-													DD_magnitude[pair_periodicity].push_back(magnitude);
-													DD_normal[pair_periodicity].push_back(vector_ij);
-												}
-											}// end for nc
-										}// end for nb
-									}// end for na
-								}// end if in radius
-							}
-							}
-							}
-							// else 
-							// 	std::cerr << "outed " << iatom << " " << jatom << " with d=" << magnitude << std::endl;
-						}// end for pair_dc
-					}// end for pair_db
-				}// end for pair_da
-			}// end for jatom
-		}// end for iatom
+							pair_periodicity = 0;
+						}
+						//		a
+						else if (periods_a != 0 && periods_b == 0 && periods_c == 0)
+						{
+							pair_periodicity = 1;
+						}
+						//		b
+						else if (periods_a == 0 && periods_b != 0 && periods_c == 0)
+						{
+							pair_periodicity = 2;
+						}
+						//		c
+						else if (periods_a == 0 && periods_b == 0 && periods_c != 0)
+						{
+							pair_periodicity = 3;
+						}
+						//		ab
+						else if (periods_a != 0 && periods_b != 0 && periods_c == 0)
+						{
+							pair_periodicity = 4;
+						}
+						//		ac
+						else if (periods_a != 0 && periods_b == 0 && periods_c != 0)
+						{
+							pair_periodicity = 5;
+						}
+						//		bc
+						else if (periods_a == 0 && periods_b != 0 && periods_c != 0)
+						{
+							pair_periodicity = 6;
+						}
+						//		abc
+						else if (periods_a != 0 && periods_b != 0 && periods_c != 0)
+						{
+							pair_periodicity = 7;
+						}
+
+						// Add the indices and parameters to the corresponding lists
+						if (idx_i < idx_j)
+						{
+							DD_indices[pair_periodicity].push_back(indexPair{ idx_i, idx_j });
+							DD_magnitude[pair_periodicity].push_back(offset.distance);
+							DD_normal[pair_periodicity].push_back(normal);
+						}
+					}// end for nc
+				}// end for nb
+			}// end for na
+		}// end for offset
 	}
 
 
@@ -766,9 +1072,17 @@ namespace Engine
 		// Calculate boundary vectors
 		boundary_vectors = Get_Boundary_Vectors(geometry, boundary_conditions);
 
-		// Get maximum number of neighbours in the DD radius
-		max_n_array = Get_MaxNumber_NInShell(geometry, 1, shell_radius, boundary_vectors, false);
-		int max_n = max_n_array[0];
+		// Get maximum number of neighbours in the DD radius. Get_MaxNumber_NInShell counts only the atoms of the first cell,
+		//		which have fewer neighbours than the atoms inside the lattice for open boundary conditions, so the number of
+		//		offsets of each basis atom is used, which bounds the number of neighbours of every atom.
+		int max_n = 0;
+		if (dd_radius > 0.0)
+		{
+			max_n_array = std::vector<int>(geometry.n_spins_basic_domain, 0);
+			for (auto & offset : Get_Neighbour_Offsets(geometry, dd_radius, std::vector<int>{ 2 * geometry.n_cells[0] - 1, 2 * geometry.n_cells[1] - 1, 2 * geometry.n_cells[2] - 1 }))
+				++max_n_array[offset.iatom];
+			max_n = *std::max_element(max_n_array.begin(), max_n_array.end());
+		}
 		
 		//------------- Allocate output vectors ---------------
 		// Dipole Dipole neighbours of each spin neigh_dd[nos][max_n]
@@ -808,6 +1122,34 @@ namespace Engine
 		}
 	}// end Neighbours::Create_Dipole_Neighbours
 
+	void Neighbours::Create_Dipole_Neighbours_Compressed(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions,
+		const scalar dd_radius, intfield & dd_offset, intfield & dd_neigh, vectorfield & dd_normal, scalarfield & dd_distance)
+	{
+		if (dd_radius <= 0.0)
+		{
+			dd_offset = intfield(geometry.nos + 1, 0);
+			dd_neigh = intfield(0);
+			dd_normal = vectorfield(0);
+			dd_distance = scalarfield(0);
+			return;
+		}
+
+		// dd_normal holds the positions of the neighbours until the normal vectors are calculated
+		Get_Neighbours_in_Shells_Compressed(geometry, 1, std::vector<scalar>(1, dd_radius), Get_Boundary_Vectors(geometry, boundary_conditions),
+			dd_offset, dd_neigh, dd_normal, false);
+		dd_distance = scalarfield(dd_neigh.size());
+		for (int ispin = 0; ispin < geometry.nos; ++ispin)
+		{
+			for (int k = dd_offset[ispin]; k < dd_offset[ispin + 1]; ++k)
+			{
+				dd_normal[k] = geometry.spin_pos[ispin] - dd_normal[k];
+				dd_distance[k] = dd_normal[k].norm();
+				if (dd_distance[k] == 0.0) throw Exception::Division_by_zero;
+				dd_normal[k] = dd_normal[k] / dd_distance[k];
+			}
+		}
+	}// end Neighbours::Create_Dipole_Neighbours_Compressed
+
 	std::vector<Vector3> Neighbours::Get_Boundary_Vectors(const Data::Geometry & geometry, const std::vector<bool> & boundary_conditions)
 	{
 		// Determine vector size
@@ -1,11 +1,31 @@
 #include <engine/Optimizer.hpp>
 #include <utility/Timing.hpp>
 #include <utility/Logging.hpp>
+#include <utility/Exception.hpp>
+#include <utility/IO_Mapped_File.hpp>
+#include <utility/IO_Binary_File.hpp>
 
 using namespace Utility;
 
 #include <sstream>
 #include <iomanip>
+#include <cstdio>
+#include <cstdint>
+
+/*
+	Checkpoint files
+
+	The state of a running simulation, from which it can be continued exactly, i.e. reproducing
+	the uninterrupted trajectory bit for bit (on the same machine and build).
+		char[8]   magic "SPIRITCP"
+		uint32    format version
+		uint32    size of scalar in bytes
+	followed by arrays (see IO_Binary_File.hpp) containing
+		the names of the method and the optimizer, the number of systems and spins,
+		the number of iterations done and the start time of the simulation (for the names of the output files),
+		for each system its spins, the iteration of its thermal noise and the state of its PRNG,
+		the state of the method (Method::Save_State) and of the optimizer (Optimizer::Save_State).
+*/
 
 namespace Engine
 {
@@ -53,6 +73,12 @@ namespace Engine
         auto sender     = method->SenderName;
         //----
 		int i=0, step = 0;
+        //---- Continue from a checkpoint, if there is one
+        std::string checkpoint_file = this->method->parameters->checkpoint_file;
+        int n_iterations_checkpoint = this->method->parameters->n_iterations_checkpoint;
+        int i_start = 0;
+        bool resumed = checkpoint_file != "" && this->Load_Checkpoint(checkpoint_file, i_start);
+        if (i_start > 0) step = (i_start - 1) / n_iterations_log;
         //----
         std::stringstream maxforce_stream;
         maxforce_stream << std::fixed << std::setprecision(this->print_precision) << this->method->force_maxAbsComponent;
@@ -73,6 +99,7 @@ namespace Engine
 				"    Optimizer: " + this->FullName(),
 				"-----------------------------------------------------"
 			}, this->method->idx_image, this->method->idx_chain);
+        if (resumed) Log(Log_Level::All, sender, "    Continuing from checkpoint " + checkpoint_file + " at iteration " + std::to_string(i_start), this->method->idx_image, this->method->idx_chain);
 
         //---- Start Timings
 		auto t_start = system_clock::now();
@@ -80,18 +107,24 @@ namespace Engine
 		auto t_last = system_clock::now();
 
         //---- Initial save
-		this->method->Save_Current(this->starttime, i, true, false);
+		if (!resumed) this->method->Save_Current(this->starttime, i, true, false);
 
         //---- Iteration loop
-		for (i = 0; i < n_iterations && this->method->ContinueIterating() && !this->StopFilePresent(); ++i)
+		for (i = i_start; i < n_iterations && this->method->ContinueIterating() && !this->StopFilePresent(); ++i)
 		{
             // Pre-Iteration hook
             this->method->Hook_Pre_Iteration();
 			// Do one single Iteration
 			this->Iteration();
+			// The observables of the systems belong to the old spins
+			for (auto & system : this->method->systems) system->Invalidate();
             // Post-Iteration hook
             this->method->Hook_Post_Iteration();
 
+			// Checkpoint after every n_iterations_checkpoint iterations
+			if (checkpoint_file != "" && n_iterations_checkpoint > 0 && 0 == (i + 1) % n_iterations_checkpoint)
+				this->Save_Checkpoint(checkpoint_file, i + 1);
+
 			// Recalculate FPS
 			this->t_iterations.pop_front();
 			this->t_iterations.push_back(system_clock::now());
@@ -156,6 +189,13 @@ namespace Engine
 		block.push_back("-----------------------------------------------------");
 		Log.SendBlock(Log_Level::All, sender, block, this->method->idx_image, this->method->idx_chain);
 
+        //---- Checkpoint: an interrupted simulation can be continued, the one of a finished simulation is removed
+        if (checkpoint_file != "")
+        {
+            if (i < n_iterations && !this->method->Force_Converged()) this->Save_Checkpoint(checkpoint_file, i);
+            else std::remove(checkpoint_file.c_str());
+        }
+
         //---- Final save
 		this->method->Save_Current(this->starttime, i, false, true);
         //---- Finalize (set iterations_allowed to false etc.)
@@ -171,6 +211,167 @@ namespace Engine
 
 
 
+    void Optimizer::Save_Checkpoint(const std::string & file, int iteration)
+    {
+        // Written to a temporary file first, so that an interruption does not destroy the last checkpoint
+        std::string temp_file = file + ".tmp";
+        {
+            IO::Binary_Writer writer(temp_file);
+            writer.file.write("SPIRITCP", 8);
+            writer.Write_Raw<std::uint32_t>(1);
+            writer.Write_Raw<std::uint32_t>(sizeof(scalar));
+            writer.Write_Array(this->method->Name());
+            writer.Write_Array(this->Name());
+            writer.Write_Value<std::int32_t>(this->noi);
+            writer.Write_Value<std::int32_t>(this->nos);
+            writer.Write_Value<std::int64_t>(iteration);
+            writer.Write_Array(this->starttime);
+            for (auto & system : this->method->systems)
+            {
+                std::ostringstream prng;
+                prng << system->llg_parameters->prng;
+                writer.Write_Array(*system->spins);
+                writer.Write_Value(system->llg_parameters->noise_iteration);
+                writer.Write_Array(prng.str());
+            }
+            this->method->Save_State(writer);
+            this->Save_State(writer);
+            writer.file.close();
+            if (!writer.file)
+            {
+                Log(Log_Level::Error, method->SenderName, "Could not write checkpoint " + file, this->method->idx_image, this->method->idx_chain);
+                return;
+            }
+        }
+        // On some systems rename does not replace an existing file
+        if (std::rename(temp_file.c_str(), file.c_str()) != 0)
+        {
+            std::remove(file.c_str());
+            std::rename(temp_file.c_str(), file.c_str());
+        }
+        Log(Log_Level::Info, method->SenderName, "Wrote checkpoint " + file + " at iteration " + std::to_string(iteration), this->method->idx_image, this->method->idx_chain);
+    }
+
+    bool Optimizer::Load_Checkpoint(const std::string & file, int & iteration)
+    {
+        std::unique_ptr<IO::Mapped_File> mapped;
+        try
+        {
+            mapped = std::unique_ptr<IO::Mapped_File>(new IO::Mapped_File(file));
+        }
+        catch (Exception ex)
+        {
+            return false;
+        }
+        IO::Binary_Reader reader(*mapped);
+
+        // Header
+        char magic[8] = { 0 };
+        for (auto & c : magic) c = reader.Read_Raw<char>();
+        std::uint32_t version = reader.Read_Raw<std::uint32_t>();
+        std::uint32_t scalar_size = reader.Read_Raw<std::uint32_t>();
+        std::string method_name, optimizer_name, l_starttime;
+        reader.Read_Array(method_name);
+        reader.Read_Array(optimizer_name);
+        int l_noi = reader.Read_Value<std::int32_t>();
+        int l_nos = reader.Read_Value<std::int32_t>();
+        std::int64_t l_iteration = reader.Read_Value<std::int64_t>();
+        reader.Read_Array(l_starttime);
+        if (!reader.ok || std::string(magic, 8) != "SPIRITCP" || version != 1 || scalar_size != sizeof(scalar)
+            || method_name != this->method->Name() || optimizer_name != this->Name() || l_noi != this->noi || l_nos != this->nos)
+        {
+            Log(Log_Level::Warning, method->SenderName, "Checkpoint " + file + " does not belong to this " + this->method->Name() + " " + this->Name() + " simulation and is ignored",
+                this->method->idx_image, this->method->idx_chain);
+            return false;
+        }
+
+        // The systems are only modified once their data has been read completely
+        std::vector<vectorfield> spins(this->noi);
+        std::vector<std::uint64_t> noise_iterations(this->noi);
+        std::vector<std::string> prngs(this->noi);
+        for (int img = 0; img < this->noi; ++img)
+        {
+            reader.Read_Array(spins[img]);
+            noise_iterations[img] = reader.Read_Value<std::uint64_t>();
+            reader.Read_Array(prngs[img]);
+            if ((int)spins[img].size() != this->nos) reader.ok = false;
+        }
+        if (!reader.ok)
+        {
+            Log(Log_Level::Error, method->SenderName, "Checkpoint " + file + " is incomplete and is ignored", this->method->idx_image, this->method->idx_chain);
+            return false;
+        }
+
+        // The state of the method and the optimizer can only be read into them, so the current state is kept
+        //      to be restored if the checkpoint turns out to be incomplete
+        std::vector<vectorfield> spins_current(this->noi);
+        std::vector<std::uint64_t> noise_iterations_current(this->noi);
+        std::vector<std::string> prngs_current(this->noi);
+        for (int img = 0; img < this->noi; ++img)
+        {
+            auto & system = *this->method->systems[img];
+            std::ostringstream prng;
+            prng << system.llg_parameters->prng;
+            spins_current[img] = *system.spins;
+            noise_iterations_current[img] = system.llg_parameters->noise_iteration;
+            prngs_current[img] = prng.str();
+        }
+        std::ostringstream state_current;
+        {
+            IO::Binary_Writer writer(state_current);
+            this->method->Save_State(writer);
+            this->Save_State(writer);
+        }
+
+        auto set_state = [this](const std::vector<vectorfield> & spins, const std::vector<std::uint64_t> & noise_iterations,
+            const std::vector<std::string> & prngs, IO::Binary_Reader & state)
+        {
+            for (int img = 0; img < this->noi; ++img)
+            {
+                auto & system = *this->method->systems[img];
+                *system.spins = spins[img];
+                system.llg_parameters->noise_iteration = noise_iterations[img];
+                std::istringstream prng(prngs[img]);
+                prng >> system.llg_parameters->prng;
+                system.Invalidate();
+            }
+
+            // The data derived from the spins is recalculated as in the constructor,
+            // then the state of the method and the optimizer is restored
+            this->method->Calculate_Force(this->configurations, this->force);
+            this->method->Hook_Post_Iteration();
+            this->method->Load_State(state);
+            this->Load_State(state);
+        };
+        set_state(spins, noise_iterations, prngs, reader);
+        if (!reader.ok)
+        {
+            std::string state = state_current.str();
+            IO::Binary_Reader reader_current(state);
+            set_state(spins_current, noise_iterations_current, prngs_current, reader_current);
+            Log(Log_Level::Error, method->SenderName, "The state of the method or optimizer could not be read completely from checkpoint " + file + ", it is ignored",
+                this->method->idx_image, this->method->idx_chain);
+            return false;
+        }
+
+        iteration = (int)l_iteration;
+        this->starttime = l_starttime;
+        return true;
+    }
+
+    void Optimizer::Save_State(IO::Binary_Writer & writer)
+    {
+        writer.Write_Arrays(this->force);
+    }
+
+    void Optimizer::Load_State(IO::Binary_Reader & reader)
+    {
+        std::vector<vectorfield> l_force;
+        reader.Read_Arrays(l_force);
+        if (l_force.size() == this->force.size()) this->force = l_force;
+        else reader.ok = false;
+    }
+
     scalar Optimizer::getIterationsPerSecond()
     {
         scalar l_ips = 0.0;
@@ -1,56 +1,208 @@
 #include <engine/Optimizer_CG.hpp>
+#include <engine/Vectormath.hpp>
+#include <utility/Threading.hpp>
 
+#include <algorithm>
+#include <cmath>
 
 namespace Engine
 {
     Optimizer_CG::Optimizer_CG(std::shared_ptr<Engine::Method> method) :
         Optimizer(method)
     {
-		// int jmax = 500;
-
-		// double err_NR = 1e-5;	// Newton-Raphson error threshold
-
-		// double delta_0, delta_new, delta_d;
-		// double alpha;
-		// r = -f' = eff_field // this->method->Calculate_Force(configurations, force);
-		// delta_0 = r*r
-		// delta_new = delta_0
-		// beta = 0
-		// d = r //+ beta*d
+		this->direction = std::vector<vectorfield>(this->noi, vectorfield(this->nos, Vector3::Zero()));	// [noi][nos]
+		this->gradient = std::vector<vectorfield>(this->noi, vectorfield(this->nos, Vector3::Zero()));	// [noi][nos]
+		this->gradient_previous = std::vector<vectorfield>(this->noi, vectorfield(this->nos, Vector3::Zero()));	// [noi][nos]
+		this->spins_start = std::vector<vectorfield>(this->noi, vectorfield(this->nos));	// [noi][nos]
+		this->spins_gradient = std::vector<vectorfield>(this->noi, vectorfield(this->nos));	// [noi][nos]
+		this->step = std::vector<scalar>(this->noi, 0);	// [noi]
+		this->slope = std::vector<scalar>(this->noi, 0);	// [noi]
+		this->conjugate = false;
     }
 
     void Optimizer_CG::Iteration()
     {
-        // Not Implemented!
-        Log(Utility::Log_Level::Error, Utility::Log_Sender::All, std::string("Tried to use Optimizer::Step() of the Optimizer base class!"));
-
-		
-		// Perform a Newton-Raphson line search in order to determine the minimum along d
-		// delta_d = d*d
-		// for (int j = 0; j < jmax && std::pow(alpha,2)*delta_d > std::pow(err_NR,2); ++j)
-		// {
-			// alpha = - (f'*d)/(d*f''*d)	// ToDo: How to get the second derivative from here??
-			// x = x + alpha*d
-		// }
-
-		// Update the direction d
-		// r = -f' = eff_field
-		// delta_old = delta_new
-		// delta_new = r*r
-		// beta = delta_new/delta_old
-		// d = r + beta*d
-
-		// Restart if d is not a descent direction or after nos iterations
-		//		The latter improves convergence for small nos
-		// ++k
-		// if (r*d <= 0 || k==nos)
-		//{
-			// d = r
-			// k = 0
-		//}
+		// The gradients of the last iteration are reused, unless the spins were changed in between
+		bool reuse = this->conjugate;
+		for (int i = 0; i < noi && reuse; ++i) reuse = spins_gradient[i] == *configurations[i];
+		if (!reuse)
+		{
+			this->method->Calculate_Force(configurations, force);
+			for (int i = 0; i < noi; ++i) this->Tangent_Gradient(*configurations[i], force[i], gradient[i]);
+		}
+
+		// Conjugate directions and trial steps
+		std::vector<scalar> slope_start(noi), step_taken(noi), d_max(noi);
+		for (int i = 0; i < noi; ++i)
+		{
+			auto & g = gradient[i];
+			auto & d = direction[i];
+			scalar gg = Vectormath::dot(g, g);
+
+			// beta = max(0, min(PR, FR)), where the previous gradient and direction were transported with the spins
+			scalar beta = 0;
+			scalar gg_previous = Vectormath::dot(gradient_previous[i], gradient_previous[i]);
+			if (reuse && gg_previous > 0)
+			{
+				scalar beta_pr = (gg - Vectormath::dot(g, gradient_previous[i])) / gg_previous;
+				scalar beta_fr = gg / gg_previous;
+				beta = std::max(scalar(0), std::min(beta_pr, beta_fr));
+			}
+			Vectormath::scale(d, beta);
+			Vectormath::add_c_a(-1, g, d);
+
+			// Restart with steepest descent if d is not a descent direction
+			slope_start[i] = Vectormath::dot(g, d);
+			if (slope_start[i] >= 0)
+			{
+				d = g;
+				Vectormath::scale(d, -1);
+				slope_start[i] = -gg;
+			}
+			gradient_previous[i] = g;
+
+			d_max[i] = 0;
+			for (auto & v : d) d_max[i] = std::max(d_max[i], v.norm());
+
+			// Initial step from the last one, assuming the same decrease along the new direction,
+			//		such that no spin rotates by more than max_rotation
+			if (d_max[i] == 0) step_taken[i] = 0;
+			else
+			{
+				if (reuse && step[i] > 0 && slope[i] < 0) step_taken[i] = step[i] * slope[i] / slope_start[i];
+				else step_taken[i] = 0.1 * max_rotation / d_max[i];
+				step_taken[i] = std::min(step_taken[i], max_rotation / d_max[i]);
+			}
+			step[i] = step_taken[i];
+			slope[i] = slope_start[i];
+
+			// Trial step
+			spins_start[i] = *configurations[i];
+			this->Rotate(spins_start[i], d, step_taken[i], *configurations[i], {});
+		}
+
+		// Gradients at the trial steps
+		this->method->Calculate_Force(configurations, force);
+		bool secant = false;
+		for (int i = 0; i < noi; ++i)
+		{
+			this->Tangent_Gradient(*configurations[i], force[i], gradient[i]);
+			if (step_taken[i] == 0) continue;
+
+			// Directional derivative at the trial step
+			vectorfield d_transported = direction[i];
+			this->Rotate(spins_start[i], direction[i], step_taken[i], spins_gradient[i], { &d_transported });
+			scalar slope_trial = Vectormath::dot(gradient[i], d_transported);
+
+			// The trial step is accepted if the directional derivative dropped sufficiently
+			if (std::abs(slope_trial) <= curvature_condition * std::abs(slope_start[i])) continue;
+
+			if (slope_trial > slope_start[i])
+			{
+				// Secant step to the zero of the directional derivative, at most 4 times as long as the trial step
+				scalar alpha = step_taken[i] * slope_start[i] / (slope_start[i] - slope_trial);
+				step_taken[i] = std::min({ alpha, 4 * step_taken[i], max_rotation / d_max[i] });
+				step[i] = step_taken[i];
+				this->Rotate(spins_start[i], direction[i], step_taken[i], *configurations[i], {});
+				secant = true;
+			}
+			else
+			{
+				// Negative curvature: the trial step is kept and the next one is longer
+				step[i] = 2 * step_taken[i];
+			}
+		}
+
+		// Gradients at the new configurations
+		if (secant)
+		{
+			this->method->Calculate_Force(configurations, force);
+			for (int i = 0; i < noi; ++i) this->Tangent_Gradient(*configurations[i], force[i], gradient[i]);
+		}
+
+		// Transport the previous gradients and the directions into the tangent spaces of the new configurations
+		for (int i = 0; i < noi; ++i)
+		{
+			this->Rotate(spins_start[i], direction[i], step_taken[i], spins_gradient[i], { &gradient_previous[i], &direction[i] });
+			spins_gradient[i] = *configurations[i];
+		}
+		this->conjugate = true;
     }
 
+	void Optimizer_CG::Tangent_Gradient(const vectorfield & spins, const vectorfield & force, vectorfield & out)
+	{
+		Utility::Threading::Parallel_For(spins.size(), [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+				out[i] = spins[i].dot(force[i]) * spins[i] - force[i];
+		});
+	}
+
+	void Optimizer_CG::Rotate(const vectorfield & start, const vectorfield & direction, scalar alpha, vectorfield & spins, std::vector<vectorfield*> transport)
+	{
+		Utility::Threading::Parallel_For(start.size(), [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				Vector3 s = start[i];
+				scalar norm = direction[i].norm();
+				if (norm == 0 || alpha == 0)
+				{
+					spins[i] = s;
+					continue;
+				}
+				Vector3 t = direction[i] / norm;
+				scalar c = std::cos(alpha*norm), sn = std::sin(alpha*norm);
+				spins[i] = (c*s + sn*t).normalized();
+				// The component along the great circle is rotated with it, the one perpendicular to it is unchanged
+				for (auto v : transport)
+				{
+					Vector3 & w = (*v)[i];
+					w += w.dot(t) * ((c - 1)*t - sn*s);
+				}
+			}
+		});
+	}
+
+	void Optimizer_CG::Save_State(Utility::IO::Binary_Writer & writer)
+	{
+		Optimizer::Save_State(writer);
+		writer.Write_Value<std::int32_t>(this->conjugate);
+		writer.Write_Arrays(this->direction);
+		writer.Write_Arrays(this->gradient);
+		writer.Write_Arrays(this->gradient_previous);
+		writer.Write_Arrays(this->spins_gradient);
+		writer.Write_Array(this->step);
+		writer.Write_Array(this->slope);
+	}
+
+	void Optimizer_CG::Load_State(Utility::IO::Binary_Reader & reader)
+	{
+		Optimizer::Load_State(reader);
+		this->conjugate = reader.Read_Value<std::int32_t>() != 0;
+		std::vector<vectorfield> l_direction, l_gradient, l_gradient_previous, l_spins_gradient;
+		std::vector<scalar> l_step, l_slope;
+		reader.Read_Arrays(l_direction);
+		reader.Read_Arrays(l_gradient);
+		reader.Read_Arrays(l_gradient_previous);
+		reader.Read_Arrays(l_spins_gradient);
+		reader.Read_Array(l_step);
+		reader.Read_Array(l_slope);
+		if (l_direction.size() == this->direction.size() && l_gradient.size() == this->gradient.size() &&
+			l_gradient_previous.size() == this->gradient_previous.size() && l_spins_gradient.size() == this->spins_gradient.size() &&
+			l_step.size() == this->step.size() && l_slope.size() == this->slope.size())
+		{
+			this->direction = l_direction;
+			this->gradient = l_gradient;
+			this->gradient_previous = l_gradient_previous;
+			this->spins_gradient = l_spins_gradient;
+			this->step = l_step;
+			this->slope = l_slope;
+		}
+		else reader.ok = false;
+	}
+
     // Optimizer name as string
     std::string Optimizer_CG::Name() { return "CG"; }
     std::string Optimizer_CG::FullName() { return "Conjugate Gradient"; }
-}
\ No newline at end of file
+}
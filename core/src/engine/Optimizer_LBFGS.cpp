@@ -0,0 +1,180 @@
+#include <engine/Optimizer_LBFGS.hpp>
+#include <engine/Vectormath.hpp>
+#include <utility/Threading.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Dense>
+
+namespace Engine
+{
+    Optimizer_LBFGS::Optimizer_LBFGS(std::shared_ptr<Engine::Method> method) :
+        Optimizer(method)
+    {
+		this->gradient = std::vector<vectorfield>(this->noi, vectorfield(this->nos, Vector3::Zero()));	// [noi][nos]
+		this->rotation = std::vector<vectorfield>(this->noi, vectorfield(this->nos, Vector3::Zero()));	// [noi][nos]
+		this->spins_step = std::vector<vectorfield>(this->noi, vectorfield(this->nos));	// [noi][nos]
+		this->history_step = std::vector<std::deque<vectorfield>>(this->noi);	// [noi][n_history][nos]
+		this->history_gradient = std::vector<std::deque<vectorfield>>(this->noi);	// [noi][n_history][nos]
+		this->has_gradient = false;
+    }
+
+    void Optimizer_LBFGS::Iteration()
+    {
+		// The histories belong to the last steps, unless the spins were changed in between
+		bool continued = this->has_gradient;
+		for (int i = 0; i < noi && continued; ++i) continued = spins_step[i] == *configurations[i];
+
+		// Get the forces on the configurations
+		this->method->Calculate_Force(configurations, force);
+
+		vectorfield gradient_new(nos);
+		for (int i = 0; i < noi; ++i)
+		{
+			auto & spins = *configurations[i];
+			auto & history_s = history_step[i];
+			auto & history_y = history_gradient[i];
+
+			// Update the history with the last step, if its curvature is positive
+			this->Rotation_Gradient(spins, force[i], gradient_new);
+			if (!continued)
+			{
+				history_s.clear();
+				history_y.clear();
+			}
+			else
+			{
+				vectorfield y = gradient_new;
+				Vectormath::add_c_a(-1, gradient[i], y);
+				if (Vectormath::dot(rotation[i], y) > 0)
+				{
+					history_s.push_back(rotation[i]);
+					history_y.push_back(y);
+					if ((int)history_s.size() > n_history)
+					{
+						history_s.pop_front();
+						history_y.pop_front();
+					}
+				}
+			}
+			gradient[i] = gradient_new;
+			auto & g = gradient[i];
+
+			// Two-loop recursion for the direction -H*g
+			int n = history_s.size();
+			std::vector<scalar> rho(n), alpha(n);
+			auto & d = rotation[i];
+			d = g;
+			for (int k = n - 1; k >= 0; --k)
+			{
+				rho[k] = 1 / Vectormath::dot(history_s[k], history_y[k]);
+				alpha[k] = rho[k] * Vectormath::dot(history_s[k], d);
+				Vectormath::add_c_a(-alpha[k], history_y[k], d);
+			}
+			if (n > 0) Vectormath::scale(d, 1 / (rho[n - 1] * Vectormath::dot(history_y[n - 1], history_y[n - 1])));
+			for (int k = 0; k < n; ++k)
+			{
+				scalar beta = rho[k] * Vectormath::dot(history_y[k], d);
+				Vectormath::add_c_a(alpha[k] - beta, history_s[k], d);
+			}
+			Vectormath::scale(d, -1);
+
+			// Only the rotations perpendicular to the spins move them
+			for (int j = 0; j < nos; ++j) d[j] -= d[j].dot(spins[j]) * spins[j];
+
+			// Steepest descent if this is not a descent direction
+			if (Vectormath::dot(d, g) >= 0)
+			{
+				history_s.clear();
+				history_y.clear();
+				n = 0;
+				d = g;
+				Vectormath::scale(d, -1);
+			}
+
+			// No spin is rotated by more than max_rotation
+			scalar d_max = 0;
+			for (auto & v : d) d_max = std::max(d_max, v.norm());
+			if (d_max > max_rotation) Vectormath::scale(d, max_rotation / d_max);
+
+			// Rotate the spins, together with the vectors of their tangent spaces, i.e. the history, gradient and step
+			std::vector<vectorfield*> transport{ &g, &d };
+			for (int k = 0; k < n; ++k)
+			{
+				transport.push_back(&history_s[k]);
+				transport.push_back(&history_y[k]);
+			}
+			Utility::Threading::Parallel_For(nos, [&](int begin, int end)
+			{
+				for (int j = begin; j < end; ++j)
+				{
+					scalar angle = d[j].norm();
+					if (angle == 0) continue;
+					Vector3 axis = d[j] / angle;
+					scalar c = std::cos(angle), s = std::sin(angle);
+					spins[j] = (c * spins[j] + s * axis.cross(spins[j])).normalized();
+					for (auto v : transport)
+					{
+						Vector3 & w = (*v)[j];
+						w = c * w + s * axis.cross(w) + (1 - c) * axis.dot(w) * axis;
+					}
+				}
+			});
+			spins_step[i] = spins;
+		}
+		this->has_gradient = true;
+    }
+
+	void Optimizer_LBFGS::Rotation_Gradient(const vectorfield & spins, const vectorfield & force, vectorfield & out)
+	{
+		Utility::Threading::Parallel_For(spins.size(), [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i) out[i] = force[i].cross(spins[i]);
+		});
+	}
+
+	void Optimizer_LBFGS::Save_State(Utility::IO::Binary_Writer & writer)
+	{
+		Optimizer::Save_State(writer);
+		writer.Write_Value<std::int32_t>(this->has_gradient);
+		writer.Write_Arrays(this->gradient);
+		writer.Write_Arrays(this->rotation);
+		writer.Write_Arrays(this->spins_step);
+		for (int i = 0; i < noi; ++i)
+		{
+			writer.Write_Arrays(std::vector<vectorfield>(history_step[i].begin(), history_step[i].end()));
+			writer.Write_Arrays(std::vector<vectorfield>(history_gradient[i].begin(), history_gradient[i].end()));
+		}
+	}
+
+	void Optimizer_LBFGS::Load_State(Utility::IO::Binary_Reader & reader)
+	{
+		Optimizer::Load_State(reader);
+		this->has_gradient = reader.Read_Value<std::int32_t>() != 0;
+		std::vector<vectorfield> l_gradient, l_rotation, l_spins_step;
+		reader.Read_Arrays(l_gradient);
+		reader.Read_Arrays(l_rotation);
+		reader.Read_Arrays(l_spins_step);
+		if (l_gradient.size() == gradient.size() && l_rotation.size() == rotation.size() && l_spins_step.size() == spins_step.size())
+		{
+			this->gradient = l_gradient;
+			this->rotation = l_rotation;
+			this->spins_step = l_spins_step;
+		}
+		else reader.ok = false;
+		for (int i = 0; i < noi; ++i)
+		{
+			std::vector<vectorfield> l_step, l_gradient_difference;
+			reader.Read_Arrays(l_step);
+			reader.Read_Arrays(l_gradient_difference);
+			if (l_step.size() != l_gradient_difference.size()) reader.ok = false;
+			this->history_step[i].assign(l_step.begin(), l_step.end());
+			this->history_gradient[i].assign(l_gradient_difference.begin(), l_gradient_difference.end());
+		}
+	}
+
+    // Optimizer name as string
+    std::string Optimizer_LBFGS::Name() { return "LBFGS"; }
+    std::string Optimizer_LBFGS::FullName() { return "Limited-memory BFGS"; }
+}
@@ -0,0 +1,18 @@
+#include <engine/Optimizer_MC.hpp>
+
+namespace Engine
+{
+	Optimizer_MC::Optimizer_MC(std::shared_ptr<Engine::Method_MC> method) :
+		Optimizer(method), method_mc(method)
+	{
+	}
+
+	void Optimizer_MC::Iteration()
+	{
+		this->method_mc->Sweep();
+	}
+
+	// Optimizer name as string
+	std::string Optimizer_MC::Name() { return "MC"; }
+	std::string Optimizer_MC::FullName() { return "Metropolis Monte Carlo"; }
+}
@@ -1,29 +1,52 @@
 #include <engine/Optimizer_SIB.hpp>
 #include <engine/Vectormath.hpp>
+#include <utility/Random.hpp>
+#include <utility/Threading.hpp>
+#include <utility/Logging.hpp>
+
+#include <algorithm>
 
 namespace Engine
 {
 	Optimizer_SIB::Optimizer_SIB(std::shared_ptr<Engine::Method> method) :
         Optimizer(method)
     {
-		this->xi = vectorfield(this->nos);
-		this->virtualforce = std::vector<vectorfield>(this->noi, vectorfield(this->nos));	// [noi][nos]
+		this->xi = std::vector<vectorfield>(this->noi, vectorfield(this->nos));	// [noi][nos]
 		
 		this->spins_temp = std::vector<std::shared_ptr<vectorfield>>(this->noi);
 		for (int i=0; i<this->noi; ++i) spins_temp[i] = std::shared_ptr<vectorfield>(new vectorfield(this->nos)); // [noi][nos]
+
+		this->error_previous = 1;
+		this->warned_adaptive = false;
     }
 
     void Optimizer_SIB::Iteration()
     {
 		std::shared_ptr<Data::Spin_System> s;
 
+		auto & params = *method->systems[0]->llg_parameters;
+		if (params.adaptive_dt)
+		{
+			// The error estimate does not apply to the stochastic equation
+			bool deterministic = true;
+			for (int i = 0; i < this->noi; ++i) deterministic = deterministic && method->systems[i]->llg_parameters->temperature == 0;
+			bool bounds = params.dt_min > 0 && params.dt_min <= params.dt_max;
+			if (deterministic && bounds) return this->Iteration_Adaptive();
+			if (!this->warned_adaptive)
+			{
+				Log(Utility::Log_Level::Warning, method->SenderName, bounds ? "SIB: the time step is adapted only at zero temperature, using the fixed dt" :
+					"SIB: the bounds of the adaptive time step need 0 < dt_min <= dt_max, using the fixed dt", method->idx_image, method->idx_chain);
+				this->warned_adaptive = true;
+			}
+		}
+
 		// Random Numbers
 		for (int i = 0; i < this->noi; ++i)
 		{
 			s = method->systems[i];
 			this->epsilon = std::sqrt(2.0*s->llg_parameters->damping / (1.0 + std::pow(s->llg_parameters->damping, 2))*s->llg_parameters->temperature*Vectormath::kB());
 			// Precalculate RNs --> move this up into Iterate and add array dimension n for no of iterations?
-			this->Gen_Xi(*s, xi, epsilon);
+			this->Gen_Xi(*s, xi[i], epsilon);
 		}
 
 		// First part of the step
@@ -31,8 +54,7 @@ namespace Engine
 		for (int i = 0; i < this->noi; ++i)
 		{
 			s = method->systems[i];
-			this->VirtualForce(s->nos, *s->spins, *s->llg_parameters, force[i], xi, virtualforce[i]);
-			this->FirstStep(s->nos, *s->spins, virtualforce[i], *spins_temp[i]);
+			this->Step(*s->spins, *s->spins, *s->llg_parameters, s->llg_parameters->dt, force[i], xi[i], *spins_temp[i], true);
 		}
 
 		// Second part of the step
@@ -40,114 +62,161 @@ namespace Engine
 		for (int i = 0; i < this->noi; ++i)
 		{
 			s = method->systems[i];
-			this->VirtualForce(s->nos, *spins_temp[i], *s->llg_parameters, force[i], xi, virtualforce[i]);
-			this->SecondStep(s->nos, virtualforce[i], *s->spins);
+			this->Step(*s->spins, *spins_temp[i], *s->llg_parameters, s->llg_parameters->dt, force[i], xi[i], *s->spins, false);
+		}
+	}
+
+
+	void Optimizer_SIB::Iteration_Adaptive()
+	{
+		auto & params = *method->systems[0]->llg_parameters;
+		scalar dt = std::max(params.dt_min, std::min(params.dt_max, params.dt));
+
+		// The forces at the start of the step are the same for every trial step
+		std::vector<vectorfield> force_start(noi);
+		this->method->Calculate_Force(configurations, force);
+		for (int i = 0; i < noi; ++i)
+		{
+			force_start[i] = force[i];
+			Vectormath::fill(xi[i], { 0,0,0 });
+		}
+
+		vectorfield spins_new(nos);
+		scalar error = 0;
+		while (true)
+		{
+			// Predictor, i.e. the midpoint of the first order step
+			for (int i = 0; i < noi; ++i)
+				this->Step(*configurations[i], *configurations[i], *method->systems[i]->llg_parameters, dt, force_start[i], xi[i], *spins_temp[i], true);
+
+			// Corrector, compared with the first order step 2*midpoint - start
+			this->method->Calculate_Force(this->spins_temp, force);
+			error = 0;
+			for (int i = 0; i < noi; ++i)
+			{
+				auto & spins = *configurations[i];
+				auto & midpoint = *spins_temp[i];
+				this->Step(spins, midpoint, *method->systems[i]->llg_parameters, dt, force[i], xi[i], spins_new, false);
+				for (int j = 0; j < nos; ++j) error = std::max(error, (spins_new[j] - 2 * midpoint[j] + spins[j]).norm());
+				// The spins of the trial are kept in spins_temp
+				midpoint = spins_new;
+			}
+			error /= params.dt_tolerance;
+
+			if (error <= 1 || dt <= params.dt_min) break;
+
+			// Rejected: retry with a smaller step
+			dt = std::max(params.dt_min, dt * std::max(scalar(0.2), scalar(0.9) * std::pow(error, scalar(-0.5))));
+		}
+
+		for (int i = 0; i < noi; ++i) *configurations[i] = *spins_temp[i];
+
+		// PI control of the next step, for an error estimate of second order in dt
+		scalar error_safe = std::max(error, scalar(1e-10));
+		scalar factor = 0.9 * std::pow(error_safe, scalar(-0.35)) * std::pow(this->error_previous, scalar(0.2));
+		factor = std::max(scalar(0.2), std::min(scalar(5), factor));
+		this->error_previous = std::max(error_safe, scalar(1e-4));
+		scalar dt_next = std::max(params.dt_min, std::min(params.dt_max, dt * factor));
+
+		for (int i = 0; i < noi; ++i)
+		{
+			auto & p = *method->systems[i]->llg_parameters;
+			p.time += dt;
+			if (p.save_output_any && p.save_output_archive) p.dt_history.push_back(dt);
+			p.dt = dt_next;
 		}
 	}
 
 
-	void Optimizer_SIB::VirtualForce(const int nos, vectorfield & spins, Data::Parameters_Method_LLG & llg_params, vectorfield & gradient,  vectorfield & xi, vectorfield & force)
+	void Optimizer_SIB::Step(const vectorfield & spins, const vectorfield & spins_force, const Data::Parameters_Method_LLG & llg_params, scalar dt,
+		const vectorfield & gradient, const vectorfield & xi, vectorfield & out, bool predictor)
 	{
 		//========================= Init local vars ================================
-		// deterministic variables
-		Vector3 a1, b1, asc;
-		// stochastic variables
-		Vector3 s1, f1;
-		// aux variables
-		Vector3 A;
 		// time steps
 		scalar damping = llg_params.damping;
-		scalar sqrtdt = std::sqrt(llg_params.dt), dtg = llg_params.dt, sqrtdtg = sqrtdt;
-		// integration variables
-		Vector3 e1;
+		scalar sqrtdt = std::sqrt(dt), dtg = dt, sqrtdtg = sqrtdt;
 		// STT
 		scalar a_j = llg_params.stt_magnitude;
 		Vector3 s_c_vec = llg_params.stt_polarisation_normal;
 		//------------------------ End Init ----------------------------------------
 
-		Vectormath::fill       (force, {0,0,0});
-		Vectormath::add_c_a    (-0.5 * dtg, gradient, force);
-		Vectormath::add_c_cross(-0.5 * dtg * damping, spins, gradient, force);
-		Vectormath::add_c_a    ( 0.5 * dtg * a_j * damping, s_c_vec, force);
-		Vectormath::add_c_cross(-0.5 * dtg * a_j, s_c_vec, spins, force);
-
-		Vectormath::add_c_a    (-0.5 * sqrtdtg, xi, force);
-		Vectormath::add_c_cross(-0.5 * sqrtdtg * damping, spins, xi, force);
+		Utility::Threading::Parallel_For(spins.size(), [&](int begin, int end)
+		{
+			// aux variables
+			Vector3 a2, A;
+			scalar detAi;
+			// integration variables
+			Vector3 e1, et;
+
+			for (int i = begin; i < end; ++i)
+			{
+				// Virtual force (the terms are added in the order of the former separate passes)
+				const Vector3 & s = spins_force[i];
+				A = { 0,0,0 };
+				A += -0.5 * dtg * gradient[i];
+				A += -0.5 * dtg * damping * s.cross(gradient[i]);
+				A += 0.5 * dtg * a_j * damping * s_c_vec;
+				A += -0.5 * dtg * a_j * s_c_vec.cross(s);
+				A += -0.5 * sqrtdtg * xi[i];
+				A += -0.5 * sqrtdtg * damping * s.cross(xi[i]);
+
+				e1 = spins[i];
+
+				// 1/determinant(A)
+				detAi = 1.0 / (1 + pow(A.norm(), 2.0));
+
+				// calculate equation without the predictor?
+				a2 = e1 + e1.cross(A);
+
+				et[0] = (a2[0] * (1 + A[0] * A[0])    + a2[1] * (A[0] * A[1] + A[2]) + a2[2] * (A[0] * A[2] - A[1]))*detAi;
+				et[1] = (a2[0] * (A[1] * A[0] - A[2]) + a2[1] * (1 + A[1] * A[1])    + a2[2] * (A[1] * A[2] + A[0]))*detAi;
+				et[2] = (a2[0] * (A[2] * A[0] + A[1]) + a2[1] * (A[2] * A[1] - A[0]) + a2[2] * (1 + A[2] * A[2]))*detAi;
+
+				if (predictor) out[i] = (e1 + et)*0.5;
+				else out[i] = et;
+			}
+		});
 	}
 
 
-	void Optimizer_SIB::FirstStep(const int nos, vectorfield & spins, vectorfield & force, vectorfield & spins_temp)
+	void Optimizer_SIB::Gen_Xi(Data::Spin_System & s, vectorfield & xi, scalar eps)
 	{
-		// aux variables
-		Vector3 a2, A;
-		scalar detAi;
-		// integration variables
-		Vector3 e1, et;
-		int dim = 0;
-
-		for (int i = 0; i < nos; ++i)
-		{
-			e1 = spins[i];
-			A = force[i];
-
-			// 1/determinant(A)
-			detAi = 1.0 / (1 + pow(A.norm(), 2.0));
-
-			// calculate equation without the predictor?
-			a2 = e1 + e1.cross(A);
-
-			et[0] = (a2[0] * (1 + A[0] * A[0])    + a2[1] * (A[0] * A[1] + A[2]) + a2[2] * (A[0] * A[2] - A[1]))*detAi;
-			et[1] = (a2[0] * (A[1] * A[0] - A[2]) + a2[1] * (1 + A[1] * A[1])    + a2[2] * (A[1] * A[2] + A[0]))*detAi;
-			et[2] = (a2[0] * (A[2] * A[0] + A[1]) + a2[1] * (A[2] * A[1] - A[0]) + a2[2] * (1 + A[2] * A[2]))*detAi;
+		// Gaussian noise from the counter-based generator, determined by the seed and the noise iteration
+		Utility::Random::Fill_Gaussian(xi, eps, s.llg_parameters->seed, s.llg_parameters->noise_iteration++);
+	}//end Gen_Xi
 
-			spins_temp[i] = (e1 + et)*0.5;
+	void Optimizer_SIB::Save_State(Utility::IO::Binary_Writer & writer)
+	{
+		Optimizer::Save_State(writer);
+		writer.Write_Value(this->error_previous);
+		std::vector<scalar> dt(noi), time(noi);
+		for (int i = 0; i < noi; ++i)
+		{
+			dt[i] = method->systems[i]->llg_parameters->dt;
+			time[i] = method->systems[i]->llg_parameters->time;
 		}
+		writer.Write_Array(dt);
+		writer.Write_Array(time);
 	}
 
-	void Optimizer_SIB::SecondStep(const int nos, vectorfield & force, vectorfield & spins)
+	void Optimizer_SIB::Load_State(Utility::IO::Binary_Reader & reader)
 	{
-		// aux variables
-		Vector3 a2, A;
-		scalar detAi;
-		// integration variables
-		Vector3 e1, et;
-		int dim = 0;
-
-		for (int i = 0; i < nos; ++i) {
-
-			e1 = spins[i];
-			A = force[i];
-
-			// 1/determinant(A)
-			detAi = 1.0 / (1 + pow(A.norm(), 2.0));
-
-			// calculate equation without the predictor?
-			a2 = e1 + e1.cross(A);
-
-			et[0] = (a2[0] * (1 + A[0] * A[0]) + a2[1] * (A[0] * A[1] + A[2]) + a2[2] * (A[0] * A[2] - A[1]))*detAi;
-			et[1] = (a2[0] * (A[1] * A[0] - A[2]) + a2[1] * (1 + A[1] * A[1]) + a2[2] * (A[1] * A[2] + A[0]))*detAi;
-			et[2] = (a2[0] * (A[2] * A[0] + A[1]) + a2[1] * (A[2] * A[1] - A[0]) + a2[2] * (1 + A[2] * A[2]))*detAi;
-
-			spins[i] = et;
+		Optimizer::Load_State(reader);
+		this->error_previous = reader.Read_Value<scalar>();
+		std::vector<scalar> dt, time;
+		reader.Read_Array(dt);
+		reader.Read_Array(time);
+		if (dt.size() == (unsigned int)noi && time.size() == (unsigned int)noi)
+		{
+			for (int i = 0; i < noi; ++i)
+			{
+				method->systems[i]->llg_parameters->dt = dt[i];
+				method->systems[i]->llg_parameters->time = time[i];
+			}
 		}
+		else reader.ok = false;
 	}
 
-
-	void Optimizer_SIB::Gen_Xi(Data::Spin_System & s, vectorfield & xi, scalar eps)
-	{
-		//for (int i = 0; i < 3*s.nos; ++i) {
-		//	// PRNG gives RN int [0,1] -> [-1,1] -> multiply with eps
-		//	xi[i] = (s.llg_parameters->distribution_int(s.llg_parameters->prng) * 2 - 1)*eps;
-		//}//endfor i
-		for (int dim = 0; dim < 3; ++dim) {
-			for (int i = 0; i < s.nos; ++i) {
-				// PRNG gives RN int [0,1] -> [-1,1] -> multiply with eps
-				xi[i][dim] = (s.llg_parameters->distribution_int(s.llg_parameters->prng) * 2 - 1)*eps;
-			}//endfor i
-		}//enfor dim
-
-	}//end Gen_Xi
-
     // Optimizer name as string
     std::string Optimizer_SIB::Name() { return "SIB"; }
     std::string Optimizer_SIB::FullName() { return "Semi-implicit B"; }
@@ -1,5 +1,6 @@
 #include <engine/Optimizer_SIB2.hpp>
 #include <engine/Vectormath.hpp>
+#include <utility/Random.hpp>
 
 namespace Engine
 {
@@ -128,17 +129,8 @@ namespace Engine
 
 	void Optimizer_SIB2::Gen_Xi(Data::Spin_System & s, vectorfield & xi, scalar eps)
 	{
-		//for (int i = 0; i < 3*s.nos; ++i) {
-		//	// PRNG gives RN int [0,1] -> [-1,1] -> multiply with eps
-		//	xi[i] = (s.llg_parameters->distribution_int(s.llg_parameters->prng) * 2 - 1)*eps;
-		//}//endfor i
-		for (int dim = 0; dim < 3; ++dim) {
-			for (int i = 0; i < s.nos; ++i) {
-				// PRNG gives RN int [0,1] -> [-1,1] -> multiply with eps
-				xi[i][dim] = (s.llg_parameters->distribution_int(s.llg_parameters->prng) * 2 - 1)*eps;
-			}//endfor i
-		}//enfor dim
-
+		// Gaussian noise from the counter-based generator, determined by the seed and the noise iteration
+		Utility::Random::Fill_Gaussian(xi, eps, s.llg_parameters->seed, s.llg_parameters->noise_iteration++);
 	}//end Gen_Xi
 
 
@@ -64,6 +64,21 @@ namespace Engine
 		}
     }
     
+    void Optimizer_VP::Save_State(Utility::IO::Binary_Writer & writer)
+    {
+        Optimizer::Save_State(writer);
+        writer.Write_Arrays(this->velocity);
+    }
+
+    void Optimizer_VP::Load_State(Utility::IO::Binary_Reader & reader)
+    {
+        Optimizer::Load_State(reader);
+        std::vector<vectorfield> l_velocity;
+        reader.Read_Arrays(l_velocity);
+        if (l_velocity.size() == this->velocity.size()) this->velocity = l_velocity;
+        else reader.ok = false;
+    }
+
     // Optimizer name as string
     std::string Optimizer_VP::Name() { return "VP"; }
     std::string Optimizer_VP::FullName() { return "Velocity Projection"; }
@@ -142,7 +142,7 @@ namespace Engine
 			scalar ret = 0;
 			for (unsigned int i = 0; i<sf.size(); ++i)
 			{
-				ret = (i - 1) / i * ret + sf[i] / i;
+				ret = (scalar)i / (i + 1) * ret + sf[i] / (i + 1);
 			}
 			return ret;
 		}
@@ -186,7 +186,7 @@ namespace Engine
 			Vector3 ret = { 0,0,0 };
 			for (unsigned int i = 0; i<vf.size(); ++i)
 			{
-				ret = (i-1)/i * ret + vf[i]/i;
+				ret = (scalar)i / (i + 1) * ret + vf[i] / (i + 1);
 			}
 			return ret;
 		}
@@ -0,0 +1,261 @@
+#include <engine/Vectormath_SoA.hpp>
+
+#include <cmath>
+
+// Explicitly vectorised kernels for x86-64 with GCC or Clang, selected at runtime
+#if defined(CORE_SCALAR_TYPE_DOUBLE) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	#define VECTORMATH_SOA_X86
+	#include <immintrin.h>
+#endif
+
+namespace Engine
+{
+	vectorfield_soa::vectorfield_soa(const vectorfield & vf)
+	{
+		Vectormath::assign(*this, vf);
+	}
+
+	namespace Vectormath
+	{
+		namespace
+		{
+			struct Fields { scalar * x, * y, * z; };
+			struct Const_Fields { const scalar * x, * y, * z; };
+
+			Fields fields(vectorfield_soa & vf) { return Fields{ vf.x.data(), vf.y.data(), vf.z.data() }; }
+			Const_Fields fields(const vectorfield_soa & vf) { return Const_Fields{ vf.x.data(), vf.y.data(), vf.z.data() }; }
+
+			// The kernels of one instruction set
+			struct Kernels
+			{
+				void(*fill)(Fields o, int n, const Vector3 & v);
+				void(*normalize)(Fields o, int n);
+				void(*scale)(Fields o, int n, scalar c);
+				Vector3(*sum)(Const_Fields a, int n);
+				scalar(*dot)(Const_Fields a, Const_Fields b, int n);
+				void(*dot_field)(Const_Fields a, Const_Fields b, scalar * out, int n, scalar c, bool add);
+				void(*add_c_dot)(scalar c, const Vector3 & a, Const_Fields b, scalar * out, int n);
+				void(*cross)(Const_Fields a, Const_Fields b, Fields o, int n, scalar c, bool add);
+				void(*add_c_cross)(scalar c, const Vector3 & a, Const_Fields b, Fields o, int n);
+				void(*add_c_a)(scalar c, const Vector3 & a, Const_Fields af, Fields o, int n, bool field);
+			};
+
+			// Traits of a single element, used for the remainder of the fields and without SIMD
+			struct Single
+			{
+				typedef scalar V;
+				static const int width = 1;
+				static V load(const scalar * p) { return *p; }
+				static V loadu(const scalar * p) { return *p; }
+				static void store(scalar * p, V v) { *p = v; }
+				static void storeu(scalar * p, V v) { *p = v; }
+				static V set1(scalar s) { return s; }
+				static V add(V a, V b) { return a + b; }
+				static V sub(V a, V b) { return a - b; }
+				static V mul(V a, V b) { return a * b; }
+				static V div(V a, V b) { return a / b; }
+				static V fmadd(V a, V b, V c) { return a * b + c; }
+				static V sqrt(V a) { return std::sqrt(a); }
+				static V nonzero_or_one(V a) { return a == 0 ? 1 : a; }
+				static scalar reduce(V a) { return a; }
+			};
+
+			namespace generic
+			{
+				typedef Single Simd;
+				#include "Vectormath_SoA_Kernels.inl"
+			}
+
+		#ifdef VECTORMATH_SOA_X86
+			#if defined(__clang__)
+				#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+			#else
+				#pragma GCC push_options
+				#pragma GCC target("avx2,fma")
+			#endif
+			namespace avx2
+			{
+				struct Simd
+				{
+					typedef __m256d V;
+					static const int width = 4;
+					static V load(const scalar * p) { return _mm256_load_pd(p); }
+					static V loadu(const scalar * p) { return _mm256_loadu_pd(p); }
+					static void store(scalar * p, V v) { _mm256_store_pd(p, v); }
+					static void storeu(scalar * p, V v) { _mm256_storeu_pd(p, v); }
+					static V set1(scalar s) { return _mm256_set1_pd(s); }
+					static V add(V a, V b) { return _mm256_add_pd(a, b); }
+					static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+					static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+					static V div(V a, V b) { return _mm256_div_pd(a, b); }
+					static V fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+					static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+					static V nonzero_or_one(V a) { return _mm256_blendv_pd(a, _mm256_set1_pd(1), _mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_EQ_OQ)); }
+					static scalar reduce(V a)
+					{
+						__m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+						return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+					}
+				};
+				#include "Vectormath_SoA_Kernels.inl"
+			}
+			#if defined(__clang__)
+				#pragma clang attribute pop
+				#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+			#else
+				#pragma GCC pop_options
+				#pragma GCC push_options
+				#pragma GCC target("avx512f")
+			#endif
+			namespace avx512
+			{
+				struct Simd
+				{
+					typedef __m512d V;
+					static const int width = 8;
+					static V load(const scalar * p) { return _mm512_load_pd(p); }
+					static V loadu(const scalar * p) { return _mm512_loadu_pd(p); }
+					static void store(scalar * p, V v) { _mm512_store_pd(p, v); }
+					static void storeu(scalar * p, V v) { _mm512_storeu_pd(p, v); }
+					static V set1(scalar s) { return _mm512_set1_pd(s); }
+					static V add(V a, V b) { return _mm512_add_pd(a, b); }
+					static V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+					static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+					static V div(V a, V b) { return _mm512_div_pd(a, b); }
+					static V fmadd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+					static V sqrt(V a) { return _mm512_sqrt_pd(a); }
+					static V nonzero_or_one(V a) { return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, _mm512_setzero_pd(), _CMP_EQ_OQ), a, _mm512_set1_pd(1)); }
+					static scalar reduce(V a) { return _mm512_reduce_add_pd(a); }
+				};
+				#include "Vectormath_SoA_Kernels.inl"
+			}
+			#if defined(__clang__)
+				#pragma clang attribute pop
+			#else
+				#pragma GCC pop_options
+			#endif
+		#endif
+
+			// The kernels of the best instruction set supported by the CPU
+			struct Dispatch
+			{
+				const Kernels * kernels;
+				std::string name;
+				Dispatch() : kernels(&generic::table), name("generic")
+				{
+				#ifdef VECTORMATH_SOA_X86
+					__builtin_cpu_init();
+					if (__builtin_cpu_supports("avx512f"))
+					{
+						kernels = &avx512::table;
+						name = "avx512";
+					}
+					else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+					{
+						kernels = &avx2::table;
+						name = "avx2";
+					}
+				#endif
+				}
+			};
+
+			const Dispatch & dispatch()
+			{
+				static const Dispatch d;
+				return d;
+			}
+
+			const Kernels & kernels()
+			{
+				return *dispatch().kernels;
+			}
+		}
+
+		std::string SoA_Instruction_Set()
+		{
+			return dispatch().name;
+		}
+
+		void assign(vectorfield_soa & out, const vectorfield & vf)
+		{
+			out.resize(vf.size());
+			for (unsigned int i = 0; i < vf.size(); ++i) out.set(i, vf[i]);
+		}
+
+		void assign(vectorfield & out, const vectorfield_soa & vf)
+		{
+			out.resize(vf.size());
+			for (int i = 0; i < vf.size(); ++i) out[i] = vf.get(i);
+		}
+
+		void fill(vectorfield_soa & vf, const Vector3 & v)
+		{
+			kernels().fill(fields(vf), vf.size(), v);
+		}
+
+		void normalize_vectors(vectorfield_soa & vf)
+		{
+			kernels().normalize(fields(vf), vf.size());
+		}
+
+		void scale(vectorfield_soa & vf, const scalar & sc)
+		{
+			kernels().scale(fields(vf), vf.size(), sc);
+		}
+
+		Vector3 sum(const vectorfield_soa & vf)
+		{
+			return kernels().sum(fields(vf), vf.size());
+		}
+
+		Vector3 mean(const vectorfield_soa & vf)
+		{
+			return sum(vf) / vf.size();
+		}
+
+		scalar dot(const vectorfield_soa & vf1, const vectorfield_soa & vf2)
+		{
+			return kernels().dot(fields(vf1), fields(vf2), vf1.size());
+		}
+
+		void dot(const vectorfield_soa & vf1, const vectorfield_soa & vf2, scalarfield & out)
+		{
+			kernels().dot_field(fields(vf1), fields(vf2), out.data(), vf1.size(), 1, false);
+		}
+
+		void cross(const vectorfield_soa & vf1, const vectorfield_soa & vf2, vectorfield_soa & out)
+		{
+			kernels().cross(fields(vf1), fields(vf2), fields(out), vf1.size(), 1, false);
+		}
+
+		void add_c_a(const scalar & c, const Vector3 & a, vectorfield_soa & out)
+		{
+			kernels().add_c_a(c, a, fields((const vectorfield_soa &)out), fields(out), out.size(), false);
+		}
+
+		void add_c_a(const scalar & c, const vectorfield_soa & a, vectorfield_soa & out)
+		{
+			kernels().add_c_a(c, Vector3{ 0,0,0 }, fields(a), fields(out), out.size(), true);
+		}
+
+		void add_c_dot(const scalar & c, const Vector3 & a, const vectorfield_soa & b, scalarfield & out)
+		{
+			kernels().add_c_dot(c, a, fields(b), out.data(), b.size());
+		}
+
+		void add_c_dot(const scalar & c, const vectorfield_soa & a, const vectorfield_soa & b, scalarfield & out)
+		{
+			kernels().dot_field(fields(a), fields(b), out.data(), a.size(), c, true);
+		}
+
+		void add_c_cross(const scalar & c, const Vector3 & a, const vectorfield_soa & b, vectorfield_soa & out)
+		{
+			kernels().add_c_cross(c, a, fields(b), fields(out), b.size());
+		}
+
+		void add_c_cross(const scalar & c, const vectorfield_soa & a, const vectorfield_soa & b, vectorfield_soa & out)
+		{
+			kernels().cross(fields(a), fields(b), fields(out), a.size(), c, true);
+		}
+	}
+}
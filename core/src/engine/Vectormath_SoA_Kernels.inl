@@ -0,0 +1,216 @@
+// Kernels of the Vectormath functions for vectorfield_soa.
+//		This file is included once per instruction set by Vectormath_SoA.cpp, inside a namespace which
+//		defines the traits struct Simd (register type V, width and the arithmetic operations).
+//		Each kernel processes the range [begin, end) with the traits S, so that the main part of
+//		a field is processed with Simd and the remainder with the one-element traits Single.
+//		The ranges processed with Simd start at multiples of its width, i.e. at aligned addresses.
+
+template<typename S>
+void fill_range(Fields o, int begin, int end, const Vector3 & v)
+{
+	typename S::V vx = S::set1(v[0]), vy = S::set1(v[1]), vz = S::set1(v[2]);
+	for (int i = begin; i < end; i += S::width)
+	{
+		S::store(o.x + i, vx); S::store(o.y + i, vy); S::store(o.z + i, vz);
+	}
+}
+
+template<typename S>
+void normalize_range(Fields o, int begin, int end)
+{
+	for (int i = begin; i < end; i += S::width)
+	{
+		typename S::V x = S::load(o.x + i), y = S::load(o.y + i), z = S::load(o.z + i);
+		typename S::V norm = S::nonzero_or_one(S::sqrt(S::fmadd(x, x, S::fmadd(y, y, S::mul(z, z)))));
+		S::store(o.x + i, S::div(x, norm)); S::store(o.y + i, S::div(y, norm)); S::store(o.z + i, S::div(z, norm));
+	}
+}
+
+template<typename S>
+void scale_range(Fields o, int begin, int end, scalar c)
+{
+	typename S::V vc = S::set1(c);
+	for (int i = begin; i < end; i += S::width)
+	{
+		S::store(o.x + i, S::mul(vc, S::load(o.x + i)));
+		S::store(o.y + i, S::mul(vc, S::load(o.y + i)));
+		S::store(o.z + i, S::mul(vc, S::load(o.z + i)));
+	}
+}
+
+template<typename S>
+Vector3 sum_range(Const_Fields a, int begin, int end)
+{
+	typename S::V sx = S::set1(0), sy = S::set1(0), sz = S::set1(0);
+	for (int i = begin; i < end; i += S::width)
+	{
+		sx = S::add(sx, S::load(a.x + i)); sy = S::add(sy, S::load(a.y + i)); sz = S::add(sz, S::load(a.z + i));
+	}
+	return Vector3{ S::reduce(sx), S::reduce(sy), S::reduce(sz) };
+}
+
+template<typename S>
+scalar dot_range(Const_Fields a, Const_Fields b, int begin, int end)
+{
+	typename S::V s = S::set1(0);
+	for (int i = begin; i < end; i += S::width)
+	{
+		s = S::fmadd(S::load(a.x + i), S::load(b.x + i), s);
+		s = S::fmadd(S::load(a.y + i), S::load(b.y + i), s);
+		s = S::fmadd(S::load(a.z + i), S::load(b.z + i), s);
+	}
+	return S::reduce(s);
+}
+
+template<typename S>
+void dot_field_range(Const_Fields a, Const_Fields b, scalar * out, int begin, int end, scalar c, bool add)
+{
+	typename S::V vc = S::set1(c);
+	for (int i = begin; i < end; i += S::width)
+	{
+		typename S::V d = S::fmadd(S::load(a.x + i), S::load(b.x + i),
+			S::fmadd(S::load(a.y + i), S::load(b.y + i), S::mul(S::load(a.z + i), S::load(b.z + i))));
+		S::storeu(out + i, add ? S::fmadd(vc, d, S::loadu(out + i)) : d);
+	}
+}
+
+template<typename S>
+void add_c_dot_range(scalar c, const Vector3 & a, Const_Fields b, scalar * out, int begin, int end)
+{
+	typename S::V ax = S::set1(c*a[0]), ay = S::set1(c*a[1]), az = S::set1(c*a[2]);
+	for (int i = begin; i < end; i += S::width)
+	{
+		typename S::V d = S::fmadd(ax, S::load(b.x + i), S::fmadd(ay, S::load(b.y + i), S::mul(az, S::load(b.z + i))));
+		S::storeu(out + i, S::add(S::loadu(out + i), d));
+	}
+}
+
+// out = a x b, or out += c * a x b
+template<typename S>
+void cross_range(Const_Fields a, Const_Fields b, Fields o, int begin, int end, scalar c, bool add)
+{
+	typename S::V vc = S::set1(c);
+	for (int i = begin; i < end; i += S::width)
+	{
+		typename S::V ax = S::load(a.x + i), ay = S::load(a.y + i), az = S::load(a.z + i);
+		typename S::V bx = S::load(b.x + i), by = S::load(b.y + i), bz = S::load(b.z + i);
+		typename S::V cx = S::sub(S::mul(ay, bz), S::mul(az, by));
+		typename S::V cy = S::sub(S::mul(az, bx), S::mul(ax, bz));
+		typename S::V cz = S::sub(S::mul(ax, by), S::mul(ay, bx));
+		if (add)
+		{
+			cx = S::fmadd(vc, cx, S::load(o.x + i));
+			cy = S::fmadd(vc, cy, S::load(o.y + i));
+			cz = S::fmadd(vc, cz, S::load(o.z + i));
+		}
+		S::store(o.x + i, cx); S::store(o.y + i, cy); S::store(o.z + i, cz);
+	}
+}
+
+template<typename S>
+void add_c_cross_range(scalar c, const Vector3 & a, Const_Fields b, Fields o, int begin, int end)
+{
+	typename S::V ax = S::set1(c*a[0]), ay = S::set1(c*a[1]), az = S::set1(c*a[2]);
+	for (int i = begin; i < end; i += S::width)
+	{
+		typename S::V bx = S::load(b.x + i), by = S::load(b.y + i), bz = S::load(b.z + i);
+		S::store(o.x + i, S::add(S::load(o.x + i), S::sub(S::mul(ay, bz), S::mul(az, by))));
+		S::store(o.y + i, S::add(S::load(o.y + i), S::sub(S::mul(az, bx), S::mul(ax, bz))));
+		S::store(o.z + i, S::add(S::load(o.z + i), S::sub(S::mul(ax, by), S::mul(ay, bx))));
+	}
+}
+
+// out += c*a (a constant) or out += c*a[i] (a field)
+template<typename S>
+void add_c_a_range(scalar c, const Vector3 & a, Const_Fields af, Fields o, int begin, int end, bool field)
+{
+	typename S::V vc = S::set1(c), ax = S::set1(c*a[0]), ay = S::set1(c*a[1]), az = S::set1(c*a[2]);
+	for (int i = begin; i < end; i += S::width)
+	{
+		if (field)
+		{
+			S::store(o.x + i, S::fmadd(vc, S::load(af.x + i), S::load(o.x + i)));
+			S::store(o.y + i, S::fmadd(vc, S::load(af.y + i), S::load(o.y + i)));
+			S::store(o.z + i, S::fmadd(vc, S::load(af.z + i), S::load(o.z + i)));
+		}
+		else
+		{
+			S::store(o.x + i, S::add(S::load(o.x + i), ax));
+			S::store(o.y + i, S::add(S::load(o.y + i), ay));
+			S::store(o.z + i, S::add(S::load(o.z + i), az));
+		}
+	}
+}
+
+
+// ------ Full fields: the first n - n%Simd::width elements with Simd, the rest element-wise ------
+
+void fill(Fields o, int n, const Vector3 & v)
+{
+	int n_simd = n - n % Simd::width;
+	fill_range<Simd>(o, 0, n_simd, v);
+	fill_range<Single>(o, n_simd, n, v);
+}
+
+void normalize(Fields o, int n)
+{
+	int n_simd = n - n % Simd::width;
+	normalize_range<Simd>(o, 0, n_simd);
+	normalize_range<Single>(o, n_simd, n);
+}
+
+void scale(Fields o, int n, scalar c)
+{
+	int n_simd = n - n % Simd::width;
+	scale_range<Simd>(o, 0, n_simd, c);
+	scale_range<Single>(o, n_simd, n, c);
+}
+
+Vector3 sum(Const_Fields a, int n)
+{
+	int n_simd = n - n % Simd::width;
+	return sum_range<Simd>(a, 0, n_simd) + sum_range<Single>(a, n_simd, n);
+}
+
+scalar dot(Const_Fields a, Const_Fields b, int n)
+{
+	int n_simd = n - n % Simd::width;
+	return dot_range<Simd>(a, b, 0, n_simd) + dot_range<Single>(a, b, n_simd, n);
+}
+
+void dot_field(Const_Fields a, Const_Fields b, scalar * out, int n, scalar c, bool add)
+{
+	int n_simd = n - n % Simd::width;
+	dot_field_range<Simd>(a, b, out, 0, n_simd, c, add);
+	dot_field_range<Single>(a, b, out, n_simd, n, c, add);
+}
+
+void add_c_dot(scalar c, const Vector3 & a, Const_Fields b, scalar * out, int n)
+{
+	int n_simd = n - n % Simd::width;
+	add_c_dot_range<Simd>(c, a, b, out, 0, n_simd);
+	add_c_dot_range<Single>(c, a, b, out, n_simd, n);
+}
+
+void cross(Const_Fields a, Const_Fields b, Fields o, int n, scalar c, bool add)
+{
+	int n_simd = n - n % Simd::width;
+	cross_range<Simd>(a, b, o, 0, n_simd, c, add);
+	cross_range<Single>(a, b, o, n_simd, n, c, add);
+}
+
+void add_c_cross(scalar c, const Vector3 & a, Const_Fields b, Fields o, int n)
+{
+	int n_simd = n - n % Simd::width;
+	add_c_cross_range<Simd>(c, a, b, o, 0, n_simd);
+	add_c_cross_range<Single>(c, a, b, o, n_simd, n);
+}
+
+void add_c_a(scalar c, const Vector3 & a, Const_Fields af, Fields o, int n, bool field)
+{
+	int n_simd = n - n % Simd::width;
+	add_c_a_range<Simd>(c, a, af, o, 0, n_simd, field);
+	add_c_a_range<Single>(c, a, af, o, n_simd, n, field);
+}
+
+const Kernels table = { &fill, &normalize, &scale, &sum, &dot, &dot_field, &add_c_dot, &cross, &add_c_cross, &add_c_a };
@@ -248,6 +248,7 @@ void Chain_Get_Energy(State * state, float * Energy, int idx_chain)
 
 	for (int i = 0; i < chain->noi; ++i)
 	{
+		chain->images[i]->UpdateEnergy();
 		Energy[i] = (float)chain->images[i]->E;
 	}
 }
@@ -13,6 +13,7 @@ void Configuration_DomainWall(State *state, const float pos[3], float v[3], bool
 
 	// Apply configuration
 	Utility::Configurations::DomainWall(*image, Vector3{ pos[0],pos[1],pos[2] }, Vector3{ v[0],v[1],v[2] }, greater);
+	image->Invalidate();
 }
 
 void Configuration_Homogeneous(State *state, float v[3], int idx_image, int idx_chain)
@@ -23,6 +24,7 @@ void Configuration_Homogeneous(State *state, float v[3], int idx_image, int idx_
 
     // Apply configuration
     Utility::Configurations::Homogeneous(*image, Vector3{ v[0],v[1],v[2] });
+	image->Invalidate();
 }
 
 void Configuration_PlusZ(State *state, int idx_image, int idx_chain)
@@ -33,6 +35,7 @@ void Configuration_PlusZ(State *state, int idx_image, int idx_chain)
 
     // Apply configuration
     Utility::Configurations::PlusZ(*image);
+	image->Invalidate();
 }
 
 void Configuration_MinusZ(State *state, int idx_image, int idx_chain)
@@ -43,6 +46,7 @@ void Configuration_MinusZ(State *state, int idx_image, int idx_chain)
 
     // Apply configuration
     Utility::Configurations::MinusZ(*image);
+	image->Invalidate();
 }
 
 void Configuration_Random(State *state, bool external, int idx_image, int idx_chain)
@@ -53,6 +57,7 @@ void Configuration_Random(State *state, bool external, int idx_image, int idx_ch
 
 	// Apply configuration
     Utility::Configurations::Random(*image);
+	image->Invalidate();
 }
 
 void Configuration_Add_Noise_Temperature(State *state, float temperature, int idx_image, int idx_chain)
@@ -62,6 +67,7 @@ void Configuration_Add_Noise_Temperature(State *state, float temperature, int id
 	from_indices(state, idx_image, idx_chain, image, chain);
 
     Utility::Configurations::Add_Noise_Temperature(*image, temperature);
+	image->Invalidate();
 }
 
 void Configuration_Hopfion(State *state, float pos[3], float r, int order, int idx_image, int idx_chain)
@@ -74,6 +80,7 @@ void Configuration_Hopfion(State *state, float pos[3], float r, int order, int i
 
 	// Apply configuration
 	Utility::Configurations::Hopfion(*image, position, r, order);
+	image->Invalidate();
 }
 
 void Configuration_Skyrmion(State *state, float pos[3], float r, float order, float phase, bool upDown, bool achiral, bool rl, int idx_image, int idx_chain)
@@ -86,6 +93,7 @@ void Configuration_Skyrmion(State *state, float pos[3], float r, float order, fl
 
     // Apply configuration
     Utility::Configurations::Skyrmion(*image, position, r, order, phase, upDown, achiral, rl, false);
+	image->Invalidate();
 }
 
 void Configuration_SpinSpiral(State *state, const char * direction_type, float q[3], float axis[3], float theta, int idx_image, int idx_chain)
@@ -98,4 +106,5 @@ void Configuration_SpinSpiral(State *state, const char * direction_type, float q
 
     // Apply configuration
 	Utility::Configurations::SpinSpiral(*image, dir_type, Vector3{ q[0], q[1], q[2] }, Vector3{ axis[0], axis[1], axis[2] }, theta);
+	image->Invalidate();
 }
\ No newline at end of file
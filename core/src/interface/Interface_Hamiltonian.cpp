@@ -16,9 +16,15 @@ void Hamiltonian_Set_Boundary_Conditions(State *state, const bool * periodical,
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    // Copy-on-write: other images sharing the Hamiltonian keep it unchanged
+    image->Unshare_Hamiltonian();
+
     image->hamiltonian->boundary_conditions[0] = periodical[0];
     image->hamiltonian->boundary_conditions[1] = periodical[1];
     image->hamiltonian->boundary_conditions[2] = periodical[2];
+
+    // The energy and effective field have changed
+    image->Invalidate();
 }
 
 void Hamiltonian_Set_mu_s(State *state, float mu_s, int idx_image, int idx_chain)
@@ -27,6 +33,8 @@ void Hamiltonian_Set_mu_s(State *state, float mu_s, int idx_image, int idx_chain
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->Unshare_Hamiltonian();
+
     if (image->hamiltonian->Name() == "Isotropic Heisenberg")
     {
         auto ham = (Engine::Hamiltonian_Isotropic*)image->hamiltonian.get();
@@ -37,6 +45,9 @@ void Hamiltonian_Set_mu_s(State *state, float mu_s, int idx_image, int idx_chain
         auto ham = (Engine::Hamiltonian_Anisotropic*)image->hamiltonian.get();
         for (auto& m : ham->mu_s) m = mu_s;
     }
+
+    // The energy and effective field have changed
+    image->Invalidate();
 }
 
 void Hamiltonian_Set_Field(State *state, float magnitude, const float * normal, int idx_image, int idx_chain)
@@ -45,6 +56,8 @@ void Hamiltonian_Set_Field(State *state, float magnitude, const float * normal,
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->Unshare_Hamiltonian();
+
     if (image->hamiltonian->Name() == "Isotropic Heisenberg")
     {
         auto ham = (Engine::Hamiltonian_Isotropic*)image->hamiltonian.get();
@@ -92,6 +105,9 @@ void Hamiltonian_Set_Field(State *state, float magnitude, const float * normal,
         // Update Energies
         ham->Update_Energy_Contributions();
     }
+
+    // The energy and effective field have changed
+    image->Invalidate();
 }
 
 void Hamiltonian_Set_Anisotropy(State *state, float magnitude, const float * normal, int idx_image, int idx_chain)
@@ -100,6 +116,8 @@ void Hamiltonian_Set_Anisotropy(State *state, float magnitude, const float * nor
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->Unshare_Hamiltonian();
+
     if (image->hamiltonian->Name() == "Isotropic Heisenberg")
     {
         auto ham = (Engine::Hamiltonian_Isotropic*)image->hamiltonian.get();
@@ -123,6 +141,9 @@ void Hamiltonian_Set_Anisotropy(State *state, float magnitude, const float * nor
     {
         Log(Utility::Log_Level::Error, Utility::Log_Sender::API, "Setting Anisotropy is not yet implemented in Hamiltonian_Anisotropic!");
     }
+
+    // The energy and effective field have changed
+    image->Invalidate();
 }
 
 void Hamiltonian_Set_Exchange(State *state, int n_shells, const float* jij, int idx_image, int idx_chain)
@@ -131,6 +152,8 @@ void Hamiltonian_Set_Exchange(State *state, int n_shells, const float* jij, int
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->Unshare_Hamiltonian();
+
     if (image->hamiltonian->Name() == "Isotropic Heisenberg")
     {
         auto ham = (Engine::Hamiltonian_Isotropic*)image->hamiltonian.get();
@@ -146,6 +169,9 @@ void Hamiltonian_Set_Exchange(State *state, int n_shells, const float* jij, int
     {
         Log(Utility::Log_Level::Error, Utility::Log_Sender::API, "Setting Exchange is not yet implemented in Hamiltonian_Anisotropic!");
     }
+
+    // The energy and effective field have changed
+    image->Invalidate();
 }
 
 void Hamiltonian_Set_DMI(State *state, float dij, int idx_image, int idx_chain)
@@ -154,6 +180,8 @@ void Hamiltonian_Set_DMI(State *state, float dij, int idx_image, int idx_chain)
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->Unshare_Hamiltonian();
+
     if (image->hamiltonian->Name() == "Isotropic Heisenberg")
     {
         auto ham = (Engine::Hamiltonian_Isotropic*)image->hamiltonian.get();
@@ -166,6 +194,9 @@ void Hamiltonian_Set_DMI(State *state, float dij, int idx_image, int idx_chain)
     {
         Log(Utility::Log_Level::Error, Utility::Log_Sender::API, "Setting DMI is not yet implemented in Hamiltonian_Anisotropic!");
     }
+
+    // The energy and effective field have changed
+    image->Invalidate();
 }
 
 void Hamiltonian_Set_BQE(State *state, float bij, int idx_image, int idx_chain)
@@ -174,6 +205,8 @@ void Hamiltonian_Set_BQE(State *state, float bij, int idx_image, int idx_chain)
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->Unshare_Hamiltonian();
+
     if (image->hamiltonian->Name() == "Isotropic Heisenberg")
     {
         auto ham = (Engine::Hamiltonian_Isotropic*)image->hamiltonian.get();
@@ -186,6 +219,9 @@ void Hamiltonian_Set_BQE(State *state, float bij, int idx_image, int idx_chain)
     {
         Log(Utility::Log_Level::Error, Utility::Log_Sender::API, "BQE is not implemented in Hamiltonian_Anisotropic - use Quadruplet interaction instead!");
     }
+
+    // The energy and effective field have changed
+    image->Invalidate();
 }
 
 void Hamiltonian_Set_FSC(State *state, float kijkl, int idx_image, int idx_chain)
@@ -194,6 +230,8 @@ void Hamiltonian_Set_FSC(State *state, float kijkl, int idx_image, int idx_chain
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->Unshare_Hamiltonian();
+
     if (image->hamiltonian->Name() == "Isotropic Heisenberg")
     {
         auto ham = (Engine::Hamiltonian_Isotropic*)image->hamiltonian.get();
@@ -206,6 +244,9 @@ void Hamiltonian_Set_FSC(State *state, float kijkl, int idx_image, int idx_chain
     {
         Log(Utility::Log_Level::Error, Utility::Log_Sender::API, "FSC is not implemented in Hamiltonian_Anisotropic - use Quadruplet interaction instead!");
     }
+
+    // The energy and effective field have changed
+    image->Invalidate();
 }
 
 void Hamiltonian_Set_STT(State *state, float magnitude, const float * normal, int idx_image, int idx_chain)
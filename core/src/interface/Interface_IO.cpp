@@ -50,6 +50,7 @@ void IO_Image_Read(State * state, const char * file, int format, int idx_image,
 
     // Read the data
 	Utility::IO::Read_Spin_Configuration(image, std::string(file), Utility::IO::VectorFileFormat(format));
+	image->Invalidate();
 }
 
 void IO_Image_Write(State * state, const char * file, int format, int idx_image, int idx_chain)
@@ -59,7 +60,13 @@ void IO_Image_Write(State * state, const char * file, int format, int idx_image,
 	from_indices(state, idx_image, idx_chain, image, chain);
 
 	// Write the data
-	Utility::IO::Append_Spin_Configuration(image, 0, std::string(file));
+	if (format == IO_Fileformat_Binary)
+	{
+		// A new trajectory with a single frame
+		std::ofstream(file, std::ios::trunc);
+		Utility::IO::Append_Trajectory_Frame(image, 0, std::string(file));
+	}
+	else Utility::IO::Append_Spin_Configuration(image, 0, std::string(file));
 }
 
 void IO_Image_Append(State * state, const char * file, int iteration, int format, int idx_image, int idx_chain)
@@ -69,7 +76,8 @@ void IO_Image_Append(State * state, const char * file, int iteration, int format
 	from_indices(state, idx_image, idx_chain, image, chain);
 
 	// Write the data
-	Utility::IO::Append_Spin_Configuration(image, 0, std::string(file));
+	if (format == IO_Fileformat_Binary) Utility::IO::Append_Trajectory_Frame(image, iteration, std::string(file));
+	else Utility::IO::Append_Spin_Configuration(image, 0, std::string(file));
 }
 
 
@@ -85,6 +93,7 @@ void IO_Chain_Read(State * state, const char * file, int idx_image, int idx_chai
 
 	// Read the data
 	Utility::IO::Read_SpinChain_Configuration(chain, std::string(file));
+	for (auto & img : chain->images) img->Invalidate();
 }
 
 void IO_Chain_Write(State * state, const char * file, int idx_image, int idx_chain)
@@ -149,4 +158,24 @@ void IO_Energies_Interpolated_Save(State * state, const char * file, int idx_cha
 
 	// Write the data
 	Utility::IO::Save_Energies_Interpolated(*state->active_chain, std::string(file));
+}
+
+
+/*------------------------------------------------------------------------------------------------------ */
+/*--------------------------------- Asynchronous Output ------------------------------------------------ */
+/*------------------------------------------------------------------------------------------------------ */
+
+int IO_Output_Queue_Depth(State * state)
+{
+	return Utility::IO::Output_Queue_Depth();
+}
+
+long long IO_Output_Bytes_Written(State * state)
+{
+	return (long long)Utility::IO::Output_Bytes_Written();
+}
+
+void IO_Output_Flush(State * state)
+{
+	Utility::IO::Flush_Output();
 }
\ No newline at end of file
@@ -8,6 +8,9 @@
 #include <engine/Optimizer_SIB2.hpp>
 #include <engine/Optimizer_CG.hpp>
 #include <engine/Optimizer_VP.hpp>
+#include <engine/Optimizer_LBFGS.hpp>
+#include <engine/Optimizer_MC.hpp>
+#include <engine/Method_MC.hpp>
 #include <engine/Method.hpp>
 
 
@@ -33,6 +36,20 @@ void Simulation_SingleShot(State *state, const char * c_method_type, const char
         if (n_iterations_log > 0) image->llg_parameters->n_iterations_log = n_iterations_log;
         method = std::shared_ptr<Engine::Method_LLG>(new Engine::Method_LLG(image, idx_image, idx_chain));
     }
+    else if (method_type == "LLG_Replicas")
+    {
+        for (auto & replica : chain->images) replica->iteration_allowed = true;
+        if (n_iterations > 0) chain->images[0]->llg_parameters->n_iterations = n_iterations;
+        if (n_iterations_log > 0) chain->images[0]->llg_parameters->n_iterations_log = n_iterations_log;
+        method = std::shared_ptr<Engine::Method_LLG>(new Engine::Method_LLG(chain, idx_chain));
+    }
+    else if (method_type == "MC")
+    {
+        image->iteration_allowed = true;
+        if (n_iterations > 0) image->llg_parameters->n_iterations = n_iterations;
+        if (n_iterations_log > 0) image->llg_parameters->n_iterations_log = n_iterations_log;
+        method = std::shared_ptr<Engine::Method_MC>(new Engine::Method_MC(image, idx_image, idx_chain));
+    }
     else if (method_type == "GNEB")
     {
         if (Simulation_Running_LLG_Chain(state, idx_chain))
@@ -70,8 +87,12 @@ void Simulation_SingleShot(State *state, const char * c_method_type, const char
 		return;
 	}
 
-    // Determine the Optimizer
-    if (optimizer_type == "SIB")
+    // Determine the Optimizer (Monte Carlo has its own, independent of the optimizer type)
+    if (method_type == "MC")
+    {
+        optim = std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_MC(std::dynamic_pointer_cast<Engine::Method_MC>(method)));
+    }
+    else if (optimizer_type == "SIB")
     {
         optim = std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_SIB(method));
     }
@@ -90,6 +111,10 @@ void Simulation_SingleShot(State *state, const char * c_method_type, const char
     else if (optimizer_type == "VP")
     {
         optim = std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_VP(method));
+    }
+    else if (optimizer_type == "LBFGS")
+    {
+        optim = std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_LBFGS(method));
     }
 	else
 	{
@@ -146,6 +171,29 @@ void Simulation_PlayPause(State *state, const char * c_method_type, const char *
 			if (n_iterations_log > 0) image->llg_parameters->n_iterations_log = n_iterations_log;
             method = std::shared_ptr<Engine::Method_LLG>(new Engine::Method_LLG(image, idx_image, idx_chain));
         }
+        else if (method_type == "LLG_Replicas")
+        {
+            // All images of the chain are iterated as replicas
+            if (Simulation_Running_LLG_Chain(state, idx_chain))
+            {
+                Log(Utility::Log_Level::Error, Utility::Log_Sender::API, "There are still LLG simulations running on the specified chain! Please stop them before starting a replica calculation.");
+				return;
+            }
+            else
+            {
+                for (auto & replica : chain->images) replica->iteration_allowed = true;
+                if (n_iterations > 0) chain->images[0]->llg_parameters->n_iterations = n_iterations;
+                if (n_iterations_log > 0) chain->images[0]->llg_parameters->n_iterations_log = n_iterations_log;
+                method = std::shared_ptr<Engine::Method_LLG>(new Engine::Method_LLG(chain, idx_chain));
+            }
+        }
+        else if (method_type == "MC")
+        {
+            image->iteration_allowed = true;
+            if (n_iterations > 0) image->llg_parameters->n_iterations = n_iterations;
+            if (n_iterations_log > 0) image->llg_parameters->n_iterations_log = n_iterations_log;
+            method = std::shared_ptr<Engine::Method_MC>(new Engine::Method_MC(image, idx_image, idx_chain));
+        }
         else if (method_type == "GNEB")
         {
             if (Simulation_Running_LLG_Chain(state, idx_chain))
@@ -183,8 +231,12 @@ void Simulation_PlayPause(State *state, const char * c_method_type, const char *
 			return;
 		}
 
-        // Determine the Optimizer
-        if (optimizer_type == "SIB")
+        // Determine the Optimizer (Monte Carlo has its own, independent of the optimizer type)
+        if (method_type == "MC")
+        {
+            optim = std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_MC(std::dynamic_pointer_cast<Engine::Method_MC>(method)));
+        }
+        else if (optimizer_type == "SIB")
         {
             optim = std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_SIB(method));
         }
@@ -203,6 +255,10 @@ void Simulation_PlayPause(State *state, const char * c_method_type, const char *
         else if (optimizer_type == "VP")
         {
             optim = std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_VP(method));
+        }
+        else if (optimizer_type == "LBFGS")
+        {
+            optim = std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_LBFGS(method));
         }
 		else
 		{
@@ -214,10 +270,14 @@ void Simulation_PlayPause(State *state, const char * c_method_type, const char *
 		auto info = std::shared_ptr<Simulation_Information>(new Simulation_Information{ optim, method } );
 
         // Add to correct list
-		if (method_type == "LLG")
+		if (method_type == "LLG" || method_type == "MC")
 		{
 			state->simulation_information_llg[idx_chain][idx_image] = info;
 		}
+		else if (method_type == "LLG_Replicas")
+		{
+			for (int img = 0; img < chain->noi; ++img) state->simulation_information_llg[idx_chain][img] = info;
+		}
 		else if (method_type == "GNEB")
 		{
 			state->simulation_information_gneb[idx_chain] = info;
@@ -308,6 +368,71 @@ float Simulation_Get_IterationsPerSecond(State *state, int idx_image, int idx_ch
 	return 0;
 }
 
+// The replica method running on a chain, if any
+std::shared_ptr<Engine::Method_LLG> Replica_Method(State * state, int idx_chain, std::shared_ptr<Data::Spin_System_Chain> chain)
+{
+    if (!Simulation_Running_LLG_Chain(state, idx_chain) || !state->simulation_information_llg[idx_chain][0]) return nullptr;
+    auto method = std::dynamic_pointer_cast<Engine::Method_LLG>(state->simulation_information_llg[idx_chain][0]->method);
+    if (method && (int)method->systems.size() == chain->noi && chain->noi > 1) return method;
+    return nullptr;
+}
+
+float Simulation_Get_MC_AcceptanceRatio(State * state, int idx_image, int idx_chain)
+{
+    std::shared_ptr<Data::Spin_System> image;
+    std::shared_ptr<Data::Spin_System_Chain> chain;
+    from_indices(state, idx_image, idx_chain, image, chain);
+
+    if (Simulation_Running_LLG(state, idx_image, idx_chain) && state->simulation_information_llg[idx_chain][idx_image])
+    {
+        auto method = std::dynamic_pointer_cast<Engine::Method_MC>(state->simulation_information_llg[idx_chain][idx_image]->method);
+        if (method) return (float)method->acceptance_ratio;
+    }
+    return 0;
+}
+
+void Simulation_Get_Replica_Energies(State * state, float * energies, int idx_chain)
+{
+    int idx_image = -1;
+    std::shared_ptr<Data::Spin_System> image;
+    std::shared_ptr<Data::Spin_System_Chain> chain;
+    from_indices(state, idx_image, idx_chain, image, chain);
+
+    for (int img = 0; img < chain->noi; ++img)
+    {
+        chain->images[img]->UpdateEnergy();
+        energies[img] = (float)chain->images[img]->E;
+    }
+}
+
+void Simulation_Get_Replica_MaxTorqueComponents(State * state, float * torques, int idx_chain)
+{
+    int idx_image = -1;
+    std::shared_ptr<Data::Spin_System> image;
+    std::shared_ptr<Data::Spin_System_Chain> chain;
+    from_indices(state, idx_image, idx_chain, image, chain);
+
+    auto method = Replica_Method(state, idx_chain, chain);
+    for (int img = 0; img < chain->noi; ++img)
+        torques[img] = method ? (float)method->force_maxAbsComponent_image[img] : 0;
+}
+
+void Simulation_Get_Replica_Swap_Acceptance(State * state, float * rates, int idx_chain)
+{
+    int idx_image = -1;
+    std::shared_ptr<Data::Spin_System> image;
+    std::shared_ptr<Data::Spin_System_Chain> chain;
+    from_indices(state, idx_image, idx_chain, image, chain);
+
+    auto method = Replica_Method(state, idx_chain, chain);
+    for (int img = 0; img < chain->noi - 1; ++img)
+    {
+        rates[img] = 0;
+        if (method && method->n_swaps_attempted[img] > 0)
+            rates[img] = (float)method->n_swaps_accepted[img] / method->n_swaps_attempted[img];
+    }
+}
+
 bool Simulation_Running_Any_Anywhere(State *state)
 {
     if (Simulation_Running_LLG_Anywhere(state) ||
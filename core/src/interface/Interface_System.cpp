@@ -31,6 +31,7 @@ scalar * System_Get_Effective_Field(State * state, int idx_image, int idx_chain)
 	std::shared_ptr<Data::Spin_System_Chain> chain;
 	from_indices(state, idx_image, idx_chain, image, chain);
 
+	image->UpdateEffectiveField();
 	return image->effective_field[0].data();
 }
 
@@ -49,6 +50,7 @@ float System_Get_Energy(State * state, int idx_image, int idx_chain)
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->UpdateEnergy();
     return (float)image->E;
 }
 
@@ -58,6 +60,7 @@ void System_Get_Energy_Array(State * state, float * energies, int idx_image, int
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->UpdateEnergy();
     for (unsigned int i=0; i<image->E_array.size(); ++i)
     {
         energies[i] = (float)image->E_array[i].second;
@@ -70,6 +73,7 @@ void System_Print_Energy_Array(State * state, int idx_image, int idx_chain)
     std::shared_ptr<Data::Spin_System_Chain> chain;
     from_indices(state, idx_image, idx_chain, image, chain);
 
+    image->UpdateEnergy();
     scalar nd = 1/(scalar)image->nos;
 
     std::cerr << "E_tot = " << image->E*nd << "  ||  ";
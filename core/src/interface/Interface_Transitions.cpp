@@ -15,6 +15,7 @@ void Transition_Homogeneous(State *state, int idx_1, int idx_2, int idx_chain)
 
     // Use this when State implements chain collection: else c = state->collection[idx_chain];
     Utility::Configuration_Chain::Homogeneous_Rotation(chain, idx_1, idx_2);
+    for (auto & img : chain->images) img->Invalidate();
 }
 
 void Transition_Add_Noise_Temperature(State *state, float temperature, int idx_1, int idx_2, int idx_chain)
@@ -26,4 +27,5 @@ void Transition_Add_Noise_Temperature(State *state, float temperature, int idx_1
 
     // Use this when State implements chain collection: else c = state->collection[idx_chain];
     Utility::Configuration_Chain::Add_Noise_Temperature(chain, idx_1, idx_2, temperature);
+    for (auto & img : chain->images) img->Invalidate();
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <utility/IO_Filter_File_Handle.hpp>
 #include <engine/Vectormath.hpp>
 #include <engine/Neighbours.hpp>
+#include <engine/Dipole_FFT.hpp>
+#include <engine/Dipole_Octree.hpp>
 #include <utility/Logging.hpp>
 #include <utility/Exception.hpp>
 
@@ -76,12 +78,34 @@ namespace Utility
 		{
 			Log(Log_Level::Info, Log_Sender::IO, "-------------- Initialising Spin System ------------");
 			// ----------------------------------------------------------------------------------------------
-			// Geometry
-			auto geometry = Geometry_from_Config(configFile);
+			// Geometry and Hamiltonian, from the compiled Hamiltonian if it is up to date
+			std::unique_ptr<Data::Geometry> geometry;
+			std::unique_ptr<Engine::Hamiltonian> hamiltonian;
+			std::string cache_file = "";
+			std::uint64_t cache_key = 0;
+			if (configFile != "")
+			{
+				try {
+					IO::Filter_File_Handle myfile(configFile);
+					if (myfile.Find("hamiltonian_cache")) myfile.iss >> cache_file;
+				}
+				catch (Exception ex) {
+					if (ex != Exception::File_not_Found) throw ex;
+				}
+			}
+			if (cache_file != "")
+			{
+				cache_key = Hamiltonian_Cache_Key(configFile);
+				Load_Compiled_Hamiltonian(cache_file, cache_key, geometry, hamiltonian);
+			}
+			if (!hamiltonian)
+			{
+				geometry = Geometry_from_Config(configFile);
+				hamiltonian = Hamiltonian_from_Config(configFile, *geometry);
+				if (cache_file != "" && hamiltonian) Save_Compiled_Hamiltonian(cache_file, cache_key, *geometry, *hamiltonian);
+			}
 			// LLG Parameters
 			auto llg_params = Parameters_Method_LLG_from_Config(configFile);
-			// Hamiltonian
-			auto hamiltonian = std::move(Hamiltonian_from_Config(configFile, *geometry));
 			// Spin System
 			auto system = std::unique_ptr<Data::Spin_System>(new Data::Spin_System(std::move(hamiltonian), std::move(geometry), std::move(llg_params), false));
 			// ----------------------------------------------------------------------------------------------
@@ -291,7 +315,7 @@ namespace Utility
 			std::string output_folder = "output_llg";
 			// Save output when logging
 			bool save_output_any = true, save_output_initial = false, save_output_final = true, save_output_energy = true;
-			bool save_output_archive = false, save_output_single = false;
+			bool save_output_archive = false, save_output_single = false, save_output_binary = false;
 			// PRNG Seed
 			int seed = 0;
 			// number of iterations carried out when pressing "play" or calling "iterate"
@@ -304,6 +328,10 @@ namespace Utility
 			scalar damping = 0.5;
 			// iteration time step
 			scalar dt = 1.0E-02;
+			// Adaptive time step, its error tolerance and bounds
+			bool adaptive_dt = false;
+			scalar dt_tolerance = 1e-4;
+			scalar dt_min = 1.0E-05, dt_max = 1.0;
 			// Whether to renormalize spins after every SD iteration
 			bool renorm_sd = 1;
 			// spin transfer torque vector
@@ -312,6 +340,16 @@ namespace Utility
 			Vector3 stt_polarisation_normal = { 1.0, -1.0, 0.0 };
 			// Force convergence parameter
 			scalar force_convergence = 10e-9;
+			// Checkpoint file (none if empty) and number of iterations after which it is written
+			std::string checkpoint_file = "";
+			int n_iterations_checkpoint = 0;
+			// Number of iterations between the parallel tempering swaps of replicas (0 = no swaps)
+			int n_iterations_swap = 0;
+			// Monte Carlo trial moves in a cone (or uniform), its angle [degrees] and its adaption to the target acceptance ratio
+			bool mc_metropolis_cone = true;
+			scalar mc_cone_angle = 30;
+			bool mc_adaptive_cone = true;
+			scalar mc_acceptance_target = 0.5;
 
 			//------------------------------- Parser --------------------------------
 			Log(Log_Level::Info, Log_Sender::IO, "Parameters LLG: building");
@@ -327,6 +365,7 @@ namespace Utility
 					myfile.Read_Single(save_output_energy, "llg_output_save_energy");
 					myfile.Read_Single(save_output_archive, "llg_output_save_archive");
 					myfile.Read_Single(save_output_single, "llg_output_save_single");
+					myfile.Read_Single(save_output_binary, "llg_output_binary");
 					myfile.Read_Single(seed, "llg_seed");
 					myfile.Read_Single(n_iterations, "llg_n_iterations");
 					myfile.Read_Single(n_iterations_log, "llg_n_iterations_log");
@@ -335,10 +374,21 @@ namespace Utility
 					myfile.Read_Single(dt, "llg_dt");
 					// dt = time_step [ps] * 10^-12 * gyromagnetic raio / mu_B  { / (1+damping^2)} <- not implemented
 					dt = dt*std::pow(10, -12) / Engine::Vectormath::MuB()*1.760859644*std::pow(10, 11);
+					myfile.Read_Single(adaptive_dt, "llg_adaptive_dt");
+					myfile.Read_Single(dt_tolerance, "llg_dt_tolerance");
+					myfile.Read_Single(dt_min, "llg_dt_min");
+					myfile.Read_Single(dt_max, "llg_dt_max");
 					myfile.Read_Single(renorm_sd, "llg_renorm");
 					myfile.Read_Single(stt_magnitude, "llg_stt_magnitude");
 					myfile.Read_Vector3(stt_polarisation_normal, "llg_stt_polarisation_normal");
 					myfile.Read_Single(force_convergence, "llg_force_convergence");
+					if (myfile.Find("llg_checkpoint_file")) myfile.iss >> checkpoint_file;
+					myfile.Read_Single(n_iterations_checkpoint, "llg_n_iterations_checkpoint");
+					myfile.Read_Single(n_iterations_swap, "llg_n_iterations_swap");
+					myfile.Read_Single(mc_metropolis_cone, "mc_metropolis_cone");
+					myfile.Read_Single(mc_cone_angle, "mc_cone_angle");
+					myfile.Read_Single(mc_adaptive_cone, "mc_adaptive_cone");
+					myfile.Read_Single(mc_acceptance_target, "mc_acceptance_target");
 				}// end try
 				catch (Exception ex) {
 					if (ex == Exception::File_not_Found)
@@ -356,6 +406,10 @@ namespace Utility
 			Log(Log_Level::Parameter, Log_Sender::IO, "        temperature         = " + std::to_string(temperature));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        damping             = " + std::to_string(damping));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        time step           = " + std::to_string(dt));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        adaptive_dt         = " + std::to_string(adaptive_dt));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        dt_tolerance        = " + std::to_string(dt_tolerance));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        dt_min [ps]         = " + std::to_string(dt_min));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        dt_max [ps]         = " + std::to_string(dt_max));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        stt magnitude       = " + std::to_string(stt_magnitude));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        stt normal          = " + std::to_string(stt_polarisation_normal[0]) + " " + std::to_string(stt_polarisation_normal[1]) + " " + std::to_string(stt_polarisation_normal[2]));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        force convergence   = " + std::to_string(force_convergence));
@@ -368,7 +422,31 @@ namespace Utility
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_energy  = " + std::to_string(save_output_energy));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_archive = " + std::to_string(save_output_archive));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_single  = " + std::to_string(save_output_single));
-			auto llg_params = std::unique_ptr<Data::Parameters_Method_LLG>(new Data::Parameters_Method_LLG(output_folder, {save_output_any, save_output_initial, save_output_final, save_output_energy, save_output_archive, save_output_single}, force_convergence, n_iterations, n_iterations_log, seed, temperature, damping, dt, renorm_sd, stt_magnitude, stt_polarisation_normal));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_binary  = " + std::to_string(save_output_binary));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        checkpoint_file     = " + checkpoint_file);
+			Log(Log_Level::Parameter, Log_Sender::IO, "        n_iter_checkpoint   = " + std::to_string(n_iterations_checkpoint));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        n_iterations_swap   = " + std::to_string(n_iterations_swap));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        mc_metropolis_cone  = " + std::to_string(mc_metropolis_cone));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        mc_cone_angle       = " + std::to_string(mc_cone_angle));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        mc_adaptive_cone    = " + std::to_string(mc_adaptive_cone));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        mc_accept_target    = " + std::to_string(mc_acceptance_target));
+			auto llg_params = std::unique_ptr<Data::Parameters_Method_LLG>(new Data::Parameters_Method_LLG(output_folder, {save_output_any, save_output_initial, save_output_final, save_output_energy, save_output_archive, save_output_single, save_output_binary}, force_convergence, n_iterations, n_iterations_log, seed, temperature, damping, dt, renorm_sd, stt_magnitude, stt_polarisation_normal));
+			llg_params->checkpoint_file = checkpoint_file;
+			llg_params->n_iterations_checkpoint = n_iterations_checkpoint;
+			llg_params->n_iterations_swap = n_iterations_swap;
+			llg_params->adaptive_dt = adaptive_dt;
+			llg_params->dt_tolerance = dt_tolerance;
+			// The bounds are given in ps, like dt
+			if (dt_min > 0 && dt_min <= dt_max)
+			{
+				llg_params->dt_min = dt_min*std::pow(10, -12) / Engine::Vectormath::MuB()*1.760859644*std::pow(10, 11);
+				llg_params->dt_max = dt_max*std::pow(10, -12) / Engine::Vectormath::MuB()*1.760859644*std::pow(10, 11);
+			}
+			else Log(Log_Level::Error, Log_Sender::IO, "Parameters LLG: llg_dt_min and llg_dt_max need 0 < llg_dt_min <= llg_dt_max. Using the defaults.");
+			llg_params->mc_metropolis_cone = mc_metropolis_cone;
+			llg_params->mc_cone_angle = mc_cone_angle;
+			llg_params->mc_adaptive_cone = mc_adaptive_cone;
+			llg_params->mc_acceptance_target = mc_acceptance_target;
 			Log(Log_Level::Info, Log_Sender::IO, "Parameters LLG: built");
 			return llg_params;
 		}// end Parameters_Method_LLG_from_Config
@@ -379,7 +457,7 @@ namespace Utility
 			// Output folder for results
 			std::string output_folder = "output_gneb";
 			// Save output when logging
-			bool save_output_any = true, save_output_initial = false, save_output_final = true, save_output_energy = true;
+			bool save_output_any = true, save_output_initial = false, save_output_final = true, save_output_energy = true, save_output_binary = false;
 			// Spring constant
 			scalar spring_constant = 1.0;
 			// Force convergence parameter
@@ -390,6 +468,11 @@ namespace Utility
 			int n_iterations_log = 100;
 			// Number of Energy Interpolation points
 			int n_E_interpolations = 10;
+			// Maximum number of threads evaluating the images concurrently (0 = all threads)
+			int n_threads_images = 0;
+			// Checkpoint file (none if empty) and number of iterations after which it is written
+			std::string checkpoint_file = "";
+			int n_iterations_checkpoint = 0;
 			//------------------------------- Parser --------------------------------
 			Log(Log_Level::Info, Log_Sender::IO, "Parameters GNEB: building");
 			if (configFile != "")
@@ -402,11 +485,15 @@ namespace Utility
 					myfile.Read_Single(save_output_initial, "gneb_output_save_initial");
 					myfile.Read_Single(save_output_final, "gneb_output_save_final");
 					myfile.Read_Single(save_output_energy, "gneb_output_save_energy");
+					myfile.Read_Single(save_output_binary, "gneb_output_binary");
 					myfile.Read_Single(spring_constant, "gneb_spring_constant");
 					myfile.Read_Single(force_convergence, "gneb_force_convergence");
 					myfile.Read_Single(n_iterations, "gneb_n_iterations");
 					myfile.Read_Single(n_iterations_log, "gneb_n_iterations_log");
 					myfile.Read_Single(n_E_interpolations, "gneb_n_energy_interpolations");
+					myfile.Read_Single(n_threads_images, "gneb_n_threads_images");
+					if (myfile.Find("gneb_checkpoint_file")) myfile.iss >> checkpoint_file;
+					myfile.Read_Single(n_iterations_checkpoint, "gneb_n_iterations_checkpoint");
 				}// end try
 				catch (Exception ex) {
 					if (ex == Exception::File_not_Found)
@@ -423,6 +510,7 @@ namespace Utility
 			Log(Log_Level::Parameter, Log_Sender::IO, "        spring_constant     = " + std::to_string(spring_constant));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        force_convergence   = " + std::to_string(force_convergence));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        n_E_interpolations  = " + std::to_string(n_E_interpolations));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        n_threads_images    = " + std::to_string(n_threads_images));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        n_iterations        = " + std::to_string(n_iterations));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        n_iterations_log    = " + std::to_string(n_iterations_log));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        output_folder       = " + output_folder);
@@ -430,7 +518,13 @@ namespace Utility
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_initial = " + std::to_string(save_output_initial));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_final   = " + std::to_string(save_output_final));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_energy  = " + std::to_string(save_output_energy));
-			auto gneb_params = std::unique_ptr<Data::Parameters_Method_GNEB>(new Data::Parameters_Method_GNEB(output_folder, {save_output_any, save_output_initial, save_output_final, save_output_energy}, force_convergence, n_iterations, n_iterations_log, spring_constant, n_E_interpolations));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_binary  = " + std::to_string(save_output_binary));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        checkpoint_file     = " + checkpoint_file);
+			Log(Log_Level::Parameter, Log_Sender::IO, "        n_iter_checkpoint   = " + std::to_string(n_iterations_checkpoint));
+			auto gneb_params = std::unique_ptr<Data::Parameters_Method_GNEB>(new Data::Parameters_Method_GNEB(output_folder, {save_output_any, save_output_initial, save_output_final, save_output_energy}, force_convergence, n_iterations, n_iterations_log, spring_constant, n_E_interpolations, n_threads_images));
+			gneb_params->save_output_binary = save_output_binary;
+			gneb_params->checkpoint_file = checkpoint_file;
+			gneb_params->n_iterations_checkpoint = n_iterations_checkpoint;
 			Log(Log_Level::Info, Log_Sender::IO, "Parameters GNEB: built");
 			return gneb_params;
 		}// end Parameters_Method_LLG_from_Config
@@ -448,6 +542,9 @@ namespace Utility
 			int n_iterations = (int)2E+6;
 			// Number of iterations after which the system is logged to file
 			int n_iterations_log = 100;
+			// Checkpoint file (none if empty) and number of iterations after which it is written
+			std::string checkpoint_file = "";
+			int n_iterations_checkpoint = 0;
 			
 			//------------------------------- Parser --------------------------------
 			Log(Log_Level::Info, Log_Sender::IO, "Parameters MMF: building");
@@ -464,6 +561,8 @@ namespace Utility
 					myfile.Read_Single(force_convergence, "mmf_force_convergence");
 					myfile.Read_Single(n_iterations, "mmf_n_iterations");
 					myfile.Read_Single(n_iterations_log, "mmf_n_iterations_log");
+					if (myfile.Find("mmf_checkpoint_file")) myfile.iss >> checkpoint_file;
+					myfile.Read_Single(n_iterations_checkpoint, "mmf_n_iterations_checkpoint");
 				}// end try
 				catch (Exception ex) {
 					if (ex == Exception::File_not_Found)
@@ -485,7 +584,11 @@ namespace Utility
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_initial = " + std::to_string(save_output_initial));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_final   = " + std::to_string(save_output_final));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        save_output_energy  = " + std::to_string(save_output_energy));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        checkpoint_file     = " + checkpoint_file);
+			Log(Log_Level::Parameter, Log_Sender::IO, "        n_iter_checkpoint   = " + std::to_string(n_iterations_checkpoint));
 			auto mmf_params = std::unique_ptr<Data::Parameters_Method_MMF>(new Data::Parameters_Method_MMF(output_folder, {save_output_any, save_output_initial, save_output_final, save_output_energy}, force_convergence, n_iterations, n_iterations_log));
+			mmf_params->checkpoint_file = checkpoint_file;
+			mmf_params->n_iterations_checkpoint = n_iterations_checkpoint;
 			Log(Log_Level::Info, Log_Sender::IO, "Parameters MMF: built");
 			return mmf_params;
 		}
@@ -572,6 +675,10 @@ namespace Utility
 			scalar kijkl = 0.0;
 			// Dipole-Dipole interaction radius
 			scalar dd_radius = 0.0;
+			// Dipole-Dipole method (direct, fft or octree)
+			std::string dd_method = "direct";
+			// Dipole-Dipole octree accuracy
+			scalar dd_theta = 0.5;
 
 			//------------------------------- Parser --------------------------------
 			Log(Log_Level::Info, Log_Sender::IO, "Hamiltonian_Isotropic: building");
@@ -607,6 +714,8 @@ namespace Utility
 					myfile.Read_Single(bij, "bij");
 					myfile.Read_Single(kijkl, "kijkl");
 					myfile.Read_Single(dd_radius, "dd_radius");
+					if (myfile.Find("dd_method")) myfile.iss >> dd_method;
+					if (myfile.Find("dd_theta")) myfile.iss >> dd_theta;
 				}// end try
 				catch (Exception ex) {
 					if (ex == Exception::File_not_Found)
@@ -632,9 +741,23 @@ namespace Utility
 			Log(Log_Level::Parameter, Log_Sender::IO, "        B_ij                = " + std::to_string(bij));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        K_ijkl              = " + std::to_string(kijkl));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        dd_radius           = " + std::to_string(dd_radius));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        dd_method           = " + dd_method);
+			if (dd_method == "octree") Log(Log_Level::Parameter, Log_Sender::IO, "        dd_theta            = " + std::to_string(dd_theta));
+			// The FFT covers all pairs within dd_radius (or the whole lattice if dd_radius < 0), the octree all pairs of spins
+			std::shared_ptr<Engine::Dipole_Solver> dipole_solver;
+			if (dd_radius != 0)
+			{
+				if (dd_method == "fft") dipole_solver = std::shared_ptr<Engine::Dipole_Solver>(new Engine::Dipole_FFT(geometry, boundary_conditions, dd_radius));
+				else if (dd_method == "octree")
+				{
+					if (boundary_conditions[0] || boundary_conditions[1] || boundary_conditions[2])
+						Log(Log_Level::Warning, Log_Sender::IO, "Hamiltonian_Isotropic: the Dipole-Dipole octree does not include periodic images");
+					dipole_solver = std::shared_ptr<Engine::Dipole_Solver>(new Engine::Dipole_Octree(geometry, dd_theta));
+				}
+			}
 			auto hamiltonian = std::unique_ptr<Engine::Hamiltonian_Isotropic>(new Engine::Hamiltonian_Isotropic(boundary_conditions, external_field_magnitude,
 					external_field_normal, mu_s, anisotropy_magnitude, anisotropy_normal,
-					n_neigh_shells, jij, dij, bij, kijkl, dd_radius, geometry));
+					n_neigh_shells, jij, dij, bij, kijkl, dd_radius, geometry, dipole_solver));
 			Log(Log_Level::Info, Log_Sender::IO, "Hamiltonian_Isotropic: built");
 			return hamiltonian;
 		}// end Hamiltonian_Isotropic_from_Config
@@ -675,6 +798,9 @@ namespace Utility
 			std::vector<indexPairs> DD_indices(8); std::vector<scalarfield> DD_magnitude(8); std::vector<vectorfield> DD_normal(8);
 
 			scalar dd_radius = 0.0;
+			std::string dd_method = "direct";
+			scalar dd_theta = 0.5;
+			std::shared_ptr<Engine::Dipole_Solver> dipole_solver;
 
 			// ------------ Quadruplet Interactions ------------
 			int n_quadruplets = 0;
@@ -815,7 +941,21 @@ namespace Utility
 					// Engine::Neighbours::Create_DD_Pairs_from_Neighbours(geometry, dd_neigh, dd_neigh_pos, dd_distance, dd_normal, DD_indices, DD_magnitude, DD_normal);
 					
 					
-					Engine::Neighbours::Create_Dipole_Pairs(geometry, dd_radius, DD_indices, DD_magnitude, DD_normal);
+					// Dipole Dipole method: pairs within dd_radius, FFT (where dd_radius < 0 means the whole lattice)
+					//		or octree (all pairs of spins, with accuracy dd_theta)
+					if (myfile.Find("dd_method")) myfile.iss >> dd_method;
+					if (myfile.Find("dd_theta")) myfile.iss >> dd_theta;
+					if (dd_method == "fft")
+					{
+						if (dd_radius != 0) dipole_solver = std::shared_ptr<Engine::Dipole_Solver>(new Engine::Dipole_FFT(geometry, boundary_conditions, dd_radius));
+					}
+					else if (dd_method == "octree")
+					{
+						if (boundary_conditions[0] || boundary_conditions[1] || boundary_conditions[2])
+							Log(Log_Level::Warning, Log_Sender::IO, "Hamiltonian_Anisotropic: the Dipole-Dipole octree does not include periodic images");
+						if (dd_radius != 0) dipole_solver = std::shared_ptr<Engine::Dipole_Solver>(new Engine::Dipole_Octree(geometry, dd_theta));
+					}
+					else Engine::Neighbours::Create_Dipole_Pairs(geometry, dd_radius, DD_indices, DD_magnitude, DD_normal);
 
 
 					// Interaction Quadruplets
@@ -847,6 +987,8 @@ namespace Utility
 			Log(Log_Level::Parameter, Log_Sender::IO, "        K[0]                = " + std::to_string(K));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        K_normal[0]         = " + std::to_string(K_normal[0]) + " " + std::to_string(K_normal[1]) + " " + std::to_string(K_normal[2]));
 			Log(Log_Level::Parameter, Log_Sender::IO, "        dd_radius           = " + std::to_string(dd_radius));
+			Log(Log_Level::Parameter, Log_Sender::IO, "        dd_method           = " + dd_method);
+			if (dd_method == "octree") Log(Log_Level::Parameter, Log_Sender::IO, "        dd_theta            = " + std::to_string(dd_theta));
 			auto hamiltonian = std::unique_ptr<Engine::Hamiltonian_Anisotropic>(new Engine::Hamiltonian_Anisotropic(
 				mu_s,
 				external_field_index, external_field_magnitude, external_field_normal,
@@ -855,7 +997,8 @@ namespace Utility
 				DMI_indices, DMI_magnitude, DMI_normal,
 				DD_indices, DD_magnitude, DD_normal,
 				quadruplet_indices, quadruplet_magnitude,
-				boundary_conditions
+				boundary_conditions,
+				dipole_solver
 			));
 			Log(Log_Level::Info, Log_Sender::IO, "Hamiltonian_Anisotropic: built");
 			return hamiltonian;
@@ -2,6 +2,7 @@
 #include <utility/IO_Filter_File_Handle.hpp>
 #include <engine/Vectormath.hpp>
 #include <engine/Neighbours.hpp>
+#include <engine/Dipole_Octree.hpp>
 #include <utility/Logging.hpp>
 #include <utility/Exception.hpp>
 
@@ -75,14 +76,28 @@ namespace Utility
 			config += "llg_output_save_energy         " + std::to_string(parameters->save_output_energy) + "\n";
 			config += "llg_output_save_single         " + std::to_string(parameters->save_output_single) + "\n";
 			config += "llg_output_save_archive        " + std::to_string(parameters->save_output_archive) + "\n";
+			config += "llg_output_binary              " + std::to_string(parameters->save_output_binary) + "\n";
 			config += "llg_force_convergence          " + center(parameters->force_convergence, 14, 16) + "\n";
 			config += "llg_n_iterations               " + std::to_string(parameters->n_iterations) + "\n";
 			config += "llg_n_iterations_log           " + std::to_string(parameters->n_iterations_log) + "\n";
+			config += "llg_checkpoint_file            " + parameters->checkpoint_file + "\n";
+			config += "llg_n_iterations_checkpoint    " + std::to_string(parameters->n_iterations_checkpoint) + "\n";
+			config += "llg_n_iterations_swap          " + std::to_string(parameters->n_iterations_swap) + "\n";
+			config += "mc_metropolis_cone             " + std::to_string(parameters->mc_metropolis_cone) + "\n";
+			config += "mc_cone_angle                  " + std::to_string(parameters->mc_cone_angle) + "\n";
+			config += "mc_adaptive_cone               " + std::to_string(parameters->mc_adaptive_cone) + "\n";
+			config += "mc_acceptance_target           " + std::to_string(parameters->mc_acceptance_target) + "\n";
 			config += "llg_renorm                     " + std::to_string(parameters->renorm_sd) + "\n";
 			config += "llg_seed                       " + std::to_string(parameters->seed) + "\n";
 			config += "llg_temperature                " + std::to_string(parameters->temperature) + "\n";
 			config += "llg_damping                    " + std::to_string(parameters->damping) + "\n";
-			config += "llg_dt                         " + std::to_string(parameters->dt) + "\n";
+			// The time steps are read in ps
+			scalar ps = std::pow(10, -12) / Engine::Vectormath::MuB()*1.760859644*std::pow(10, 11);
+			config += "llg_dt                         " + center(parameters->dt/ps, 14, 16) + "\n";
+			config += "llg_adaptive_dt                " + std::to_string(parameters->adaptive_dt) + "\n";
+			config += "llg_dt_tolerance               " + center(parameters->dt_tolerance, 14, 16) + "\n";
+			config += "llg_dt_min                     " + center(parameters->dt_min/ps, 14, 16) + "\n";
+			config += "llg_dt_max                     " + center(parameters->dt_max/ps, 14, 16) + "\n";
 			config += "llg_stt_magnitude              " + std::to_string(parameters->stt_magnitude) + "\n";
 			config += "llg_stt_polarisation_normal    " + std::to_string(parameters->stt_polarisation_normal[0]) + " " + std::to_string(parameters->stt_polarisation_normal[1]) + " " + std::to_string(parameters->stt_polarisation_normal[2]) + "\n";
 			config += "############### End LLG Parameters ###############";
@@ -97,12 +112,16 @@ namespace Utility
 			config += "gneb_output_save_initial       " + std::to_string(parameters->save_output_initial) + "\n";
 			config += "gneb_output_save_final         " + std::to_string(parameters->save_output_final) + "\n";
 			config += "gneb_output_save_energy        " + std::to_string(parameters->save_output_energy) + "\n";
+			config += "gneb_output_binary             " + std::to_string(parameters->save_output_binary) + "\n";
 			config += "gneb_force_convergence         " + center(parameters->force_convergence, 14, 16) + "\n";
 			config += "gneb_n_iterations              " + std::to_string(parameters->n_iterations) + "\n";
 			config += "gneb_n_iterations_log          " + std::to_string(parameters->n_iterations_log) + "\n";
+			config += "gneb_checkpoint_file           " + parameters->checkpoint_file + "\n";
+			config += "gneb_n_iterations_checkpoint   " + std::to_string(parameters->n_iterations_checkpoint) + "\n";
 			// config += "gneb_renorm                    " + std::to_string(parameters->renorm_gneb) + "\n";
 			config += "gneb_spring_constant           " + std::to_string(parameters->spring_constant) + "\n";
 			config += "gneb_n_energy_interpolations   " + std::to_string(parameters->n_E_interpolations) + "\n";
+			config += "gneb_n_threads_images          " + std::to_string(parameters->n_threads_images) + "\n";
 			config += "############### End GNEB Parameters ##############";
 			Append_String_to_File(config, configFile);
 		}// end Parameters_Method_LLG_from_Config
@@ -118,6 +137,8 @@ namespace Utility
 			config += "mmf_force_convergence          " + center(parameters->force_convergence, 14, 16) + "\n";
 			config += "mmf_n_iterations               " + std::to_string(parameters->n_iterations) + "\n";
 			config += "mmf_n_iterations_log           " + std::to_string(parameters->n_iterations_log) + "\n";
+			config += "mmf_checkpoint_file            " + parameters->checkpoint_file + "\n";
+			config += "mmf_n_iterations_checkpoint    " + std::to_string(parameters->n_iterations_checkpoint) + "\n";
 			config += "############### End MMF Parameters ###############";
 			Append_String_to_File(config, configFile);
 		}// end Parameters_Method_MMF_to_Config
@@ -159,6 +180,9 @@ namespace Utility
 			config += "bij                      " + std::to_string(ham_iso->bij) + "\n";
 			config += "kijkl                    " + std::to_string(ham_iso->kijkl) + "\n";
 			config += "dd_radius                " + std::to_string(ham_iso->dd_radius) + "\n";
+			if (ham_iso->dipole_solver) config += "dd_method                " + ham_iso->dipole_solver->Method() + "\n";
+			if (ham_iso->dipole_solver && ham_iso->dipole_solver->Method() == "octree")
+				config += "dd_theta                 " + std::to_string(((Engine::Dipole_Octree *)ham_iso->dipole_solver.get())->theta) + "\n";
 			Append_String_to_File(config, configFile);
 		}// end Hamiltonian_Isotropic_to_Config
 
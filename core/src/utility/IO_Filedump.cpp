@@ -64,6 +64,8 @@ namespace Utility
 		void Write_Energy_Header(Data::Spin_System & s, const std::string fileName, std::vector<std::string> firstcolumns, bool contributions)
 		{
 			bool readability_toggle = true;
+			// The names of the contributions are needed
+			if (contributions) s.UpdateEnergy();
 
 			std::string separator = "";
 			std::string line = "";
@@ -372,6 +374,7 @@ namespace Utility
 				Log(Log_Level::Debug, Log_Sender::All, "Started writing " + name);
 				for (int i = 0; i < no; ++i) {
 					myfile << text[i];
+					Count_Output_Bytes(text[i].size());
 				}
 				myfile.close();
 				Log(Log_Level::Debug, Log_Sender::All, "Finished writing " + name);
@@ -391,6 +394,7 @@ namespace Utility
 				Log(Log_Level::Debug, Log_Sender::All, "Started writing " + name);
 				myfile << text;
 				myfile.close();
+				Count_Output_Bytes(text.size());
 				Log(Log_Level::Debug, Log_Sender::All, "Finished writing " + name);
 			}
 			else
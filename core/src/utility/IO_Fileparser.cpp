@@ -1,5 +1,7 @@
 ﻿#include <utility/IO.hpp>
 #include <utility/IO_Filter_File_Handle.hpp>
+#include <utility/IO_Mapped_File.hpp>
+#include <utility/Threading.hpp>
 #include <utility/Logging.hpp>
 #include <utility/Exception.hpp>
 #include <engine/Vectormath.hpp>
@@ -48,125 +50,209 @@ namespace Utility
 			return result;
 		}
 
-		/*
-		Reads a configuration file into an existing Spin_System
-		*/
-		void Read_Spin_Configuration(std::shared_ptr<Data::Spin_System> s, const std::string file, VectorFileFormat format)
+		namespace
 		{
-			std::ifstream myfile(file);
-			if (myfile.is_open())
+			enum class Line_Type { Empty, Comment, Image, Spin };
+
+			// Classifies the line [begin, end). Lines containing a # are comments,
+			// in chain files the images are separated by lines containing "Image No"
+			Line_Type Classify_Line(const char * begin, const char * end, bool chain)
 			{
-				Log(Log_Level::Info, Log_Sender::IO, std::string("Reading Spins File ").append(file));
-				std::string line = "";
-				std::istringstream iss(line);
-				std::size_t found;
-				int i = 0;
-				if (format == VectorFileFormat::CSV_POS_SPIN)
+				const char * p = begin;
+				while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+				if (p == end) return Line_Type::Empty;
+				if (std::find(p, end, '#') != end) return Line_Type::Comment;
+				static const std::string image_marker = "Image No";
+				if (chain && std::search(p, end, image_marker.begin(), image_marker.end()) != end) return Line_Type::Image;
+				return Line_Type::Spin;
+			}
+
+			// Reads the three components of a spin from the line [p, end), skipping the first n_skip columns.
+			// The columns may be separated by whitespace or commas.
+			bool Parse_Spin(const char * p, const char * end, int n_skip, Vector3 & spin)
+			{
+				scalar value;
+				for (int col = 0; col < n_skip + 3; ++col)
 				{
-					auto& spins = *s->spins;
-					while (getline(myfile, line))
+					while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) ++p;
+					const char * next = Parse_Scalar(p, end, value);
+					if (next == p) return false;
+					if (col >= n_skip) spin[col - n_skip] = value;
+					p = next;
+				}
+				return true;
+			}
+
+			/*
+			Reads the spins of a file into the given fields.
+				The file is mapped into memory and split into line-aligned chunks. The chunks are parsed in parallel
+				in two passes: the first counts the spin lines (and image lines) of each chunk, from which the
+				image and row of the first spin of each chunk follow; the second parses the spins into place.
+				If chain is true, the spins following the i-th "Image No" line are read into fields[i], otherwise
+				all spins are read into fields[0]. Rows beyond the size of a field are ignored.
+				Returns the number of spin lines per image found in the file.
+			*/
+			std::vector<int> Read_Spin_Lines(const std::string & file, bool chain, int n_skip, std::vector<vectorfield *> & fields, int & n_invalid)
+			{
+				Mapped_File mapped(file);
+
+				// Chunks of at least 64 kB, a few per thread for load balancing
+				int n_threads = Utility::Threading::Get_N_Threads();
+				int n_chunks = (int)std::min<std::size_t>(4 * n_threads, mapped.Size() / 65536 + 1);
+				auto chunks = mapped.Line_Chunks(n_chunks);
+				n_chunks = chunks.size() - 1;
+
+				// First pass: the number of spin lines in the segments of each chunk, where
+				// segment 0 continues the image of the previous chunk and each image line starts a new segment
+				std::vector<std::vector<int>> segments(n_chunks);
+				Utility::Threading::Parallel_For(n_chunks, [&](int begin, int end)
+				{
+					for (int ichunk = begin; ichunk < end; ++ichunk)
 					{
-						if (i >= s->nos) { Log(Log_Level::Warning, Log_Sender::IO, "NOS mismatch in Read Spin Configuration - Aborting"); myfile.close(); return; }
-						found = line.find("#");
-						// Read the line if # is not found (# marks a comment)
-						if (found == std::string::npos)
+						auto & seg = segments[ichunk];
+						seg.assign(1, 0);
+						for (const char * line = chunks[ichunk]; line < chunks[ichunk + 1]; )
 						{
-							auto x = split_string_to_scalar(line, ",");
-							spins[i][0] = x[3];
-							spins[i][1] = x[4];
-							spins[i][2] = x[5];
-							++i;
-						}// endif (# not found)
-						 // discard line if # is found
-					}// endif new line (while)
-				}
-				else
+							const char * line_end = std::find(line, chunks[ichunk + 1], '\n');
+							auto type = Classify_Line(line, line_end, chain);
+							if (type == Line_Type::Spin) ++seg.back();
+							else if (type == Line_Type::Image) seg.push_back(0);
+							line = line_end + 1;
+						}
+					}
+				});
+
+				// Image and row of the first spin of each chunk, and the number of rows per image
+				std::vector<int> first_image(n_chunks), first_row(n_chunks);
+				std::vector<int> n_rows(chain ? 0 : 1, 0);
+				int image = chain ? -1 : 0, row = 0;
+				for (int ichunk = 0; ichunk < n_chunks; ++ichunk)
 				{
-					auto& spins = *s->spins;
-					while (getline(myfile, line))
+					first_image[ichunk] = image;
+					first_row[ichunk] = row;
+					for (unsigned int iseg = 0; iseg < segments[ichunk].size(); ++iseg)
 					{
-						if (i >= s->nos) { Log(Log_Level::Warning, Log_Sender::IO, "NOS mismatch in Read Spin Configuration - Aborting"); myfile.close(); return; }
-						found = line.find("#");
-						// Read the line if # is not found (# marks a comment)
-						if (found == std::string::npos)
+						if (iseg > 0)
 						{
-							//scalar x, y, z;
-							iss.clear();
-							iss.str(line);
-							//iss >> x >> y >> z;
-							iss >> spins[i][0] >> spins[i][1] >> spins[i][2];
-							++i;
-						}// endif (# not found)
-						 // discard line if # is found
-					}// endif new line (while)
+							++image;
+							row = 0;
+							n_rows.push_back(0);
+						}
+						row += segments[ichunk][iseg];
+						if (image >= 0) n_rows[image] += segments[ichunk][iseg];
+					}
 				}
-				if (i < s->nos) { Log(Log_Level::Warning, Log_Sender::IO, "NOS mismatch in Read Spin Configuration"); }
-				myfile.close();
-				Log(Log_Level::Info, Log_Sender::IO, "Done");
-			}
-		}
-		void Read_SpinChain_Configuration(std::shared_ptr<Data::Spin_System_Chain> c, const std::string file)
-		{
-			std::ifstream myfile(file);
-			if (myfile.is_open())
-			{
-				Log(Log_Level::Info, Log_Sender::IO, std::string("Reading SpinChain File ").append(file));
-				std::string line = "";
-				std::istringstream iss(line);
-				std::size_t found;
-				int i = 0, iimage = -1, nos = c->images[0]->nos, noi = c->noi;
-				while (getline(myfile, line))
+
+				// Second pass: parse the spins into the fields
+				std::vector<int> invalid(n_chunks, 0);
+				int n_fields = fields.size();
+				Utility::Threading::Parallel_For(n_chunks, [&](int begin, int end)
 				{
-					found = line.find("#");
-					if (found == std::string::npos)		// Read the line if # is not found (# marks a comment)
+					for (int ichunk = begin; ichunk < end; ++ichunk)
 					{
-						found = line.find("Image No");
-						if (found != std::string::npos)	// Set counters if 'Image No' was found
+						int image = first_image[ichunk], row = first_row[ichunk];
+						for (const char * line = chunks[ichunk]; line < chunks[ichunk + 1]; )
 						{
-							if (i < nos && iimage>0)	// Check if less than NOS spins were read for the image before
-							{
-								Log(Log_Level::Warning, Log_Sender::IO, std::string("NOS(image) > NOS(file) in image ").append(std::to_string(iimage)));
-							}
-							++iimage;
-							i = 0;
-							if (iimage >= noi)
+							const char * line_end = std::find(line, chunks[ichunk + 1], '\n');
+							auto type = Classify_Line(line, line_end, chain);
+							if (type == Line_Type::Image)
 							{
-								Log(Log_Level::Warning, Log_Sender::IO, "NOI(file) > NOI(chain)");
+								++image;
+								row = 0;
 							}
-							else
+							else if (type == Line_Type::Spin)
 							{
-								nos = c->images[iimage]->nos; // Note: different NOS in different images is currently not supported
+								// Spins before the first image line of a chain file are ignored
+								if (image >= 0 && image < n_fields && row < (int)fields[image]->size())
+								{
+									if (!Parse_Spin(line, line_end, n_skip, (*fields[image])[row])) ++invalid[ichunk];
+								}
+								++row;
 							}
-						}//endif "Image No"
-						else if (iimage < noi)	// The line should contain a spin
-						{
+							line = line_end + 1;
+						}
+					}
+				});
 
-							if (i >= nos)
-							{
-								Log(Log_Level::Warning, Log_Sender::IO, std::string("NOS missmatch in image ").append(std::to_string(iimage)));
-								Log(Log_Level::Warning, Log_Sender::IO, std::string("NOS(file) > NOS(image)"));
-								//Log(Log_Level::Warning, Log_Sender::IO, std::string("Aborting Loading of SpinChain Configuration ").append(file));
-								//myfile.close();
-								//return;
-							}
-							else
-							{
-								iss.clear();
-								iss.str(line);
-								auto& spins = *c->images[iimage]->spins;
-								//iss >> x >> y >> z;
-								iss >> spins[i][0] >> spins[i][1] >> spins[i][2];
-							}
-							++i;
-						}//end else
-					}// endif (# not found)
-					 // discard line if # is found
-				}// endif new line (while)
-				if (i < nos) Log(Log_Level::Warning, Log_Sender::IO, std::string("NOS(image) > NOS(file) in image ").append(std::to_string(iimage - 1)));
-				if (iimage < noi-1) Log(Log_Level::Warning, Log_Sender::IO, "NOI(chain) > NOI(file)");
-				myfile.close();
-				Log(Log_Level::Info, Log_Sender::IO, std::string("Done Reading SpinChain File ").append(file));
+				n_invalid = 0;
+				for (int n : invalid) n_invalid += n;
+				return n_rows;
+			}
+
+			int Columns_Before_Spins(VectorFileFormat format)
+			{
+				if (format == VectorFileFormat::CSV_POS_SPIN || format == VectorFileFormat::WHITESPACE_POS_SPIN) return 3;
+				return 0;
+			}
+		}
+
+		/*
+		Reads a configuration file into an existing Spin_System
+		*/
+		void Read_Spin_Configuration(std::shared_ptr<Data::Spin_System> s, const std::string file, VectorFileFormat format, int frame)
+		{
+			if (format == VectorFileFormat::BINARY_TRAJECTORY)
+			{
+				Read_Trajectory_Frame(s, file, frame);
+				return;
+			}
+
+			Log(Log_Level::Info, Log_Sender::IO, std::string("Reading Spins File ").append(file));
+			std::vector<vectorfield *> fields{ s->spins.get() };
+			std::vector<int> n_rows;
+			int n_invalid = 0;
+			try
+			{
+				n_rows = Read_Spin_Lines(file, false, Columns_Before_Spins(format), fields, n_invalid);
+			}
+			catch (Exception ex)
+			{
+				Log(Log_Level::Error, Log_Sender::IO, "Could not open spins file " + file);
+				return;
+			}
+			if (n_rows[0] != s->nos)
+				Log(Log_Level::Warning, Log_Sender::IO, "NOS mismatch in Read Spin Configuration: NOS(file) = " + std::to_string(n_rows[0]) + ", NOS(image) = " + std::to_string(s->nos));
+			if (n_invalid > 0)
+				Log(Log_Level::Warning, Log_Sender::IO, std::to_string(n_invalid) + " lines of " + file + " could not be read");
+			Log(Log_Level::Info, Log_Sender::IO, "Done");
+		}
+
+		void Read_SpinChain_Configuration(std::shared_ptr<Data::Spin_System_Chain> c, const std::string file, VectorFileFormat format)
+		{
+			if (format == VectorFileFormat::BINARY_TRAJECTORY)
+			{
+				// The frames of a chain trajectory are its images
+				int n_frames = Trajectory_N_Frames(file);
+				if (n_frames != c->noi) Log(Log_Level::Warning, Log_Sender::IO, "NOI mismatch in Read SpinChain Configuration: NOI(file) = " + std::to_string(n_frames) + ", NOI(chain) = " + std::to_string(c->noi));
+				for (int img = 0; img < std::min(n_frames, c->noi); ++img)
+					Read_Trajectory_Frame(c->images[img], file, img);
+				return;
+			}
+
+			Log(Log_Level::Info, Log_Sender::IO, std::string("Reading SpinChain File ").append(file));
+			std::vector<vectorfield *> fields;
+			for (auto & image : c->images) fields.push_back(image->spins.get());
+			std::vector<int> n_rows;
+			int n_invalid = 0;
+			try
+			{
+				n_rows = Read_Spin_Lines(file, true, Columns_Before_Spins(format), fields, n_invalid);
+			}
+			catch (Exception ex)
+			{
+				Log(Log_Level::Error, Log_Sender::IO, "Could not open spin chain file " + file);
+				return;
+			}
+			for (int img = 0; img < std::min((int)n_rows.size(), c->noi); ++img)
+			{
+				if (n_rows[img] != c->images[img]->nos)
+					Log(Log_Level::Warning, Log_Sender::IO, "NOS mismatch in image " + std::to_string(img) + ": NOS(file) = " + std::to_string(n_rows[img]) + ", NOS(image) = " + std::to_string(c->images[img]->nos));
 			}
+			if ((int)n_rows.size() > c->noi) Log(Log_Level::Warning, Log_Sender::IO, "NOI(file) > NOI(chain)");
+			if ((int)n_rows.size() < c->noi) Log(Log_Level::Warning, Log_Sender::IO, "NOI(chain) > NOI(file)");
+			if (n_invalid > 0)
+				Log(Log_Level::Warning, Log_Sender::IO, std::to_string(n_invalid) + " lines of " + file + " could not be read");
+			Log(Log_Level::Info, Log_Sender::IO, std::string("Done Reading SpinChain File ").append(file));
 		}
 
 		/*std::vector<std::vector<scalar>> External_Field_from_File(int nos, const std::string externalFieldFile)
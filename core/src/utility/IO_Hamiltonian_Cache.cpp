@@ -0,0 +1,338 @@
+#include <utility/IO.hpp>
+#include <utility/IO_Filter_File_Handle.hpp>
+#include <utility/IO_Mapped_File.hpp>
+#include <utility/IO_Binary_File.hpp>
+#include <utility/Logging.hpp>
+#include <utility/Exception.hpp>
+#include <engine/Hamiltonian_Isotropic.hpp>
+#include <engine/Hamiltonian_Anisotropic.hpp>
+#include <engine/Dipole_FFT.hpp>
+#include <engine/Dipole_Octree.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+/*
+	Compiled Hamiltonian files
+
+	The geometry and all index and coefficient arrays of an isotropic or anisotropic Hamiltonian,
+	so that a system can be set up without parsing interaction files or calculating neighbours.
+	A file is only used if its key, a hash of the config file and the files it references, matches.
+		char[8]   magic "SPIRITHC"
+		uint32    format version
+		uint32    size of scalar in bytes
+		uint64    key
+		uint32    Hamiltonian type (see Hamiltonian_Type)
+		uint32    dipole solver (see Solver_Type)
+	followed by the arrays of the geometry and the Hamiltonian in a fixed order (see IO_Binary_File.hpp).
+*/
+
+namespace Utility
+{
+	namespace IO
+	{
+		namespace
+		{
+			const char Magic[8] = { 'S','P','I','R','I','T','H','C' };
+			const std::uint32_t Version = 1;
+
+			enum class Hamiltonian_Type : std::uint32_t { Isotropic = 1, Anisotropic = 2 };
+			enum class Solver_Type : std::uint32_t { None = 0, FFT = 1, Octree = 2 };
+
+			// Adds the bytes of a file (or only its name, if it cannot be read) to an FNV-1a hash
+			void Hash_File(std::uint64_t & hash, const std::string & filename)
+			{
+				auto add = [&hash](const char * data, std::size_t size)
+				{
+					for (std::size_t i = 0; i < size; ++i)
+					{
+						hash ^= (unsigned char)data[i];
+						hash *= 1099511628211ULL;
+					}
+				};
+				add(filename.data(), filename.size());
+				try
+				{
+					Mapped_File mapped(filename);
+					add(mapped.Begin(), mapped.Size());
+				}
+				catch (Exception ex)
+				{
+				}
+			}
+
+			std::vector<int> Boundary_Conditions_to_Ints(const std::vector<bool> & boundary_conditions)
+			{
+				return std::vector<int>(boundary_conditions.begin(), boundary_conditions.end());
+			}
+		}
+
+		std::uint64_t Hamiltonian_Cache_Key(const std::string configFile)
+		{
+			std::uint64_t hash = 14695981039346656037ULL;
+			// The format of the data
+			std::uint32_t format[2] = { Version, sizeof(scalar) };
+			for (unsigned int i = 0; i < sizeof(format); ++i)
+			{
+				hash ^= reinterpret_cast<const unsigned char *>(format)[i];
+				hash *= 1099511628211ULL;
+			}
+			Hash_File(hash, configFile);
+			// The basis and interaction files referenced by the config
+			try
+			{
+				IO::Filter_File_Handle myfile(configFile);
+				for (std::string keyword : { "basis_from_config", "anisotropy_file", "interaction_pairs_file", "interaction_quadruplets_file", "external_field_file" })
+				{
+					std::string filename = "";
+					if (myfile.Find(keyword)) myfile.iss >> filename;
+					if (filename.length() > 0) Hash_File(hash, filename);
+				}
+			}
+			catch (Exception ex)
+			{
+			}
+			return hash;
+		}
+
+		void Save_Compiled_Hamiltonian(const std::string file, std::uint64_t key, const Data::Geometry & geometry, Engine::Hamiltonian & hamiltonian)
+		{
+			auto isotropic = dynamic_cast<Engine::Hamiltonian_Isotropic *>(&hamiltonian);
+			auto anisotropic = dynamic_cast<Engine::Hamiltonian_Anisotropic *>(&hamiltonian);
+			if (!isotropic && !anisotropic)
+			{
+				Log(Log_Level::Info, Log_Sender::IO, "Compiled Hamiltonian: only isotropic and anisotropic Hamiltonians are cached");
+				return;
+			}
+			auto dipole_solver = isotropic ? isotropic->dipole_solver : anisotropic->dipole_solver;
+			auto fft = std::dynamic_pointer_cast<Engine::Dipole_FFT>(dipole_solver);
+			auto octree = std::dynamic_pointer_cast<Engine::Dipole_Octree>(dipole_solver);
+			if (dipole_solver && !fft && !octree)
+			{
+				Log(Log_Level::Warning, Log_Sender::IO, "Compiled Hamiltonian: unknown Dipole-Dipole solver, not writing " + file);
+				return;
+			}
+
+			Binary_Writer out(file);
+			if (!out.file.is_open())
+			{
+				Log(Log_Level::Error, Log_Sender::IO, "Compiled Hamiltonian: could not open " + file);
+				return;
+			}
+			out.file.write(Magic, 8);
+			out.Write_Raw<std::uint32_t>(Version);
+			out.Write_Raw<std::uint32_t>(sizeof(scalar));
+			out.Write_Raw<std::uint64_t>(key);
+			out.Write_Raw<std::uint32_t>(std::uint32_t(isotropic ? Hamiltonian_Type::Isotropic : Hamiltonian_Type::Anisotropic));
+			out.Write_Raw<std::uint32_t>(std::uint32_t(fft ? Solver_Type::FFT : octree ? Solver_Type::Octree : Solver_Type::None));
+
+			// Geometry
+			out.Write_Array(geometry.basis);
+			out.Write_Array(geometry.translation_vectors);
+			out.Write_Array(geometry.n_cells);
+			out.Write_Array(geometry.basis_atoms);
+			out.Write_Array(geometry.spin_pos);
+
+			// Hamiltonian
+			out.Write_Array(Boundary_Conditions_to_Ints(hamiltonian.boundary_conditions));
+			out.Write_Value<scalar>(fft ? fft->cutoff_radius : octree ? octree->theta : 0);
+			if (isotropic)
+			{
+				auto & h = *isotropic;
+				out.Write_Value(h.external_field_magnitude);
+				out.Write_Value(h.external_field_normal);
+				out.Write_Value(h.mu_s);
+				out.Write_Value(h.anisotropy_magnitude);
+				out.Write_Value(h.anisotropy_normal);
+				out.Write_Value<std::int32_t>(h.n_neigh_shells);
+				out.Write_Array(h.jij);
+				out.Write_Value(h.dij);
+				out.Write_Value(h.bij);
+				out.Write_Value(h.kijkl);
+				out.Write_Value(h.dd_radius);
+				out.Write_Array(h.neigh_offset);
+				out.Write_Array(h.neigh);
+				out.Write_Array(h.dm_normal);
+				out.Write_Array(h.dd_offset);
+				out.Write_Array(h.dd_neigh);
+				out.Write_Array(h.dd_normal);
+				out.Write_Array(h.dd_distance);
+				out.Write_Value<std::int32_t>(h.max_n_4spin);
+				out.Write_Array(h.n_4spin_offset);
+				out.Write_Array(h.neigh_4spin);
+			}
+			else
+			{
+				auto & h = *anisotropic;
+				out.Write_Array(h.mu_s);
+				out.Write_Array(h.external_field_index);
+				out.Write_Array(h.external_field_magnitude);
+				out.Write_Array(h.external_field_normal);
+				out.Write_Array(h.anisotropy_index);
+				out.Write_Array(h.anisotropy_magnitude);
+				out.Write_Array(h.anisotropy_normal);
+				out.Write_Arrays(h.Exchange_indices);
+				out.Write_Arrays(h.Exchange_magnitude);
+				out.Write_Arrays(h.DMI_indices);
+				out.Write_Arrays(h.DMI_magnitude);
+				out.Write_Arrays(h.DMI_normal);
+				out.Write_Arrays(h.DD_indices);
+				out.Write_Arrays(h.DD_magnitude);
+				out.Write_Arrays(h.DD_normal);
+				out.Write_Arrays(h.Quadruplet_indices);
+				out.Write_Arrays(h.Quadruplet_magnitude);
+			}
+
+			if (out.file) Log(Log_Level::Info, Log_Sender::IO, "Compiled Hamiltonian written to " + file);
+			else Log(Log_Level::Error, Log_Sender::IO, "Compiled Hamiltonian: could not write to " + file);
+		}
+
+		bool Load_Compiled_Hamiltonian(const std::string file, std::uint64_t key, std::unique_ptr<Data::Geometry> & geometry, std::unique_ptr<Engine::Hamiltonian> & hamiltonian)
+		{
+			std::unique_ptr<Mapped_File> mapped;
+			try
+			{
+				mapped = std::unique_ptr<Mapped_File>(new Mapped_File(file));
+			}
+			catch (Exception ex)
+			{
+				Log(Log_Level::Info, Log_Sender::IO, "Compiled Hamiltonian: " + file + " does not exist yet");
+				return false;
+			}
+
+			Binary_Reader in(*mapped);
+			if (mapped->Size() < 8 || std::memcmp(mapped->Begin(), Magic, 8) != 0)
+			{
+				Log(Log_Level::Warning, Log_Sender::IO, "Compiled Hamiltonian: " + file + " is not a compiled Hamiltonian");
+				return false;
+			}
+			in.p += 8;
+			if (in.Read_Raw<std::uint32_t>() != Version || in.Read_Raw<std::uint32_t>() != sizeof(scalar) || in.Read_Raw<std::uint64_t>() != key)
+			{
+				Log(Log_Level::Info, Log_Sender::IO, "Compiled Hamiltonian: " + file + " is out of date");
+				return false;
+			}
+			auto type = Hamiltonian_Type(in.Read_Raw<std::uint32_t>());
+			auto solver_type = Solver_Type(in.Read_Raw<std::uint32_t>());
+
+			// Geometry
+			std::vector<Vector3> basis, translation_vectors, basis_atoms;
+			std::vector<int> n_cells;
+			vectorfield spin_pos;
+			in.Read_Array(basis);
+			in.Read_Array(translation_vectors);
+			in.Read_Array(n_cells);
+			in.Read_Array(basis_atoms);
+			in.Read_Array(spin_pos);
+			if (!in.ok || basis.size() != 3 || translation_vectors.size() != 3 || n_cells.size() != 3)
+			{
+				Log(Log_Level::Warning, Log_Sender::IO, "Compiled Hamiltonian: " + file + " is corrupt");
+				return false;
+			}
+			auto new_geometry = std::unique_ptr<Data::Geometry>(new Data::Geometry(basis, translation_vectors, n_cells, basis_atoms, spin_pos));
+
+			// Hamiltonian
+			std::vector<int> boundary_conditions_i;
+			in.Read_Array(boundary_conditions_i);
+			std::vector<bool> boundary_conditions(boundary_conditions_i.begin(), boundary_conditions_i.end());
+			scalar solver_parameter = in.Read_Value<scalar>();
+			auto Create_Solver = [&]() -> std::shared_ptr<Engine::Dipole_Solver>
+			{
+				if (solver_type == Solver_Type::FFT) return std::shared_ptr<Engine::Dipole_Solver>(new Engine::Dipole_FFT(*new_geometry, boundary_conditions, solver_parameter));
+				if (solver_type == Solver_Type::Octree) return std::shared_ptr<Engine::Dipole_Solver>(new Engine::Dipole_Octree(*new_geometry, solver_parameter));
+				return nullptr;
+			};
+
+			std::unique_ptr<Engine::Hamiltonian> new_hamiltonian;
+			if (type == Hamiltonian_Type::Isotropic)
+			{
+				auto external_field_magnitude = in.Read_Value<scalar>();
+				auto external_field_normal = in.Read_Value<Vector3>();
+				auto mu_s = in.Read_Value<scalar>();
+				auto anisotropy_magnitude = in.Read_Value<scalar>();
+				auto anisotropy_normal = in.Read_Value<Vector3>();
+				int n_neigh_shells = in.Read_Value<std::int32_t>();
+				std::vector<scalar> jij;
+				in.Read_Array(jij);
+				auto dij = in.Read_Value<scalar>();
+				auto bij = in.Read_Value<scalar>();
+				auto kijkl = in.Read_Value<scalar>();
+				auto dd_radius = in.Read_Value<scalar>();
+				Engine::Hamiltonian_Isotropic::Neighbour_Lists lists;
+				in.Read_Array(lists.neigh_offset);
+				in.Read_Array(lists.neigh);
+				in.Read_Array(lists.dm_normal);
+				in.Read_Array(lists.dd_offset);
+				in.Read_Array(lists.dd_neigh);
+				in.Read_Array(lists.dd_normal);
+				in.Read_Array(lists.dd_distance);
+				lists.max_n_4spin = in.Read_Value<std::int32_t>();
+				in.Read_Array(lists.n_4spin_offset);
+				in.Read_Array(lists.neigh_4spin);
+				if (in.ok)
+				{
+					auto h = new Engine::Hamiltonian_Isotropic(boundary_conditions, external_field_magnitude, external_field_normal, mu_s,
+						anisotropy_magnitude, anisotropy_normal, n_neigh_shells, jij, dij, bij, kijkl, dd_radius, std::move(lists), Create_Solver());
+					// The field was stored after its conversion by the constructor
+					h->external_field_magnitude = external_field_magnitude;
+					h->external_field_normal = external_field_normal;
+					new_hamiltonian = std::unique_ptr<Engine::Hamiltonian>(h);
+				}
+			}
+			else if (type == Hamiltonian_Type::Anisotropic)
+			{
+				scalarfield mu_s, external_field_magnitude, anisotropy_magnitude;
+				intfield external_field_index, anisotropy_index;
+				vectorfield external_field_normal, anisotropy_normal;
+				std::vector<indexPairs> Exchange_indices, DMI_indices, DD_indices;
+				std::vector<scalarfield> Exchange_magnitude, DMI_magnitude, DD_magnitude, quadruplet_magnitude;
+				std::vector<vectorfield> DMI_normal, DD_normal;
+				std::vector<indexQuadruplets> quadruplet_indices;
+				in.Read_Array(mu_s);
+				in.Read_Array(external_field_index);
+				in.Read_Array(external_field_magnitude);
+				in.Read_Array(external_field_normal);
+				in.Read_Array(anisotropy_index);
+				in.Read_Array(anisotropy_magnitude);
+				in.Read_Array(anisotropy_normal);
+				in.Read_Arrays(Exchange_indices);
+				in.Read_Arrays(Exchange_magnitude);
+				in.Read_Arrays(DMI_indices);
+				in.Read_Arrays(DMI_magnitude);
+				in.Read_Arrays(DMI_normal);
+				in.Read_Arrays(DD_indices);
+				in.Read_Arrays(DD_magnitude);
+				in.Read_Arrays(DD_normal);
+				in.Read_Arrays(quadruplet_indices);
+				in.Read_Arrays(quadruplet_magnitude);
+				if (in.ok)
+				{
+					auto h = new Engine::Hamiltonian_Anisotropic(mu_s,
+						external_field_index, external_field_magnitude, external_field_normal,
+						anisotropy_index, anisotropy_magnitude, anisotropy_normal,
+						Exchange_indices, Exchange_magnitude,
+						DMI_indices, DMI_magnitude, DMI_normal,
+						DD_indices, DD_magnitude, DD_normal,
+						quadruplet_indices, quadruplet_magnitude,
+						boundary_conditions, Create_Solver());
+					// The field was stored after its conversion by the constructor
+					h->external_field_magnitude = external_field_magnitude;
+					new_hamiltonian = std::unique_ptr<Engine::Hamiltonian>(h);
+				}
+			}
+
+			if (!new_hamiltonian)
+			{
+				Log(Log_Level::Warning, Log_Sender::IO, "Compiled Hamiltonian: " + file + " is corrupt");
+				return false;
+			}
+			geometry = std::move(new_geometry);
+			hamiltonian = std::move(new_hamiltonian);
+			Log(Log_Level::Info, Log_Sender::IO, "Compiled Hamiltonian read from " + file);
+			return true;
+		}
+	}
+}
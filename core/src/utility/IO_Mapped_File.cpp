@@ -0,0 +1,117 @@
+#include <utility/IO_Mapped_File.hpp>
+#include <utility/Exception.hpp>
+
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#define IO_MAPPED_FILE_POSIX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace Utility
+{
+	namespace IO
+	{
+		Mapped_File::Mapped_File(const std::string & filename) : data(nullptr), size(0), mapped(false)
+		{
+		#ifdef IO_MAPPED_FILE_POSIX
+			int fd = open(filename.c_str(), O_RDONLY);
+			if (fd < 0) throw Utility::Exception::File_not_Found;
+			struct stat st;
+			bool has_size = fstat(fd, &st) == 0;
+			if (has_size && st.st_size > 0)
+			{
+				void * p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED)
+				{
+					// The file is read front to back
+					madvise(p, st.st_size, MADV_SEQUENTIAL);
+					this->data = static_cast<const char *>(p);
+					this->size = st.st_size;
+					this->mapped = true;
+				}
+			}
+			close(fd);
+			if (this->mapped || (has_size && st.st_size == 0)) return;
+		#endif
+			// Fall back to reading the file into a buffer
+			std::ifstream file(filename, std::ios::in | std::ios::binary);
+			if (!file.is_open()) throw Utility::Exception::File_not_Found;
+			this->buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			this->data = this->buffer.data();
+			this->size = this->buffer.size();
+		}
+
+		Mapped_File::~Mapped_File()
+		{
+		#ifdef IO_MAPPED_FILE_POSIX
+			if (this->mapped) munmap(const_cast<char *>(this->data), this->size);
+		#endif
+		}
+
+		std::vector<const char *> Mapped_File::Line_Chunks(int n_chunks) const
+		{
+			std::vector<const char *> chunks{ this->Begin() };
+			n_chunks = std::max(1, n_chunks);
+			for (int i = 1; i < n_chunks; ++i)
+			{
+				const char * p = std::max(chunks.back(), this->Begin() + this->size / n_chunks * i);
+				// Move the boundary to the beginning of the next line
+				p = std::find(p, this->End(), '\n');
+				if (p == this->End()) break;
+				if (p + 1 > chunks.back()) chunks.push_back(p + 1);
+			}
+			chunks.push_back(this->End());
+			return chunks;
+		}
+
+		const char * Parse_Scalar(const char * begin, const char * end, scalar & value)
+		{
+			// Fast path for plain decimal numbers: if the digits fit exactly into a double and the
+			// power of ten is exact as well, a single multiplication or division is correctly rounded
+			static const double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+			const char * p = begin;
+			bool negative = false;
+			if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+			std::uint64_t mantissa = 0;
+			int n_digits = 0, exponent = 0;
+			for (; p < end && *p >= '0' && *p <= '9'; ++p, ++n_digits) mantissa = 10 * mantissa + (*p - '0');
+			if (p < end && *p == '.')
+			{
+				for (++p; p < end && *p >= '0' && *p <= '9'; ++p, ++n_digits, --exponent) mantissa = 10 * mantissa + (*p - '0');
+			}
+			bool plain = n_digits > 0 && n_digits <= 15 && !(p < end && (*p == 'e' || *p == 'E' || *p == 'n' || *p == 'N' || *p == 'i' || *p == 'I'));
+			if (plain && exponent >= -22)
+			{
+				double x = exponent < 0 ? double(mantissa) / powers_of_ten[-exponent] : double(mantissa);
+				value = scalar(negative ? -x : x);
+				return p;
+			}
+
+			// Otherwise copy the characters which can be part of a number into a null-terminated buffer
+			char token[64];
+			int n = 0;
+			for (p = begin; p < end && n < 63; ++p, ++n)
+			{
+				char c = *p;
+				if (!((c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E'
+					|| c == 'n' || c == 'N' || c == 'a' || c == 'A' || c == 'i' || c == 'I' || c == 'f' || c == 'F'))
+					break;
+				token[n] = c;
+			}
+			token[n] = '\0';
+			char * token_end;
+			double x = std::strtod(token, &token_end);
+			if (token_end == token) return begin;
+			value = scalar(x);
+			return begin + (token_end - token);
+		}
+	}
+}
@@ -0,0 +1,180 @@
+#include <utility/IO.hpp>
+#include <utility/Logging.hpp>
+
+#include <atomic>
+#include <algorithm>
+#ifdef CORE_USE_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#endif
+
+namespace Utility
+{
+	namespace IO
+	{
+		namespace
+		{
+			std::atomic<std::uint64_t> bytes_written(0);
+
+		#ifdef CORE_USE_THREADS
+			// FIFO of output tasks, which are executed one after the other on a dedicated thread
+			class Output_Queue
+			{
+			public:
+				Output_Queue() : capacity(4), n_queued(0), n_done(0), stop(false)
+				{
+					this->thread = std::thread([this] { this->Run(); });
+				}
+
+				// Writes the remaining output before the program exits
+				~Output_Queue()
+				{
+					{
+						std::lock_guard<std::mutex> lock(this->mutex);
+						this->stop = true;
+					}
+					this->cv_task.notify_all();
+					this->thread.join();
+				}
+
+				std::uint64_t Push(std::function<void()> task)
+				{
+					std::unique_lock<std::mutex> lock(this->mutex);
+					// Backpressure: wait until a task has finished if the queue is full
+					this->cv_done.wait(lock, [this] { return this->n_queued - this->n_done < (std::uint64_t)this->capacity; });
+					this->tasks.push_back(std::move(task));
+					std::uint64_t ticket = ++this->n_queued;
+					lock.unlock();
+					this->cv_task.notify_one();
+					return ticket;
+				}
+
+				void Wait(std::uint64_t ticket)
+				{
+					std::unique_lock<std::mutex> lock(this->mutex);
+					this->cv_done.wait(lock, [this, ticket] { return this->n_done >= ticket; });
+				}
+
+				void Flush()
+				{
+					std::unique_lock<std::mutex> lock(this->mutex);
+					this->cv_done.wait(lock, [this] { return this->n_done == this->n_queued; });
+				}
+
+				int Depth()
+				{
+					std::lock_guard<std::mutex> lock(this->mutex);
+					return int(this->n_queued - this->n_done);
+				}
+
+				void Set_Capacity(int capacity)
+				{
+					{
+						std::lock_guard<std::mutex> lock(this->mutex);
+						this->capacity = std::max(1, capacity);
+					}
+					this->cv_done.notify_all();
+				}
+
+			private:
+				void Run()
+				{
+					while (true)
+					{
+						std::function<void()> task;
+						{
+							std::unique_lock<std::mutex> lock(this->mutex);
+							this->cv_task.wait(lock, [this] { return this->stop || !this->tasks.empty(); });
+							if (this->tasks.empty()) return;
+							task = std::move(this->tasks.front());
+							this->tasks.pop_front();
+						}
+						try
+						{
+							task();
+						}
+						catch (...)
+						{
+							Log(Log_Level::Error, Log_Sender::IO, "An output task failed");
+						}
+						{
+							std::lock_guard<std::mutex> lock(this->mutex);
+							++this->n_done;
+						}
+						this->cv_done.notify_all();
+					}
+				}
+
+				int capacity;
+				// Tickets: the i-th task pushed has ticket i, it is finished when n_done >= i
+				std::uint64_t n_queued, n_done;
+				bool stop;
+				std::deque<std::function<void()>> tasks;
+				std::mutex mutex;
+				std::condition_variable cv_task, cv_done;
+				std::thread thread;
+			};
+
+			Output_Queue & queue()
+			{
+				static Output_Queue q;
+				return q;
+			}
+		#else
+			std::uint64_t n_done = 0;
+		#endif
+		}
+
+		std::uint64_t Queue_Output(std::function<void()> task)
+		{
+		#ifdef CORE_USE_THREADS
+			return queue().Push(std::move(task));
+		#else
+			task();
+			return ++n_done;
+		#endif
+		}
+
+		void Wait_For_Output(std::uint64_t ticket)
+		{
+		#ifdef CORE_USE_THREADS
+			if (ticket > 0) queue().Wait(ticket);
+		#endif
+		}
+
+		void Flush_Output()
+		{
+		#ifdef CORE_USE_THREADS
+			queue().Flush();
+		#endif
+		}
+
+		void Set_Output_Queue_Capacity(int capacity)
+		{
+		#ifdef CORE_USE_THREADS
+			queue().Set_Capacity(capacity);
+		#endif
+		}
+
+		int Output_Queue_Depth()
+		{
+		#ifdef CORE_USE_THREADS
+			return queue().Depth();
+		#else
+			return 0;
+		#endif
+		}
+
+		std::uint64_t Output_Bytes_Written()
+		{
+			return bytes_written;
+		}
+
+		void Count_Output_Bytes(std::size_t n_bytes)
+		{
+			bytes_written += n_bytes;
+		}
+	}
+}
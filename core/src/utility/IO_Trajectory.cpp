@@ -0,0 +1,389 @@
+#include <utility/IO.hpp>
+#include <utility/Logging.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+/*
+	Binary trajectory files
+
+	The file starts with a header describing the geometry:
+		char[8]   magic "SPIRITTR"
+		uint32    format version
+		int32     nos
+		int32     n_cells[3]
+		int32     number of basis atoms
+		uint64    fingerprint of nos and the spin positions
+		double    basis[3][3], translation_vectors[3][3], basis_atoms[n_basis][3]
+		uint64    offset of the first index block
+
+	The frames are found via a linked list of index blocks, each holding the offsets of up to
+	Index_Capacity frames, so that frames can be appended and read in any order without scanning:
+		uint64    offset of the next index block (0 for the last one)
+		uint32    number of frames in this block
+		uint32    capacity of this block
+		uint64    offsets of the frames[capacity]
+
+	Each frame holds:
+		int32     iteration
+		uint32    compression (see Trajectory_Compression)
+		double    energy
+		uint64    size of the data in bytes
+		          data: the 3*nos spin components as double, float or 16 bit fixed point
+
+	All values are stored in the byte order of the writing machine.
+*/
+
+namespace Utility
+{
+	namespace IO
+	{
+		namespace
+		{
+			const char Magic[8] = { 'S','P','I','R','I','T','T','R' };
+			const std::uint32_t Version = 1;
+			const std::uint32_t Index_Capacity = 1024;
+
+			template<typename T>
+			void write_value(std::fstream & file, const T & value)
+			{
+				file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+			}
+
+			template<typename T>
+			T read_value(std::fstream & file)
+			{
+				T value;
+				file.read(reinterpret_cast<char *>(&value), sizeof(T));
+				return value;
+			}
+
+			void write_vectors(std::fstream & file, const std::vector<Vector3> & vectors)
+			{
+				for (auto & v : vectors)
+				{
+					for (int dim = 0; dim < 3; ++dim) write_value<double>(file, v[dim]);
+				}
+			}
+
+			// FNV-1a hash of nos and the spin positions, to recognise the geometry of a file
+			std::uint64_t Fingerprint(const Data::Geometry & geometry)
+			{
+				std::uint64_t hash = 14695981039346656037ULL;
+				auto add = [&hash](const void * data, std::size_t size)
+				{
+					const unsigned char * bytes = static_cast<const unsigned char *>(data);
+					for (std::size_t i = 0; i < size; ++i)
+					{
+						hash ^= bytes[i];
+						hash *= 1099511628211ULL;
+					}
+				};
+				std::int32_t nos = geometry.nos;
+				add(&nos, sizeof(nos));
+				for (auto & p : geometry.spin_pos)
+				{
+					for (int dim = 0; dim < 3; ++dim)
+					{
+						double x = p[dim];
+						add(&x, sizeof(x));
+					}
+				}
+				return hash;
+			}
+
+			struct Header
+			{
+				std::int32_t nos;
+				std::uint64_t fingerprint;
+				std::uint64_t first_index;
+			};
+
+			// Reads the header of an open file, returns false if it is not a trajectory file
+			bool Read_Header(std::fstream & file, Header & header)
+			{
+				char magic[8];
+				file.seekg(0);
+				file.read(magic, 8);
+				if (!file || std::memcmp(magic, Magic, 8) != 0) return false;
+				if (read_value<std::uint32_t>(file) != Version) return false;
+				header.nos = read_value<std::int32_t>(file);
+				for (int dim = 0; dim < 3; ++dim) read_value<std::int32_t>(file);
+				std::int32_t n_basis = read_value<std::int32_t>(file);
+				header.fingerprint = read_value<std::uint64_t>(file);
+				file.seekg((6 + n_basis) * 3 * sizeof(double), std::ios::cur);
+				header.first_index = read_value<std::uint64_t>(file);
+				return bool(file);
+			}
+
+			void Write_Header(std::fstream & file, const Data::Geometry & geometry)
+			{
+				file.write(Magic, 8);
+				write_value<std::uint32_t>(file, Version);
+				write_value<std::int32_t>(file, geometry.nos);
+				for (int dim = 0; dim < 3; ++dim) write_value<std::int32_t>(file, geometry.n_cells[dim]);
+				write_value<std::int32_t>(file, geometry.n_spins_basic_domain);
+				write_value<std::uint64_t>(file, Fingerprint(geometry));
+				write_vectors(file, geometry.basis);
+				write_vectors(file, geometry.translation_vectors);
+				write_vectors(file, geometry.basis_atoms);
+				// The first index block follows directly
+				std::uint64_t first_index = std::uint64_t(file.tellp()) + sizeof(std::uint64_t);
+				write_value<std::uint64_t>(file, first_index);
+			}
+
+			// Appends an empty index block at the end of the file and returns its offset
+			std::uint64_t Append_Index_Block(std::fstream & file)
+			{
+				file.seekp(0, std::ios::end);
+				std::uint64_t offset = file.tellp();
+				write_value<std::uint64_t>(file, 0);
+				write_value<std::uint32_t>(file, 0);
+				write_value<std::uint32_t>(file, Index_Capacity);
+				std::vector<std::uint64_t> offsets(Index_Capacity, 0);
+				file.write(reinterpret_cast<const char *>(offsets.data()), Index_Capacity * sizeof(std::uint64_t));
+				return offset;
+			}
+
+			// The offsets of all frames of a file
+			std::vector<std::uint64_t> Read_Index(std::fstream & file, const Header & header)
+			{
+				std::vector<std::uint64_t> frames;
+				std::uint64_t block = header.first_index;
+				while (block != 0 && file)
+				{
+					file.seekg(block);
+					std::uint64_t next = read_value<std::uint64_t>(file);
+					std::uint32_t n_frames = read_value<std::uint32_t>(file);
+					read_value<std::uint32_t>(file);
+					std::vector<std::uint64_t> offsets(n_frames);
+					file.read(reinterpret_cast<char *>(offsets.data()), n_frames * sizeof(std::uint64_t));
+					frames.insert(frames.end(), offsets.begin(), offsets.end());
+					block = next;
+				}
+				return frames;
+			}
+
+			// Appends a frame to an open trajectory file
+			void Append_Frame(std::fstream & file, const Header & header, const vectorfield & spins, int iteration, scalar energy, Trajectory_Compression compression)
+			{
+				// Encode the spins
+				int n = 3 * spins.size();
+				const scalar * in = spins[0].data();
+				std::vector<char> data;
+				if (compression == Trajectory_Compression::SINGLE_PRECISION)
+				{
+					data.resize(n * sizeof(float));
+					float * out = reinterpret_cast<float *>(data.data());
+					for (int i = 0; i < n; ++i) out[i] = float(in[i]);
+				}
+				else if (compression == Trajectory_Compression::FIXED_POINT_16)
+				{
+					data.resize(n * sizeof(std::int16_t));
+					std::int16_t * out = reinterpret_cast<std::int16_t *>(data.data());
+					for (int i = 0; i < n; ++i)
+					{
+						scalar x = std::max(scalar(-1), std::min(scalar(1), in[i]));
+						out[i] = std::int16_t(std::lround(x * 32767));
+					}
+				}
+				else
+				{
+					data.resize(n * sizeof(double));
+					double * out = reinterpret_cast<double *>(data.data());
+					for (int i = 0; i < n; ++i) out[i] = in[i];
+				}
+
+				// Find the last index block, or start a new one if it is full
+				std::uint64_t block = header.first_index, next;
+				std::uint32_t n_frames;
+				while (true)
+				{
+					file.seekg(block);
+					next = read_value<std::uint64_t>(file);
+					n_frames = read_value<std::uint32_t>(file);
+					if (next == 0) break;
+					block = next;
+				}
+				if (n_frames == Index_Capacity)
+				{
+					std::uint64_t new_block = Append_Index_Block(file);
+					file.seekp(block);
+					write_value<std::uint64_t>(file, new_block);
+					block = new_block;
+					n_frames = 0;
+				}
+
+				// Write the frame before it is added to the index, so that an interrupted write leaves a valid file
+				file.seekp(0, std::ios::end);
+				std::uint64_t offset = file.tellp();
+				write_value<std::int32_t>(file, iteration);
+				write_value<std::uint32_t>(file, std::uint32_t(compression));
+				write_value<double>(file, energy);
+				write_value<std::uint64_t>(file, data.size());
+				file.write(data.data(), data.size());
+				Count_Output_Bytes(data.size());
+
+				file.seekp(block + sizeof(std::uint64_t) + 2 * sizeof(std::uint32_t) + n_frames * sizeof(std::uint64_t));
+				write_value<std::uint64_t>(file, offset);
+				file.seekp(block + sizeof(std::uint64_t));
+				write_value<std::uint32_t>(file, n_frames + 1);
+			}
+
+			// Opens a trajectory for appending, creating it if necessary.
+			//		Returns false if the file cannot be used for the given geometry.
+			bool Open_for_Appending(std::fstream & file, const std::string fileName, const Data::Geometry & geometry, Header & header)
+			{
+				file.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+				if (!file.is_open() || file.peek() == std::fstream::traits_type::eof())
+				{
+					// Create a new file
+					file.close();
+					file.open(fileName, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+					if (!file.is_open())
+					{
+						Log(Log_Level::Error, Log_Sender::IO, "Could not open " + fileName + " to write to file");
+						return false;
+					}
+					Write_Header(file, geometry);
+					Append_Index_Block(file);
+				}
+				file.clear();
+				if (!Read_Header(file, header))
+				{
+					Log(Log_Level::Error, Log_Sender::IO, "Not a valid trajectory file: " + fileName);
+					return false;
+				}
+				if (header.nos != geometry.nos || header.fingerprint != Fingerprint(geometry))
+				{
+					Log(Log_Level::Error, Log_Sender::IO, "The trajectory " + fileName + " belongs to a different geometry - not appending");
+					return false;
+				}
+				return true;
+			}
+		}
+
+
+		void Append_Trajectory_Frame(std::shared_ptr<Data::Spin_System> & s, const int iteration, const std::string fileName, Trajectory_Compression compression)
+		{
+			std::fstream file;
+			Header header;
+			if (!Open_for_Appending(file, fileName, *s->geometry, header)) return;
+
+			Log(Log_Level::Debug, Log_Sender::All, "Started writing " + fileName);
+			s->UpdateEnergy();
+			Append_Frame(file, header, *s->spins, iteration, s->E, compression);
+			if (!file) Log(Log_Level::Error, Log_Sender::IO, "Could not write to " + fileName);
+			Log(Log_Level::Debug, Log_Sender::All, "Finished writing " + fileName);
+		}
+
+		void Save_SpinChain_Trajectory(std::shared_ptr<Data::Spin_System_Chain> & c, const std::string fileName, Trajectory_Compression compression)
+		{
+			// Start a new file
+			std::ofstream(fileName, std::ios::trunc);
+			std::fstream file;
+			Header header;
+			if (!Open_for_Appending(file, fileName, *c->images[0]->geometry, header)) return;
+
+			Log(Log_Level::Debug, Log_Sender::All, "Started writing " + fileName);
+			for (int img = 0; img < c->noi; ++img)
+			{
+				c->images[img]->UpdateEnergy();
+				Append_Frame(file, header, *c->images[img]->spins, img, c->images[img]->E, compression);
+			}
+			if (!file) Log(Log_Level::Error, Log_Sender::IO, "Could not write to " + fileName);
+			Log(Log_Level::Debug, Log_Sender::All, "Finished writing " + fileName);
+		}
+
+		int Trajectory_N_Frames(const std::string fileName)
+		{
+			std::fstream file(fileName, std::ios::in | std::ios::binary);
+			Header header;
+			if (!file.is_open() || !Read_Header(file, header)) return 0;
+			return Read_Index(file, header).size();
+		}
+
+		void Read_Trajectory_Frame(std::shared_ptr<Data::Spin_System> s, const std::string fileName, int frame, int * iteration, scalar * energy)
+		{
+			std::fstream file(fileName, std::ios::in | std::ios::binary);
+			Header header;
+			if (!file.is_open())
+			{
+				Log(Log_Level::Error, Log_Sender::IO, "Could not open trajectory file " + fileName);
+				return;
+			}
+			if (!Read_Header(file, header))
+			{
+				Log(Log_Level::Error, Log_Sender::IO, "Not a valid trajectory file: " + fileName);
+				return;
+			}
+			if (header.nos != s->nos)
+			{
+				Log(Log_Level::Error, Log_Sender::IO, "NOS mismatch in Read Trajectory Frame - Aborting");
+				return;
+			}
+			if (header.fingerprint != Fingerprint(*s->geometry))
+				Log(Log_Level::Warning, Log_Sender::IO, "The trajectory " + fileName + " was written for different spin positions");
+
+			auto frames = Read_Index(file, header);
+			int n_frames = frames.size();
+			if (frame < 0) frame += n_frames;
+			if (frame < 0 || frame >= n_frames)
+			{
+				Log(Log_Level::Error, Log_Sender::IO, "Frame " + std::to_string(frame) + " does not exist in " + fileName
+					+ ", which has " + std::to_string(n_frames) + " frames");
+				return;
+			}
+
+			Log(Log_Level::Info, Log_Sender::IO, "Reading frame " + std::to_string(frame) + " of trajectory " + fileName);
+			file.seekg(frames[frame]);
+			std::int32_t frame_iteration = read_value<std::int32_t>(file);
+			auto compression = Trajectory_Compression(read_value<std::uint32_t>(file));
+			double frame_energy = read_value<double>(file);
+			std::uint64_t size = read_value<std::uint64_t>(file);
+			std::vector<char> data(size);
+			file.read(data.data(), size);
+
+			int n = 3 * s->nos;
+			std::size_t element_size = compression == Trajectory_Compression::SINGLE_PRECISION ? sizeof(float)
+				: compression == Trajectory_Compression::FIXED_POINT_16 ? sizeof(std::int16_t) : sizeof(double);
+			if (!file || size != n * element_size)
+			{
+				Log(Log_Level::Error, Log_Sender::IO, "Frame " + std::to_string(frame) + " of " + fileName + " is incomplete - Aborting");
+				return;
+			}
+
+			auto & spins = *s->spins;
+			scalar * out = spins[0].data();
+			if (compression == Trajectory_Compression::SINGLE_PRECISION)
+			{
+				const float * in = reinterpret_cast<const float *>(data.data());
+				for (int i = 0; i < n; ++i) out[i] = in[i];
+			}
+			else if (compression == Trajectory_Compression::FIXED_POINT_16)
+			{
+				const std::int16_t * in = reinterpret_cast<const std::int16_t *>(data.data());
+				for (int i = 0; i < n; ++i) out[i] = in[i] / scalar(32767);
+			}
+			else
+			{
+				const double * in = reinterpret_cast<const double *>(data.data());
+				for (int i = 0; i < n; ++i) out[i] = scalar(in[i]);
+			}
+			// Reduced precision leaves the spins slightly off the unit sphere
+			if (compression != Trajectory_Compression::NONE)
+			{
+				for (auto & spin : spins) spin.normalize();
+			}
+
+			if (iteration) *iteration = frame_iteration;
+			if (energy) *energy = frame_energy;
+			Log(Log_Level::Info, Log_Sender::IO, "Done");
+		}
+	}
+}
@@ -146,13 +146,17 @@ namespace Utility
 			Send(Log_Level::Info, Log_Sender::All, "Appending Log to file " + output_folder + "/" + fileName);
 			
 			// Gather the string
+			//		This may be called from the output thread, while other threads are adding entries
 			std::string logstring = "";
-			int begin_append = no_dumped;
-			no_dumped = n_entries;
-			for (int i=begin_append; i<n_entries; ++i)
 			{
-				logstring.append(LogEntryToString(log_entries[i]));
-				logstring.append("\n");
+				std::lock_guard<std::mutex> guard(mutex);
+				int begin_append = no_dumped;
+				no_dumped = n_entries;
+				for (int i=begin_append; i<n_entries; ++i)
+				{
+					logstring.append(LogEntryToString(log_entries[i]));
+					logstring.append("\n");
+				}
 			}
 
 			// Append to file
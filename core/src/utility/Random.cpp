@@ -0,0 +1,47 @@
+#include <utility/Random.hpp>
+#include <utility/Threading.hpp>
+
+#include <cmath>
+
+namespace Utility
+{
+	namespace Random
+	{
+		// The four uniform random numbers in (0,1) of spin ispin
+		inline std::array<scalar, 4> Uniform_4(int ispin, int seed, uint64_t iteration)
+		{
+			std::array<uint32_t, 2> key = { (uint32_t)seed, 0 };
+			auto r0 = Philox4x32({ (uint32_t)ispin, 0, (uint32_t)iteration, (uint32_t)(iteration >> 32) }, key);
+			auto r1 = Philox4x32({ (uint32_t)ispin, 1, (uint32_t)iteration, (uint32_t)(iteration >> 32) }, key);
+			return { Uniform_Open(r0[0], r0[1]), Uniform_Open(r0[2], r0[3]), Uniform_Open(r1[0], r1[1]), Uniform_Open(r1[2], r1[3]) };
+		}
+
+		void Fill_Gaussian(vectorfield & vf, scalar sigma, int seed, uint64_t iteration)
+		{
+			const scalar two_pi = 6.283185307179586476925;
+			Threading::Parallel_For(vf.size(), [&](int begin, int end)
+			{
+				for (int ispin = begin; ispin < end; ++ispin)
+				{
+					// Box-Muller transform of two pairs of uniform numbers
+					auto u = Uniform_4(ispin, seed, iteration);
+					scalar r0 = sigma * std::sqrt(-2 * std::log(u[0]));
+					scalar r1 = sigma * std::sqrt(-2 * std::log(u[2]));
+					vf[ispin] = { r0 * std::cos(two_pi*u[1]), r0 * std::sin(two_pi*u[1]), r1 * std::cos(two_pi*u[3]) };
+				}
+			});
+		}
+
+		void Fill_Uniform(vectorfield & vf, scalar min, scalar max, int seed, uint64_t iteration)
+		{
+			Threading::Parallel_For(vf.size(), [&](int begin, int end)
+			{
+				for (int ispin = begin; ispin < end; ++ispin)
+				{
+					auto u = Uniform_4(ispin, seed, iteration);
+					vf[ispin] = { min + (max - min)*u[0], min + (max - min)*u[1], min + (max - min)*u[2] };
+				}
+			});
+		}
+	}
+}
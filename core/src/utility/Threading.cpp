@@ -0,0 +1,187 @@
+#include <utility/Threading.hpp>
+
+#include <algorithm>
+
+#ifdef CORE_USE_THREADS
+	#include <thread>
+	#include <mutex>
+	#include <condition_variable>
+	#include <vector>
+	#include <memory>
+#endif
+
+namespace Utility
+{
+	namespace Threading
+	{
+		#ifdef CORE_USE_THREADS
+		/*
+			A fixed set of worker threads which cooperatively process the chunks of one loop at a time.
+			The thread calling Run participates in the work.
+		*/
+		class Thread_Pool
+		{
+		public:
+			Thread_Pool(int n_threads) : n_threads(n_threads), stop(false), generation(0), n_chunks(0), next_chunk(0), n_done(0)
+			{
+				for (int i = 1; i < n_threads; ++i)
+					workers.push_back(std::thread(&Thread_Pool::Work, this));
+			}
+
+			~Thread_Pool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stop = true;
+				}
+				cv_work.notify_all();
+				for (auto& worker : workers) worker.join();
+			}
+
+			// Process the chunks 0..n_chunks-1 and return when all are done
+			void Run(int n_chunks, const std::function<void(int)> & chunk_function)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					this->job = &chunk_function;
+					this->n_chunks = n_chunks;
+					this->next_chunk = 0;
+					this->n_done = 0;
+					++this->generation;
+				}
+				cv_work.notify_all();
+
+				Process_Chunks();
+
+				std::unique_lock<std::mutex> lock(mutex);
+				cv_done.wait(lock, [this] { return this->n_done == this->n_chunks; });
+				this->job = nullptr;
+			}
+
+			const int n_threads;
+			// Held by the thread which currently runs a loop on this pool
+			std::mutex run_mutex;
+
+		private:
+			void Work()
+			{
+				unsigned long last_generation = 0;
+				while (true)
+				{
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						cv_work.wait(lock, [this, last_generation] { return this->stop || this->generation != last_generation; });
+						if (this->stop) return;
+						last_generation = this->generation;
+					}
+					Process_Chunks();
+				}
+			}
+
+			void Process_Chunks()
+			{
+				in_parallel_region = true;
+				while (true)
+				{
+					int chunk;
+					const std::function<void(int)> * f;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						if (this->job == nullptr || this->next_chunk >= this->n_chunks) break;
+						chunk = this->next_chunk++;
+						f = this->job;
+					}
+					(*f)(chunk);
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						++this->n_done;
+						if (this->n_done == this->n_chunks) cv_done.notify_all();
+					}
+				}
+				in_parallel_region = false;
+			}
+
+			std::vector<std::thread> workers;
+			std::mutex mutex;
+			std::condition_variable cv_work, cv_done;
+			bool stop;
+			unsigned long generation;
+			const std::function<void(int)> * job;
+			int n_chunks, next_chunk, n_done;
+
+		public:
+			// Whether the current thread is processing a chunk of a parallel loop
+			static thread_local bool in_parallel_region;
+		};
+
+		thread_local bool Thread_Pool::in_parallel_region = false;
+
+		static std::mutex pool_mutex;
+		static std::shared_ptr<Thread_Pool> pool;
+		static int n_threads_requested = 0;
+
+		static std::shared_ptr<Thread_Pool> Get_Pool()
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			if (!pool)
+			{
+				int n_threads = n_threads_requested;
+				if (n_threads <= 0) n_threads = std::max(1, (int)std::thread::hardware_concurrency());
+				pool = std::shared_ptr<Thread_Pool>(new Thread_Pool(n_threads));
+			}
+			return pool;
+		}
+
+		int Get_N_Threads()
+		{
+			return Get_Pool()->n_threads;
+		}
+
+		void Set_N_Threads(int n_threads)
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			n_threads_requested = n_threads;
+			// The old pool is destroyed as soon as no loop is using it anymore
+			pool.reset();
+		}
+
+		void Parallel_For(int n, const std::function<void(int begin, int end)> & f, int max_threads)
+		{
+			if (n <= 0) return;
+
+			auto thread_pool = Get_Pool();
+			int n_chunks = std::min(n, thread_pool->n_threads);
+			if (max_threads > 0) n_chunks = std::min(n_chunks, max_threads);
+
+			// Nested loops and loops competing for a busy pool run serially
+			if (n_chunks < 2 || Thread_Pool::in_parallel_region || !thread_pool->run_mutex.try_lock())
+			{
+				f(0, n);
+				return;
+			}
+			std::lock_guard<std::mutex> lock(thread_pool->run_mutex, std::adopt_lock);
+
+			thread_pool->Run(n_chunks, [&](int chunk)
+			{
+				int begin = (int)((long long)n * chunk / n_chunks);
+				int end   = (int)((long long)n * (chunk + 1) / n_chunks);
+				f(begin, end);
+			});
+		}
+		#else
+		int Get_N_Threads()
+		{
+			return 1;
+		}
+
+		void Set_N_Threads(int n_threads)
+		{
+		}
+
+		void Parallel_For(int n, const std::function<void(int begin, int end)> & f, int max_threads)
+		{
+			if (n > 0) f(0, n);
+		}
+		#endif
+	}
+}
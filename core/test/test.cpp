@@ -1,7 +1,60 @@
 #include <catch.hpp>
 #include <engine/Vectormath_Defines.hpp>
 #include <engine/Vectormath.hpp>
+#include <engine/Vectormath_SoA.hpp>
 #include <engine/Manifoldmath.hpp>
+#include <engine/Hamiltonian_Isotropic.hpp>
+#include <engine/Hamiltonian_Anisotropic.hpp>
+#include <engine/Hamiltonian_Gaussian.hpp>
+#include <engine/Neighbours.hpp>
+#include <engine/Dipole_FFT.hpp>
+#include <engine/Dipole_Octree.hpp>
+#include <data/Spin_System.hpp>
+#include <data/Spin_System_Chain.hpp>
+#include <engine/Method_LLG.hpp>
+#include <engine/Method_GNEB.hpp>
+#include <engine/Optimizer_SIB.hpp>
+#include <engine/Optimizer_VP.hpp>
+#include <engine/Optimizer_CG.hpp>
+#include <engine/Optimizer_LBFGS.hpp>
+#include <engine/Method_MC.hpp>
+#include <engine/Optimizer_MC.hpp>
+#include <utility/Random.hpp>
+#include <utility/Threading.hpp>
+#include <utility/IO.hpp>
+#include <utility/IO_Mapped_File.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <thread>
+
+
+// A simple cubic lattice of n_cells, periodic in a and b, with the isotropic Hamiltonian: a field of 2 along field_normal,
+//		an anisotropy of 0.5 along z, the exchange jij of the first shells, a DMI of 6 and optionally BQC, FSC and DDI
+std::shared_ptr<Data::Spin_System> make_isotropic_system(std::vector<int> n_cells, Vector3 field_normal, scalar mu_s,
+	std::vector<scalar> jij = { 10.0 }, scalar bij = 0, scalar kijkl = 0, scalar dd_radius = 0)
+{
+	std::vector<Vector3> basis{ { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	std::vector<Vector3> basis_atoms{ { 0.0, 0.0, 0.0 } };
+	vectorfield spin_pos(n_cells[0] * n_cells[1] * n_cells[2]);
+	Engine::Vectormath::Build_Spins(spin_pos, basis_atoms, basis, n_cells);
+	std::unique_ptr<Data::Geometry> geometry(new Data::Geometry(basis, basis, n_cells, basis_atoms, spin_pos));
+	std::unique_ptr<Engine::Hamiltonian> hamiltonian(new Engine::Hamiltonian_Isotropic(std::vector<bool>{ true, true, false },
+		2.0, field_normal, mu_s, 0.5, Vector3{ 0.0, 0.0, 1.0 }, jij.size(), jij, 6.0, bij, kijkl, dd_radius, *geometry));
+	auto system = std::make_shared<Data::Spin_System>(std::move(hamiltonian), std::move(geometry), Utility::IO::Parameters_Method_LLG_from_Config(""), false);
+	system->llg_parameters->save_output_any = false;
+	return system;
+}
+
+// A smooth non-collinear configuration, the same for every test
+void set_test_spins(vectorfield & spins, scalar phase = 0, scalar offset = 0)
+{
+	for (unsigned int i = 0; i < spins.size(); ++i) spins[i] = Vector3{ std::sin(0.3*i + phase), 0.2, std::cos(0.7*i) + offset }.normalized();
+}
 
 
 TEST_CASE( "Vectormath operations", "[vectormath]" )
@@ -77,4 +130,1318 @@ TEST_CASE( "Manifold operations", "[manifold]" )
 		Engine::Manifoldmath::invert_orthogonal(v1,v2);
 		REQUIRE( Engine::Vectormath::dot(v1, v3) == Approx(-proj_prev) );
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Sparse Hessian", "[hamiltonian]" )
+{
+	// A periodic chain of spins with anisotropy, exchange and DMI
+	int N = 6;
+	std::vector<indexPairs> pairs(8);
+	std::vector<scalarfield> magnitudes(8);
+	std::vector<vectorfield> normals(8);
+	for (int i = 0; i < N; ++i)
+	{
+		int periodicity = (i == N-1) ? 1 : 0;
+		pairs[periodicity].push_back(indexPair{ i, (i+1)%N });
+		magnitudes[periodicity].push_back(1.0 + 0.1*i);
+		normals[periodicity].push_back(Vector3{ 0.0, 1.0, 0.0 });
+	}
+	intfield indices(N);
+	for (int i = 0; i < N; ++i) indices[i] = i;
+	auto hamiltonian = Engine::Hamiltonian_Anisotropic(
+		scalarfield(N, 1),
+		intfield(0), scalarfield(0), vectorfield(0),
+		indices, scalarfield(N, 0.5), vectorfield(N, Vector3{ 0.0, 0.0, 1.0 }),
+		pairs, magnitudes,
+		pairs, magnitudes, normals,
+		std::vector<indexPairs>(8), std::vector<scalarfield>(8), std::vector<vectorfield>(8),
+		std::vector<indexQuadruplets>(8), std::vector<scalarfield>(8),
+		std::vector<bool>{ true, false, false });
+
+	vectorfield spins(N);
+	for (int i = 0; i < N; ++i) spins[i] = Vector3{ std::sin(0.3*i), 0.0, std::cos(0.3*i) };
+
+	MatrixX dense(3*N, 3*N);
+	SpMatrixX sparse;
+	hamiltonian.Hessian(spins, dense);
+	hamiltonian.Sparse_Hessian(spins, sparse);
+
+	REQUIRE( sparse.rows() == 3*N );
+	REQUIRE( sparse.cols() == 3*N );
+	REQUIRE( (MatrixX(sparse) - dense).norm() == Approx(0) );
+}
+
+TEST_CASE( "Energy and gradient", "[hamiltonian]" )
+{
+	// A periodic chain of spins with field, anisotropy, exchange, DMI and a quadruplet
+	int N = 7;
+	std::vector<indexPairs> pairs(8);
+	std::vector<scalarfield> magnitudes(8);
+	std::vector<vectorfield> normals(8);
+	for (int i = 0; i < N; ++i)
+	{
+		int periodicity = (i == N-1) ? 1 : 0;
+		pairs[periodicity].push_back(indexPair{ i, (i+1)%N });
+		magnitudes[periodicity].push_back(1.0 + 0.1*i);
+		normals[periodicity].push_back(Vector3{ 0.0, 1.0, 0.0 });
+	}
+	std::vector<indexQuadruplets> quadruplets(8);
+	std::vector<scalarfield> quadruplet_magnitudes(8);
+	quadruplets[0].push_back(indexQuadruplet{ 0, 1, 2, 3 });
+	quadruplet_magnitudes[0].push_back(0.3);
+	intfield indices(N);
+	for (int i = 0; i < N; ++i) indices[i] = i;
+	Engine::Hamiltonian_Anisotropic anisotropic(
+		scalarfield(N, 1),
+		indices, scalarfield(N, 0.2), vectorfield(N, Vector3{ 0.0, 0.6, 0.8 }),
+		indices, scalarfield(N, 0.5), vectorfield(N, Vector3{ 0.0, 0.0, 1.0 }),
+		pairs, magnitudes,
+		pairs, magnitudes, normals,
+		std::vector<indexPairs>(8), std::vector<scalarfield>(8), std::vector<vectorfield>(8),
+		quadruplets, quadruplet_magnitudes,
+		std::vector<bool>{ true, false, false });
+	Engine::Hamiltonian_Gaussian gaussian(
+		std::vector<scalar>{ 1.0, -0.5 }, std::vector<scalar>{ 0.4, 0.2 },
+		std::vector<Vector3>{ Vector3{ 0.0, 0.0, 1.0 }, Vector3{ 1.0, 0.0, 0.0 } });
+
+	vectorfield spins(N);
+	for (int i = 0; i < N; ++i) spins[i] = Vector3{ std::sin(0.3*i), 0.2, std::cos(0.3*i) }.normalized();
+
+	// The isotropic Hamiltonian with two exchange shells, DMI, BQC, FSC and DDI
+	auto system = make_isotropic_system({ 6, 6, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0, { 10.0, 1.0 }, 0.5, 0.2, 2.5);
+	set_test_spins(*system->spins);
+	REQUIRE( system->hamiltonian->Energy_Contributions(*system->spins).size() == 7 );
+
+	for (auto test : std::vector<std::pair<Engine::Hamiltonian*, vectorfield*>>{ { &anisotropic, &spins }, { &gaussian, &spins },
+		{ system->hamiltonian.get(), system->spins.get() } })
+	{
+		auto hamiltonian = test.first;
+		auto & configuration = *test.second;
+		int nos = configuration.size();
+		vectorfield gradient(nos), gradient_fused(nos);
+		hamiltonian->Gradient(configuration, gradient);
+		auto energy = hamiltonian->Energy_Contributions(configuration);
+		std::vector<std::pair<std::string, scalar>> energy_fused;
+		hamiltonian->Energy_and_Gradient(configuration, gradient_fused, energy_fused);
+
+		REQUIRE( energy_fused.size() == energy.size() );
+		for (unsigned int i = 0; i < energy.size(); ++i)
+		{
+			REQUIRE( energy_fused[i].first == energy[i].first );
+			REQUIRE( energy_fused[i].second == Approx(energy[i].second) );
+		}
+		for (int i = 0; i < nos; ++i)
+		{
+			for (int dim = 0; dim < 3; ++dim)
+				REQUIRE( gradient_fused[i][dim] == Approx(gradient[i][dim]) );
+		}
+	}
+}
+
+TEST_CASE( "Threaded gradient", "[hamiltonian]" )
+{
+	// A periodic chain of spins with all interactions of the anisotropic Hamiltonian
+	int N = 300;
+	std::vector<indexPairs> pairs(8);
+	std::vector<scalarfield> magnitudes(8);
+	std::vector<vectorfield> normals(8);
+	std::vector<indexQuadruplets> quadruplets(8);
+	std::vector<scalarfield> quadruplet_magnitudes(8);
+	for (int i = 0; i < N; ++i)
+	{
+		int periodicity = (i >= N-3) ? 1 : 0;
+		for (int j = 1; j <= 3; ++j)
+		{
+			pairs[periodicity].push_back(indexPair{ i, (i+j)%N });
+			magnitudes[periodicity].push_back(1.0 + 0.1*j + 0.001*i);
+			normals[periodicity].push_back(Vector3{ 0.0, 0.6, 0.8 });
+		}
+		quadruplets[periodicity].push_back(indexQuadruplet{ i, (i+1)%N, (i+2)%N, (i+3)%N });
+		quadruplet_magnitudes[periodicity].push_back(0.3);
+	}
+	intfield indices(N);
+	for (int i = 0; i < N; ++i) indices[i] = i;
+	Engine::Hamiltonian_Anisotropic anisotropic(
+		scalarfield(N, 1),
+		indices, scalarfield(N, 0.2), vectorfield(N, Vector3{ 0.0, 0.6, 0.8 }),
+		indices, scalarfield(N, 0.5), vectorfield(N, Vector3{ 0.0, 0.0, 1.0 }),
+		pairs, magnitudes,
+		pairs, magnitudes, normals,
+		pairs, magnitudes, normals,
+		quadruplets, quadruplet_magnitudes,
+		std::vector<bool>{ true, false, false });
+	vectorfield spins(N);
+	set_test_spins(spins);
+
+	// An isotropic system with DMI, BQC, FSC and DDI
+	auto system = make_isotropic_system({ 12, 12, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0, { 10.0, 1.0 }, 0.5, 0.2, 2.5);
+	set_test_spins(*system->spins);
+
+	// The results do not depend on the number of threads, not even in the last bit
+	for (auto test : std::vector<std::pair<Engine::Hamiltonian*, vectorfield*>>{ { &anisotropic, &spins }, { system->hamiltonian.get(), system->spins.get() } })
+	{
+		auto & hamiltonian = *test.first;
+		auto & configuration = *test.second;
+		int nos = configuration.size();
+		std::vector<vectorfield> gradient, gradient_fused;
+		std::vector<std::vector<std::pair<std::string, scalarfield>>> energy_per_spin;
+		std::vector<std::vector<std::pair<std::string, scalar>>> energy_fused;
+		for (int n_threads : { 1, 4 })
+		{
+			Utility::Threading::Set_N_Threads(n_threads);
+			gradient.push_back(vectorfield(nos));
+			gradient_fused.push_back(vectorfield(nos));
+			energy_per_spin.push_back({});
+			energy_fused.push_back({});
+			hamiltonian.Gradient(configuration, gradient.back());
+			hamiltonian.Energy_Contributions_per_Spin(configuration, energy_per_spin.back());
+			hamiltonian.Energy_and_Gradient(configuration, gradient_fused.back(), energy_fused.back());
+		}
+		Utility::Threading::Set_N_Threads(0);
+
+		for (int i = 0; i < nos; ++i)
+		{
+			REQUIRE( gradient[1][i] == gradient[0][i] );
+			REQUIRE( gradient_fused[1][i] == gradient_fused[0][i] );
+		}
+		REQUIRE( energy_per_spin[1].size() == energy_per_spin[0].size() );
+		for (unsigned int c = 0; c < energy_per_spin[0].size(); ++c)
+			for (int i = 0; i < nos; ++i) REQUIRE( energy_per_spin[1][c].second[i] == energy_per_spin[0][c].second[i] );
+		REQUIRE( energy_fused[1].size() == energy_fused[0].size() );
+		for (unsigned int c = 0; c < energy_fused[0].size(); ++c) REQUIRE( energy_fused[1][c].second == energy_fused[0][c].second );
+	}
+}
+
+TEST_CASE( "Shared Hamiltonian", "[hamiltonian]" )
+{
+	int nos = 64;
+	auto system = make_isotropic_system({ 8, 8, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0);
+	auto & image = *system;
+	Data::Spin_System copy(image);
+	set_test_spins(*image.spins);
+	for (int i = 0; i < nos; ++i) (*copy.spins)[i] = Vector3{ std::cos(0.5*i), std::sin(0.5*i), 0.1 }.normalized();
+
+	// The copy shares the Hamiltonian and geometry
+	REQUIRE( copy.hamiltonian == image.hamiltonian );
+	REQUIRE( copy.geometry == image.geometry );
+
+	// Both images can be evaluated concurrently
+	std::vector<std::pair<std::string, scalar>> energy_image, energy_copy;
+	vectorfield gradient_image(nos), gradient_copy(nos);
+	std::thread thread([&] { image.hamiltonian->Energy_and_Gradient(*image.spins, gradient_image, energy_image); });
+	copy.hamiltonian->Energy_and_Gradient(*copy.spins, gradient_copy, energy_copy);
+	thread.join();
+	auto expected_image = image.hamiltonian->Energy_Contributions(*image.spins);
+	auto expected_copy = copy.hamiltonian->Energy_Contributions(*copy.spins);
+	for (unsigned int i = 0; i < expected_image.size(); ++i)
+	{
+		REQUIRE( energy_image[i].second == Approx(expected_image[i].second) );
+		REQUIRE( energy_copy[i].second == Approx(expected_copy[i].second) );
+	}
+
+	// Modifying the Hamiltonian of the copy does not change the one of the image
+	scalar energy = image.hamiltonian->Energy(*image.spins);
+	copy.Unshare_Hamiltonian();
+	REQUIRE( copy.hamiltonian != image.hamiltonian );
+	((Engine::Hamiltonian_Isotropic*)copy.hamiltonian.get())->dij = 0;
+	copy.hamiltonian->Update_Energy_Contributions();
+	REQUIRE( image.hamiltonian->Energy(*image.spins) == energy );
+	REQUIRE( copy.hamiltonian->Energy(*image.spins) != energy );
+}
+
+TEST_CASE( "Energy versions", "[gneb]" )
+{
+	int nos = 36;
+	auto system = make_isotropic_system({ 6, 6, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0);
+	set_test_spins(*system->spins);
+
+	// The energy is only recalculated after the spins were invalidated
+	system->UpdateEnergy();
+	REQUIRE( system->energy_version == system->spins_version );
+	scalar energy = system->E;
+	set_test_spins(*system->spins, 1.0);
+	system->UpdateEnergy();
+	REQUIRE( system->E == energy );
+	system->Invalidate();
+	REQUIRE( system->energy_version != system->spins_version );
+	system->UpdateEnergy();
+	REQUIRE( system->energy_version == system->spins_version );
+	REQUIRE( system->E == Approx(system->hamiltonian->Energy(*system->spins)) );
+	REQUIRE( system->E != Approx(energy) );
+
+	// The energies calculated by GNEB are those of the images, and are valid until their spins change
+	int noi = 4;
+	std::vector<std::shared_ptr<Data::Spin_System>> images;
+	std::vector<std::shared_ptr<vectorfield>> configurations;
+	for (int img = 0; img < noi; ++img)
+	{
+		images.push_back(std::make_shared<Data::Spin_System>(*system));
+		set_test_spins(*images[img]->spins, 0.2 * img);
+		images[img]->Invalidate();
+		configurations.push_back(images[img]->spins);
+	}
+	auto chain = std::make_shared<Data::Spin_System_Chain>(images, Utility::IO::Parameters_Method_GNEB_from_Config(""), false);
+	auto method = std::make_shared<Engine::Method_GNEB>(chain, 0);
+	std::vector<vectorfield> forces(noi, vectorfield(nos));
+	method->Calculate_Force(configurations, forces);
+	for (auto & image : images)
+	{
+		REQUIRE( image->energy_version == image->spins_version );
+		REQUIRE( image->E == Approx(image->hamiltonian->Energy(*image->spins)) );
+	}
+	set_test_spins(*images[1]->spins, 2.0);
+	images[1]->Invalidate();
+	REQUIRE( images[1]->energy_version != images[1]->spins_version );
+	images[1]->UpdateEnergy();
+	REQUIRE( images[1]->E == Approx(images[1]->hamiltonian->Energy(*images[1]->spins)) );
+
+	// Other configurations, e.g. the predictor of an optimizer, do not change the observables of the images
+	scalar energy_image = images[2]->E;
+	configurations[2] = std::make_shared<vectorfield>(*images[0]->spins);
+	method->Calculate_Force(configurations, forces);
+	REQUIRE( images[2]->E == energy_image );
+	REQUIRE( images[2]->energy_version == images[2]->spins_version );
+}
+
+TEST_CASE( "GNEB force", "[gneb]" )
+{
+	int nos = 256, noi = 6;
+	auto system = make_isotropic_system({ 16, 16, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0, { 10.0, 1.0 }, 0.5, 0.0, 0.0);
+	std::vector<std::shared_ptr<Data::Spin_System>> images;
+	std::vector<std::shared_ptr<vectorfield>> configurations;
+	for (int img = 0; img < noi; ++img)
+	{
+		images.push_back(std::make_shared<Data::Spin_System>(*system));
+		set_test_spins(*images[img]->spins, 0.2 * img);
+		configurations.push_back(images[img]->spins);
+	}
+	auto chain = std::make_shared<Data::Spin_System_Chain>(images, Utility::IO::Parameters_Method_GNEB_from_Config(""), false);
+	chain->image_type[2] = Data::GNEB_Image_Type::Climbing;
+	auto method = std::make_shared<Engine::Method_GNEB>(chain, 0);
+
+	// Images evaluated one after the other, concurrently, and as chosen automatically give the same force
+	Utility::Threading::Set_N_Threads(4);
+	std::vector<std::vector<vectorfield>> forces;
+	for (int n_threads_images : { 1, 4, 0 })
+	{
+		chain->gneb_parameters->n_threads_images = n_threads_images;
+		forces.push_back(std::vector<vectorfield>(noi, vectorfield(nos, Vector3{ 0, 0, 0 })));
+		method->Calculate_Force(configurations, forces.back());
+	}
+	Utility::Threading::Set_N_Threads(0);
+	for (int img = 1; img < noi - 1; ++img)
+	{
+		for (int i = 0; i < nos; ++i)
+		{
+			REQUIRE( forces[1][img][i] == forces[0][img][i] );
+			REQUIRE( forces[2][img][i] == forces[0][img][i] );
+		}
+	}
+}
+
+TEST_CASE( "Neighbours in shells", "[neighbours]" )
+{
+	// A hexagonal lattice with two basis atoms, periodic in a and b
+	std::vector<Vector3> basis{ { 1.0, 0.0, 0.0 }, { 0.5, std::sqrt(3.0)/2, 0.0 }, { 0.0, 0.0, 1.0 } };
+	std::vector<Vector3> basis_atoms{ { 0.0, 0.0, 0.0 }, { 0.5, std::sqrt(3.0)/6, 0.0 } };
+	std::vector<int> n_cells{ 9, 7, 1 };
+	int nos = basis_atoms.size() * n_cells[0] * n_cells[1] * n_cells[2];
+	vectorfield spin_pos(nos);
+	Engine::Vectormath::Build_Spins(spin_pos, basis_atoms, basis, n_cells);
+	Data::Geometry geometry(basis, basis, n_cells, basis_atoms, spin_pos);
+
+	int n_shells = 3, max_n = 12;
+	std::vector<scalar> shell_radius{ 1.0/std::sqrt(3.0), 1.0, 2.0/std::sqrt(3.0) };
+	auto boundary_vectors = Engine::Neighbours::Get_Boundary_Vectors(geometry, std::vector<bool>{ true, true, false });
+
+	auto n_spins_in_shell = std::vector<std::vector<int>>(nos, std::vector<int>(n_shells));
+	auto neigh = std::vector<std::vector<std::vector<int>>>(nos, std::vector<std::vector<int>>(n_shells, std::vector<int>(max_n)));
+	auto neigh_pos = std::vector<std::vector<std::vector<Vector3>>>(nos, std::vector<std::vector<Vector3>>(n_shells, std::vector<Vector3>(max_n)));
+	auto n_spins_in_shell_ref = n_spins_in_shell;
+	auto neigh_ref = neigh;
+	auto neigh_pos_ref = neigh_pos;
+
+	Engine::Neighbours::Get_Neighbours_in_Shells(geometry, n_shells, shell_radius, boundary_vectors, n_spins_in_shell, neigh, neigh_pos, true);
+	Engine::Neighbours::Get_Neighbours_in_Shells_Reference(geometry, n_shells, shell_radius, boundary_vectors, n_spins_in_shell_ref, neigh_ref, neigh_pos_ref, true);
+
+	REQUIRE( n_spins_in_shell[0][0] == 3 );
+	REQUIRE( n_spins_in_shell == n_spins_in_shell_ref );
+	REQUIRE( neigh == neigh_ref );
+	REQUIRE( neigh_pos == neigh_pos_ref );
+
+	// The compressed layout holds the same neighbours in the same order
+	intfield offset, neigh_compressed;
+	vectorfield neigh_pos_compressed;
+	Engine::Neighbours::Get_Neighbours_in_Shells_Compressed(geometry, n_shells, shell_radius, boundary_vectors, offset, neigh_compressed, neigh_pos_compressed, true);
+	REQUIRE( offset.size() == nos*n_shells + 1 );
+	for (int iatom = 0; iatom < nos; ++iatom)
+	{
+		for (int shell = 0; shell < n_shells; ++shell)
+		{
+			int k = offset[iatom*n_shells + shell];
+			REQUIRE( offset[iatom*n_shells + shell + 1] - k == n_spins_in_shell[iatom][shell] );
+			for (int jneigh = 0; jneigh < n_spins_in_shell[iatom][shell]; ++jneigh)
+			{
+				REQUIRE( neigh_compressed[k + jneigh] == neigh[iatom][shell][jneigh] );
+				REQUIRE( neigh_pos_compressed[k + jneigh] == neigh_pos[iatom][shell][jneigh] );
+			}
+		}
+	}
+}
+
+TEST_CASE( "Dipole pairs", "[neighbours]" )
+{
+	// A simple cubic lattice with two basis atoms
+	std::vector<Vector3> basis{ { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	std::vector<Vector3> basis_atoms{ { 0.0, 0.0, 0.0 }, { 0.5, 0.5, 0.3 } };
+	std::vector<int> n_cells{ 6, 5, 3 };
+	int N = basis_atoms.size();
+	int nos = N * n_cells[0] * n_cells[1] * n_cells[2];
+	vectorfield spin_pos(nos);
+	Engine::Vectormath::Build_Spins(spin_pos, basis_atoms, basis, n_cells);
+	Data::Geometry geometry(basis, basis, n_cells, basis_atoms, spin_pos);
+	scalar dd_radius = 2.1;
+	auto cell = [&](int ispin, int dim)
+	{
+		int stride = N;
+		for (int d = 0; d < dim; ++d) stride *= n_cells[d];
+		return (ispin / stride) % n_cells[dim];
+	};
+
+	// Pairs of all periodicities: every pair i < j and translation of j by the lattice along the periodic directions,
+	//		for which j lies in a cell less than the size of the lattice away from the cell of i
+	std::vector<std::array<int, 3>> pairs_ref;
+	for (int ispin = 0; ispin < nos; ++ispin)
+	{
+		for (int jspin = ispin + 1; jspin < nos; ++jspin)
+		{
+			for (int ia = -1; ia <= 1; ++ia)
+			for (int ib = -1; ib <= 1; ++ib)
+			for (int ic = -1; ic <= 1; ++ic)
+			{
+				int image[3] = { ia, ib, ic };
+				bool valid = true;
+				Vector3 jpos = spin_pos[jspin];
+				for (int dim = 0; dim < 3; ++dim)
+				{
+					int translation = cell(jspin, dim) - cell(ispin, dim) + image[dim] * n_cells[dim];
+					if (std::abs(translation) >= n_cells[dim]) valid = false;
+					jpos += image[dim] * n_cells[dim] * basis[dim];
+				}
+				if (!valid || (jpos - spin_pos[ispin]).norm() > dd_radius) continue;
+				int periodicity = 0;
+				if (ia != 0 && ib == 0 && ic == 0) periodicity = 1;
+				if (ia == 0 && ib != 0 && ic == 0) periodicity = 2;
+				if (ia == 0 && ib == 0 && ic != 0) periodicity = 3;
+				if (ia != 0 && ib != 0 && ic == 0) periodicity = 4;
+				if (ia != 0 && ib == 0 && ic != 0) periodicity = 5;
+				if (ia == 0 && ib != 0 && ic != 0) periodicity = 6;
+				if (ia != 0 && ib != 0 && ic != 0) periodicity = 7;
+				pairs_ref.push_back({ periodicity, ispin, jspin });
+			}
+		}
+	}
+
+	std::vector<indexPairs> DD_indices(8);
+	std::vector<scalarfield> DD_magnitude(8);
+	std::vector<vectorfield> DD_normal(8);
+	Engine::Neighbours::Create_Dipole_Pairs(geometry, dd_radius, DD_indices, DD_magnitude, DD_normal);
+	std::vector<std::array<int, 3>> pairs;
+	for (int periodicity = 0; periodicity < 8; ++periodicity)
+	{
+		for (unsigned int ipair = 0; ipair < DD_indices[periodicity].size(); ++ipair)
+		{
+			auto & pair = DD_indices[periodicity][ipair];
+			pairs.push_back({ periodicity, pair[0], pair[1] });
+			// With open boundaries the pair is not translated
+			if (periodicity == 0)
+			{
+				Vector3 r_ij = spin_pos[pair[1]] - spin_pos[pair[0]];
+				REQUIRE( DD_magnitude[0][ipair] == Approx(r_ij.norm()) );
+				REQUIRE( (DD_normal[0][ipair] - r_ij.normalized()).norm() == Approx(0).margin(1e-12) );
+			}
+		}
+	}
+	std::sort(pairs.begin(), pairs.end());
+	std::sort(pairs_ref.begin(), pairs_ref.end());
+	REQUIRE( DD_indices[0].size() > 0 );
+	REQUIRE( DD_indices[7].size() > 0 );
+	REQUIRE( pairs == pairs_ref );
+
+	// The dipole neighbours for open and for periodic boundary conditions: every spin within the radius of the nearest image
+	for (auto boundary_conditions : std::vector<std::vector<bool>>{ { false, false, false }, { true, true, false } })
+	{
+		intfield dd_offset, dd_neigh;
+		vectorfield dd_normal;
+		scalarfield dd_distance;
+		Engine::Neighbours::Create_Dipole_Neighbours_Compressed(geometry, boundary_conditions, dd_radius, dd_offset, dd_neigh, dd_normal, dd_distance);
+		std::vector<std::vector<int>> dd_neigh_nested;
+		std::vector<std::vector<Vector3>> dd_neigh_pos_nested;
+		std::vector<vectorfield> dd_normal_nested;
+		std::vector<std::vector<scalar>> dd_distance_nested;
+		Engine::Neighbours::Create_Dipole_Neighbours(geometry, boundary_conditions, dd_radius, dd_neigh_nested, dd_neigh_pos_nested, dd_normal_nested, dd_distance_nested);
+
+		int max_n = 0;
+		for (int ispin = 0; ispin < nos; ++ispin)
+		{
+			std::vector<int> neigh_ref;
+			for (int jspin = 0; jspin < nos; ++jspin)
+			{
+				Vector3 r_ij = spin_pos[jspin] - spin_pos[ispin];
+				for (int dim = 0; dim < 3; ++dim)
+				{
+					if (!boundary_conditions[dim]) continue;
+					scalar shift = std::round(r_ij.dot(basis[dim]) / n_cells[dim]);
+					r_ij -= shift * n_cells[dim] * basis[dim];
+				}
+				if (jspin != ispin && r_ij.norm() <= dd_radius) neigh_ref.push_back(jspin);
+			}
+			std::vector<int> neigh(dd_neigh.begin() + dd_offset[ispin], dd_neigh.begin() + dd_offset[ispin + 1]);
+			std::sort(neigh.begin(), neigh.end());
+			REQUIRE( neigh == neigh_ref );
+			max_n = std::max(max_n, (int)neigh.size());
+
+			// The nested lists hold the same neighbours, padded with entries of zero distance
+			int n = 0;
+			for (unsigned int jneigh = 0; jneigh < dd_neigh_nested[ispin].size(); ++jneigh)
+			{
+				if (dd_distance_nested[ispin][jneigh] > 0)
+				{
+					REQUIRE( dd_neigh_nested[ispin][jneigh] == dd_neigh[dd_offset[ispin] + n] );
+					REQUIRE( dd_distance_nested[ispin][jneigh] == Approx(dd_distance[dd_offset[ispin] + n]) );
+					++n;
+				}
+			}
+			REQUIRE( n == dd_offset[ispin + 1] - dd_offset[ispin] );
+		}
+
+		// The maximum number of neighbours in the first cell is the maximum in the lattice only with periodic boundary conditions
+		auto boundary_vectors = Engine::Neighbours::Get_Boundary_Vectors(geometry, std::vector<bool>{ true, true, true });
+		if (boundary_conditions[0])
+			REQUIRE( Engine::Neighbours::Get_MaxNumber_NInShell(geometry, 1, { dd_radius }, boundary_vectors, false)[0] >= max_n );
+	}
+}
+
+TEST_CASE( "Four-spin gradient", "[hamiltonian]" )
+{
+	// The FSC part of the gradient is the difference of the gradients with and without FSC
+	auto system = make_isotropic_system({ 6, 6, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0, { 10.0 }, 0.0, 0.7);
+	auto system_without = make_isotropic_system({ 6, 6, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0, { 10.0 }, 0.0, 0.0);
+	auto & hamiltonian = *system->hamiltonian;
+	vectorfield spins(system->nos);
+	set_test_spins(spins);
+	int nos = spins.size();
+	vectorfield gradient(nos), gradient_without(nos);
+	hamiltonian.Gradient(spins, gradient);
+	system_without->hamiltonian->Gradient(spins, gradient_without);
+
+	auto E_FourSC = [&hamiltonian](const vectorfield & spins)
+	{
+		for (auto& contribution : hamiltonian.Energy_Contributions(spins))
+			if (contribution.first == "FSC") return contribution.second;
+		return scalar(0);
+	};
+	REQUIRE( E_FourSC(spins) != 0 );
+
+	// Central finite differences of the FSC energy
+	scalar h = 1e-4;
+	for (int ispin = 0; ispin < nos; ++ispin)
+	{
+		for (int dim = 0; dim < 3; ++dim)
+		{
+			auto spins_plus = spins, spins_minus = spins;
+			spins_plus[ispin][dim] += h;
+			spins_minus[ispin][dim] -= h;
+			scalar gradient_fd = (E_FourSC(spins_plus) - E_FourSC(spins_minus)) / (2*h);
+			REQUIRE( gradient[ispin][dim] - gradient_without[ispin][dim] == Approx(gradient_fd).epsilon(1e-6) );
+		}
+	}
+}
+
+TEST_CASE( "Dipole-Dipole FFT", "[hamiltonian]" )
+{
+	// Two basis atoms on a small lattice, periodic in a and c, open in b
+	std::vector<Vector3> translations{ { 1.0, 0.0, 0.0 }, { 0.2, 1.0, 0.0 }, { 0.0, 0.0, 1.5 } };
+	std::vector<Vector3> basis_atoms{ { 0.0, 0.0, 0.0 }, { 0.5, 0.4, 0.3 } };
+	std::vector<int> n_cells{ 5, 4, 3 };
+	std::vector<bool> boundary_conditions{ true, false, true };
+	int nos = basis_atoms.size() * n_cells[0] * n_cells[1] * n_cells[2];
+	vectorfield spin_pos(nos);
+	Engine::Vectormath::Build_Spins(spin_pos, basis_atoms, translations, n_cells);
+	Data::Geometry geometry(translations, translations, n_cells, basis_atoms, spin_pos);
+
+	vectorfield spins(nos);
+	for (int i = 0; i < nos; ++i) spins[i] = Vector3{ std::sin(0.7*i), std::cos(1.3*i), std::sin(0.4*i + 1) }.normalized();
+
+	for (scalar radius : { 2.5, 100.0 })
+	{
+		std::vector<indexPairs> DD_indices(8); std::vector<scalarfield> DD_magnitude(8); std::vector<vectorfield> DD_normal(8);
+		Engine::Neighbours::Create_Dipole_Pairs(geometry, radius, DD_indices, DD_magnitude, DD_normal);
+		auto direct = Engine::Hamiltonian_Anisotropic(
+			scalarfield(nos, 1),
+			intfield(0), scalarfield(0), vectorfield(0),
+			intfield(0), scalarfield(0), vectorfield(0),
+			std::vector<indexPairs>(8), std::vector<scalarfield>(8),
+			std::vector<indexPairs>(8), std::vector<scalarfield>(8), std::vector<vectorfield>(8),
+			DD_indices, DD_magnitude, DD_normal,
+			std::vector<indexQuadruplets>(8), std::vector<scalarfield>(8),
+			boundary_conditions);
+		auto fft = Engine::Hamiltonian_Anisotropic(
+			scalarfield(nos, 1),
+			intfield(0), scalarfield(0), vectorfield(0),
+			intfield(0), scalarfield(0), vectorfield(0),
+			std::vector<indexPairs>(8), std::vector<scalarfield>(8),
+			std::vector<indexPairs>(8), std::vector<scalarfield>(8), std::vector<vectorfield>(8),
+			std::vector<indexPairs>(8), std::vector<scalarfield>(8), std::vector<vectorfield>(8),
+			std::vector<indexQuadruplets>(8), std::vector<scalarfield>(8),
+			boundary_conditions,
+			std::shared_ptr<Engine::Dipole_FFT>(new Engine::Dipole_FFT(geometry, boundary_conditions, radius)));
+
+		vectorfield gradient_direct(nos), gradient_fft(nos);
+		direct.Gradient(spins, gradient_direct);
+		fft.Gradient(spins, gradient_fft);
+		scalar max_difference = 0, max_gradient = 0;
+		for (int i = 0; i < nos; ++i)
+		{
+			max_difference = std::max(max_difference, (gradient_direct[i] - gradient_fft[i]).norm());
+			max_gradient = std::max(max_gradient, gradient_direct[i].norm());
+		}
+		REQUIRE( max_gradient > 0 );
+		REQUIRE( max_difference < 1e-10 * max_gradient );
+
+		auto energy_direct = direct.Energy_Contributions(spins);
+		auto energy_fft = fft.Energy_Contributions(spins);
+		REQUIRE( energy_fft.size() == 1 );
+		REQUIRE( energy_fft[0].first == "DD" );
+		REQUIRE( energy_fft[0].second == Approx(energy_direct[0].second) );
+	}
+}
+
+TEST_CASE( "Dipole-Dipole octree", "[hamiltonian]" )
+{
+	// Irregular positions: a jittered cloud of spins in a ball
+	int nos = 1500;
+	vectorfield spin_pos, spins;
+	for (int i = 0; spin_pos.size() < (unsigned int)nos; ++i)
+	{
+		Vector3 p{ std::fmod(0.7548776662*i, 1.0), std::fmod(0.5698402910*i, 1.0), std::fmod(0.4301597090*i, 1.0) };
+		p = 20 * (p - Vector3{ 0.5, 0.5, 0.5 });
+		if (p.norm() > 10) continue;
+		spin_pos.push_back(p);
+		spins.push_back(Vector3{ std::sin(0.7*i), std::cos(1.3*i), std::sin(0.4*i + 1) }.normalized());
+	}
+	std::vector<Vector3> translations{ { 1,0,0 }, { 0,1,0 }, { 0,0,1 } };
+	Data::Geometry geometry(translations, translations, { nos, 1, 1 }, { { 0,0,0 } }, spin_pos);
+
+	// theta = 0 is the direct sum
+	Engine::Dipole_Octree direct(geometry, 0);
+	REQUIRE( direct.Measure_Error(spins, 50) < 1e-12 );
+
+	// The error decreases with theta
+	scalar error_previous = 1;
+	for (scalar theta : { 0.8, 0.4, 0.2 })
+	{
+		Engine::Dipole_Octree octree(geometry, theta);
+		scalar error = octree.Measure_Error(spins, 200);
+		INFO( "theta = " << theta << ", error = " << error );
+		REQUIRE( error < 0.1 * theta * theta );
+		REQUIRE( error < error_previous );
+		error_previous = error;
+	}
+}
+
+TEST_CASE( "Vectormath SoA", "[vectormath]" )
+{
+	// An odd size, so that the remainder of the SIMD loops is covered
+	int n = 1003;
+	vectorfield a(n), b(n), c(n);
+	for (int i = 0; i < n; ++i)
+	{
+		a[i] = Vector3{ std::sin(0.3*i), std::cos(1.1*i), std::sin(2.3*i + 0.5) };
+		b[i] = Vector3{ std::cos(0.7*i), std::sin(0.2*i + 1), std::cos(1.9*i) };
+		c[i] = Vector3{ std::sin(1.7*i), std::sin(0.9*i), std::cos(0.4*i + 2) };
+	}
+	a[5] = Vector3{ 0, 0, 0 };
+	Engine::vectorfield_soa a_soa(a), b_soa(b), c_soa(c);
+	Vector3 v{ 0.3, -1.2, 0.7 };
+	INFO( "Instruction set: " << Engine::Vectormath::SoA_Instruction_Set() );
+
+	auto require_equal = [n](const vectorfield & aos, const Engine::vectorfield_soa & soa)
+	{
+		REQUIRE( soa.size() == n );
+		for (int i = 0; i < n; ++i) REQUIRE( (aos[i] - soa.get(i)).norm() < 1e-13 );
+	};
+	auto require_equal_sf = [n](const scalarfield & x, const scalarfield & y)
+	{
+		for (int i = 0; i < n; ++i) REQUIRE( x[i] == Approx(y[i]) );
+	};
+
+	REQUIRE( Engine::Vectormath::dot(a_soa, b_soa) == Approx(Engine::Vectormath::dot(a, b)) );
+	REQUIRE( (Engine::Vectormath::sum(a_soa) - Engine::Vectormath::sum(a)).norm() < 1e-10 );
+	REQUIRE( (Engine::Vectormath::mean(a_soa) - Engine::Vectormath::mean(a)).norm() < 1e-13 );
+
+	scalarfield d(n), d_soa(n);
+	Engine::Vectormath::dot(a, b, d);
+	Engine::Vectormath::dot(a_soa, b_soa, d_soa);
+	require_equal_sf(d, d_soa);
+	Engine::Vectormath::add_c_dot(0.5, v, b, d);
+	Engine::Vectormath::add_c_dot(0.5, v, b_soa, d_soa);
+	require_equal_sf(d, d_soa);
+	Engine::Vectormath::add_c_dot(-2, a, c, d);
+	Engine::Vectormath::add_c_dot(-2, a_soa, c_soa, d_soa);
+	require_equal_sf(d, d_soa);
+
+	Engine::Vectormath::add_c_cross(0.5, v, b, c);
+	Engine::Vectormath::add_c_cross(0.5, v, b_soa, c_soa);
+	require_equal(c, c_soa);
+	Engine::Vectormath::add_c_cross(-1.5, a, b, c);
+	Engine::Vectormath::add_c_cross(-1.5, a_soa, b_soa, c_soa);
+	require_equal(c, c_soa);
+	Engine::Vectormath::add_c_a(0.7, v, c);
+	Engine::Vectormath::add_c_a(0.7, v, c_soa);
+	require_equal(c, c_soa);
+	Engine::Vectormath::add_c_a(1.3, a, c);
+	Engine::Vectormath::add_c_a(1.3, a_soa, c_soa);
+	require_equal(c, c_soa);
+	Engine::Vectormath::cross(a, b, c);
+	Engine::Vectormath::cross(a_soa, b_soa, c_soa);
+	require_equal(c, c_soa);
+	Engine::Vectormath::scale(c, 3.5);
+	Engine::Vectormath::scale(c_soa, 3.5);
+	require_equal(c, c_soa);
+	Engine::Vectormath::normalize_vectors(a);
+	Engine::Vectormath::normalize_vectors(a_soa);
+	require_equal(a, a_soa);
+	Engine::Vectormath::fill(a, v);
+	Engine::Vectormath::fill(a_soa, v);
+	require_equal(a, a_soa);
+
+	vectorfield back;
+	Engine::Vectormath::assign(back, c_soa);
+	require_equal(back, c_soa);
+}
+
+TEST_CASE( "Vectormath SoA benchmark", "[.][benchmark]" )
+{
+	// Run explicitly with: coretest "[benchmark]"
+	std::cout << "Vectormath with vectorfield_soa (" << Engine::Vectormath::SoA_Instruction_Set() << ") compared to vectorfield" << std::endl;
+	for (int n : { 10000, 100000, 1000000, 10000000 })
+	{
+		vectorfield a(n, Vector3{ 0.3, 0.4, 0.5 }), b(n, Vector3{ -0.1, 0.7, 0.2 }), c(n, Vector3{ 0, 0, 1 });
+		Engine::vectorfield_soa a_soa(a), b_soa(b), c_soa(c);
+		scalarfield d(n, 0);
+		int n_repeat = std::max(1, 20000000 / n);
+
+		auto time = [n_repeat](const std::function<void()> & f)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < n_repeat; ++i) f();
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / n_repeat;
+		};
+		std::vector<std::pair<std::string, std::pair<double, double>>> timings{
+			{ "add_c_cross", { time([&]{ Engine::Vectormath::add_c_cross(0.1, a, b, c); }), time([&]{ Engine::Vectormath::add_c_cross(0.1, a_soa, b_soa, c_soa); }) } },
+			{ "add_c_a    ", { time([&]{ Engine::Vectormath::add_c_a(0.1, a, c); }), time([&]{ Engine::Vectormath::add_c_a(0.1, a_soa, c_soa); }) } },
+			{ "dot        ", { time([&]{ d[0] += Engine::Vectormath::dot(a, b); }), time([&]{ d[0] += Engine::Vectormath::dot(a_soa, b_soa); }) } },
+			{ "add_c_dot  ", { time([&]{ Engine::Vectormath::add_c_dot(0.1, a, b, d); }), time([&]{ Engine::Vectormath::add_c_dot(0.1, a_soa, b_soa, d); }) } },
+			{ "normalize  ", { time([&]{ Engine::Vectormath::normalize_vectors(c); }), time([&]{ Engine::Vectormath::normalize_vectors(c_soa); }) } },
+			{ "scale      ", { time([&]{ Engine::Vectormath::scale(c, 0.99); }), time([&]{ Engine::Vectormath::scale(c_soa, 0.99); }) } }
+		};
+		for (auto & t : timings)
+		{
+			std::cout << "    N = " << n << "  " << t.first << "  vectorfield " << 1e3*t.second.first << " ms,  vectorfield_soa "
+				<< 1e3*t.second.second << " ms,  speedup " << t.second.first / t.second.second << std::endl;
+		}
+	}
+}
+
+TEST_CASE( "Counter-based random numbers", "[random]" )
+{
+	SECTION("Philox4x32-10 known answers")
+	{
+		// Known-answer tests of the Random123 library
+		auto r = Utility::Random::Philox4x32({ 0, 0, 0, 0 }, { 0, 0 });
+		REQUIRE( (r == std::array<uint32_t, 4>{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }) );
+		r = Utility::Random::Philox4x32({ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff });
+		REQUIRE( (r == std::array<uint32_t, 4>{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }) );
+		r = Utility::Random::Philox4x32({ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 });
+		REQUIRE( (r == std::array<uint32_t, 4>{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }) );
+	}
+
+	SECTION("Gaussian noise")
+	{
+		int n = 100000;
+		vectorfield xi(n), xi_2(n), xi_next(n);
+		Utility::Random::Fill_Gaussian(xi, 2.0, 17, 5);
+		Utility::Random::Fill_Gaussian(xi_next, 2.0, 17, 6);
+
+		// Moments
+		for (int dim = 0; dim < 3; ++dim)
+		{
+			scalar mean = 0, variance = 0;
+			for (int i = 0; i < n; ++i) mean += xi[i][dim] / n;
+			for (int i = 0; i < n; ++i) variance += std::pow(xi[i][dim] - mean, 2) / n;
+			REQUIRE( std::abs(mean) < 0.03 );
+			REQUIRE( variance == Approx(4.0).epsilon(0.03) );
+		}
+		REQUIRE( xi[0] != xi_next[0] );
+
+		// The same (seed, iteration) gives the same field, independently of the number of threads
+		int n_threads = Utility::Threading::Get_N_Threads();
+		Utility::Threading::Set_N_Threads(3);
+		Utility::Random::Fill_Gaussian(xi_2, 2.0, 17, 5);
+		Utility::Threading::Set_N_Threads(n_threads);
+		bool identical = (xi == xi_2);
+		REQUIRE( identical );
+	}
+
+	SECTION("Uniform noise")
+	{
+		vectorfield u(10000);
+		Utility::Random::Fill_Uniform(u, -1, 3, 2, 0);
+		scalar mean = 0, min = 3, max = -1;
+		for (auto & v : u)
+		{
+			min = std::min(min, v.minCoeff());
+			max = std::max(max, v.maxCoeff());
+			mean += v.sum() / (3 * u.size());
+		}
+		REQUIRE( min > -1 );
+		REQUIRE( max < 3 );
+		REQUIRE( mean == Approx(1.0).epsilon(0.02) );
+	}
+}
+
+TEST_CASE( "Binary trajectory", "[io]" )
+{
+	std::vector<Vector3> basis{ { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	std::vector<Vector3> basis_atoms{ { 0.0, 0.0, 0.0 } };
+	std::vector<int> n_cells{ 5, 4, 1 };
+	int nos = 20;
+	vectorfield spin_pos(nos);
+	Engine::Vectormath::Build_Spins(spin_pos, basis_atoms, basis, n_cells);
+	auto system = std::shared_ptr<Data::Spin_System>(new Data::Spin_System(
+		std::unique_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Gaussian(
+			std::vector<scalar>{ 1.0 }, std::vector<scalar>{ 0.4 }, std::vector<Vector3>{ Vector3{ 0.0, 0.0, 1.0 } })),
+		std::unique_ptr<Data::Geometry>(new Data::Geometry(basis, basis, n_cells, basis_atoms, spin_pos)),
+		std::unique_ptr<Data::Parameters_Method_LLG>(new Data::Parameters_Method_LLG("", { false, false, false, false, false, false, false },
+			1e-9, 1, 1, 0, 0, 0.5, 0.01, true, 0, Vector3{ 1.0, 0.0, 0.0 })),
+		false));
+
+	std::string file = "test_trajectory.bin";
+	std::remove(file.c_str());
+	auto frame_spins = [nos](int frame)
+	{
+		vectorfield spins(nos);
+		for (int i = 0; i < nos; ++i) spins[i] = Vector3{ std::sin(0.1*i + frame), std::cos(0.3*i), 0.5 }.normalized();
+		return spins;
+	};
+	// More frames than fit into one index block
+	int n_frames = 1100;
+	auto compressions = std::vector<Utility::IO::Trajectory_Compression>{ Utility::IO::Trajectory_Compression::NONE,
+		Utility::IO::Trajectory_Compression::SINGLE_PRECISION, Utility::IO::Trajectory_Compression::FIXED_POINT_16 };
+	for (int frame = 0; frame < n_frames; ++frame)
+	{
+		*system->spins = frame_spins(frame);
+		system->Invalidate();
+		Utility::IO::Append_Trajectory_Frame(system, 10 * frame, file, compressions[frame % 3]);
+	}
+	REQUIRE( Utility::IO::Trajectory_N_Frames(file) == n_frames );
+
+	std::vector<scalar> tolerance{ 1e-12, 1e-6, 1e-4 };
+	for (int frame : std::vector<int>{ 1099, 0, 1024, 512, 1 })
+	{
+		int iteration;
+		scalar energy;
+		Utility::IO::Read_Trajectory_Frame(system, file, frame, &iteration, &energy);
+		auto spins = frame_spins(frame);
+		REQUIRE( iteration == 10 * frame );
+		REQUIRE( energy == Approx(system->hamiltonian->Energy(spins)) );
+		scalar max_error = 0;
+		for (int i = 0; i < nos; ++i) max_error = std::max(max_error, ((*system->spins)[i] - spins[i]).cwiseAbs().maxCoeff());
+		REQUIRE( max_error < tolerance[frame % 3] );
+	}
+
+	// The last frame via Read_Spin_Configuration
+	Utility::IO::Read_Spin_Configuration(system, file, Utility::IO::VectorFileFormat::BINARY_TRAJECTORY);
+	REQUIRE( ((*system->spins)[3] - frame_spins(n_frames - 1)[3]).norm() < 1e-4 );
+
+	std::remove(file.c_str());
+
+	// GNEB writes the image chain as a trajectory with one frame per image
+	int noi = 3;
+	std::vector<std::shared_ptr<Data::Spin_System>> images;
+	for (int img = 0; img < noi; ++img)
+	{
+		images.push_back(std::make_shared<Data::Spin_System>(*system));
+		*images[img]->spins = frame_spins(img);
+		images[img]->Invalidate();
+	}
+	auto chain = std::make_shared<Data::Spin_System_Chain>(images, Utility::IO::Parameters_Method_GNEB_from_Config(""), false);
+	chain->gneb_parameters->output_folder = ".";
+	chain->gneb_parameters->save_output_energy = false;
+	chain->gneb_parameters->save_output_binary = true;
+	Engine::Method_GNEB gneb(chain, 0);
+	gneb.Save_Current("test", 0, false, true);
+	std::string chain_file = "./test_Images_000000_final.bin";
+	REQUIRE( Utility::IO::Trajectory_N_Frames(chain_file) == noi );
+	for (int img = 0; img < noi; ++img)
+	{
+		int frame;
+		Utility::IO::Read_Trajectory_Frame(system, chain_file, img, &frame);
+		REQUIRE( frame == img );
+		for (int i = 0; i < nos; ++i) REQUIRE( (*system->spins)[i] == frame_spins(img)[i] );
+	}
+	std::remove(chain_file.c_str());
+}
+
+TEST_CASE( "Spin configuration files", "[io]" )
+{
+	// Numbers are parsed exactly like strtod
+	for (std::string number : { "0.1234567890", "-0.9999999999", "+12", "1e-3", "-2.5E+2", "0.3000000000000000444", "123456789012345678" })
+	{
+		scalar value = 0;
+		const char * end = Utility::IO::Parse_Scalar(number.data(), number.data() + number.size(), value);
+		REQUIRE( end == number.data() + number.size() );
+		REQUIRE( value == scalar(std::strtod(number.c_str(), nullptr)) );
+	}
+
+	std::vector<Vector3> basis{ { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	std::vector<Vector3> basis_atoms{ { 0.0, 0.0, 0.0 } };
+	std::vector<int> n_cells{ 1000, 1, 1 };
+	int nos = 1000;
+	vectorfield spin_pos(nos);
+	Engine::Vectormath::Build_Spins(spin_pos, basis_atoms, basis, n_cells);
+	auto system = std::shared_ptr<Data::Spin_System>(new Data::Spin_System(
+		std::unique_ptr<Engine::Hamiltonian>(new Engine::Hamiltonian_Gaussian(
+			std::vector<scalar>{ 1.0 }, std::vector<scalar>{ 0.4 }, std::vector<Vector3>{ Vector3{ 0.0, 0.0, 1.0 } })),
+		std::unique_ptr<Data::Geometry>(new Data::Geometry(basis, basis, n_cells, basis_atoms, spin_pos)),
+		std::unique_ptr<Data::Parameters_Method_LLG>(new Data::Parameters_Method_LLG("", { false, false, false, false, false, false, false },
+			1e-9, 1, 1, 0, 0, 0.5, 0.01, true, 0, Vector3{ 1.0, 0.0, 0.0 })),
+		false));
+
+	std::string file = "test_spins.txt";
+	vectorfield spins(nos);
+	for (int i = 0; i < nos; ++i) spins[i] = Vector3{ std::sin(0.1*i), std::cos(0.3*i), 0.5 }.normalized();
+	{
+		// Positions and spins separated by commas, with comments and Windows line endings
+		std::ofstream out(file);
+		out.precision(17);
+		out << "# x, y, z, sx, sy, sz\r\n";
+		for (int i = 0; i < nos; ++i)
+			out << spin_pos[i][0] << "," << spin_pos[i][1] << "," << spin_pos[i][2] << ","
+				<< spins[i][0] << "," << spins[i][1] << "," << spins[i][2] << "\r\n";
+	}
+	Utility::IO::Read_Spin_Configuration(system, file, Utility::IO::VectorFileFormat::CSV_POS_SPIN);
+	for (int i = 0; i < nos; ++i) REQUIRE( (*system->spins)[i] == spins[i] );
+
+	// The text format written by the LLG method
+	std::remove(file.c_str());
+	*system->spins = spins;
+	Utility::IO::Append_Spin_Configuration(system, 0, file);
+	*system->spins = vectorfield(nos, Vector3{ 0, 0, 1 });
+	Utility::IO::Read_Spin_Configuration(system, file, Utility::IO::VectorFileFormat::WHITESPACE_SPIN);
+	scalar max_error = 0;
+	for (int i = 0; i < nos; ++i) max_error = std::max(max_error, ((*system->spins)[i] - spins[i]).cwiseAbs().maxCoeff());
+	REQUIRE( max_error < 1e-10 );
+
+	std::remove(file.c_str());
+}
+
+TEST_CASE( "Compiled Hamiltonian", "[io]" )
+{
+	int nos = 30;
+	auto system = make_isotropic_system({ 6, 5, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0, { 10.0, 1.0 }, 0.0, 0.0, 1.5);
+	auto & geometry = *system->geometry;
+	auto & hamiltonian = *system->hamiltonian;
+
+	std::string file = "test_hamiltonian.bin";
+	Utility::IO::Save_Compiled_Hamiltonian(file, 42, geometry, hamiltonian);
+	std::unique_ptr<Data::Geometry> loaded_geometry;
+	std::unique_ptr<Engine::Hamiltonian> loaded;
+	REQUIRE( !Utility::IO::Load_Compiled_Hamiltonian(file, 43, loaded_geometry, loaded) );
+	REQUIRE( Utility::IO::Load_Compiled_Hamiltonian(file, 42, loaded_geometry, loaded) );
+	REQUIRE( loaded_geometry->nos == nos );
+	REQUIRE( loaded->Name() == hamiltonian.Name() );
+
+	vectorfield spins(nos), gradient(nos), loaded_gradient(nos);
+	set_test_spins(spins);
+	hamiltonian.Gradient(spins, gradient);
+	loaded->Gradient(spins, loaded_gradient);
+	for (int i = 0; i < nos; ++i) REQUIRE( loaded_gradient[i] == gradient[i] );
+	REQUIRE( loaded->Energy(spins) == hamiltonian.Energy(spins) );
+
+	// An anisotropic Hamiltonian on a periodic chain, with all interactions
+	int N = 7;
+	std::vector<indexPairs> pairs(8);
+	std::vector<scalarfield> magnitudes(8);
+	std::vector<vectorfield> normals(8);
+	for (int i = 0; i < N; ++i)
+	{
+		int periodicity = (i == N-1) ? 1 : 0;
+		pairs[periodicity].push_back(indexPair{ i, (i+1)%N });
+		magnitudes[periodicity].push_back(1.0 + 0.1*i);
+		normals[periodicity].push_back(Vector3{ 0.0, 1.0, 0.0 });
+	}
+	std::vector<indexQuadruplets> quadruplets(8);
+	std::vector<scalarfield> quadruplet_magnitudes(8);
+	quadruplets[0].push_back(indexQuadruplet{ 0, 1, 2, 3 });
+	quadruplet_magnitudes[0].push_back(0.3);
+	intfield indices(N);
+	for (int i = 0; i < N; ++i) indices[i] = i;
+	std::vector<Vector3> basis{ { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	std::vector<Vector3> basis_atoms{ { 0.0, 0.0, 0.0 } };
+	std::vector<int> n_cells{ N, 1, 1 };
+	vectorfield spin_pos(N);
+	Engine::Vectormath::Build_Spins(spin_pos, basis_atoms, basis, n_cells);
+	Data::Geometry chain_geometry(basis, basis, n_cells, basis_atoms, spin_pos);
+	Engine::Hamiltonian_Anisotropic anisotropic(
+		scalarfield(N, 1),
+		indices, scalarfield(N, 0.2), vectorfield(N, Vector3{ 0.0, 0.6, 0.8 }),
+		indices, scalarfield(N, 0.5), vectorfield(N, Vector3{ 0.0, 0.0, 1.0 }),
+		pairs, magnitudes,
+		pairs, magnitudes, normals,
+		std::vector<indexPairs>(8), std::vector<scalarfield>(8), std::vector<vectorfield>(8),
+		quadruplets, quadruplet_magnitudes,
+		std::vector<bool>{ true, false, false });
+	Utility::IO::Save_Compiled_Hamiltonian(file, 7, chain_geometry, anisotropic);
+	REQUIRE( Utility::IO::Load_Compiled_Hamiltonian(file, 7, loaded_geometry, loaded) );
+	REQUIRE( loaded_geometry->nos == N );
+	REQUIRE( loaded->Name() == anisotropic.Name() );
+	vectorfield chain_spins(N), chain_gradient(N), chain_loaded_gradient(N);
+	set_test_spins(chain_spins);
+	anisotropic.Gradient(chain_spins, chain_gradient);
+	loaded->Gradient(chain_spins, chain_loaded_gradient);
+	for (int i = 0; i < N; ++i) REQUIRE( chain_loaded_gradient[i] == chain_gradient[i] );
+	REQUIRE( loaded->Energy(chain_spins) == anisotropic.Energy(chain_spins) );
+	std::remove(file.c_str());
+
+	// The cache key depends on the files referenced by the config, including the basis
+	std::string config_file = "test_hamiltonian.cfg", basis_file = "test_basis.cfg";
+	std::ofstream(config_file) << "basis_from_config " << basis_file << "\n";
+	std::ofstream(basis_file) << "basis\n1.0 0.0 0.0\n0.0 1.0 0.0\n0.0 0.0 1.0\n1\n0 0 0\n";
+	auto key = Utility::IO::Hamiltonian_Cache_Key(config_file);
+	REQUIRE( Utility::IO::Hamiltonian_Cache_Key(config_file) == key );
+	std::ofstream(basis_file) << "basis\n1.0 0.0 0.0\n0.0 1.0 0.0\n0.0 0.0 1.0\n2\n0 0 0\n0.5 0.5 0\n";
+	REQUIRE( Utility::IO::Hamiltonian_Cache_Key(config_file) != key );
+	std::remove(config_file.c_str());
+	std::remove(basis_file.c_str());
+}
+
+TEST_CASE( "Checkpoint", "[io]" )
+{
+	int nos = 36;
+	auto make_system = []()
+	{
+		auto system = make_isotropic_system({ 6, 6, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0);
+		system->llg_parameters->temperature = 5.0;
+		set_test_spins(*system->spins);
+		return system;
+	};
+	// Iterations as in Optimizer::Iterate
+	auto iterate = [](Engine::Method & method, Engine::Optimizer & optimizer, int n)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			method.Hook_Pre_Iteration();
+			optimizer.Iteration();
+			for (auto & system : method.systems) system->Invalidate();
+			method.Hook_Post_Iteration();
+		}
+	};
+	auto make_optimizer = [](std::string name, std::shared_ptr<Engine::Method> method)
+	{
+		if (name == "SIB") return std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_SIB(method));
+		return std::shared_ptr<Engine::Optimizer>(new Engine::Optimizer_VP(method));
+	};
+	std::string file = "test_checkpoint.bin";
+
+	for (std::string name : { "SIB", "VP" })
+	{
+		// Uninterrupted trajectory with a checkpoint in between
+		auto system = make_system();
+		auto method = std::make_shared<Engine::Method_LLG>(system, 0, 0);
+		auto optimizer = make_optimizer(name, method);
+		iterate(*method, *optimizer, 10);
+		optimizer->Save_Checkpoint(file, 10);
+		iterate(*method, *optimizer, 10);
+
+		// Continued from the checkpoint
+		auto restarted = make_system();
+		auto restarted_method = std::make_shared<Engine::Method_LLG>(restarted, 0, 0);
+		auto restarted_optimizer = make_optimizer(name, restarted_method);
+		int iteration = 0;
+		REQUIRE( restarted_optimizer->Load_Checkpoint(file, iteration) );
+		REQUIRE( iteration == 10 );
+		iterate(*restarted_method, *restarted_optimizer, 10);
+		for (int i = 0; i < nos; ++i) REQUIRE( (*restarted->spins)[i] == (*system->spins)[i] );
+		REQUIRE( restarted->llg_parameters->noise_iteration == system->llg_parameters->noise_iteration );
+
+		// A checkpoint of a different optimizer is not used
+		auto other_optimizer = make_optimizer(name == "SIB" ? "VP" : "SIB", restarted_method);
+		REQUIRE( !other_optimizer->Load_Checkpoint(file, iteration) );
+
+		// A truncated checkpoint is not used and the run continues as if it had not been read
+		std::string content;
+		{
+			std::ifstream in(file, std::ios::binary);
+			content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		}
+		{
+			std::ofstream out(file, std::ios::binary | std::ios::trunc);
+			out.write(content.data(), content.size() - 8);
+		}
+		auto reference = make_system();
+		auto reference_method = std::make_shared<Engine::Method_LLG>(reference, 0, 0);
+		auto reference_optimizer = make_optimizer(name, reference_method);
+		iterate(*reference_method, *reference_optimizer, 10);
+		auto interrupted = make_system();
+		auto interrupted_method = std::make_shared<Engine::Method_LLG>(interrupted, 0, 0);
+		auto interrupted_optimizer = make_optimizer(name, interrupted_method);
+		iterate(*interrupted_method, *interrupted_optimizer, 5);
+		REQUIRE( !interrupted_optimizer->Load_Checkpoint(file, iteration) );
+		iterate(*interrupted_method, *interrupted_optimizer, 5);
+		for (int i = 0; i < nos; ++i) REQUIRE( (*interrupted->spins)[i] == (*reference->spins)[i] );
+		REQUIRE( interrupted->llg_parameters->noise_iteration == reference->llg_parameters->noise_iteration );
+	}
+
+	std::remove(file.c_str());
+}
+
+TEST_CASE( "Replicas", "[llg]" )
+{
+	int nos = 36;
+	auto system = make_isotropic_system({ 6, 6, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0);
+	system->llg_parameters->n_iterations = 50;
+	system->llg_parameters->n_iterations_swap = 5;
+
+	// Replicas at different temperatures, sharing the Hamiltonian
+	int n_replicas = 4;
+	std::vector<std::shared_ptr<Data::Spin_System>> images;
+	for (int r = 0; r < n_replicas; ++r)
+	{
+		images.push_back(std::make_shared<Data::Spin_System>(*system));
+		images[r]->llg_parameters->temperature = 10.0 * (r + 1);
+		images[r]->iteration_allowed = true;
+		set_test_spins(*images[r]->spins, r);
+	}
+	auto chain = std::make_shared<Data::Spin_System_Chain>(images, Utility::IO::Parameters_Method_GNEB_from_Config(""), false);
+
+	// The batched gradient is identical to the gradients of the single replicas
+	std::vector<std::shared_ptr<vectorfield>> configurations;
+	for (auto & image : images) configurations.push_back(image->spins);
+	for (scalar bij : { 0.0, 1.5 })
+	{
+		((Engine::Hamiltonian_Isotropic*)system->hamiltonian.get())->bij = bij;
+		std::vector<vectorfield> gradients(n_replicas, vectorfield(nos));
+		system->hamiltonian->Gradient_Batch(configurations, gradients);
+		for (int r = 0; r < n_replicas; ++r)
+		{
+			vectorfield gradient(nos);
+			system->hamiltonian->Gradient(*images[r]->spins, gradient);
+			for (int i = 0; i < nos; ++i) REQUIRE( gradients[r][i] == gradient[i] );
+		}
+	}
+
+	// All replicas are iterated, with parallel tempering swaps between neighbouring replicas
+	auto method = std::make_shared<Engine::Method_LLG>(chain, 0);
+	auto optimizer = std::make_shared<Engine::Optimizer_SIB>(method);
+	optimizer->Iterate();
+	for (int r = 0; r < n_replicas; ++r)
+	{
+		REQUIRE( images[r]->llg_parameters->noise_iteration > 0 );
+		REQUIRE( images[r]->llg_parameters->temperature == 10.0 * (r + 1) );
+		REQUIRE( !images[r]->iteration_allowed );
+	}
+	// 9 swap steps, alternately of the even and odd pairs
+	REQUIRE( method->n_swaps_attempted == std::vector<long int>({ 5, 4, 5 }) );
+	for (int r = 0; r < n_replicas - 1; ++r) REQUIRE( method->n_swaps_accepted[r] <= method->n_swaps_attempted[r] );
+}
+
+TEST_CASE( "Monte Carlo", "[mc]" )
+{
+	int nos = 36;
+	auto system = make_isotropic_system({ 6, 6, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0, { 10.0, -2.0 }, 1.5, 0.8, 1.5);
+	system->llg_parameters->temperature = 20.0;
+	system->llg_parameters->n_iterations = 40;
+	set_test_spins(*system->spins);
+
+	// The local energy difference equals the difference of the total energies
+	auto & spins = *system->spins;
+	scalar energy = system->hamiltonian->Energy(spins);
+	for (int i = 0; i < nos; i += 5)
+	{
+		Vector3 spin_new = Vector3{ std::cos(1.1*i), std::sin(1.1*i), 0.4 }.normalized();
+		vectorfield spins_new = spins;
+		spins_new[i] = spin_new;
+		scalar dE = system->hamiltonian->Energy_Difference(spins, i, spin_new);
+		REQUIRE( dE == Approx(system->hamiltonian->Energy(spins_new) - energy) );
+	}
+
+	// Spins of the same colour do not interact
+	intfield offset, interacting;
+	REQUIRE( system->hamiltonian->Interacting_Spins(nos, offset, interacting) );
+	system->iteration_allowed = true;
+	auto method = std::make_shared<Engine::Method_MC>(system, 0, 0);
+	REQUIRE( method->Number_of_Colours() > 1 );
+	intfield colour(nos, -1);
+	for (int c = 0; c < method->Number_of_Colours(); ++c)
+		for (int i : method->colours[c]) colour[i] = c;
+	for (int i = 0; i < nos; ++i)
+	{
+		REQUIRE( colour[i] >= 0 );
+		for (int k = offset[i]; k < offset[i + 1]; ++k) REQUIRE( colour[interacting[k]] != colour[i] );
+	}
+
+	// A short run keeps the spins normalized, with an adapted cone
+	auto optimizer = std::make_shared<Engine::Optimizer_MC>(method);
+	optimizer->Iterate();
+	for (int i = 0; i < nos; ++i) REQUIRE( spins[i].norm() == Approx(1.0) );
+	REQUIRE( method->acceptance_ratio > 0 );
+	REQUIRE( method->acceptance_ratio <= 1 );
+	REQUIRE( method->cone_angle != Approx(30.0 * M_PI / 180.0) );
+	REQUIRE( !system->iteration_allowed );
+
+	// The sweeps do not depend on the number of threads
+	std::vector<std::shared_ptr<Data::Spin_System>> systems;
+	for (int n_threads : { 1, 4 })
+	{
+		Utility::Threading::Set_N_Threads(n_threads);
+		systems.push_back(make_isotropic_system({ 12, 12, 1 }, Vector3{ 0.0, 0.6, 0.8 }, 2.0, { 10.0, -2.0 }, 1.5, 0.8, 1.5));
+		systems.back()->llg_parameters->temperature = 20.0;
+		set_test_spins(*systems.back()->spins);
+		Engine::Method_MC sweeps(systems.back(), 0, 0);
+		for (int i = 0; i < 5; ++i) sweeps.Sweep();
+	}
+	Utility::Threading::Set_N_Threads(0);
+	for (int i = 0; i < systems[0]->nos; ++i) REQUIRE( (*systems[1]->spins)[i] == (*systems[0]->spins)[i] );
+}
+
+TEST_CASE( "Conjugate gradient", "[optimizer]" )
+{
+	auto system = make_isotropic_system({ 10, 10, 1 }, Vector3{ 0.0, 0.0, 1.0 }, 20.0);
+	system->llg_parameters->force_convergence = 1e-7;
+	system->llg_parameters->n_iterations = 1000;
+	set_test_spins(*system->spins, 0, 0.5);
+	auto system_vp = std::make_shared<Data::Spin_System>(*system);
+
+	// CG and VP converge to the same minimum
+	std::shared_ptr<Data::Spin_System> systems[2] = { system, system_vp };
+	for (auto & s : systems)
+	{
+		s->iteration_allowed = true;
+		auto method = std::make_shared<Engine::Method_LLG>(s, 0, 0);
+		std::shared_ptr<Engine::Optimizer> optimizer;
+		if (s == system) optimizer = std::make_shared<Engine::Optimizer_CG>(method);
+		else optimizer = std::make_shared<Engine::Optimizer_VP>(method);
+		optimizer->Iterate();
+		REQUIRE( method->Force_Converged() );
+		for (auto & spin : *s->spins) REQUIRE( spin.norm() == Approx(1.0) );
+	}
+	REQUIRE( system->hamiltonian->Energy(*system->spins) == Approx(system_vp->hamiltonian->Energy(*system_vp->spins)) );
+}
+
+TEST_CASE( "L-BFGS", "[optimizer]" )
+{
+	auto system = make_isotropic_system({ 10, 10, 1 }, Vector3{ 0.0, 0.0, 1.0 }, 20.0);
+	system->llg_parameters->force_convergence = 1e-7;
+	system->llg_parameters->n_iterations = 1000;
+
+	// The images of a chain are relaxed together, each with its own history
+	int nos = 100, noi = 3;
+	std::vector<std::shared_ptr<Data::Spin_System>> images;
+	for (int img = 0; img < noi; ++img)
+	{
+		images.push_back(std::make_shared<Data::Spin_System>(*system));
+		images[img]->iteration_allowed = true;
+		set_test_spins(*images[img]->spins, img, 0.5);
+	}
+	auto chain = std::make_shared<Data::Spin_System_Chain>(images, Utility::IO::Parameters_Method_GNEB_from_Config(""), false);
+	auto method = std::make_shared<Engine::Method_LLG>(chain, 0);
+	auto optimizer = std::make_shared<Engine::Optimizer_LBFGS>(method);
+	optimizer->Iterate();
+	REQUIRE( method->Force_Converged() );
+
+	// Iterations beyond convergence, where the directions are not descent directions
+	for (auto & image : images) image->iteration_allowed = true;
+	images[0]->llg_parameters->force_convergence = 0;
+	images[0]->llg_parameters->n_iterations = 100;
+	optimizer = std::make_shared<Engine::Optimizer_LBFGS>(method);
+	optimizer->Iterate();
+
+	// The minimum is the one found by VP
+	system->iteration_allowed = true;
+	set_test_spins(*system->spins, 0, 0.5);
+	auto method_vp = std::make_shared<Engine::Method_LLG>(system, 0, 0);
+	std::make_shared<Engine::Optimizer_VP>(method_vp)->Iterate();
+	REQUIRE( method_vp->Force_Converged() );
+	for (auto & image : images)
+	{
+		for (auto & spin : *image->spins) REQUIRE( spin.norm() == Approx(1.0) );
+		REQUIRE( image->hamiltonian->Energy(*image->spins) == Approx(system->hamiltonian->Energy(*system->spins)) );
+	}
+}
+
+TEST_CASE( "Adaptive time step", "[llg]" )
+{
+	int nos = 36;
+	auto system = make_isotropic_system({ 6, 6, 1 }, Vector3{ 0.0, 0.0, 1.0 }, 5.0);
+	auto & params = *system->llg_parameters;
+	params.temperature = 0;
+	params.damping = 0.1;
+	params.force_convergence = 0;
+	params.n_iterations = 200;
+	params.adaptive_dt = true;
+	params.dt = 1e-4;
+	params.dt_min = 1e-6;
+	params.dt_max = 0.05;
+	params.dt_tolerance = 1e-4;
+	vectorfield spins_initial(nos);
+	set_test_spins(spins_initial, 0, 0.5);
+	*system->spins = spins_initial;
+
+	system->iteration_allowed = true;
+	auto method = std::make_shared<Engine::Method_LLG>(system, 0, 0);
+	std::make_shared<Engine::Optimizer_SIB>(method)->Iterate();
+	scalar time = params.time;
+	vectorfield spins_adaptive = *system->spins;
+
+	// The step grew from the initial one and stayed within the bounds
+	REQUIRE( params.dt > 1e-4 );
+	REQUIRE( params.dt <= params.dt_max );
+	REQUIRE( time > 200 * 1e-4 );
+	for (auto & spin : spins_adaptive) REQUIRE( spin.norm() == Approx(1.0) );
+
+	// The trajectory is the one with a fixed small step
+	int n_steps = 4000;
+	params.adaptive_dt = false;
+	params.dt = time / n_steps;
+	params.n_iterations = n_steps;
+	*system->spins = spins_initial;
+	system->iteration_allowed = true;
+	method = std::make_shared<Engine::Method_LLG>(system, 0, 0);
+	std::make_shared<Engine::Optimizer_SIB>(method)->Iterate();
+	for (int i = 0; i < nos; ++i) REQUIRE( (spins_adaptive[i] - (*system->spins)[i]).norm() < 1e-3 );
+
+	// Parameters constructed directly have usable bounds
+	Data::Parameters_Method_LLG constructed("", { false, false, false, false, false, false, false },
+		1e-9, 1, 1, 0, 0, 0.5, 0.01, true, 0, Vector3{ 1.0, 0.0, 0.0 });
+	REQUIRE( constructed.dt_min > 0 );
+	REQUIRE( constructed.dt_min < constructed.dt_max );
+
+	// A written config is read back with the same time steps
+	std::string file = "test_llg.cfg";
+	std::remove(file.c_str());
+	params.adaptive_dt = true;
+	params.dt = 2e-3;
+	params.dt_min = 3e-6;
+	params.dt_max = 0.04;
+	params.dt_tolerance = 5e-5;
+	Utility::IO::Parameters_Method_LLG_to_Config(file, system->llg_parameters);
+	auto read = Utility::IO::Parameters_Method_LLG_from_Config(file);
+	REQUIRE( read->adaptive_dt );
+	REQUIRE( read->dt == Approx(params.dt) );
+	REQUIRE( read->dt_min == Approx(params.dt_min) );
+	REQUIRE( read->dt_max == Approx(params.dt_max) );
+	REQUIRE( read->dt_tolerance == Approx(params.dt_tolerance) );
+	std::remove(file.c_str());
+}
@@ -9,6 +9,11 @@ namespace Utility
     namespace Handle_Signal
     {
         void Handle_SigInt(int sig);
+        void Handle_SigTerm(int sig);
+
+        // A signal handler may only set a flag, so the simulations are stopped after SIGTERM
+        //      by calling this regularly from the main thread
+        void Poll_SigTerm();
     }
 }
 
@@ -10,6 +10,9 @@
 #include "Interface_Log.h"
 
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
 
 // Initialise Global Variables
 std::shared_ptr<State> state;
@@ -20,6 +23,8 @@ int main(int argc, char ** argv)
 
 	//--- Register SigInt
 	signal(SIGINT, Utility::Handle_Signal::Handle_SigInt);
+	//--- Register SigTerm
+	signal(SIGTERM, Utility::Handle_Signal::Handle_SigTerm);
 	
 	//---------------------- file names ---------------------------------------------
 	//--- Config Files
@@ -38,7 +43,7 @@ int main(int argc, char ** argv)
 	//-------------------------------------------------------------------------------
 	
 	//--- Initialise State
-	std::shared_ptr<State> state = std::shared_ptr<State>(State_Setup(cfgfile), State_Delete);
+	state = std::shared_ptr<State>(State_Setup(cfgfile), State_Delete);
 
 	//---------------------- initialize spin_systems --------------------------------
 	// Copy the system a few times
@@ -73,7 +78,19 @@ int main(int argc, char ** argv)
 	//-------------------------------------------------------------------------------
 
 	//----------------------- LLG Iterations ----------------------------------------
-	Simulation_PlayPause(state.get(), "LLG", "SIB");
+	// The simulation runs in its own thread, so that SIGTERM can be handled here
+	std::atomic<bool> finished(false);
+	std::thread simulation([&finished]
+	{
+		Simulation_PlayPause(state.get(), "LLG", "SIB");
+		finished = true;
+	});
+	while (!finished)
+	{
+		Utility::Handle_Signal::Poll_SigTerm();
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	simulation.join();
 	//-------------------------------------------------------------------------------
 
 	return 0;
@@ -14,6 +14,7 @@ std::shared_ptr<State> extern state;
 namespace Utility
 {
     static system_clock::time_point t_last_sigint = system_clock::now();
+    static volatile sig_atomic_t sigterm_received = 0;
 
     // Handle interrupt by signal SIGINT
     void Handle_Signal::Handle_SigInt(int sig)
@@ -55,4 +56,24 @@ namespace Utility
         // Update time of last interrupt
         t_last_sigint = system_clock::now();
     }
+
+    // Handle termination by signal SIGTERM, e.g. when a job is pre-empted:
+    //      the simulations are stopped, which writes their checkpoints (if configured), and the program ends normally.
+    //      Logging and stopping lock mutexes and allocate, which is not allowed in a signal handler, so this is left to Poll_SigTerm.
+    void Handle_Signal::Handle_SigTerm(int sig)
+    {
+        // Have SIG_IGN (ignore) handle further SIGTERMs from now
+        signal(sig, SIG_IGN);
+        sigterm_received = 1;
+    }
+
+    void Handle_Signal::Poll_SigTerm()
+    {
+        if (!sigterm_received || state == nullptr) return;
+        sigterm_received = 0;
+        Log_Send(state.get(), Log_Level_All, Log_Sender_All, "SIGTERM received! All iteration_allowed are being set to false.");
+        Log_Send(state.get(), Log_Level_All, Log_Sender_All, "                  The simulations write their checkpoints and the Program terminates.");
+        Simulation_Stop_All(state.get());
+        Log_Append(state.get());
+    }
 }
\ No newline at end of file
@@ -46,3 +46,25 @@ _Chain_Write.restype     = None
 def Chain_Write(p_state, filename, idx_image=-1, idx_chain=-1):
     corelib.WrapFunction(_Chain_Write, [p_state, ctypes.c_char_p(filename.encode('utf-8')), idx_image, idx_chain])
     # _Chain_Write(p_state, ctypes.c_char_p(filename), idx_image, idx_chain)
+
+
+### Number of output tasks of the simulations which have not been written yet
+_Output_Queue_Depth             = _core.IO_Output_Queue_Depth
+_Output_Queue_Depth.argtypes    = [ctypes.c_void_p]
+_Output_Queue_Depth.restype     = ctypes.c_int
+def Output_Queue_Depth(p_state):
+    return int(_Output_Queue_Depth(p_state))
+
+### Total number of bytes written by the output functions
+_Output_Bytes_Written             = _core.IO_Output_Bytes_Written
+_Output_Bytes_Written.argtypes    = [ctypes.c_void_p]
+_Output_Bytes_Written.restype     = ctypes.c_longlong
+def Output_Bytes_Written(p_state):
+    return int(_Output_Bytes_Written(p_state))
+
+### Wait until all queued output has been written
+_Output_Flush             = _core.IO_Output_Flush
+_Output_Flush.argtypes    = [ctypes.c_void_p]
+_Output_Flush.restype     = None
+def Output_Flush(p_state):
+    corelib.WrapFunction(_Output_Flush, [p_state])
@@ -0,0 +1,2 @@
+import ctypes
+scalar=ctypes.c_double
\ No newline at end of file